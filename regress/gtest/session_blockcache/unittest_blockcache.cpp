@@ -0,0 +1,96 @@
+#include <iostream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "systemclock.h"
+#include "hwsreg.h"
+
+#include "testdevice.h"
+
+// word address of TIMER0_OVF vector on atmega48
+#define TIMER0_OVF_VECT 16
+
+// device, which counts it's Step calls
+class StepDevice: public AvrDevice_atmega48 {
+    public:
+        int steps;
+        StepDevice(): steps(0) {}
+        int Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+            steps++;
+            return AvrDevice_atmega48::Step(untilCoreStepFinished, nextStepIn_ns);
+        }
+};
+
+// Creates a atmega48, which counts in a loop and is interrupted by timer 0
+static StepDevice *CreateCountDevice(bool blockCache) {
+    const word reset[] = {
+        0xc01f          // rjmp main (word 32)
+    };
+    const word vect[] = {
+        0x9543,         // inc r20
+        0x9518          // reti
+    };
+    const word prog[] = {
+        0xef1f,         // ldi r17, 0xff
+        0xbf1d,         // out SPL, r17
+        0xe012,         // ldi r17, 0x02
+        0xbf1e,         // out SPH, r17
+        0xe040,         // ldi r20, 0
+        0xe050,         // ldi r21, 0
+        0xe060,         // ldi r22, 0
+        0xe001,         // ldi r16, 1
+        0x9300, 0x006e, // sts TIMSK0, r16
+        0x9478,         // sei
+        0xbd05,         // out TCCR0B, r16 (clk/1)
+        0x9553,         // loop: inc r21
+        0x0f65,         // add r22, r21
+        0xf7e9,         // brne loop
+        0x9563,         // inc r22
+        0xcffb          // rjmp loop
+    };
+
+    StepDevice *dev = CreateDevice<StepDevice>(reset, sizeof(reset) / sizeof(word));
+    LoadProgram(dev, vect, sizeof(vect) / sizeof(word), TIMER0_OVF_VECT);
+    LoadProgram(dev, prog, sizeof(prog) / sizeof(word), 32);
+    dev->useBlockCache = blockCache;
+    return dev;
+}
+
+TEST( SESSION_BLOCKCACHE, SAME_STATE )
+{
+    StepDevice *dev1 = CreateCountDevice(false);
+    StepDevice *dev2 = CreateCountDevice(true);
+    RunDevice(dev1, 20000 * 100);
+    RunDevice(dev2, 20000 * 100);
+
+    EXPECT_NE(0, dev1->GetCoreReg(20)) << "timer irq not raised" << endl;
+    EXPECT_LT(dev2->steps, dev1->steps) << "no blocks executed" << endl;
+
+    // block execution gives same results on same cycle
+    EXPECT_EQ(dev1->GetCycleCount(), dev2->GetCycleCount());
+    EXPECT_EQ(dev1->PC, dev2->PC);
+    for(int i = 0; i < 32; i++)
+        EXPECT_EQ(dev1->GetCoreReg(i), dev2->GetCoreReg(i)) << "R" << i << " differs" << endl;
+    EXPECT_EQ((int)*dev1->status, (int)*dev2->status);
+
+    delete dev1;
+    delete dev2;
+}
+
+TEST( SESSION_BLOCKCACHE, FLASH_WRITE )
+{
+    StepDevice *dev = CreateCountDevice(true);
+    RunDevice(dev, 1000 * 100);
+    unsigned char r21 = dev->GetCoreReg(21);
+
+    // replace "inc r21" in loop by "nop", cached block must be invalidated
+    const word nop[] = { 0x0000 };
+    LoadProgram(dev, nop, 1, 32 + 12);
+    RunDevice(dev, 1000 * 100);
+    EXPECT_EQ(r21, dev->GetCoreReg(21)) << "old block executed after flash write" << endl;
+
+    delete dev;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <algorithm>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "systemclock.h"
+
+#include "testdevice.h"
+
+// data addresses of IO registers on atmega48
+#define TCCR0B 0x45
+#define TCNT0  0x46
+#define ADCSRA 0x7a
+#define UCSR0A 0xc0
+#define UCSR0B 0xc1
+#define UDR0   0xc6
+
+// device, which gives access to it's hardware units
+class CycleDevice: public AvrDevice_atmega48 {
+    public:
+        Hardware *Prescaler(void) { return &prescaler01; }
+        Hardware *Adc(void) { return ad; }
+        Hardware *Uart(void) { return usart0; }
+};
+
+// nop, loop: rjmp loop
+static const word prog[] = { 0x0000, 0xcfff };
+
+// Creates a atmega48 with prog as only member of SystemClock
+static CycleDevice *CreateIdleDevice(void) {
+    CycleDevice *dev = CreateDevice<CycleDevice>(prog, sizeof(prog) / sizeof(word));
+    SystemClock::Instance().ResetClock();
+    SystemClock::Instance().Add(dev);
+    return dev;
+}
+
+static bool InCycleList(AvrDevice *dev, Hardware *hw) {
+    return find(dev->hwCycleList.begin(), dev->hwCycleList.end(), hw) != dev->hwCycleList.end();
+}
+
+TEST( SESSION_CYCLE_LIST, IDLE_UNITS )
+{
+    CycleDevice *dev = CreateIdleDevice();
+
+    // idle units aren't clocked
+    EXPECT_FALSE(InCycleList(dev, dev->Prescaler()));
+    EXPECT_FALSE(InCycleList(dev, dev->Adc()));
+    EXPECT_FALSE(InCycleList(dev, dev->Uart()));
+
+    // enabled units are clocked till they are disabled
+    dev->SetRWMem(ADCSRA, 0x80);
+    EXPECT_TRUE(InCycleList(dev, dev->Adc()));
+    dev->SetRWMem(UCSR0B, 0x08);
+    EXPECT_TRUE(InCycleList(dev, dev->Uart()));
+    SystemClock::Instance().RunTimeRange(10000);
+    dev->SetRWMem(ADCSRA, 0x00);
+    EXPECT_FALSE(InCycleList(dev, dev->Adc()));
+    dev->SetRWMem(UCSR0B, 0x00);
+    EXPECT_FALSE(InCycleList(dev, dev->Uart()));
+
+    SystemClock::Instance().ResetClock();
+    delete dev;
+}
+
+TEST( SESSION_CYCLE_LIST, PRESCALER_CATCH_UP )
+{
+    CycleDevice *dev = CreateIdleDevice();
+
+    // timer 0 with clk/8 counts 100 in 800 cycles, prescaler isn't clocked
+    dev->SetRWMem(TCNT0, 0);
+    dev->SetRWMem(TCCR0B, 0x02);
+    SystemClock::Instance().RunTimeRange(800 * 100);
+    EXPECT_FALSE(InCycleList(dev, dev->Prescaler()));
+    EXPECT_NEAR(100, dev->GetRWMem(TCNT0), 1);
+
+    SystemClock::Instance().ResetClock();
+    delete dev;
+}
+
+TEST( SESSION_CYCLE_LIST, UART_CATCH_UP )
+{
+    CycleDevice *dev = CreateIdleDevice();
+
+    // uart is idle for a while, then a frame is sent with 16 cycles per bit
+    SystemClock::Instance().RunTimeRange(1000 * 100);
+    dev->SetRWMem(UCSR0B, 0x08);
+    dev->SetRWMem(UDR0, 0x55);
+    // frame (start, 8 data, stop bit) isn't sent after 140 cycles
+    SystemClock::Instance().RunTimeRange(140 * 100);
+    EXPECT_EQ(0, dev->GetRWMem(UCSR0A) & 0x40);
+    // but after 200 cycles TXC is set
+    SystemClock::Instance().RunTimeRange(60 * 100);
+    EXPECT_EQ(0x40, dev->GetRWMem(UCSR0A) & 0x40);
+
+    SystemClock::Instance().ResetClock();
+    delete dev;
+}
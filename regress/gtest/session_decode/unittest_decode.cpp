@@ -0,0 +1,57 @@
+#include <iostream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "attiny2313.h"
+#include "decoder.h"
+#include "systemclock.h"
+#include "flash.h"
+
+#include "testdevice.h"
+
+// nop, inc r16, inc r16, loop: rjmp loop
+static const word prog[] = { 0x0000, 0x9503, 0x9503, 0xcfff };
+
+TEST( SESSION_DECODE, SHARED_INSTRUCTIONS )
+{
+    AvrDevice *dev1 = CreateDevice<AvrDevice_atmega48>(prog, sizeof(prog) / sizeof(word));
+    AvrDevice *dev2 = CreateDevice<AvrDevice_atmega48>(prog, sizeof(prog) / sizeof(word));
+
+    // words with same opcode share instruction in and between devices
+    EXPECT_EQ(dev1->Flash->GetInstruction(1), dev1->Flash->GetInstruction(2));
+    EXPECT_EQ(dev1->Flash->GetInstruction(1), dev2->Flash->GetInstruction(1));
+    // unused flash (0xffff) too
+    EXPECT_EQ(dev1->Flash->GetInstruction(100), dev2->Flash->GetInstruction(200));
+
+    // shared instruction works on the core, which executes it
+    dev1->SetCoreReg(16, 0);
+    dev2->SetCoreReg(16, 10);
+    SystemClock::Instance().ResetClock();
+    SystemClock::Instance().Add(dev1);
+    SystemClock::Instance().Add(dev2);
+    SystemClock::Instance().RunTimeRange(10000);
+    EXPECT_EQ(2, dev1->GetCoreReg(16));
+    EXPECT_EQ(12, dev2->GetCoreReg(16));
+
+    SystemClock::Instance().ResetClock();
+    delete dev1;
+    delete dev2;
+}
+
+TEST( SESSION_DECODE, INSTRUCTION_SET )
+{
+    // mul r16, r17
+    const word mul[] = { 0x9f01 };
+    AvrDevice *dev1 = CreateDevice<AvrDevice_atmega48>(mul, 1);
+    AvrDevice *dev2 = CreateDevice<AvrDevice_attiny2313>(mul, 1);
+
+    // devices with different instruction set don't share decoded instructions
+    EXPECT_TRUE(dynamic_cast<avr_op_MUL *>(dev1->Flash->GetInstruction(0)) != NULL);
+    EXPECT_TRUE(dynamic_cast<avr_op_ILLEGAL *>(dev2->Flash->GetInstruction(0)) != NULL);
+
+    delete dev1;
+    delete dev2;
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "systemclock.h"
+#include "traceval.h"
+
+// dumper, which only enables trace values
+class EnableDumper: public Dumper {
+    public:
+        bool enabled(const TraceValue *t) const { return true; }
+};
+
+TEST( SESSION_DIRECT_ACCESS, TRACE_VALUE_SYNC )
+{
+    AvrDevice *dev1= new AvrDevice_atmega48;
+    TraceValue *r16 = dev1->FindTraceValueByName("CORE.r16");
+    TraceValue *r17 = dev1->FindTraceValueByName("CORE.r17");
+    ASSERT_TRUE(r16 != NULL) << "trace value of r16 not found" << endl;
+    ASSERT_TRUE(r17 != NULL) << "trace value of r17 not found" << endl;
+
+    // untraced registers are written directly, trace value isn't touched
+    dev1->SetCoreReg(16, 0x55);
+    EXPECT_FALSE(r16->written()) << "trace value written by direct access" << endl;
+
+    // tracing r16 ends direct access, trace value gets register value
+    TraceSet vals;
+    vals.push_back(r16);
+    vals.push_back(r17);
+    DumpManager::Instance()->addDumper(new EnableDumper, vals);
+    EXPECT_TRUE(r16->written()) << "trace value of changed register not synchronized" << endl;
+    EXPECT_EQ(0x55U, r16->value()) << "wrong trace value of r16" << endl;
+    EXPECT_FALSE(r17->written()) << "trace value of unchanged register set" << endl;
+
+    // traced register is written by RWMemoryMember
+    dev1->SetCoreReg(17, 0x12);
+    EXPECT_EQ(0x12U, r17->value()) << "wrong trace value of r17" << endl;
+
+    DumpManager::Instance()->stopApplication();
+}
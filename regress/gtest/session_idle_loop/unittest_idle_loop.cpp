@@ -0,0 +1,66 @@
+#include <iostream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "systemclock.h"
+
+#include "testdevice.h"
+
+// data addresses on atmega48
+#define PINB  0x23
+#define RAM   0x100
+#define UDR0  0xc6
+
+// Creates a atmega48, which starts timer 0 (clk/1) and polls data address
+// `addr' in a loop without changing anything.
+static AvrDevice *CreateLoopDevice(word addr) {
+    const word prog[] = {
+        0x0000,         // nop
+        0xe011,         // ldi r17, 1
+        0xbd15,         // out TCCR0B, r17 (clk/1)
+        0x9100, addr,   // loop: lds r16, addr
+        0xcffd          // rjmp loop
+    };
+    return CreateDevice<AvrDevice_atmega48>(prog, sizeof(prog) / sizeof(word));
+}
+
+// Steps device till 2000 cycles are done, returns count of steps
+static int RunLoop(AvrDevice *dev) {
+    SystemClockOffset next;
+    int steps = 0;
+    while(dev->GetCycleCount() < 2000 && steps < 10000) {
+        bool finished;
+        dev->Step(finished, &next);
+        steps++;
+    }
+    return steps;
+}
+
+TEST( SESSION_IDLE_LOOP, SKIP_RAM_AND_PIN )
+{
+    AvrDevice *dev1 = CreateLoopDevice(RAM);
+    EXPECT_LT(RunLoop(dev1), 1000) << "polling loop on RAM not skipped" << endl;
+    AvrDevice *dev2 = CreateLoopDevice(PINB);
+    EXPECT_LT(RunLoop(dev2), 1000) << "polling loop on PINB not skipped" << endl;
+    delete dev1;
+    delete dev2;
+}
+
+TEST( SESSION_IDLE_LOOP, READ_SIDE_EFFECT )
+{
+    // reading UDR changes uart state, every pass must be executed
+    AvrDevice *dev = CreateLoopDevice(UDR0);
+    EXPECT_EQ(2000, RunLoop(dev)) << "polling loop on UDR0 skipped" << endl;
+    delete dev;
+}
+
+TEST( SESSION_IDLE_LOOP, DISABLED )
+{
+    AvrDevice *dev = CreateLoopDevice(RAM);
+    dev->useIdleLoopSkip = false;
+    EXPECT_EQ(2000, RunLoop(dev)) << "polling loop skipped, but disabled" << endl;
+    delete dev;
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+using namespace std;
+
+#include <pthread.h>
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "systemclock.h"
+
+#include "testdevice.h"
+
+// device, which remembers the thread, it's stepped on
+class ThreadDevice: public AvrDevice_atmega48 {
+    public:
+        pthread_t thread;
+        int Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+            thread = pthread_self();
+            return AvrDevice_atmega48::Step(untilCoreStepFinished, nextStepIn_ns);
+        }
+};
+
+// simulation member with optional owner device, which remembers the thread, it's stepped on
+class ThreadMember: public SimulationMember {
+    public:
+        pthread_t thread;
+        int steps;
+        AvrDevice *owner;
+        ThreadMember(AvrDevice *o): steps(0), owner(o) {}
+        int Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns) {
+            thread = pthread_self();
+            steps++;
+            if(timeToNextStepIn_ns != NULL)
+                *timeToNextStepIn_ns = 1000;
+            return 0;
+        }
+        AvrDevice *GetOwnerDevice(void) { return owner; }
+};
+
+TEST( SESSION_PARALLEL, OWNED_MEMBER_PARTITION )
+{
+    // nop, loop: rjmp loop (rjmp to word 0 runs out of flash)
+    const word prog[] = { 0x0000, 0xcfff };
+    ThreadDevice *dev1 = CreateDevice<ThreadDevice>(prog, sizeof(prog) / sizeof(word));
+    ThreadMember owned(dev1);
+    ThreadMember independent(NULL);
+
+    SystemClock::Instance().ResetClock();
+    SystemClock::Instance().Add(&independent);
+    SystemClock::Instance().Add(&owned);
+    SystemClock::Instance().Add(dev1);
+    SystemClock::Instance().RunParallel(100000, 10000, 2);
+
+    EXPECT_NE(0, owned.steps) << "owned member not stepped" << endl;
+    EXPECT_NE(0, independent.steps) << "independent member not stepped" << endl;
+    EXPECT_TRUE(pthread_equal(owned.thread, dev1->thread)) << "owned member not stepped on thread of device" << endl;
+    EXPECT_FALSE(pthread_equal(independent.thread, dev1->thread)) << "independent member stepped on thread of device" << endl;
+
+    SystemClock::Instance().ResetClock();
+}
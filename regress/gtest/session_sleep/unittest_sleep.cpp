@@ -0,0 +1,92 @@
+#include <iostream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "systemclock.h"
+
+#include "testdevice.h"
+
+// word address of TIMER0_OVF vector on atmega48
+#define TIMER0_OVF_VECT 16
+
+// Creates a atmega48, which starts timer 0 with overflow interrupt and
+// executes SLEEP. If sleepEnable is false, SE bit in SMCR isn't set.
+static AvrDevice *CreateSleepDevice(bool sleepEnable) {
+    const word reset[] = {
+        0xc01f          // rjmp main (word 32)
+    };
+    const word vect[] = {
+        0x9543,         // inc r20
+        0x9518          // reti
+    };
+    word prog[] = {
+        0xef1f,         // ldi r17, 0xff
+        0xbf1d,         // out SPL, r17
+        0xe012,         // ldi r17, 0x02
+        0xbf1e,         // out SPH, r17
+        0xe050,         // ldi r21, 0
+        0xe001,         // ldi r16, 1
+        0x9300, 0x006e, // sts TIMSK0, r16
+        0xbf03,         // out SMCR, r16 (SE)
+        0x9478,         // sei
+        0xbd05,         // out TCCR0B, r16 (clk/1)
+        0x9588,         // sleep
+        0x9553,         // loop: inc r21
+        0xcffe          // rjmp loop
+    };
+    if(!sleepEnable)
+        prog[8] = 0x0000; // nop instead of out SMCR
+
+    AvrDevice *dev = CreateDevice<AvrDevice_atmega48>(reset, sizeof(reset) / sizeof(word));
+    LoadProgram(dev, vect, sizeof(vect) / sizeof(word), TIMER0_OVF_VECT);
+    LoadProgram(dev, prog, sizeof(prog) / sizeof(word), 32);
+    return dev;
+}
+
+// Steps device till timer irq handler is entered, returns cycle count
+static unsigned long long RunToTimerIrq(AvrDevice *dev, bool fastForward, bool &slept, int &steps) {
+    SystemClockOffset next;
+    slept = false;
+    for(steps = 1; steps <= 10000; steps++) {
+        bool finished;
+        dev->Step(finished, fastForward ? &next : NULL);
+        if(dev->IsSleeping())
+            slept = true;
+        if(dev->PC == TIMER0_OVF_VECT)
+            return dev->GetCycleCount();
+    }
+    return 0;
+}
+
+TEST( SESSION_SLEEP, TIMER_WAKE_UP )
+{
+    bool slept;
+    int stepsRef, steps;
+    AvrDevice *dev1 = CreateSleepDevice(true);
+    unsigned long long cycleRef = RunToTimerIrq(dev1, false, slept, stepsRef);
+    EXPECT_TRUE(slept) << "core has not slept" << endl;
+    EXPECT_NE(0ULL, cycleRef) << "timer irq not raised" << endl;
+    EXPECT_EQ(0, dev1->GetCoreReg(21)) << "instruction after SLEEP executed before irq" << endl;
+
+    // fast forward of sleeping core must wake up on same cycle
+    AvrDevice *dev2 = CreateSleepDevice(true);
+    unsigned long long cycle = RunToTimerIrq(dev2, true, slept, steps);
+    EXPECT_TRUE(slept) << "core has not slept" << endl;
+    EXPECT_LT(steps, stepsRef) << "sleeping core not fast forwarded" << endl;
+    EXPECT_EQ(cycleRef, cycle) << "wrong wake up cycle with fast forward" << endl;
+    EXPECT_EQ(0, dev2->GetCoreReg(21)) << "instruction after SLEEP executed before irq" << endl;
+}
+
+TEST( SESSION_SLEEP, SLEEP_DISABLED )
+{
+    bool slept;
+    int steps;
+    AvrDevice *dev1 = CreateSleepDevice(false);
+    unsigned long long cycle = RunToTimerIrq(dev1, true, slept, steps);
+    EXPECT_FALSE(slept) << "SLEEP without SE bit has put core in sleep mode" << endl;
+    EXPECT_NE(0ULL, cycle) << "timer irq not raised" << endl;
+    EXPECT_NE(0, dev1->GetCoreReg(21)) << "instruction after SLEEP not executed" << endl;
+}
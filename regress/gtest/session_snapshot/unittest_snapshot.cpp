@@ -0,0 +1,93 @@
+#include <iostream>
+#include <sstream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "systemclock.h"
+#include "snapshot.h"
+
+#include "pin.h"
+#include "net.h"
+
+#include "testdevice.h"
+
+// data addresses of pin change interrupt registers on atmega48
+#define PCIFR  0x3b
+#define PCICR  0x68
+#define PCMSK0 0x6b
+
+static string SaveDevice(AvrDevice *dev) {
+    ostringstream os(ios::out | ios::binary);
+    Snapshot snap(os);
+    dev->SerializeState(snap);
+    return os.str();
+}
+
+static void RestoreDevice(AvrDevice *dev, const string &state) {
+    istringstream is(state, ios::in | ios::binary);
+    Snapshot snap(is);
+    dev->SerializeState(snap);
+}
+
+TEST( SESSION_SNAPSHOT, PIN_CHANGE_IRQ )
+{
+    AvrDevice *dev1= new AvrDevice_atmega48;
+
+    Net net;
+    Pin ext(Pin::LOW);
+    net.Add(&ext);
+    net.Add(dev1->GetPin("B0"));
+
+    dev1->SetRWMem(PCMSK0, 0x01);
+    dev1->SetRWMem(PCICR, 0x01);
+    ext= 'H';
+    EXPECT_EQ(0x01, dev1->GetRWMem(PCIFR)) << "pin change flag not set" << endl;
+
+    string state = SaveDevice(dev1);
+
+    // change state: flag cleared, registers reset, pin low
+    dev1->SetRWMem(PCIFR, 0x01);
+    dev1->SetRWMem(PCMSK0, 0x00);
+    dev1->SetRWMem(PCICR, 0x00);
+    ext= 'L';
+    EXPECT_EQ(0x00, dev1->GetRWMem(PCIFR)) << "pin change flag not cleared" << endl;
+
+    ext= 'H';
+    RestoreDevice(dev1, state);
+    EXPECT_EQ(0x01, dev1->GetRWMem(PCIFR)) << "wrong PCIFR after restore" << endl;
+    EXPECT_EQ(0x01, dev1->GetRWMem(PCICR)) << "wrong PCICR after restore" << endl;
+    EXPECT_EQ(0x01, dev1->GetRWMem(PCMSK0)) << "wrong PCMSK0 after restore" << endl;
+    EXPECT_TRUE(state == SaveDevice(dev1)) << "saved state differs after restore" << endl;
+
+    // restored pin change unit detects next change
+    dev1->SetRWMem(PCIFR, 0x01);
+    ext= 'L';
+    EXPECT_EQ(0x01, dev1->GetRWMem(PCIFR)) << "pin change not detected after restore" << endl;
+
+}
+
+TEST( SESSION_SNAPSHOT, RUN_RESTORE )
+{
+    // nop; loop: inc r16; rjmp loop
+    const word prog[] = { 0x0000, 0x9503, 0xcffe };
+    AvrDevice *dev1 = CreateDevice<AvrDevice_atmega48>(prog, sizeof(prog) / sizeof(word));
+    SystemClock::Instance().ResetClock();
+    SystemClock::Instance().Add(dev1);
+
+    SystemClock::Instance().RunTimeRange(3000);
+    unsigned char r16 = dev1->GetCoreReg(16);
+    EXPECT_NE(0, r16) << "program not executed" << endl;
+    string state = SaveDevice(dev1);
+
+    SystemClock::Instance().RunTimeRange(2000);
+    EXPECT_NE(r16, dev1->GetCoreReg(16)) << "program stopped" << endl;
+
+    RestoreDevice(dev1, state);
+    EXPECT_EQ(r16, dev1->GetCoreReg(16)) << "wrong r16 after restore" << endl;
+    EXPECT_TRUE(state == SaveDevice(dev1)) << "saved state differs after restore" << endl;
+
+    SystemClock::Instance().ResetClock();
+}
@@ -0,0 +1,128 @@
+#include <iostream>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "systemclock.h"
+#include "hwsreg.h"
+
+#include "testdevice.h"
+
+// word address of TIMER0_OVF vector on atmega48
+#define TIMER0_OVF_VECT 16
+
+// device, which counts it's Step calls
+class StepDevice: public AvrDevice_atmega48 {
+    public:
+        int steps;
+        StepDevice(): steps(0) {}
+        int Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+            steps++;
+            return AvrDevice_atmega48::Step(untilCoreStepFinished, nextStepIn_ns);
+        }
+};
+
+// Creates a atmega48, which runs a loop with memory access, skips, a call and
+// a IO read and is interrupted by timer 0
+static StepDevice *CreateLoopDevice(bool threaded, bool blockCache) {
+    const word reset[] = {
+        0xc01f          // rjmp main (word 32)
+    };
+    const word vect[] = {
+        0x9543,         // inc r20
+        0x9518          // reti
+    };
+    const word prog[] = {
+        0xef1f,         // ldi r17, 0xff
+        0xbf1d,         // out SPL, r17
+        0xe012,         // ldi r17, 0x02
+        0xbf1e,         // out SPH, r17
+        0xe040,         // ldi r20, 0
+        0xe050,         // ldi r21, 0
+        0xe060,         // ldi r22, 0
+        0xe020,         // ldi r18, 0
+        0xe0a0,         // ldi r26, 0x00 (X = 0x100)
+        0xe0b1,         // ldi r27, 0x01
+        0xe8c0,         // ldi r28, 0x80 (Y = 0x180)
+        0xe0d1,         // ldi r29, 0x01
+        0xe4e6,         // ldi r30, 0x46 (Z = TCNT0)
+        0xe0f0,         // ldi r31, 0x00
+        0xe001,         // ldi r16, 1
+        0x9300, 0x006e, // sts TIMSK0, r16
+        0x9478,         // sei
+        0xbd05,         // out TCCR0B, r16 (clk/1)
+        0x900d,         // loop: ld r0, X+
+        0x0e05,         // add r0, r21
+        0x2560,         // eor r22, r0
+        0x9566,         // lsr r22
+        0x9209,         // st Y+, r0
+        0x836a,         // std Y+2, r22
+        0x817a,         // ldd r23, Y+2
+        0x1376,         // cpse r23, r22
+        0x9370, 0x0200, // sts 0x200, r23 (always skipped)
+        0xfd60,         // sbrc r22, 0
+        0xd006,         // rcall sub
+        0x9553,         // inc r21
+        0x8190,         // ld r25, Z (IO register)
+        0x0f29,         // add r18, r25
+        0xe0b1,         // ldi r27, 0x01
+        0xe0d1,         // ldi r29, 0x01
+        0xcfee,         // rjmp loop
+        0x936f,         // sub: push r22
+        0x2f86,         // mov r24, r22
+        0x9582,         // swap r24
+        0x916f,         // pop r22
+        0x9508          // ret
+    };
+
+    StepDevice *dev = CreateDevice<StepDevice>(reset, sizeof(reset) / sizeof(word));
+    LoadProgram(dev, vect, sizeof(vect) / sizeof(word), TIMER0_OVF_VECT);
+    LoadProgram(dev, prog, sizeof(prog) / sizeof(word), 32);
+    dev->useThreadedCode = threaded;
+    dev->useBlockCache = blockCache;
+    return dev;
+}
+
+TEST( SESSION_THREADED, SAME_STATE )
+{
+    StepDevice *dev[4];
+    for(int i = 0; i < 4; i++) {
+        dev[i] = CreateLoopDevice(i & 1, i & 2);
+        RunDevice(dev[i], 20000 * 100);
+    }
+
+    EXPECT_NE(0, dev[0]->GetCoreReg(20)) << "timer irq not raised" << endl;
+    EXPECT_NE(0, dev[0]->GetCoreReg(24)) << "sub not called" << endl;
+    EXPECT_LT(dev[3]->steps, dev[1]->steps) << "no instructions chained" << endl;
+
+    // all engines give same results on same cycle
+    for(int n = 1; n < 4; n++) {
+        EXPECT_EQ(dev[0]->GetCycleCount(), dev[n]->GetCycleCount()) << "mode " << n << endl;
+        EXPECT_EQ(dev[0]->PC, dev[n]->PC) << "mode " << n << endl;
+        for(int i = 0; i < 32; i++)
+            EXPECT_EQ(dev[0]->GetCoreReg(i), dev[n]->GetCoreReg(i)) << "R" << i << " differs in mode " << n << endl;
+        EXPECT_EQ((int)*dev[0]->status, (int)*dev[n]->status) << "mode " << n << endl;
+        for(unsigned a = 0x100; a < 0x300; a++)
+            EXPECT_EQ((int)dev[0]->GetRWMem(a), (int)dev[n]->GetRWMem(a)) << "RAM " << a << " differs in mode " << n << endl;
+    }
+
+    for(int i = 0; i < 4; i++)
+        delete dev[i];
+}
+
+TEST( SESSION_THREADED, FLASH_WRITE )
+{
+    StepDevice *dev = CreateLoopDevice(true, true);
+    RunDevice(dev, 1000 * 100);
+    unsigned char r21 = dev->GetCoreReg(21);
+
+    // replace "inc r21" in loop by "nop", threaded code must be decoded again
+    const word nop[] = { 0x0000 };
+    LoadProgram(dev, nop, 1, 32 + 31);
+    RunDevice(dev, 1000 * 100);
+    EXPECT_EQ(r21, dev->GetCoreReg(21)) << "old instruction executed after flash write" << endl;
+
+    delete dev;
+}
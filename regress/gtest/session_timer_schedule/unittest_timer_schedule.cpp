@@ -0,0 +1,285 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+#include "gtest.h"
+
+#include "avrdevice.h"
+#include "atmega668base.h"
+#include "atmega8.h"
+#include "hwwado.h"
+#include "systemclock.h"
+
+#include "testdevice.h"
+
+// data addresses of IO registers on atmega48
+#define PORTB  0x25
+#define DDRB   0x24
+#define PIND   0x29
+#define DDRD   0x2a
+#define TIFR0  0x35
+#define TIFR1  0x36
+#define GTCCR  0x43
+#define TCCR0A 0x44
+#define TCCR0B 0x45
+#define TCNT0  0x46
+#define OCR0A  0x47
+#define SMCR   0x53
+#define TIMSK0 0x6e
+#define TIMSK1 0x6f
+#define TCCR1A 0x80
+#define TCCR1B 0x81
+#define TCNT1L 0x84
+#define TCNT1H 0x85
+#define ICR1L  0x86
+#define ICR1H  0x87
+#define OCR1AL 0x88
+#define OCR1AH 0x89
+
+// device, which gives access to it's timers
+class TimerDevice: public AvrDevice_atmega48 {
+    public:
+        Hardware *Timer0(void) { return timer0; }
+        Hardware *Timer1(void) { return timer1; }
+};
+
+// Creates a atmega48, irq handlers for TIMER1_OVF, TIMER0_COMPA and
+// TIMER0_OVF count r21, r22 and r20. Main sets stack, enables irqs and runs
+// a busy loop or sleeps.
+static TimerDevice *CreateTimerDevice(bool hwSchedule, bool sleep) {
+    const word reset[] = {
+        0xc02f          // rjmp main (word 48)
+    };
+    const word vect[] = {
+        0xc032,         // 13: TIMER1_OVF: rjmp 64
+        0xc033,         // 14: TIMER0_COMPA: rjmp 66
+        0x0000,         // 15
+        0xc033          // 16: TIMER0_OVF: rjmp 68
+    };
+    const word handler[] = {
+        0x9553,         // 64: inc r21
+        0x9518,         // reti
+        0x9563,         // 66: inc r22
+        0x9518,         // reti
+        0x9543,         // 68: inc r20
+        0x9518          // reti
+    };
+    word prog[] = {
+        0xef1f,         // ldi r17, 0xff
+        0xbf1d,         // out SPL, r17
+        0xe012,         // ldi r17, 0x02
+        0xbf1e,         // out SPH, r17
+        0x9478,         // sei
+        0x9573,         // loop: inc r23
+        0xcffe          // rjmp loop
+    };
+    if(sleep)
+        prog[5] = 0x9588; // sleep instead of inc r23
+
+    TimerDevice *dev = CreateDevice<TimerDevice>(reset, sizeof(reset) / sizeof(word));
+    LoadProgram(dev, vect, sizeof(vect) / sizeof(word), 13);
+    LoadProgram(dev, handler, sizeof(handler) / sizeof(word), 64);
+    LoadProgram(dev, prog, sizeof(prog) / sizeof(word), 48);
+    dev->useHardwareSchedule = hwSchedule;
+    dev->SetRWMem(SMCR, 0x01);
+    return dev;
+}
+
+// Sets a IO register on both devices
+static void SetBoth(AvrDevice *dev1, AvrDevice *dev2, unsigned addr, unsigned char val) {
+    dev1->SetRWMem(addr, val);
+    dev2->SetRWMem(addr, val);
+}
+
+// Returns core and timer state as seen by the program
+static vector<unsigned> GetState(AvrDevice *dev) {
+    vector<unsigned> s;
+    s.push_back((unsigned)dev->GetCycleCount());
+    s.push_back(dev->PC);
+    for(int r = 20; r <= 23; r++)
+        s.push_back(dev->GetCoreReg(r));
+    const unsigned regs[] = { PIND, TIFR0, TIFR1, TCNT0, TCNT1L, TCNT1H, ICR1L, ICR1H };
+    for(size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++)
+        s.push_back(dev->GetRWMem(regs[i]));
+    return s;
+}
+
+static bool InCycleList(AvrDevice *dev, Hardware *hw) {
+    return find(dev->hwCycleList.begin(), dev->hwCycleList.end(), hw) != dev->hwCycleList.end();
+}
+
+// Runs both devices for the same irregular time steps, state must be the same
+// after each step. Returns count of steps, on which timer of dev2 was out of
+// cycle list. Every 50th step changeFunc is called for both devices.
+static int CompareRuns(TimerDevice *dev1, TimerDevice *dev2, Hardware *(TimerDevice::*timer)(void),
+                       void (*changeFunc)(AvrDevice *, AvrDevice *, int)) {
+    int scheduled = 0;
+    for(int i = 0; i < 400; i++) {
+        SystemClockOffset t = ((i * 379) % 1500 + 1) * 100;
+        RunDevice(dev1, t);
+        RunDevice(dev2, t);
+        if(!InCycleList(dev2, (dev2->*timer)()))
+            scheduled++;
+        vector<unsigned> s1 = GetState(dev1), s2 = GetState(dev2);
+        EXPECT_EQ(s1, s2) << "state differs after step " << i << endl;
+        if(s1 != s2)
+            break;
+        if(changeFunc != NULL && i % 50 == 49)
+            changeFunc(dev1, dev2, i / 50);
+    }
+    return scheduled;
+}
+
+TEST( SESSION_TIMER_SCHEDULE, CTC_AND_NORMAL )
+{
+    TimerDevice *dev1 = CreateTimerDevice(false, false);
+    TimerDevice *dev2 = CreateTimerDevice(true, false);
+
+    // timer 0: CTC, TOP 99, clk/8, toggle OC0A, compare irq
+    SetBoth(dev1, dev2, DDRD, 0x40);
+    SetBoth(dev1, dev2, OCR0A, 99);
+    SetBoth(dev1, dev2, TCCR0A, 0x42);
+    SetBoth(dev1, dev2, TIMSK0, 0x02);
+    SetBoth(dev1, dev2, TCCR0B, 0x02);
+    // timer 1: normal mode from 0xff00, clk/1, overflow irq
+    SetBoth(dev1, dev2, TCNT1H, 0xff);
+    SetBoth(dev1, dev2, TCNT1L, 0x00);
+    SetBoth(dev1, dev2, TIMSK1, 0x01);
+    SetBoth(dev1, dev2, TCCR1B, 0x01);
+
+    EXPECT_GT(CompareRuns(dev1, dev2, &TimerDevice::Timer0, NULL), 0) << "timer was not scheduled" << endl;
+    EXPECT_NE(0, dev2->GetCoreReg(21)) << "no timer 1 overflow irq" << endl;
+    EXPECT_NE(0, dev2->GetCoreReg(22)) << "no timer 0 compare irq" << endl;
+
+    delete dev1;
+    delete dev2;
+}
+
+TEST( SESSION_TIMER_SCHEDULE, PWM_SLEEP )
+{
+    TimerDevice *dev1 = CreateTimerDevice(false, true);
+    TimerDevice *dev2 = CreateTimerDevice(true, true);
+
+    // timer 0: phase correct pwm, OC0A 0x40, clk/64, overflow irq
+    SetBoth(dev1, dev2, DDRD, 0x40);
+    SetBoth(dev1, dev2, OCR0A, 0x40);
+    SetBoth(dev1, dev2, TCCR0A, 0x81);
+    SetBoth(dev1, dev2, TIMSK0, 0x01);
+    SetBoth(dev1, dev2, TCCR0B, 0x03);
+    // timer 1: fast pwm 8 bit, clk/8
+    SetBoth(dev1, dev2, OCR1AH, 0x00);
+    SetBoth(dev1, dev2, OCR1AL, 0x80);
+    SetBoth(dev1, dev2, TCCR1A, 0x81);
+    SetBoth(dev1, dev2, TCCR1B, 0x0a);
+
+    EXPECT_GT(CompareRuns(dev1, dev2, &TimerDevice::Timer0, NULL), 0) << "timer was not scheduled" << endl;
+    EXPECT_NE(0, dev2->GetCoreReg(20)) << "no timer 0 overflow irq" << endl;
+
+    delete dev1;
+    delete dev2;
+}
+
+// Changes counter, compare value and prescaler phase on a running timer
+static void ChangeTimer(AvrDevice *dev1, AvrDevice *dev2, int n) {
+    switch(n % 3) {
+        case 0:
+            SetBoth(dev1, dev2, TCNT0, 200);
+            break;
+        case 1:
+            SetBoth(dev1, dev2, OCR0A, 20 + n);
+            break;
+        case 2:
+            SetBoth(dev1, dev2, GTCCR, 0x01);
+            break;
+    }
+}
+
+TEST( SESSION_TIMER_SCHEDULE, CHANGE_RUNNING_TIMER )
+{
+    TimerDevice *dev1 = CreateTimerDevice(false, true);
+    TimerDevice *dev2 = CreateTimerDevice(true, true);
+
+    // timer 0: normal mode, clk/256, compare and overflow irq
+    SetBoth(dev1, dev2, OCR0A, 10);
+    SetBoth(dev1, dev2, TIMSK0, 0x03);
+    SetBoth(dev1, dev2, TCCR0B, 0x04);
+
+    EXPECT_GT(CompareRuns(dev1, dev2, &TimerDevice::Timer0, ChangeTimer), 0) << "timer was not scheduled" << endl;
+
+    delete dev1;
+    delete dev2;
+}
+
+// Toggles input capture pin ICP1
+static void ToggleCapturePin(AvrDevice *dev1, AvrDevice *dev2, int n) {
+    SetBoth(dev1, dev2, PORTB, n & 1);
+}
+
+TEST( SESSION_TIMER_SCHEDULE, INPUT_CAPTURE )
+{
+    TimerDevice *dev1 = CreateTimerDevice(false, false);
+    TimerDevice *dev2 = CreateTimerDevice(true, false);
+
+    // timer 1: normal mode, clk/1, capture on falling edge with noise canceler
+    SetBoth(dev1, dev2, DDRB, 0x01);
+    SetBoth(dev1, dev2, PORTB, 0x01);
+    SetBoth(dev1, dev2, TCCR1B, 0x81);
+
+    EXPECT_GT(CompareRuns(dev1, dev2, &TimerDevice::Timer1, ToggleCapturePin), 0) << "timer was not scheduled" << endl;
+    EXPECT_NE(0, dev2->GetRWMem(TIFR1) & 0x20) << "no capture event" << endl;
+
+    delete dev1;
+    delete dev2;
+}
+
+// Runs device alone on a continuous clock (watchdog timeout is absolute time)
+// and returns the core state after each step
+static vector<unsigned> RunWatchdog(AvrDevice *dev, int *scheduled) {
+    vector<unsigned> s;
+    *scheduled = 0;
+    SystemClock::Instance().ResetClock();
+    SystemClock::Instance().Add(dev);
+    for(int i = 0; i < 600; i++) {
+        SystemClock::Instance().RunTimeRange(((i * 379) % 1500 + 1) * 1000);
+        if(!InCycleList(dev, dev->wado))
+            (*scheduled)++;
+        s.push_back((unsigned)dev->GetCycleCount());
+        s.push_back(dev->PC);
+        s.push_back(dev->GetCoreReg(23));
+        s.push_back(dev->GetCoreReg(24));
+    }
+    SystemClock::Instance().ResetClock();
+    return s;
+}
+
+TEST( SESSION_TIMER_SCHEDULE, WATCHDOG )
+{
+    // count resets in r24, WDR, enable watchdog with 47ms timeout, loop: count r23
+    const word prog[] = {
+        0x9583,         // inc r24
+        0x95a8,         // wdr
+        0xe008,         // ldi r16, 0x08
+        0xbd01,         // out WDTCR, r16
+        0x9573,         // loop: inc r23
+        0xcffe          // rjmp loop
+    };
+    AvrDevice *dev1 = CreateDevice<AvrDevice_atmega8>(prog, sizeof(prog) / sizeof(word));
+    AvrDevice *dev2 = CreateDevice<AvrDevice_atmega8>(prog, sizeof(prog) / sizeof(word));
+    dev1->useHardwareSchedule = false;
+    dev1->SetCoreReg(24, 0);
+    dev2->SetCoreReg(24, 0);
+
+    int scheduled1, scheduled2;
+    vector<unsigned> s1 = RunWatchdog(dev1, &scheduled1);
+    vector<unsigned> s2 = RunWatchdog(dev2, &scheduled2);
+    EXPECT_EQ(s1, s2);
+    // about 450ms run time, reset every 47ms
+    EXPECT_EQ(10, dev2->GetCoreReg(24)) << "watchdog resets missing" << endl;
+    EXPECT_EQ(0, scheduled1);
+    EXPECT_GT(scheduled2, 0) << "watchdog was not scheduled" << endl;
+
+    delete dev1;
+    delete dev2;
+}
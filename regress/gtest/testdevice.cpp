@@ -0,0 +1,23 @@
+#include <vector>
+
+#include "testdevice.h"
+#include "avrdevice.h"
+#include "systemclock.h"
+#include "flash.h"
+
+void LoadProgram(AvrDevice *dev, const word *prog, size_t words, unsigned int wordAddr) {
+    // flash takes the bytes as in a file, low byte first
+    std::vector<unsigned char> buf(words * 2);
+    for(size_t i = 0; i < words; i++) {
+        buf[2 * i] = prog[i] & 0xff;
+        buf[2 * i + 1] = prog[i] >> 8;
+    }
+    dev->Flash->WriteMem(&buf[0], wordAddr * 2, buf.size());
+}
+
+void RunDevice(AvrDevice *dev, SystemClockOffset time) {
+    SystemClock::Instance().ResetClock();
+    SystemClock::Instance().Add(dev);
+    SystemClock::Instance().RunTimeRange(time);
+    SystemClock::Instance().ResetClock();
+}
@@ -0,0 +1,26 @@
+#ifndef TESTDEVICE_H
+#define TESTDEVICE_H
+
+#include <stddef.h>
+
+#include "types.h"
+#include "systemclocktypes.h"
+
+class AvrDevice;
+
+//! Writes a program of opcode words (as in a listing) to flash, starting on word address wordAddr
+void LoadProgram(AvrDevice *dev, const word *prog, size_t words, unsigned int wordAddr = 0);
+
+//! Runs simulation with dev as only member for time ns, SystemClock is reset before and after
+void RunDevice(AvrDevice *dev, SystemClockOffset time);
+
+//! Creates a device of type T with 100ns clock period and prog on word address 0
+template<class T>
+T *CreateDevice(const word *prog, size_t words) {
+    T *dev = new T;
+    dev->SetClockFreq(100);
+    LoadProgram(dev, prog, words);
+    return dev;
+}
+
+#endif
@@ -0,0 +1,71 @@
+from simtestutil import PyTestCase, PyTestLoader
+import pysimulavr
+
+class TestCase(PyTestCase):
+
+  """
+  This tests check the breakpoint list of a device (BP), which is used by
+  gdb server and python scripts. Breakpoints are counted in a array by word
+  address, so the list and the array must not differ after add and remove.
+  """
+
+  def setUp(self):
+    pysimulavr.cvar.sysConHandler.SetUseExit(False)
+    self.dev = pysimulavr.AvrFactory.instance().makeDevice("atmega128")
+    self.bp = self.dev.BP
+
+  def tearDown(self):
+    del self.dev
+
+  def test_00(self):
+    """add and remove a breakpoint"""
+    self.assertFalse(self.bp.IsSet(0x100), "no breakpoint at start")
+    self.bp.AddBreakpoint(0x100)
+    self.assertTrue(self.bp.IsSet(0x100), "breakpoint is set")
+    self.assertFalse(self.bp.IsSet(0xff), "neighbour below isn't set")
+    self.assertFalse(self.bp.IsSet(0x101), "neighbour above isn't set")
+    self.assertFalse(self.bp.IsSet(0x10000), "address behind array isn't set")
+    self.assertEqual(len(self.bp.GetAddresses()), 1, "one breakpoint in list")
+    self.bp.RemoveBreakpoint(0x100)
+    self.assertFalse(self.bp.IsSet(0x100), "breakpoint is removed")
+    self.assertEqual(len(self.bp.GetAddresses()), 0, "list is empty")
+
+  def test_01(self):
+    """a address added twice needs two removes"""
+    self.bp.AddBreakpoint(0x20)
+    self.bp.AddBreakpoint(0x20)
+    self.bp.RemoveBreakpoint(0x20)
+    self.assertTrue(self.bp.IsSet(0x20), "second breakpoint is left")
+    self.bp.RemoveBreakpoint(0x20)
+    self.assertFalse(self.bp.IsSet(0x20), "both breakpoints are removed")
+    self.bp.RemoveBreakpoint(0x20)
+    self.assertFalse(self.bp.IsSet(0x20), "remove without breakpoint does nothing")
+
+  def test_02(self):
+    """range check"""
+    self.bp.AddBreakpoint(0x40)
+    self.assertTrue(self.bp.IsSetInRange(0x30, 0x41), "breakpoint in range")
+    self.assertFalse(self.bp.IsSetInRange(0x30, 0x40), "end of range is excluded")
+    self.assertFalse(self.bp.IsSetInRange(0x41, 0x1000), "breakpoint before range")
+    self.bp.Clear()
+    self.assertFalse(self.bp.IsSetInRange(0, 0x1000), "all breakpoints removed")
+
+  def test_03(self):
+    """ignore count and hit count"""
+    self.bp.AddBreakpoint(0x10)
+    self.bp.SetIgnoreCount(0x10, 2)
+    self.assertFalse(self.bp.Hit(0x10, self.dev), "first hit is ignored")
+    self.assertFalse(self.bp.Hit(0x10, self.dev), "second hit is ignored")
+    self.assertTrue(self.bp.Hit(0x10, self.dev), "third hit stops")
+    self.assertEqual(self.bp.GetHitCount(0x10), 3, "all hits are counted")
+    self.bp.RemoveBreakpoint(0x10)
+    self.bp.AddBreakpoint(0x10)
+    self.assertEqual(self.bp.GetHitCount(0x10), 0, "counts are removed with breakpoint")
+
+if __name__ == '__main__':
+
+  from unittest import TextTestRunner
+  tests = PyTestLoader("breakpoint").loadTestsFromTestCase(TestCase)
+  TextTestRunner(verbosity = 2).run(tests)
+
+# EOF
@@ -0,0 +1,80 @@
+#! /usr/bin/env python
+###############################################################################
+#
+# simulavr - A simulator for the Atmel AVR family of microcontrollers.
+# Copyright (C) 2001, 2002  Theodore A. Roth
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+###############################################################################
+#
+# $Id$
+#
+
+"""Test the binary memory write (X packet).
+"""
+
+import base_test
+from registers import Reg
+
+class Binary_TestFail(base_test.TestFail): pass
+
+class binary_test(base_test.opcode_test):
+	"""Base class for X packet tests.
+	"""
+	addr = 0x100
+
+	def packet(self, pkt):
+		self.target.send(pkt)
+		return self.target.recv()
+
+	def write(self, _len, data):
+		return self.packet('X%x,%x:' % (self.target.offset_sram + self.addr, _len) + data)
+
+	def check(self, expect):
+		got = self.target.read_sram(self.addr, len(expect)).tostring()
+		if got != expect:
+			raise Binary_TestFail, 'memory expect %r, got %r' % (expect, got)
+
+class test_X_write(binary_test):
+	"""Writes binary data with a escaped byte and a 0 byte
+	"""
+	def run(self):
+		reply = self.write(4, 'a\x00}\x5dz')
+		if reply != 'OK':
+			raise Binary_TestFail, 'reply "%s"' % reply
+		self.check('a\x00}z')
+
+class test_X_short(binary_test):
+	"""A packet with less data than given length is rejected
+	"""
+	def run(self):
+		self.write(3, 'abc')
+		reply = self.write(8, 'xyz')
+		if reply != 'E01':
+			raise Binary_TestFail, 'short packet not rejected: "%s"' % reply
+		# escape char at end of packet
+		reply = self.write(2, 'x}')
+		if reply != 'E01':
+			raise Binary_TestFail, 'short packet not rejected: "%s"' % reply
+		self.check('abc')
+
+class test_X_negative(binary_test):
+	"""A negative length is rejected
+	"""
+	def run(self):
+		reply = self.write(0xffffffff, 'abc')
+		if reply != 'E01':
+			raise Binary_TestFail, 'negative length not rejected: "%s"' % reply
@@ -0,0 +1,89 @@
+#! /usr/bin/env python
+###############################################################################
+#
+# simulavr - A simulator for the Atmel AVR family of microcontrollers.
+# Copyright (C) 2001, 2002  Theodore A. Roth
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+###############################################################################
+#
+# $Id$
+#
+
+"""Test conditional breakpoints (Z0 packet with condition).
+"""
+
+import array, struct
+import base_test
+from registers import Reg
+
+class Break_TestFail(base_test.TestFail): pass
+
+# ldi r16,1; inc r16; inc r16; inc r16; rjmp .-8 (back to first inc)
+prog = (0xe001, 0x9503, 0x9503, 0x9503, 0xcffc)
+
+class break_test(base_test.opcode_test):
+	"""Base class for breakpoint tests, loads prog on address 0.
+	"""
+	def packet(self, pkt):
+		self.target.send(pkt)
+		return self.target.recv()
+
+	def load_prog(self):
+		buf = array.array('B', struct.pack('<%dH' % len(prog), *prog))
+		self.target.write_flash(0, len(buf), buf)
+		self.target.write_reg(Reg.R16, 0)
+		self.target.write_reg(Reg.PC, 0)
+
+	def check(self, pc, r16):
+		regs = self.target.read_regs()
+		if regs[Reg.PC] != pc or regs[Reg.R16] != r16:
+			raise Break_TestFail, 'expect PC=%x, r16=%d, got PC=%x, r16=%d' % \
+				(pc, r16, regs[Reg.PC], regs[Reg.R16])
+
+class test_break_condition(break_test):
+	"""Breakpoint with condition r16 == 8 stops in third loop pass, a insert
+	with new condition replaces the old one
+	"""
+	def run(self):
+		self.load_prog()
+		# reg 16, const8 5, equal, end
+		reply = self.packet('Z0,4,2;X8,2600102205' + '1327')
+		if reply != 'OK':
+			raise Break_TestFail, 'insert reply "%s"' % reply
+		reply = self.packet('Z0,4,2;X8,2600102208' + '1327')
+		if reply != 'OK':
+			raise Break_TestFail, 'insert reply "%s"' % reply
+		self.target.cont()
+		self.check(4, 8)
+		self.target.break_remove(0, 4, 2)
+
+class test_break_remove(break_test):
+	"""Breakpoint inserted twice is set once, like gdb expects it
+	"""
+	def run(self):
+		self.load_prog()
+		self.target.break_insert(0, 6, 2)
+		self.target.break_insert(0, 6, 2)
+		self.target.cont()
+		self.check(6, 3)
+		self.target.break_remove(0, 6, 2)
+		# stop on the other breakpoint only
+		self.target.break_insert(0, 2, 2)
+		self.target.step()
+		self.target.cont()
+		self.check(2, 4)
+		self.target.break_remove(0, 2, 2)
@@ -0,0 +1,134 @@
+#! /usr/bin/env python
+###############################################################################
+#
+# simulavr - A simulator for the Atmel AVR family of microcontrollers.
+# Copyright (C) 2001, 2002  Theodore A. Roth
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+###############################################################################
+#
+# $Id$
+#
+
+"""Test reverse step and reverse continue (bs and bc packets).
+
+The reverse tests need a simulator with execution history (regress.py
+--history=<cycles>), without history the simulator must not announce reverse
+execution and must answer bs and bc with a empty reply.
+"""
+
+import array, struct
+import base_test
+from registers import Reg
+
+class Reverse_TestFail(base_test.TestFail): pass
+
+# ldi r16,1; inc r16; inc r16; inc r16; rjmp .-8 (back to first inc)
+prog = (0xe001, 0x9503, 0x9503, 0x9503, 0xcffc)
+
+class reverse_test(base_test.opcode_test):
+	"""Base class for reverse execution tests, loads prog on address 0.
+	"""
+	def packet(self, pkt):
+		self.target.send(pkt)
+		return self.target.recv()
+
+	def has_history(self):
+		reply = self.packet('qSupported')
+		return reply.find('ReverseStep+') >= 0
+
+	def load_prog(self):
+		buf = array.array('B', struct.pack('<%dH' % len(prog), *prog))
+		self.target.write_flash(0, len(buf), buf)
+		self.target.write_reg(Reg.R16, 0)
+		self.target.write_reg(Reg.PC, 0)
+
+	def check(self, pc, r16):
+		regs = self.target.read_regs()
+		if regs[Reg.PC] != pc or regs[Reg.R16] != r16:
+			raise Reverse_TestFail, 'expect PC=%x, r16=%d, got PC=%x, r16=%d' % \
+				(pc, r16, regs[Reg.PC], regs[Reg.R16])
+
+	def stop_reply(self, reply):
+		if reply[:3] != 'T05' and reply[:3] != 'S05':
+			raise Reverse_TestFail, 'bad stop reply "%s"' % reply
+
+class test_qSupported(reverse_test):
+	"""qSupported has to announce all features, reverse execution last
+	"""
+	def run(self):
+		reply = self.packet('qSupported')
+		for feature in ('PacketSize=', 'qXfer:features:read+',
+						'qXfer:memory-map:read+', 'ConditionalBreakpoints+'):
+			if reply.find(feature) < 0:
+				raise Reverse_TestFail, 'feature %s missing in "%s"' % (feature, reply)
+		if reply.find('ReverseStep') >= 0 and reply[-30:] != ';ReverseStep+;ReverseContinue+':
+			raise Reverse_TestFail, 'reverse execution truncated in "%s"' % reply
+
+class test_reverse_step(reverse_test):
+	"""Steps forward, back with bs and forward again
+	"""
+	def run(self):
+		if not self.has_history():
+			if self.packet('bs') != '':
+				raise Reverse_TestFail, 'bs without history not rejected'
+			return
+		self.load_prog()
+		for i in range(4):
+			self.target.step()
+		self.check(8, 4)
+		self.stop_reply(self.packet('bs'))
+		self.check(6, 3)
+		self.stop_reply(self.packet('bs'))
+		self.check(4, 2)
+		# forward again, this is replayed
+		self.target.step()
+		self.check(6, 3)
+		self.target.step()
+		self.check(8, 4)
+		# back to the first instruction
+		for i in range(4):
+			self.stop_reply(self.packet('bs'))
+		self.check(0, 0)
+
+class test_reverse_continue(reverse_test):
+	"""Runs forward to a breakpoint and back to a other one with bc
+	"""
+	def run(self):
+		if not self.has_history():
+			if self.packet('bc') != '':
+				raise Reverse_TestFail, 'bc without history not rejected'
+			return
+		self.load_prog()
+		self.target.break_insert(0, 8, 2)
+		self.stop_reply(self.target.cont())
+		self.check(8, 4)
+		self.target.break_remove(0, 8, 2)
+		self.target.break_insert(0, 6, 2)
+		self.stop_reply(self.target.cont())
+		self.check(6, 6)
+		self.target.break_remove(0, 6, 2)
+		# the last time on PC 4 was in second loop pass
+		self.target.break_insert(0, 4, 2)
+		self.stop_reply(self.packet('bc'))
+		self.check(4, 5)
+		self.stop_reply(self.packet('bc'))
+		self.check(4, 2)
+		self.target.break_remove(0, 4, 2)
+		# without breakpoint bc goes to start of history
+		reply = self.packet('bc')
+		if reply.find('replaylog:begin') < 0:
+			raise Reverse_TestFail, 'start of history not reported: "%s"' % reply
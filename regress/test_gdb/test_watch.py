@@ -0,0 +1,102 @@
+#! /usr/bin/env python
+###############################################################################
+#
+# simulavr - A simulator for the Atmel AVR family of microcontrollers.
+# Copyright (C) 2001, 2002  Theodore A. Roth
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+###############################################################################
+#
+# $Id$
+#
+
+"""Test data watchpoints (Z2, Z3 and Z4 packets).
+"""
+
+import array, struct
+import base_test
+from registers import Reg
+
+class Watch_TestFail(base_test.TestFail): pass
+
+# ldi r16,1; inc r16; sts 0x100,r16; lds r17,0x100; rjmp .-12 (back to inc)
+prog = (0xe001, 0x9503, 0x9300, 0x0100, 0x9110, 0x0100, 0xcffa)
+
+class watch_test(base_test.opcode_test):
+	"""Base class for watchpoint tests, loads prog on address 0.
+	"""
+	addr = 0x800100
+
+	def load_prog(self):
+		buf = array.array('B', struct.pack('<%dH' % len(prog), *prog))
+		self.target.write_flash(0, len(buf), buf)
+		self.target.write_reg(Reg.R16, 0)
+		self.target.write_reg(Reg.R17, 0)
+		self.target.write_reg(Reg.PC, 0)
+
+	def check(self, reply, reason, pc, r16, r17):
+		if reply.find('%s:%x;' % (reason, self.addr)) < 0:
+			raise Watch_TestFail, 'expect %s in stop reply "%s"' % (reason, reply)
+		regs = self.target.read_regs()
+		if regs[Reg.PC] != pc or regs[Reg.R16] != r16 or regs[Reg.R17] != r17:
+			raise Watch_TestFail, 'expect PC=%x, r16=%d, r17=%d, got PC=%x, r16=%d, r17=%d' % \
+				(pc, r16, r17, regs[Reg.PC], regs[Reg.R16], regs[Reg.R17])
+
+class test_watch_write(watch_test):
+	"""Write watchpoint stops after the store
+	"""
+	def run(self):
+		self.load_prog()
+		self.target.break_insert(2, self.addr, 1)
+		self.check(self.target.cont(), 'watch', 8, 2, 0)
+		self.check(self.target.cont(), 'watch', 8, 3, 2)
+		self.target.break_remove(2, self.addr, 1)
+
+class test_watch_read(watch_test):
+	"""Read watchpoint stops after the load
+	"""
+	def run(self):
+		self.load_prog()
+		self.target.break_insert(3, self.addr, 1)
+		self.check(self.target.cont(), 'rwatch', 12, 2, 2)
+		self.target.break_remove(3, self.addr, 1)
+
+class test_watch_access(watch_test):
+	"""Access watchpoint stops after store and load
+	"""
+	def run(self):
+		self.load_prog()
+		self.target.break_insert(4, self.addr, 1)
+		self.check(self.target.cont(), 'awatch', 8, 2, 0)
+		self.check(self.target.cont(), 'awatch', 12, 2, 2)
+		self.target.break_remove(4, self.addr, 1)
+
+class test_watch_range(watch_test):
+	"""Watchpoint on other cells doesn't stop, a watchpoint on flash is rejected
+	"""
+	def run(self):
+		self.load_prog()
+		self.target.send('Z2,0,1')
+		reply = self.target.recv()
+		if reply != 'E01':
+			raise Watch_TestFail, 'watchpoint on flash not rejected: "%s"' % reply
+		self.target.break_insert(2, self.addr + 1, 1)
+		self.target.break_insert(0, 12, 2)
+		reply = self.target.cont()
+		if reply.find('watch') >= 0:
+			raise Watch_TestFail, 'stop on not watched cell: "%s"' % reply
+		self.target.break_remove(0, 12, 2)
+		self.target.break_remove(2, self.addr + 1, 1)
@@ -25,11 +25,11 @@
 
 #include "application.h"
 #include "printable.h"
+#include "simulationcontext.h"
 using namespace std;
 
 Application* Application::GetInstance() {
-    static Application instance;
-    return &instance;
+    return SimulationContext::Current()->GetApplication();
 }
 
 void Application::RegisterPrintable(Printable *p) {
@@ -35,9 +35,11 @@ class Application {
         std::vector <Printable*> printable;
 
     private:
-        Application() {} // no way to create an object
+        friend class SimulationContext;
+        Application() {} // no way to create an object, see SimulationContext
 
     public:
+        //! Returns the Application instance of the current SimulationContext
         static Application* GetInstance();
         void RegisterPrintable(Printable *x);
         void PrintResults();
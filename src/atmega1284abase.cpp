@@ -65,6 +65,7 @@ AvrDevice_atmega1284Abase::~AvrDevice_atmega1284Abase() {
     delete pcmsk1_reg;
     delete pcmsk0_reg;
     delete pcifr_reg;
+    delete smcr_reg;
     delete pcicr_reg;
     delete extirq012;
     delete eifr_reg;
@@ -115,6 +116,8 @@ AvrDevice_atmega1284Abase::AvrDevice_atmega1284Abase(unsigned ram_bytes,
 
     pcicr_reg = new IOSpecialReg(&coreTraceGroup, "PCICR");
     pcifr_reg = new IOSpecialReg(&coreTraceGroup, "PCIFR");
+    smcr_reg = new IOSpecialReg(&coreTraceGroup, "SMCR");
+    SetSleepEnableBit(smcr_reg, 0);
     pcmsk0_reg = new IOSpecialReg(&coreTraceGroup, "PCMSK0");
     pcmsk1_reg = new IOSpecialReg(&coreTraceGroup, "PCMSK1");
     pcmsk2_reg = new IOSpecialReg(&coreTraceGroup, "PCMSK2");
@@ -298,7 +301,7 @@ AvrDevice_atmega1284Abase::AvrDevice_atmega1284Abase(unsigned ram_bytes,
     // 0x56 reserved
     rw[0x55]= new NotSimulatedRegister("MCU register MCUCR not simulated");
     rw[0x54]= new NotSimulatedRegister("MCU register MCUSR not simulated");
-    rw[0x53]= new NotSimulatedRegister("MCU register SMCR not simulated");
+    rw[0x53]= smcr_reg;
     // 0x52 reserved
     rw[0x51]= new NotSimulatedRegister("On-chip debug register OCDR not simulated");
     rw[0x50]= & acomp->acsr_reg;
@@ -113,6 +113,7 @@ AvrDevice_atmega16_32::AvrDevice_atmega16_32(unsigned ram_bytes,
     gicr_reg = new IOSpecialReg(&coreTraceGroup, "GICR");
     gifr_reg = new IOSpecialReg(&coreTraceGroup, "GIFR");
     mcucr_reg = new IOSpecialReg(&coreTraceGroup, "MCUCR");
+    SetSleepEnableBit(mcucr_reg, 7);
     mcucsr_reg = new IOSpecialReg(&coreTraceGroup, "MCUCSR");
     extirq = new ExternalIRQHandler(this, irqSystem, gicr_reg, gifr_reg);
     extirq->registerIrq(1, 6, new ExternalIRQSingle(mcucr_reg, 0, 2, GetPin("D2")));  // INT0
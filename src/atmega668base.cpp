@@ -58,6 +58,7 @@ AvrDevice_atmega668base::~AvrDevice_atmega668base() {
     delete pcmsk1_reg;
     delete pcmsk0_reg;
     delete pcifr_reg;
+    delete smcr_reg;
     delete pcicr_reg;
     delete extirq01;
     delete eifr_reg;
@@ -117,6 +118,8 @@ AvrDevice_atmega668base::AvrDevice_atmega668base(unsigned ram_bytes,
 
     pcicr_reg = new IOSpecialReg(&coreTraceGroup, "PCICR");
     pcifr_reg = new IOSpecialReg(&coreTraceGroup, "PCIFR");
+    smcr_reg = new IOSpecialReg(&coreTraceGroup, "SMCR");
+    SetSleepEnableBit(smcr_reg, 0);
     pcmsk0_reg = new IOSpecialReg(&coreTraceGroup, "PCMSK0");
     pcmsk1_reg = new IOSpecialReg(&coreTraceGroup, "PCMSK1");
     pcmsk2_reg = new IOSpecialReg(&coreTraceGroup, "PCMSK2");
@@ -284,7 +287,7 @@ AvrDevice_atmega668base::AvrDevice_atmega668base(unsigned ram_bytes,
     // 0x56 reserved
     rw[0x55]= new NotSimulatedRegister("MCU register MCUCR not simulated");
     rw[0x54]= new NotSimulatedRegister("MCU register MCUSR not simulated");
-    rw[0x53]= new NotSimulatedRegister("MCU register SMCR not simulated");
+    rw[0x53]= smcr_reg;
     // 0x52 reserved
     // 0x51 reserved
     rw[0x50]= & acomp->acsr_reg;
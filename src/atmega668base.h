@@ -58,6 +58,7 @@ class AvrDevice_atmega668base: public AvrDevice {
         ExternalIRQHandler* extirqpc;    //!< external interrupt support for PCINT[0-2]
         IOSpecialReg*       pcicr_reg;   //!< PCICR IO register
         IOSpecialReg*       pcifr_reg;   //!< PCIFR IO register
+        IOSpecialReg*       smcr_reg;    //!< SMCR IO register (only sleep enable bit is used)
         IOSpecialReg*       pcmsk0_reg;  //!< PCIMSK0 IO register
         IOSpecialReg*       pcmsk1_reg;  //!< PCIMSK1 IO register
         IOSpecialReg*       pcmsk2_reg;  //!< PCIMSK2 IO register
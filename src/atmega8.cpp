@@ -90,6 +90,7 @@ AvrDevice_atmega8::AvrDevice_atmega8() :
 
     mcucr_reg = new IOSpecialReg(&coreTraceGroup,
             "MCUCR");
+    SetSleepEnableBit(mcucr_reg, 7);
 
     mcucsr_reg = new IOSpecialReg(&coreTraceGroup,
             "MCUCSR");
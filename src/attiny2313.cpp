@@ -95,6 +95,7 @@ AvrDevice_attiny2313::AvrDevice_attiny2313():
     gimsk_reg = new IOSpecialReg(&coreTraceGroup, "GIMSK");
     eifr_reg = new IOSpecialReg(&coreTraceGroup, "EIFR");
     mcucr_reg = new IOSpecialReg(&coreTraceGroup, "MCUCR");
+    SetSleepEnableBit(mcucr_reg, 5);
     pcmsk_reg = new IOSpecialReg(&coreTraceGroup, "PCMSK");
     extirq = new ExternalIRQHandler(this, irqSystem, gimsk_reg, eifr_reg);
     extirq->registerIrq(1, 6, new ExternalIRQSingle(mcucr_reg, 0, 2, GetPin("D2")));
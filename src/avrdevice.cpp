@@ -24,6 +24,7 @@
  */
 
 #include <limits>
+#include <cstring>
 
 #include "avrdevice.h"
 #include "traceval.h"
@@ -33,6 +34,11 @@
 #include "avrerror.h"
 #include "avrmalloc.h"
 #include "avrreadelf.h"
+#include "snapshot.h"
+#include "flash.h"
+#include "flashprog.h"
+#include "hwstack.h"
+#include "hwsreg.h"
 #include <assert.h>
 
 #include "avrdevice_impl.h"
@@ -48,15 +54,58 @@ void AvrDevice::AddToResetList(Hardware *hw) {
 }
 
 void AvrDevice::AddToCycleList(Hardware *hw) {
+    UnscheduleHardware(hw);
     if(find(hwCycleList.begin(), hwCycleList.end(), hw) == hwCycleList.end())
         hwCycleList.push_back(hw);
 }
         
 void AvrDevice::RemoveFromCycleList(Hardware *hw) {
+    UnscheduleHardware(hw);
     vector<Hardware*>::iterator element;
     element=find(hwCycleList.begin(), hwCycleList.end(), hw);
-    if(element != hwCycleList.end())
-        hwCycleList.erase(element);
+    if(element != hwCycleList.end()) {
+        // don't erase here, list could be processed in CycleHardware just now
+        *element = NULL;
+        hwCycleListChanged = true;
+    }
+}
+
+bool AvrDevice::ScheduleHardware(Hardware *hw, unsigned long long cycle) {
+    // dumpers want to see every counter change
+    if(!useHardwareSchedule || dump_manager->IsActive())
+        return false;
+    RemoveFromCycleList(hw);
+    hwScheduleList.push_back(make_pair(hw, cycle));
+    if(cycle < hwWakeCycle)
+        hwWakeCycle = cycle;
+    return true;
+}
+
+void AvrDevice::UnscheduleHardware(Hardware *hw) {
+    for(unsigned i = 0; i < hwScheduleList.size(); i++) {
+        if(hwScheduleList[i].first != hw)
+            continue;
+        hwScheduleList.erase(hwScheduleList.begin() + i);
+        hwWakeCycle = numeric_limits<unsigned long long>::max();
+        for(unsigned j = 0; j < hwScheduleList.size(); j++)
+            hwWakeCycle = min(hwWakeCycle, hwScheduleList[j].second);
+        return;
+    }
+}
+
+void AvrDevice::WakeUpScheduledHardware(void) {
+    // AddToCycleList removes the entry from hwScheduleList
+    for(unsigned i = 0; i < hwScheduleList.size(); ) {
+        if(hwScheduleList[i].second <= cycleCounter)
+            AddToCycleList(hwScheduleList[i].first);
+        else
+            i++;
+    }
+}
+
+void AvrDevice::WakeUpAllHardware(void) {
+    while(!hwScheduleList.empty())
+        AddToCycleList(hwScheduleList[0].first);
 }
 
 void AvrDevice::Load(const char* fname) {
@@ -66,6 +115,8 @@ void AvrDevice::Load(const char* fname) {
 
 void AvrDevice::SetClockFreq(SystemClockOffset nanosec) {
    clockFreq = nanosec;
+   // watchdog has scheduled it's timeout with the old clock
+   WakeUpAllHardware();
 }
 
 SystemClockOffset AvrDevice::GetClockFreq() {
@@ -101,6 +152,9 @@ AvrDevice::~AvrDevice() {
     delete statusRegister;
     delete status;
     delete [] rw;
+    delete [] memValues;
+    delete [] memDirect;
+    delete [] memWatch;
     delete data;
     delete fuses;
     delete lockbits;
@@ -118,6 +172,7 @@ public:
         change(ref->value()*2);
         set_written();
     }
+    virtual bool polled() const { return true; }
 private:
     TraceValue *ref; // Reference value that will be doubled
 };
@@ -132,7 +187,27 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     iRamSize(IRamSize),
     eRamSize(ERamSize),
     devSignature(numeric_limits<unsigned int>::max()),
+    memSize(registerSpaceSize + _ioSpaceSize + IRamSize + ERamSize),
+    memValues(NULL),
+    memDirect(NULL),
+    memWatch(NULL),
+    watchHitType(0),
+    watchHitAddr(0),
+    cycleCounter(0),
+    hwCycleListChanged(false),
+    hwWakeCycle(numeric_limits<unsigned long long>::max()),
+    sleepMode(false),
+    sleepReg(NULL),
+    sleepEnableMask(0),
+    idleLoopValid(false),
+    idleLoopStart(0),
+    idleLoopEnd(0),
+    idleLoopCycle(0),
     abortOnInvalidAccess(false),
+    useBlockCache(false),
+    useThreadedCode(false),
+    useIdleLoopSkip(true),
+    useHardwareSchedule(true),
     coreTraceGroup(this),
     deferIrq(false),
     newIrqPc(0xffffffff),
@@ -157,6 +232,15 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     TraceValue* pc_tracer=trace_direct(&coreTraceGroup, "PC", &cPC);
     coreTraceGroup.RegisterTraceValue(new TwiceTV(coreTraceGroup.GetTraceValuePrefix()+"PCb",  pc_tracer));
     trace_on = 0;
+    clockFreq = 0; // not set, see SetClockFreq
+    binaryTrace = NULL;
+    profiler = NULL;
+    coverage = NULL;
+    history = NULL;
+    binaryTraceIndex = 0;
+    binaryTraceLine = false;
+    binaryTraceSreg = -1;
+    binaryTraceSP = 0;
     
     fuses = new AvrFuses;
     lockbits = new AvrLockBits;
@@ -170,6 +254,15 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     unsigned invalidSize = totalIoSpace - registerSpaceSize - IRamSize - ERamSize; 
     rw = new RWMemoryMember* [totalIoSpace];
     invalidRW = new RWMemoryMember* [invalidSize];
+
+    // value store for registers and RAM cells, IO space is never accessed directly
+    memValues = new unsigned char [memSize];
+    memDirect = new bool [memSize];
+    memWatch = new unsigned char [memSize];
+    for(unsigned idx = 0; idx < memSize; idx++) {
+        memDirect[idx] = false;
+        memWatch[idx] = 0;
+    }
     
     // the status register is generic to all devices
     status = new HWSreg();
@@ -192,7 +285,7 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     unsigned invalidRWOffset = 0;
 
     for(unsigned ii = 0; ii < registerSpaceSize; ii++) {
-        rw[currentOffset] = new RAM(&coreTraceGroup, "r", ii, registerSpaceSize);
+        rw[currentOffset] = new RAM(&coreTraceGroup, "r", ii, registerSpaceSize, &memValues[currentOffset]);
         if(rw[currentOffset] == NULL)
             avr_error("Not enough memory for registers in AvrDevice::AvrDevice");
         currentOffset++;
@@ -214,7 +307,7 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
 
     // create the internal ram handlers 
     for(unsigned ii = 0; ii < IRamSize; ii++ ) {
-        rw[currentOffset] = new RAM(&coreTraceGroup, "IRAM", ii, IRamSize);
+        rw[currentOffset] = new RAM(&coreTraceGroup, "IRAM", ii, IRamSize, &memValues[currentOffset]);
         if(rw[currentOffset] == NULL)
             avr_error("Not enough memory for IRAM in AvrDevice::AvrDevice");
         currentOffset++;
@@ -223,13 +316,14 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     // create the external ram handlers, TODO: make the configuration from
     // mcucr available here
     for(unsigned ii = 0; ii < ERamSize; ii++ ) {
-        rw[currentOffset] = new RAM(&coreTraceGroup, "ERAM", ii, ERamSize);
+        rw[currentOffset] = new RAM(&coreTraceGroup, "ERAM", ii, ERamSize, &memValues[currentOffset]);
         if(rw[currentOffset] == NULL)
             avr_error("Not enough memory for io space in AvrDevice::AvrDevice");
         currentOffset++;
     }
 
     assert(currentOffset<=totalIoSpace);
+    UpdateDirectAccess();
     // fill the rest of the address space with error handlers
     for(; currentOffset < totalIoSpace; currentOffset++, invalidRWOffset++) {
         invalidRW[invalidRWOffset] = new InvalidMem(this, currentOffset);
@@ -239,10 +333,252 @@ AvrDevice::AvrDevice(unsigned int _ioSpaceSize,
     }
 }
 
+bool AvrDevice::CycleHardware(void) {
+    bool hwWait = false;
+    cycleCounter++;
+    if(cycleCounter >= hwWakeCycle)
+        WakeUpScheduledHardware();
+    for(unsigned i = 0; i < hwCycleList.size(); i++) {
+        Hardware * p = hwCycleList[i];
+        if(p != NULL && p->CpuCycle() > 0)
+            hwWait = true;
+    }
+    if(hwCycleListChanged) {
+        hwCycleList.erase(remove(hwCycleList.begin(), hwCycleList.end(), (Hardware *)NULL), hwCycleList.end());
+        hwCycleListChanged = false;
+    }
+    return hwWait;
+}
+
+void AvrDevice::HandleIrq(void) {
+    if(deferIrq && ( newIrqPc != 0xffffffff )) {
+        /* Every IRQ is delayed of one cycle. Normally this happens (see datasheet)
+         * only after a SEI instruction or after a RETI. But because of
+         * "pipelining" (first cycle is fetch instruction, second is processing)
+         * it's never possible to raise an interrupt with a instruction from
+         * inside the controller immediately after fetching (and processing here
+         * in simulavr) this instruction. Only a external source or peripherals
+         * could do that. Hold this in mind, if you try to measure processing time!
+         */
+        deferIrq = false;
+
+        if(trace_on)
+            traceOut << "IRQ DETECTED: VectorAddr: " << newIrqPc ;
+        if(binaryTrace != NULL)
+            TraceBinary(BinaryTrace::REC_IRQ, newIrqPc);
+
+        irqSystem->IrqHandlerStarted(actualIrqVector);    //what vector we raise?
+        Funktor* fkt = new IrqFunktor(irqSystem, &HWIrqSystem::IrqHandlerFinished, actualIrqVector);
+        stack->SetReturnPoint(stack->GetStackPointer(), fkt);
+        stack->PushAddr(PC);
+        if(profiler != NULL)
+            profiler->Interrupt(actualIrqVector, newIrqPc);
+        cpuCycles = 4; //push needs 4 cycles! (on external RAM +2, this is handled from HWExtRam!)
+        status->I = 0; //irq started so remove I-Flag from SREG
+        PC = newIrqPc - 1;   //we add a few lines later 1 so we sub here 1 :-)
+
+    } else if(status->I == 1) {
+        newIrqPc = irqSystem->GetNewPc(actualIrqVector);
+
+        if(newIrqPc != 0xffffffff) {
+           deferIrq = true; // do always one instruction before entering irq vect
+           if(trace_on)
+              traceOut << "IRQ prepared for addr " << hex << newIrqPc << dec << endl;
+           if(binaryTrace != NULL)
+              TraceBinary(BinaryTrace::REC_IRQ_PREPARED, newIrqPc);
+        }
+    }
+}
+
+int AvrDevice::StepBlock(unsigned int blockSize, bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+    SystemClock &clock = SystemClock::Instance();
+    unsigned int blockEnd = PC + blockSize;
+    bool hwWait = false;
+    unsigned long long skippedCycles = 0;
+
+    // same as Step without trace, break- and exitpoint handling (there is
+    // none in this block), but loops over cycles till block is left
+    for(;;) {
+        if(cpuCycles <= 0)
+            cPC = PC;
+
+        hwWait = CycleHardware();
+
+        if(hwWait) {
+            // CPU is hold, continue with normal steps
+        } else if(cpuCycles <= 0) {
+            HandleIrq();
+
+            bool jumpedBack = false;
+            if(cpuCycles <= 0) {
+                if(idleLoopValid && (PC < idleLoopStart || PC > idleLoopEnd))
+                    idleLoopValid = false;
+                if(useThreadedCode) {
+                    unsigned long long chained;
+                    cpuCycles = ExecuteThreaded(this, profiler == NULL && !deferIrq, chained);
+                    if(chained > 0) {
+                        clock.IncrTime(chained * clockFreq);
+                        SkipIdleCycles(chained);
+                    }
+                } else
+                    cpuCycles = (*(Flash->GetInstruction(PC)))(this);
+                // report changes on status
+                statusRegister->trigger_change();
+                jumpedBack = PC < cPC;
+                if(coverage != NULL)
+                    coverage->Executed(cPC, PC + 1);
+            }
+
+            PC++;
+            cpuCycles--;
+
+            if(jumpedBack)
+                skippedCycles = FastForwardIdleLoop();
+        } else
+            cpuCycles--;
+
+        if(profiler != NULL)
+            profiler->Cycle(cPC);
+        dump_manager->cycle();
+
+        if(hwWait || cpuCycles < 0 || skippedCycles > 0)
+            break;
+        // block is left or last instruction jumps back into block
+        if(cpuCycles <= 0 && (PC <= cPC || PC >= blockEnd))
+            break;
+        // next cycle would be behind the next call of a other simulation member
+        if(clock.GetCurrentTime() + clockFreq >= clock.GetNextEventTime())
+            break;
+        clock.IncrTime(clockFreq);
+    }
+
+    *nextStepIn_ns = clockFreq * (1 + skippedCycles);
+    untilCoreStepFinished = !((cpuCycles > 0) || hwWait);
+    return (cpuCycles < 0) ? cpuCycles : 0;
+}
+
+unsigned long long AvrDevice::GetIdleCycles(void) {
+    // dumpers want to see every cycle
+    if(dump_manager->IsActive())
+        return 0;
+
+    // cycles till next event of other simulation members
+    SystemClock &clock = SystemClock::Instance();
+    SystemClockOffset now = clock.GetCurrentTime();
+    SystemClockOffset next = clock.GetNextEventTime();
+    unsigned long long idle = numeric_limits<unsigned long long>::max();
+    if(next != numeric_limits<SystemClockOffset>::max())
+        idle = (next > now) ? (next - now - 1) / clockFreq : 0;
+
+    // cycles, where hardware does nothing than counting
+    for(unsigned i = 0; i < hwCycleList.size() && idle > 0; i++) {
+        if(hwCycleList[i] != NULL)
+            idle = min(idle, hwCycleList[i]->CyclesIdle());
+    }
+    // the cycle, on which scheduled hardware joins cycle list again, isn't idle
+    if(hwWakeCycle != numeric_limits<unsigned long long>::max())
+        idle = (hwWakeCycle > cycleCounter) ? min(idle, hwWakeCycle - cycleCounter - 1) : 0;
+    return idle;
+}
+
+void AvrDevice::SkipIdleCycles(unsigned long long cycles) {
+    for(unsigned i = 0; i < hwCycleList.size(); i++) {
+        if(hwCycleList[i] != NULL)
+            hwCycleList[i]->SkipCycles(cycles);
+    }
+    cycleCounter += cycles;
+}
+
+unsigned long long AvrDevice::FastForwardSleep(void) {
+    // irq is prepared
+    if(deferIrq)
+        return 0;
+
+    unsigned long long skip = GetIdleCycles();
+    // nothing can wake up core, so there is nothing to skip
+    if(skip == 0 || skip == numeric_limits<unsigned long long>::max())
+        return 0;
+
+    SkipIdleCycles(skip);
+    return skip;
+}
+
+unsigned long long AvrDevice::FastForwardIdleLoop(void) {
+    // PC is the jump target now, cPC the jump back instruction
+    unsigned int start = PC;
+    unsigned int end = cPC;
+    // profiler has to see every cycle of the loop
+    if(!useIdleLoopSkip || deferIrq || profiler != NULL || !Flash->IsIdleLoop(start, end) || HasBreakpointInRange(start, end + 1)) {
+        idleLoopValid = false;
+        return 0;
+    }
+
+    unsigned char state[33];
+    for(unsigned int i = 0; i < 32; i++)
+        state[i] = GetCoreReg(i);
+    state[32] = (int)*status;
+
+    if(!idleLoopValid || idleLoopStart != start || idleLoopEnd != end ||
+       memcmp(state, idleLoopState, sizeof(state)) != 0) {
+        // first pass or loop has changed registers, remember state for next pass
+        memcpy(idleLoopState, state, sizeof(state));
+        idleLoopValid = true;
+        idleLoopStart = start;
+        idleLoopEnd = end;
+        idleLoopCycle = cycleCounter;
+        return 0;
+    }
+
+    // last pass hasn't changed anything, so the next passes will do the same,
+    // till a event changes data read by the loop
+    unsigned long long period = cycleCounter - idleLoopCycle;
+    idleLoopCycle = cycleCounter;
+
+    // data read by the loop must not change while skipping (counter registers)
+    for(unsigned int idx = start; idx <= end; ) {
+        DecodedInstruction *instr = Flash->GetInstruction(idx);
+        int addr = instr->GetDataReadAddress(this, idx);
+        idx += instr->IsInstruction2Words() ? 2 : 1;
+        if(addr < (int)registerSpaceSize)
+            continue;
+        // reading UDR, SPDR, ADCL ... changes hardware state, loop must run
+        if(!rw[addr]->IsReadSideEffectFree())
+            return 0;
+        for(unsigned i = 0; i < hwCycleList.size(); i++) {
+            if(hwCycleList[i] != NULL && hwCycleList[i]->IsChangedBySkip(rw[addr]))
+                return 0;
+        }
+        for(unsigned i = 0; i < hwScheduleList.size(); i++) {
+            if(hwScheduleList[i].first->IsChangedBySkip(rw[addr]))
+                return 0;
+        }
+    }
+
+    unsigned long long idle = GetIdleCycles();
+    // nothing can ever change loop result, don't skip
+    if(idle == numeric_limits<unsigned long long>::max())
+        return 0;
+
+    // skip only complete passes of the loop
+    unsigned long long skip = idle - (idle % period);
+    if(skip > 0) {
+        SkipIdleCycles(skip);
+        idleLoopCycle = cycleCounter;
+    }
+    return skip;
+}
+
 // do a single core step, (0)->a real hardware step, (1) until the uC finish the opcode!
 int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+    if(useBlockCache && trace_on == 0 && binaryTrace == NULL && cpuCycles <= 0 && !sleepMode && nextStepIn_ns != NULL) {
+        unsigned int blockSize = Flash->GetBlockSize(PC);
+        if(blockSize != 0 && WP.empty() && !HasBreakpointInRange(PC, PC + blockSize))
+            return StepBlock(blockSize, untilCoreStepFinished, nextStepIn_ns);
+    }
+
     if (cpuCycles<=0)
         cPC=PC;
+    binaryTraceLine = false;
     if(trace_on == 1) {
         traceOut << actualFilename << " ";
         traceOut << HexShort(cPC << 1) << dec << ": ";
@@ -253,22 +589,45 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
             traceOut << " " ;
     }
 
-    bool hwWait = false;
-    for(unsigned i = 0; i < hwCycleList.size(); i++) {
-        Hardware * p = hwCycleList[i];
-        if (p->CpuCycle() > 0)
-            hwWait = true;
-    }
+    bool hwWait = CycleHardware();
+    unsigned long long skippedCycles = 0;
+    bool sleepCycle = false;
 
     if(hwWait) {
         if(trace_on)
             traceOut << "CPU-Hold by IO-Hardware ";
+        if(binaryTrace != NULL)
+            TraceBinary(BinaryTrace::REC_HOLD);
+    } else if(cpuCycles <= 0 && sleepMode) {
+        if(trace_on)
+            traceOut << "CPU-Sleep ";
+        if(binaryTrace != NULL)
+            TraceBinary(BinaryTrace::REC_SLEEP);
+
+        HandleIrq();
+
+        if(cpuCycles > 0) {
+            // irq wakes up core, irq handler is entered
+            sleepMode = false;
+            PC++;
+            cpuCycles--;
+        } else {
+            if(trace_on == 0 && binaryTrace == NULL && nextStepIn_ns != NULL)
+                skippedCycles = FastForwardSleep();
+            if(profiler != NULL)
+                profiler->Sleep(1 + skippedCycles);
+            sleepCycle = true;
+        }
     } else if(cpuCycles <= 0) {
+            watchHitType = 0;
 
             //check for enabled breakpoints here
-            if(BP.end() != find(BP.begin(), BP.end(), PC)) {
+            if(BP.IsSet(PC) && BP.Hit(PC, this)) {
+                dump_manager->Trigger("breakpoint");
                 if(trace_on)
                     traceOut << "Breakpoint found at 0x" << hex << PC << dec << endl;
+                if(binaryTrace != NULL)
+                    TraceBinary(BinaryTrace::REC_BREAKPOINT);
                 if(nextStepIn_ns != 0)
                     *nextStepIn_ns=clockFreq;
                 untilCoreStepFinished = !(cpuCycles > 0);
@@ -276,45 +635,20 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
                 return BREAK_POINT;
             }
 
-            if(EP.end() != find(EP.begin(), EP.end(), PC)) {
+            if(EP.IsSet(PC) && EP.Hit(PC, this)) {
+                dump_manager->Trigger("exit point");
                 avr_message("Simulation finished!");
                 SystemClock::Instance().stop();
                 dump_manager->cycle();
                 return 0;
             }
 
-            if(deferIrq && ( newIrqPc != 0xffffffff )) {
-                /* Every IRQ is delayed of one cycle. Normally this happens (see datasheet)
-                 * only after a SEI instruction or after a RETI. But because of
-                 * "pipelining" (first cycle is fetch instruction, second is processing)
-                 * it's never possible to raise an interrupt with a instruction from
-                 * inside the controller immediately after fetching (and processing here
-                 * in simulavr) this instruction. Only a external source or peripherals
-                 * could do that. Hold this in mind, if you try to measure processing time!
-                 */
-                deferIrq = false;
+            if(TP.IsSet(PC) && TP.Hit(PC, this))
+                dump_manager->Trigger("trigger point");
 
-                if(trace_on)
-                    traceOut << "IRQ DETECTED: VectorAddr: " << newIrqPc ;
-
-                irqSystem->IrqHandlerStarted(actualIrqVector);    //what vector we raise?
-                Funktor* fkt = new IrqFunktor(irqSystem, &HWIrqSystem::IrqHandlerFinished, actualIrqVector);
-                stack->SetReturnPoint(stack->GetStackPointer(), fkt);
-                stack->PushAddr(PC);
-                cpuCycles = 4; //push needs 4 cycles! (on external RAM +2, this is handled from HWExtRam!)
-                status->I = 0; //irq started so remove I-Flag from SREG
-                PC = newIrqPc - 1;   //we add a few lines later 1 so we sub here 1 :-)
-
-            } else if(status->I == 1) {
-                newIrqPc = irqSystem->GetNewPc(actualIrqVector);
-
-                if(newIrqPc != 0xffffffff) {
-                   deferIrq = true; // do always one instruction before entering irq vect
-                   if(trace_on)
-                      traceOut << "IRQ prepared for addr " << hex << newIrqPc << dec << endl;
-                }
-            }
+            HandleIrq();
 
+            bool jumpedBack = false;
             if(cpuCycles <= 0) {
                 if((unsigned int)(PC << 1) >= (unsigned int)Flash->GetSize() ) {
                     ostringstream os;
@@ -325,31 +659,63 @@ int AvrDevice::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_n
                     avr_error("%s", s.c_str());
                 }
 
-                DecodedInstruction *de = (Flash->GetInstruction(PC));
+                if(idleLoopValid && (PC < idleLoopStart || PC > idleLoopEnd))
+                    idleLoopValid = false;
+
+                if(binaryTrace != NULL) {
+                    TraceBinary(BinaryTrace::REC_INSTRUCTION, Flash->ReadMemWord(PC * 2));
+                    if(Flash->GetInstruction(PC)->IsInstruction2Words())
+                        binaryTrace->Add(binaryTraceIndex, BinaryTrace::REC_OPERAND,
+                                         PC + 1, Flash->ReadMemWord((PC + 1) * 2));
+                }
+
                 if(trace_on) {
-                    cpuCycles = de->Trace();
+                    cpuCycles = Flash->GetInstruction(PC)->Trace(this);
+                } else if(useThreadedCode) {
+                    // more than one instruction per step only in block mode, see StepBlock
+                    unsigned long long chained;
+                    bool chain = useBlockCache && binaryTrace == NULL && profiler == NULL &&
+                                 !deferIrq && WP.empty() && nextStepIn_ns != NULL;
+                    cpuCycles = ExecuteThreaded(this, chain, chained);
+                    if(chained > 0) {
+                        SystemClock::Instance().IncrTime(chained * clockFreq);
+                        SkipIdleCycles(chained);
+                    }
                 } else {
-                    cpuCycles = (*de)(); 
+                    cpuCycles = (*(Flash->GetInstruction(PC)))(this);
                 }
                 // report changes on status
                 statusRegister->trigger_change();
+                jumpedBack = PC < cPC;
+                if(coverage != NULL)
+                    coverage->Executed(cPC, PC + 1);
             }
 
             PC++;
             cpuCycles--;
+
+            if(jumpedBack && trace_on == 0 && binaryTrace == NULL && nextStepIn_ns != NULL)
+                skippedCycles = FastForwardIdleLoop();
     } else { //cpuCycles>0
         if(trace_on == 1)
             traceOut << "CPU-waitstate";
+        if(binaryTrace != NULL)
+            TraceBinary(BinaryTrace::REC_WAITSTATE);
         cpuCycles--;
     }
 
     if(nextStepIn_ns != NULL)
-        *nextStepIn_ns = clockFreq;
+        *nextStepIn_ns = clockFreq * (1 + skippedCycles);
 
     if(trace_on == 1) {
         traceOut << endl;
         sysConHandler.TraceNextLine();
     }
+    if(binaryTrace != NULL)
+        TraceBinaryStatus();
+
+    if(profiler != NULL && !sleepCycle)
+        profiler->Cycle(cPC);
 
     untilCoreStepFinished = !((cpuCycles > 0) || hwWait);
     dump_manager->cycle();
@@ -366,13 +732,243 @@ void AvrDevice::Reset() {
 
     PC = 0; cPC=0;
     *status = 0;
+    sleepMode = false;
+    idleLoopValid = false;
 
     // init the old static vars from Step()
     cpuCycles = 0;
+
+    if(profiler != NULL)
+        profiler->Reset();
+}
+
+void AvrDevice::SerializeState(Snapshot &snap) {
+    snap.Check("device " + devName);
+    snap.Check("memory size", memSize);
+    snap.Check("flash size", Flash->GetSize());
+    snap.Check("hardware count", hwResetList.size());
+
+    // core
+    snap.Value(clockFreq);
+    snap.Value(PC);
+    snap.Value(cPC);
+    snap.Value(PC_size);
+    snap.Value(cpuCycles);
+    snap.Value(cycleCounter);
+    snap.Value(sleepMode);
+    snap.Value(deferIrq);
+    snap.Value(newIrqPc);
+    snap.Value(actualIrqVector);
+    snap.Value(*status);
+    snap.Block(memValues, memSize);
+    for(unsigned int i = registerSpaceSize; i < registerSpaceSize + ioSpaceSize; i++) {
+        IOSpecialReg *reg = dynamic_cast<IOSpecialReg *>(rw[i]);
+        if(reg != NULL)
+            reg->SerializeState(snap);
+    }
+
+    // memories, eeprom is a hardware
+    Flash->SerializeState(snap);
+    fuses->SerializeState(snap);
+    lockbits->SerializeState(snap);
+
+    // hardware and it's place in cycle list
+    vector<unsigned int> cycleList;
+    if(!snap.IsRestoring()) {
+        for(unsigned int i = 0; i < hwCycleList.size(); i++) {
+            if(hwCycleList[i] == NULL)
+                continue;
+            unsigned int idx = find(hwResetList.begin(), hwResetList.end(), hwCycleList[i]) - hwResetList.begin();
+            if(idx == hwResetList.size())
+                avr_error("can't save hardware in cycle list, which isn't part of the device");
+            cycleList.push_back(idx);
+        }
+    }
+    vector<unsigned int> scheduleList;
+    vector<unsigned long long> scheduleCycles;
+    if(!snap.IsRestoring()) {
+        for(unsigned int i = 0; i < hwScheduleList.size(); i++) {
+            unsigned int idx = find(hwResetList.begin(), hwResetList.end(), hwScheduleList[i].first) - hwResetList.begin();
+            if(idx == hwResetList.size())
+                avr_error("can't save scheduled hardware, which isn't part of the device");
+            scheduleList.push_back(idx);
+            scheduleCycles.push_back(hwScheduleList[i].second);
+        }
+    }
+    snap.Vector(cycleList);
+    snap.Vector(scheduleList);
+    snap.Vector(scheduleCycles);
+    for(unsigned int i = 0; i < hwResetList.size(); i++)
+        hwResetList[i]->SerializeState(snap);
+    if(snap.IsRestoring()) {
+        hwCycleList.clear();
+        hwCycleListChanged = false;
+        for(unsigned int i = 0; i < cycleList.size(); i++) {
+            if(cycleList[i] >= hwResetList.size())
+                avr_error("snapshot doesn't match: invalid hardware in cycle list");
+            hwCycleList.push_back(hwResetList[cycleList[i]]);
+        }
+        hwScheduleList.clear();
+        hwWakeCycle = numeric_limits<unsigned long long>::max();
+        if(scheduleCycles.size() != scheduleList.size())
+            avr_error("snapshot doesn't match: invalid list of scheduled hardware");
+        for(unsigned int i = 0; i < scheduleList.size(); i++) {
+            if(scheduleList[i] >= hwResetList.size())
+                avr_error("snapshot doesn't match: invalid scheduled hardware");
+            hwScheduleList.push_back(make_pair(hwResetList[scheduleList[i]], scheduleCycles[i]));
+            hwWakeCycle = min(hwWakeCycle, scheduleCycles[i]);
+        }
+    }
+
+    // interrupts and stack, after hardware, which could raise interrupts on restore
+    irqSystem->SerializeState(snap);
+    stack->SerializeState(snap);
+
+    if(snap.IsRestoring())
+        idleLoopValid = false;
+}
+
+Breakpoints::~Breakpoints() {
+    Clear();
+}
+
+void Breakpoints::AddBreakpoint(dword pc) {
+    if((unsigned int)pc >= flags.size())
+        flags.resize(pc + 1, 0);
+    if(flags[pc] == 255)
+        avr_error("too many breakpoints at word address 0x%x", pc);
+    flags[pc]++;
+    addresses.push_back(pc);
+}
+
+void Breakpoints::RemoveBreakpoint(dword pc) {
+    std::vector<dword>::iterator i = find(addresses.begin(), addresses.end(), pc);
+    if(i == addresses.end())
+        return;
+    addresses.erase(i);
+    if(--flags[pc] == 0) {
+        std::map<dword, Info>::iterator ii = info.find(pc);
+        if(ii != info.end()) {
+            delete ii->second.condition;
+            info.erase(ii);
+        }
+    }
+}
+
+void Breakpoints::Clear(void) {
+    addresses.clear();
+    flags.clear();
+    std::map<dword, Info>::iterator i;
+    for(i = info.begin(); i != info.end(); i++)
+        delete i->second.condition;
+    info.clear();
+}
+
+bool Breakpoints::IsSetInRange(dword from, dword to) const {
+    if(addresses.empty())
+        return false;
+    for(unsigned int pc = from; pc < (unsigned int)to && pc < flags.size(); pc++)
+        if(flags[pc] != 0)
+            return true;
+    return false;
+}
+
+Breakpoints::Info &Breakpoints::GetInfo(dword pc) {
+    std::map<dword, Info>::iterator i = info.find(pc);
+    if(i != info.end())
+        return i->second;
+    Info &n = info[pc];
+    n.condition = NULL;
+    n.ignoreCount = 0;
+    n.hits = 0;
+    return n;
+}
+
+void Breakpoints::SetCondition(dword pc, BreakpointCondition *cond) {
+    if(!IsSet(pc)) {
+        delete cond;
+        return;
+    }
+    Info &i = GetInfo(pc);
+    delete i.condition;
+    i.condition = cond;
+}
+
+void Breakpoints::SetIgnoreCount(dword pc, unsigned long count) {
+    if(IsSet(pc))
+        GetInfo(pc).ignoreCount = count;
+}
+
+unsigned long long Breakpoints::GetHitCount(dword pc) const {
+    std::map<dword, Info>::const_iterator i = info.find(pc);
+    return (i == info.end()) ? 0 : i->second.hits;
+}
+
+bool Breakpoints::Hit(dword pc, AvrDevice *core) {
+    std::map<dword, Info>::iterator ii = info.find(pc);
+    // plain breakpoint
+    if(ii == info.end())
+        return true;
+    Info &i = ii->second;
+    if(i.condition != NULL && !i.condition->IsTrue(core))
+        return false;
+    i.hits++;
+    if(i.ignoreCount > 0) {
+        i.ignoreCount--;
+        return false;
+    }
+    return true;
+}
+
+bool Breakpoints::ConditionIsTrue(dword pc, AvrDevice *core) const {
+    std::map<dword, Info>::const_iterator i = info.find(pc);
+    return i == info.end() || i->second.condition == NULL || i->second.condition->IsTrue(core);
 }
 
 void AvrDevice::DeleteAllBreakpoints() {
-    BP.erase(BP.begin(), BP.end());
+    BP.Clear();
+    WP.clear();
+    UpdateWatchpoints();
+}
+
+void AvrDevice::InsertWatchpoint(unsigned int addr, unsigned int len, int type) {
+    Watchpoint w;
+    w.addr = addr;
+    w.len = len;
+    w.type = type;
+    WP.push_back(w);
+    UpdateWatchpoints();
+}
+
+bool AvrDevice::RemoveWatchpoint(unsigned int addr, unsigned int len, int type) {
+    for(Watchpoints::iterator i = WP.begin(); i != WP.end(); i++) {
+        if(i->addr == addr && i->len == len && i->type == type) {
+            WP.erase(i);
+            UpdateWatchpoints();
+            return true;
+        }
+    }
+    return false;
+}
+
+void AvrDevice::UpdateWatchpoints(void) {
+    for(unsigned idx = 0; idx < memSize; idx++)
+        memWatch[idx] = 0;
+    for(unsigned int i = 0; i < WP.size(); i++)
+        for(unsigned int a = WP[i].addr; a < WP[i].addr + WP[i].len && a < memSize; a++)
+            memWatch[a] |= WP[i].type;
+    UpdateDirectAccess();
+}
+
+void AvrDevice::WatchpointHit(unsigned addr, int access) {
+    // report the first watchpoint on this cell, which matches the access
+    for(unsigned int i = 0; i < WP.size(); i++) {
+        if(addr >= WP[i].addr && addr < WP[i].addr + WP[i].len && (WP[i].type & access) != 0) {
+            watchHitType = WP[i].type;
+            watchHitAddr = addr;
+            return;
+        }
+    }
 }
 
 void AvrDevice::SetDeviceNameAndSignature(const std::string &name, unsigned int signature) {
@@ -384,16 +980,39 @@ void AvrDevice::ReplaceIoRegister(unsigned int offset, RWMemoryMember *newMember
     if (offset >= ioSpaceSize + registerSpaceSize)
         avr_error("Could not replace register in non existing IoRegisterSpace");
     rw[offset] = newMember;
+    memDirect[offset] = false;
 }
 
 bool AvrDevice::ReplaceMemRegister(unsigned int offset, RWMemoryMember *newMember) {
     if(offset < totalIoSpace) {
         rw[offset] = newMember;
+        if(offset < memSize)
+            memDirect[offset] = false;
         return true;
     }
     return false;
 }
 
+void AvrDevice::UpdateDirectAccess(void) {
+    for(unsigned idx = 0; idx < memSize; idx++) {
+        RAM *ram = dynamic_cast<RAM *>(rw[idx]);
+        bool direct = (ram != NULL) && !ram->IsTraced() && (binaryTrace == NULL) && memWatch[idx] == 0;
+        if(ram != NULL && direct != memDirect[idx])
+            ram->SetDirectAccess(direct);
+        memDirect[idx] = direct;
+    }
+}
+
+void AvrDevice::TraceBinaryStatus(void) {
+    int sreg = *status;
+    unsigned long sp = stack->GetStackPointer();
+    if(sreg != binaryTraceSreg || sp != binaryTraceSP) {
+        binaryTraceSreg = sreg;
+        binaryTraceSP = sp;
+        binaryTrace->Add(binaryTraceIndex, BinaryTrace::REC_STATUS, sp, sreg);
+    }
+}
+
 RWMemoryMember* AvrDevice::GetMemRegisterInstance(unsigned int offset) {
     if(offset < totalIoSpace)
         return rw[offset];
@@ -406,7 +1025,11 @@ void AvrDevice::RegisterTerminationSymbol(const char *symbol) {
     assert(false);  // TODO: Implement loading symbols from ELF file
 #endif
     unsigned int epa = Flash->GetAddressAtSymbol(symbol);
-    EP.push_back(epa);
+    EP.AddBreakpoint(epa);
+}
+
+void AvrDevice::RegisterTriggerSymbol(const char *symbol) {
+    TP.AddBreakpoint(Flash->GetAddressAtSymbol(symbol));
 }
 
 void AvrDevice::DebugOnJump()
@@ -418,65 +1041,54 @@ void AvrDevice::DebugOnJump()
     DebugRecentJumps[next] = -1;
 }
 
-unsigned char AvrDevice::GetRWMem(unsigned addr) {
+bool AvrDevice::IsSleepEnabled(void) const {
+    return sleepReg == NULL || (sleepReg->GetValue() & sleepEnableMask) != 0;
+}
+
+unsigned char AvrDevice::GetRWMemVirtual(unsigned addr) {
     if(addr >= GetMemTotalSize())
         return 0;
+    CheckWatchpoint(addr, WATCH_READ);
     return *(rw[addr]);
 }
 
-bool AvrDevice::SetRWMem(unsigned addr, unsigned char val) {
+bool AvrDevice::SetRWMemVirtual(unsigned addr, unsigned char val) {
     if(addr >= GetMemTotalSize())
         return false;
+    CheckWatchpoint(addr, WATCH_WRITE);
     *(rw[addr]) = val;
-    return true;
-}
-
-unsigned char AvrDevice::GetCoreReg(unsigned addr) {
-    assert(addr < registerSpaceSize);
-    return *(rw[addr]);
-}
-
-bool AvrDevice::SetCoreReg(unsigned addr, unsigned char val) {
-    assert(addr < registerSpaceSize);
-    *(rw[addr]) = val;
+    if(binaryTrace != NULL)
+        binaryTrace->Add(binaryTraceIndex, BinaryTrace::REC_WRITE, addr, val);
     return true;
 }
 
 unsigned char AvrDevice::GetIOReg(unsigned addr) {
     assert(addr < ioSpaceSize);  // callers do use 0x00 base, not 0x20
+    CheckWatchpoint(addr + registerSpaceSize, WATCH_READ);
     return *(rw[addr + registerSpaceSize]);
 }
 
 bool AvrDevice::SetIOReg(unsigned addr, unsigned char val) {
     assert(addr < ioSpaceSize);  // callers do use 0x00 base, not 0x20
+    CheckWatchpoint(addr + registerSpaceSize, WATCH_WRITE);
     *(rw[addr + registerSpaceSize]) = val;
+    if(binaryTrace != NULL)
+        binaryTrace->Add(binaryTraceIndex, BinaryTrace::REC_WRITE, addr + registerSpaceSize, val);
     return true;
 }
 
 bool AvrDevice::SetIORegBit(unsigned addr, unsigned bitaddr, bool bval) {
     assert(addr < 0x20);  // only first 32 IO registers are bit-settable
+    CheckWatchpoint(addr + registerSpaceSize, WATCH_WRITE);
     unsigned char val = *(rw[addr + registerSpaceSize]);
     if(bval)
       val |= 1 << bitaddr;
     else
       val &= ~(1 << bitaddr);
     *(rw[addr + registerSpaceSize]) = val;
+    if(binaryTrace != NULL)
+        binaryTrace->Add(binaryTraceIndex, BinaryTrace::REC_WRITE, addr + registerSpaceSize, val);
     return true;
 }
 
-unsigned AvrDevice::GetRegX(void) {
-    // R27:R26
-    return (*(rw[27]) << 8) + *(rw[26]);
-}
-
-unsigned AvrDevice::GetRegY(void) {
-    // R29:R28
-    return (*(rw[29]) << 8) + *(rw[28]);
-}
-
-unsigned AvrDevice::GetRegZ(void) {
-    // R31:R30
-    return (*(rw[31]) << 8) + *(rw[30]);
-}
-
 // EOF
@@ -32,20 +32,96 @@
 #include "net.h"
 #include "traceval.h"
 #include "flashprog.h"
+#include "binarytrace.h"
+#include "profiler.h"
+#include "coverage.h"
 
 #include <string>
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <assert.h>
 #include "types.h" // for dword
 
 // transfered from global.h
 #define BREAK_POINT    -2
 #define INVALID_OPCODE -1
 
+class AvrDevice;
+class ExecutionHistory;
+
+//! Condition of a breakpoint, see Breakpoints::SetCondition
+class BreakpointCondition {
+    public:
+        virtual ~BreakpointCondition() {}
+        //! Returns true, if the breakpoint has to stop the simulation
+        virtual bool IsTrue(AvrDevice *core) = 0;
+};
+
 // transfered from breakpoint.h
-class Breakpoints: public std::vector<dword> { };
-class Exitpoints: public std::vector<dword> { };
+//! Breakpoints on word addresses of flash
+/*! Besides the list of addresses every breakpoint is counted in a array
+  indexed by word address, so IsSet is a array lookup and a instruction
+  without breakpoint doesn't pay for the count of breakpoints. Breakpoints
+  have to be set and removed by AddBreakpoint and RemoveBreakpoint, a
+  address can be added more than once.
+
+  A breakpoint can have a condition and a ignore count, both are only
+  evaluated by Hit, if IsSet is true for the address. */
+class Breakpoints {
+
+    public:
+        ~Breakpoints();
+
+        //! Adds a breakpoint on word address pc
+        void AddBreakpoint(dword pc);
+        //! Removes one breakpoint on pc, condition and counts with the last one
+        void RemoveBreakpoint(dword pc);
+        //! Removes all breakpoints
+        void Clear(void);
+        //! Returns addresses of all breakpoints, in order of AddBreakpoint
+        const std::vector<dword> &GetAddresses(void) const { return addresses; }
+        //! Returns true, if a breakpoint is set on pc
+        bool IsSet(dword pc) const { return (unsigned int)pc < flags.size() && flags[pc] != 0; }
+        //! Returns true, if a breakpoint is set in [from, to)
+        bool IsSetInRange(dword from, dword to) const;
+
+        //! Sets condition of breakpoint on pc, NULL removes it, the breakpoint owns the condition
+        void SetCondition(dword pc, BreakpointCondition *cond);
+        //! Next count hits (with true condition) of breakpoint on pc don't stop simulation
+        void SetIgnoreCount(dword pc, unsigned long count);
+        //! Returns count of hits (with true condition) of breakpoint on pc
+        /*! Hits are counted only for breakpoints, which have (or had) a
+          condition or a ignore count. */
+        unsigned long long GetHitCount(dword pc) const;
+        //! Called, if IsSet(pc) is true, returns true, if simulation has to stop
+        bool Hit(dword pc, AvrDevice *core);
+        //! Returns true, if breakpoint on pc has no condition or it's condition is true, counters aren't changed
+        bool ConditionIsTrue(dword pc, AvrDevice *core) const;
+
+    private:
+        //! Condition and counters of a breakpoint address
+        struct Info {
+            BreakpointCondition *condition;
+            unsigned long ignoreCount;
+            unsigned long long hits;
+        };
+        std::vector<dword> addresses; //!< list of breakpoints, a address can be in list more than once
+        std::vector<unsigned char> flags; //!< count of breakpoints per word address
+        std::map<dword, Info> info; //!< only for breakpoints with condition, ignore count or hits
+
+        Info &GetInfo(dword pc);
+};
+class Exitpoints: public Breakpoints { };
+class Triggerpoints: public Breakpoints { };
+
+//! Data watchpoint on [addr, addr + len) in data address space
+struct Watchpoint {
+    unsigned int addr;
+    unsigned int len;
+    int type;   //!< AvrDevice::WATCH_READ, WATCH_WRITE or WATCH_ACCESS
+};
+class Watchpoints: public std::vector<Watchpoint> { };
 
 // from hwsreg.h, but not included, because of circular include with this header
 class HWSreg;
@@ -58,9 +134,11 @@ class HWWado;
 class Data;
 class HWIrqSystem;
 class RWMemoryMember;
+class IOSpecialReg;
 class Hardware;
 class DumpManager;
 class AddressExtensionRegister;
+class Snapshot;
 
 //! Basic AVR device, contains the core functionality
 class AvrDevice: public SimulationMember, public TraceValueRegister {
@@ -74,6 +152,68 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         const unsigned int eRamSize;
         unsigned int devSignature; //!< hold the device signature for this core
         std::string devName; //!< hold the device name, which this core simulate
+        unsigned int memSize; //!< size of memValues and memDirect: registers, IO space and RAM
+        unsigned char *memValues; //!< contiguous store for values of registers and RAM cells, same index as rw
+        bool *memDirect; //!< per address flag: rw[] is a untraced RAM cell, access memValues without virtual call
+        unsigned char *memWatch; //!< per address flags WATCH_READ, WATCH_WRITE of watchpoints, such cells aren't accessed directly
+        Watchpoints WP; //!< data watchpoints, see InsertWatchpoint
+        int watchHitType; //!< type of watchpoint hit by current instruction, 0 if none
+        unsigned int watchHitAddr; //!< accessed address of watchpoint hit
+
+        unsigned long long cycleCounter; //!< count of core clock cycles since creation of device
+        bool hwCycleListChanged; //!< hwCycleList contains removed (NULL) entries
+        std::vector<std::pair<Hardware *, unsigned long long> > hwScheduleList; //!< hardware out of cycle list and the core cycle, it joins it again, see ScheduleHardware
+        unsigned long long hwWakeCycle; //!< earliest core cycle in hwScheduleList
+        bool sleepMode; //!< core is sleeping (SLEEP executed), only hardware is clocked till next irq
+        IOSpecialReg *sleepReg; //!< register with sleep enable bit (MCUCR or SMCR), NULL if not simulated
+        unsigned char sleepEnableMask; //!< mask of sleep enable bit (SE) in sleepReg
+        bool idleLoopValid; //!< idleLoopState holds the state of a pass through a idle loop
+        unsigned int idleLoopStart; //!< word index of jump target of idle loop
+        unsigned int idleLoopEnd; //!< word index of jump back instruction of idle loop
+        unsigned long long idleLoopCycle; //!< core cycle count on last jump back in idle loop
+        unsigned char idleLoopState[33]; //!< R0-R31 and SREG on last jump back in idle loop
+        bool binaryTraceLine; //!< a record for the current step was added to binaryTrace
+        int binaryTraceSreg; //!< status register, which was last added to binaryTrace
+        unsigned long binaryTraceSP; //!< stack pointer, which was last added to binaryTrace
+
+        //! Calls CpuCycle on all hardware in hwCycleList, returns true, if cpu is hold
+        bool CycleHardware(void);
+        //! Brings hardware from hwScheduleList back into cycle list, if it's core cycle is reached
+        void WakeUpScheduledHardware(void);
+        //! Removes hardware from hwScheduleList, if it's there
+        void UnscheduleHardware(Hardware *hw);
+        //! Starts a pending irq or looks for a new one, called on instruction boundary
+        void HandleIrq(void);
+        //! Returns true, if a break-, exit- or triggerpoint is set in range [from, to)
+        bool HasBreakpointInRange(unsigned int from, unsigned int to) const {
+            return BP.IsSetInRange(from, to) || EP.IsSetInRange(from, to) || TP.IsSetInRange(from, to);
+        }
+        //! Executes the basic block on PC with `blockSize' words in one step, see Step()
+        int StepBlock(unsigned int blockSize, bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns);
+        //! Returns count of following cycles, in which hardware and other simulation members do nothing than counting
+        unsigned long long GetIdleCycles(void);
+        //! Moves hardware and cycle count forward by idle cycles, see GetIdleCycles
+        void SkipIdleCycles(unsigned long long cycles);
+        //! Skips idle cycles of a sleeping core till the next possible wake up event, returns count of skipped cycles
+        unsigned long long FastForwardSleep(void);
+        //! Skips passes of a side effect free loop after a jump back, if a pass hasn't changed registers, returns count of skipped cycles
+        /*! Loops, which read IO registers with side effects on read (UDR,
+          SPDR, ADCL ...), aren't skipped, see RWMemoryMember::IsReadSideEffectFree */
+        unsigned long long FastForwardIdleLoop(void);
+        //! Adds a REC_STATUS record to binaryTrace, if status register or stack pointer has changed
+        void TraceBinaryStatus(void);
+        //! Reads a memory cell by rw[], if it can't be accessed directly
+        unsigned char GetRWMemVirtual(unsigned addr);
+        //! Writes a memory cell by rw[], if it can't be accessed directly
+        bool SetRWMemVirtual(unsigned addr, unsigned char val);
+        //! Records a hit, if a watchpoint for access (WATCH_READ or WATCH_WRITE) is set on addr
+        void CheckWatchpoint(unsigned addr, int access) {
+            if(addr < memSize && (memWatch[addr] & access) != 0 && watchHitType == 0)
+                WatchpointHit(addr, access);
+        }
+        void WatchpointHit(unsigned addr, int access);
+        //! Sets memWatch from WP
+        void UpdateWatchpoints(void);
 
     protected:
         SystemClockOffset clockFreq;  ///< Period of a tick (1/F_OSC) in [ns]
@@ -84,9 +224,18 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         int cpuCycles;
 
     public:
+        //! Types of watchpoints, WATCH_ACCESS is read or write
+        enum { WATCH_READ = 1, WATCH_WRITE = 2, WATCH_ACCESS = 3 };
+
         int trace_on;
+        BinaryTrace *binaryTrace; //!< binary execution trace or NULL, see BinaryTrace::AddDevice
+        unsigned char binaryTraceIndex; //!< index of this device in binaryTrace
+        Profiler *profiler; //!< cycle profiler or NULL, see Profiler
+        Coverage *coverage; //!< code coverage recording or NULL, see Coverage
+        ExecutionHistory *history; //!< execution history for reverse debugging or NULL, see ExecutionHistory
         Breakpoints BP;
         Exitpoints EP;
+        Triggerpoints TP; //!< addresses, which fire a trigger for windowed tracing, see DumpManager::Trigger
         word PC;  ///< Next/current instruction index. Multiply by 2 to get an address. This will not be enough for ATmega2560
         /// When mupti-cycle instruction is "processed" this holds its address, PC holds the next instruction.
         word cPC;
@@ -101,6 +250,10 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         AddressExtensionRegister *rampz; //!< RAMPZ address extension register
         AddressExtensionRegister *eind; //!< EIND address extension register
         bool abortOnInvalidAccess; //!< Flag, that simulation abort if an invalid access occured, default is false
+        bool useBlockCache; //!< Flag, execute a whole basic block per Step call (if not tracing), default is false
+        bool useThreadedCode; //!< Flag, execute instructions from threaded code, see ExecuteThreaded, default is false
+        bool useIdleLoopSkip; //!< Flag, skip passes of side effect free polling loops till next event (if not tracing), default is true
+        bool useHardwareSchedule; //!< Flag, running timers and watchdog leave cycle list till their next event, see ScheduleHardware, default is true
         TraceValueCoreRegister coreTraceGroup;
         bool deferIrq;  ///< Almost always false.
         unsigned int newIrqPc;
@@ -142,34 +295,137 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         void AddToResetList(Hardware *hw);
 
         /*! Adds to the list of parts to cycle per clock tick. If already in that list, does
-          nothing. */
+          nothing.
+
+          Idle peripherals leave this list (prescaler, uart, adc, watchdog,
+          CLKPR and flash programming) and join it again, if they have
+          something to do. Running timers and a enabled watchdog leave it
+          till their next event, see ScheduleHardware. */
         void AddToCycleList(Hardware *hw);
 
         //! Removes from the cycle list, if possible.
-        /*! Does nothing if the part is not in the cycle list. */
+        /*! Does nothing if the part is not in the cycle list. It's save to call
+          this from CpuCycle method, while cycle list is processed. */
         void RemoveFromCycleList(Hardware *hw);
+
+        //! Removes hardware from cycle list till the given core cycle
+        /*! Hardware, which has nothing else to do than counting till a known
+          core cycle (timer compare match or overflow, watchdog timeout), leaves
+          the cycle list by this call. It's put back into cycle list before
+          this core cycle is processed, so CpuCycle is called again for this
+          cycle. In between it has to count missed cycles from GetCycleCount,
+          if a register is accessed. A sleeping core or a idle loop isn't
+          fast forwarded behind this cycle, so the next step of the core on
+          SystemClock is just on this event.
+
+          Returns false and does nothing, if useHardwareSchedule isn't set or
+          a dumper wants to see every cycle. It's save to call this from
+          CpuCycle method, while cycle list is processed. */
+        bool ScheduleHardware(Hardware *hw, unsigned long long cycle);
+
+        //! Puts hardware back into cycle list, if it has left it by ScheduleHardware
+        /*! Used, if a input of the hardware has changed (pin, prescaler,
+          register). */
+        void WakeUpHardware(Hardware *hw) {
+            for(unsigned i = 0; i < hwScheduleList.size(); i++) {
+                if(hwScheduleList[i].first == hw) {
+                    AddToCycleList(hw);
+                    return;
+                }
+            }
+        }
+
+        //! Puts all hardware back into cycle list, which has left it by ScheduleHardware
+        void WakeUpAllHardware(void);
+
+        //! Returns count of core clock cycles since creation of device
+        /*! Hardware, which isn't in cycle list while idle, can use this to
+          catch up counters for the cycles, it was not called. */
+        unsigned long long GetCycleCount(void) const { return cycleCounter; }
+
+        //! Puts core in sleep mode, called by SLEEP instruction
+        /*! Core does not execute instructions till a interrupt is raised, only
+          hardware is clocked. */
+        void EnterSleepMode(void) { sleepMode = true; }
+        //! Sets register and bit of sleep enable flag (SE), see IsSleepEnabled
+        void SetSleepEnableBit(IOSpecialReg *reg, int bit) { sleepReg = reg; sleepEnableMask = 1 << bit; }
+        //! Returns true, if sleep enable bit (SE) is set
+        /*! If device doesn't simulate the register with SE bit, sleep is
+          always enabled. */
+        bool IsSleepEnabled(void) const;
+        //! Returns true, if core is in sleep mode
+        bool IsSleeping(void) const { return sleepMode; }
+
+        //! Adds a record of the current step to binaryTrace, address is the program counter of step
+        /*! The first record of a step starts a new trace line. */
+        void TraceBinary(unsigned char type, unsigned int value = 0) {
+            if(!binaryTraceLine) {
+                type |= BinaryTrace::REC_LINE;
+                binaryTraceLine = true;
+            }
+            binaryTrace->Add(binaryTraceIndex, type, cPC, value);
+        }
     
         void Load(const char* n); //!< Load flash, eeprom, signature, fuses from elf file, wrapper for LoadBFD or LoadSimpleELF
         void ReplaceIoRegister(unsigned int offset, RWMemoryMember *);
         bool ReplaceMemRegister(unsigned int offset, RWMemoryMember *);
         RWMemoryMember *GetMemRegisterInstance(unsigned int offset);
         void RegisterTerminationSymbol(const char *symbol);
+        //! Adds a trigger point for windowed tracing at symbol or address
+        void RegisterTriggerSymbol(const char *symbol);
 
         Pin *GetPin(const char *name);
         /*! Steps the AVR core.
           \param untilCoreStepFinished iff true, steps a core step and not a
-          single clock cycle. */
+          single clock cycle.
+
+          If useBlockCache is set and nextStepIn_ns is given, all cycles of the
+          basic block on PC are processed in one call, as long as no other
+          simulation member is due. Cycle count and hardware timing stay the
+          same, SystemClock time is moved forward by this method. With
+          useThreadedCode set too, instructions, which only change registers
+          and RAM, are chained over cycles, in which hardware and other
+          simulation members are idle, see ExecuteThreaded.
+
+          If core is sleeping and nextStepIn_ns is given, all cycles till the
+          next possible wake up event are skipped in one call, see
+          Hardware::CyclesIdle. The same is done for passes of a polling loop
+          (like "rjmp .-2" or waiting for a flag), which doesn't change
+          anything, if useIdleLoopSkip is set. */
         int Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns =0);
+        //! A device owns itself, see SimulationMember::GetOwnerDevice
+        AvrDevice *GetOwnerDevice(void) { return this; }
         void Reset();
+        //! Saves or restores the state of core, memories and all hardware, see Snapshot
+        /*! Breakpoints, exitpoints, trace, block cache and engine flags are configuration
+          and not part of the state. */
+        void SerializeState(Snapshot &snap);
         void SetClockFreq(SystemClockOffset f);
         SystemClockOffset GetClockFreq();
 
         void RegisterPin(const std::string &name, Pin *p) {
             allPins.insert(std::pair<std::string, Pin*>(name, p));
         }
+        //! Returns all pins of the device, registered by RegisterPin
+        const std::map<std::string, Pin*> &GetAllPins(void) const { return allPins; }
 
-        //! Clear all breakpoints in device
+        //! Clear all breakpoints and watchpoints in device
         void DeleteAllBreakpoints(void);
+        //! Sets a watchpoint on data addresses [addr, addr + len)
+        /*! Watched cells are accessed by rw[], see GetRWMem, so a set
+          watchpoint doesn't cost anything on other cells. A hit is reported
+          by GetWatchpointHit after the instruction, which has accessed the
+          cell. */
+        void InsertWatchpoint(unsigned int addr, unsigned int len, int type);
+        //! Removes a watchpoint set by InsertWatchpoint, returns false, if it isn't set
+        bool RemoveWatchpoint(unsigned int addr, unsigned int len, int type);
+        //! Returns type of watchpoint hit by last instruction or 0, addr is the accessed address
+        int GetWatchpointHit(unsigned int &addr) const {
+            addr = watchHitAddr;
+            return watchHitType;
+        }
+        //! Forgets a watchpoint hit, for instance after a access by debugger
+        void ClearWatchpointHit(void) { watchHitType = 0; }
 
         //! Return filename from loaded program
         const std::string &GetFname(void) { return actualFilename; }
@@ -192,13 +448,41 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
         unsigned int GetMemERamSize(void) { return eRamSize; }
         
         //! Get a value of RW memory cell
-        unsigned char GetRWMem(unsigned addr);
+        unsigned char GetRWMem(unsigned addr) {
+            if(addr < memSize && memDirect[addr])
+                return memValues[addr];
+            return GetRWMemVirtual(addr);
+        }
         //! Set a value to RW memory cell
-        bool SetRWMem(unsigned addr, unsigned char val);
+        bool SetRWMem(unsigned addr, unsigned char val) {
+            if(addr < memSize && memDirect[addr]) {
+                memValues[addr] = val;
+                return true;
+            }
+            return SetRWMemVirtual(addr, val);
+        }
         //! Get a value from core register
-        unsigned char GetCoreReg(unsigned addr);
+        unsigned char GetCoreReg(unsigned addr) {
+            assert(addr < registerSpaceSize);
+            return memDirect[addr] ? memValues[addr] : GetRWMemVirtual(addr);
+        }
         //! Set a value to core register
-        bool SetCoreReg(unsigned addr, unsigned char val);
+        bool SetCoreReg(unsigned addr, unsigned char val) {
+            assert(addr < registerSpaceSize);
+            if(memDirect[addr])
+                memValues[addr] = val;
+            else
+                SetRWMemVirtual(addr, val);
+            return true;
+        }
+        //! Returns true, if data address is a untraced RAM cell or register, see UpdateDirectAccess
+        bool IsDirectMemory(unsigned addr) const { return addr < memSize && memDirect[addr]; }
+        //! Recalculates, which RAM cells and registers could be accessed directly
+        /*! Must be called, if trace values for RAM cells are enabled, see
+          DumpManager::addDumper. Direct access bypasses the TraceValue of a
+          cell, so the TraceValue of a cell, which leaves direct access, is
+          synchronized with the cell value, see RAM::SetDirectAccess. */
+        void UpdateDirectAccess(void);
         //! Get a value from IO register (without offset of 0x20!)
         unsigned char GetIOReg(unsigned addr);
         //! Set a value to IO register (without offset of 0x20!)
@@ -210,16 +494,17 @@ class AvrDevice: public SimulationMember, public TraceValueRegister {
             bit will be set to 1 */
         bool SetIORegBit(unsigned addr, unsigned bitaddr, bool val);
         //! Get value of X register (16bit)
-        unsigned GetRegX(void);
+        unsigned GetRegX(void) { return (GetCoreReg(27) << 8) + GetCoreReg(26); }
         //! Get value of Y register (16bit)
-        unsigned GetRegY(void);
+        unsigned GetRegY(void) { return (GetCoreReg(29) << 8) + GetCoreReg(28); }
         //! Get value of Z register (16bit)
-        unsigned GetRegZ(void);
+        unsigned GetRegZ(void) { return (GetCoreReg(31) << 8) + GetCoreReg(30); }
 
         //! When a call/jump/cond-jump instruction was executed. For debugging.
         void DebugOnJump();
 
         friend void ELFLoad(AvrDevice * core);
+        friend int ExecuteThreaded(AvrDevice *core, bool chain, unsigned long long &startCycle);
 
 };
 
@@ -42,6 +42,7 @@
 
 #include "avrerror.h"
 #include "helper.h"
+#include "compressedstream.h"
 
 /* for preprocessor symbol HAVE_SYS_MINGW */
 #include "config.h"
@@ -57,6 +58,9 @@ SystemConsoleHandler::SystemConsoleHandler() {
     wrnStream = &std::cerr;
     traceStream = nullStream;
     traceEnabled = false;
+    traceOutput = NULL;
+    traceLineStream = NULL;
+    traceRingHead = traceRingFill = 0;
 }
 
 SystemConsoleHandler::~SystemConsoleHandler() {
@@ -78,10 +82,8 @@ void SystemConsoleHandler::SetWarningStream(std::ostream *s) {
 
 void SystemConsoleHandler::SetTraceFile(const char *name, unsigned int maxlines) {
     StopTrace();
-    std::ofstream* os = new std::ofstream();
-    os->open(name);
     traceFilename = name;
-    traceStream = os;
+    traceStream = OpenTraceOutput(traceFilename);
     traceFileCount = 1;
     traceLinesOnFile = maxlines;
     traceLines = 0;
@@ -99,13 +101,31 @@ void SystemConsoleHandler::SetTraceStream(std::ostream *s) {
 void SystemConsoleHandler::StopTrace(void) {
     if(!traceEnabled)
         return;
+    if(traceOutput != NULL) {
+        // kept lines without trigger are dropped
+        delete traceLineStream;
+        traceLineStream = NULL;
+        traceStream = traceOutput;
+        traceOutput = NULL;
+        traceRing.clear();
+        traceRingHead = traceRingFill = 0;
+    }
     if(traceToFile)
-        ((std::ofstream *)traceStream)->close();
+        delete traceStream; // closes file
     traceStream = nullStream;
     traceEnabled = false;
 }
 
 void SystemConsoleHandler::TraceNextLine(void) {
+    if(traceOutput != NULL && traceStream == traceLineStream) {
+        // keep line in ring
+        traceRing[traceRingHead] = traceLineStream->str();
+        traceLineStream->str("");
+        traceRingHead = (traceRingHead + 1) % traceRing.size();
+        if(traceRingFill < traceRing.size())
+            traceRingFill++;
+        return;
+    }
     if(!traceEnabled || !traceToFile)
         return;
 
@@ -114,19 +134,49 @@ void SystemConsoleHandler::TraceNextLine(void) {
         traceFileCount++;
         traceLines = 0;
         
-        ((std::ofstream *)traceStream)->close();
-        delete traceStream;
+        delete traceStream; // closes file
         
         std::ostringstream n;
         int idx = traceFilename.rfind('.');
         n << traceFilename.substr(0, idx) << "_" << traceFileCount << traceFilename.substr(idx);
-        std::ofstream* os = new std::ofstream();
-        os->open(n.str().c_str());
-        
-        traceStream = os;
+        traceStream = OpenTraceOutput(n.str());
+        if(traceOutput != NULL)
+            traceOutput = traceStream;
     }
 }
 
+void SystemConsoleHandler::SetTraceWindow(unsigned long lines) {
+    if(!traceEnabled || traceOutput != NULL || lines == 0)
+        return;
+    traceOutput = traceStream;
+    traceLineStream = new std::ostringstream;
+    traceStream = traceLineStream;
+    traceRing.resize(lines);
+    traceRingHead = traceRingFill = 0;
+}
+
+void SystemConsoleHandler::TraceTrigger(const std::string &title) {
+    if(traceOutput == NULL || traceStream != traceLineStream)
+        return;
+    *traceOutput << title << std::endl;
+    size_t oldest = (traceRingFill < traceRing.size()) ? 0 : traceRingHead;
+    for(size_t i = 0; i < traceRingFill; i++) {
+        std::string &line = traceRing[(oldest + i) % traceRing.size()];
+        *traceOutput << line;
+        line.clear();
+    }
+    traceRingHead = traceRingFill = 0;
+    // current line is continued on real trace stream
+    *traceOutput << traceLineStream->str();
+    traceLineStream->str("");
+    traceStream = traceOutput;
+}
+
+void SystemConsoleHandler::TraceRearm(void) {
+    if(traceOutput != NULL)
+        traceStream = traceLineStream;
+}
+
 void SystemConsoleHandler::vfmessage(const char *fmt, ...) {
     if ( ! global_verbose_on)
         return;
@@ -27,6 +27,9 @@
 #define SIM_AVRERROR_H
 
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #if defined(_MSC_VER) && !defined(SWIG)
 #define ATTRIBUTE_NORETURN __declspec(noreturn)
@@ -61,6 +64,8 @@ class SystemConsoleHandler {
         void SetWarningStream(std::ostream *s);
         
         //! Sets the trace to file stream and enables tracing global
+        /*! If name ends with ".gz", the trace is written compressed, see
+          CompressedOStream. */
         void SetTraceFile(const char *name, unsigned int maxlines = 0);
         //! Sets the trace to given stream and enables tracing global
         void SetTraceStream(std::ostream *s);
@@ -72,6 +77,12 @@ class SystemConsoleHandler {
         std::ostream &traceOutStream(void) { return *traceStream; }
         //! Ends a trace line, performs reopen new filestream, if necessary
         void TraceNextLine(void);
+        //! Keeps the last lines of trace in memory only, see DumpManager::SetTraceWindow
+        void SetTraceWindow(unsigned long lines);
+        //! Writes title and the kept lines, then trace is written directly
+        void TraceTrigger(const std::string &title);
+        //! Keeps the next lines of trace in memory again
+        void TraceRearm(void);
         
         //! Format and send a message to message stream (default stdout)
         void vfmessage(const char *fmt, ...)
@@ -108,6 +119,11 @@ class SystemConsoleHandler {
         unsigned int traceLinesOnFile; //!< how much lines will be written on one trace file 0->means endless
         unsigned int traceLines; //!< how much lines are written on current trace file
         int traceFileCount; //!< Counter for trace files
+        std::ostream *traceOutput; //!< real trace stream, while trace lines are kept in memory
+        std::ostringstream *traceLineStream; //!< collects current line, while trace lines are kept in memory
+        std::vector<std::string> traceRing; //!< last trace lines, empty if there is no trace window
+        size_t traceRingHead; //!< next line to overwrite in traceRing
+        size_t traceRingFill; //!< count of used lines in traceRing
         
         //! Creates the format string for formatting a message
         char *getFormatString(const char *prefix, const char *file, int line, const char *fmtstr);
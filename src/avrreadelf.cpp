@@ -34,6 +34,12 @@
 #include <cstring>
 #include <map>
 #include <limits>
+#include <vector>
+#include <stdio.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#   include <sys/mman.h>
+#endif
 
 #include "avrdevice_impl.h"
 #include "avrsignature.h"
@@ -136,42 +142,215 @@ unsigned int ELFGetDeviceNameAndSignature(const char *filename, char *devicename
     return std::numeric_limits<unsigned int>::max();
 }
 
+bool ELFReadLineTable(const std::string &filename, std::vector<ELFLineEntry> &lines) {
+    avr_warning("reading DWARF line table isn't supported on this platform");
+    return false;
+}
+
+void ELFReadFunctions(const std::string &filename, std::map<unsigned int, std::string> &functions) {
+}
+
 #endif
 
 #ifndef _MSC_VER
-void ELFLoad(AvrDevice * core) {
-    ELFIO::elfio reader;
-
-    if(!reader.load(core->GetFname()))
-        avr_error("File '%s' not found or isn't a elf object",
-                  core->GetFname().c_str());
+//! Read only image of a ELF file, mapped into memory
+/*! The file is mapped by mmap, if available, otherwise read into a buffer.
+  Only the headers are parsed, section and segment data is accessed in place,
+  so a big file with debug information doesn't cost more than it's program. */
+class ELFImage {
+
+    public:
+        //! Section of ELF file, data points into image
+        struct Section {
+            std::string name;
+            unsigned long nameOffset;   //!< offset of name in section name string table
+            unsigned int type;
+            unsigned long size;
+            unsigned int link;          //!< index of linked section (string table of symbols)
+            const unsigned char *data;  //!< NULL for sections without data in file
+        };
+        //! Segment (program header) of ELF file, data points into image
+        struct Segment {
+            unsigned int type;
+            unsigned long vaddr;
+            unsigned long paddr;
+            unsigned long filesize;
+            const unsigned char *data;
+        };
+        //! Symbol of a symbol table section
+        struct Symbol {
+            std::string name;
+            unsigned long value;
+            unsigned long size;
+            unsigned char bind;
+            unsigned char type;
+            unsigned int sectionIndex;
+        };
+
+        std::vector<Section> sections;
+        std::vector<Segment> segments;
+
+        ELFImage(const std::string &filename);
+        ~ELFImage();
+
+        //! Returns section with name, NULL if there is none
+        const Section *FindSection(const std::string &name) const;
+        //! Reads all symbols of a symbol table section
+        void ReadSymbols(const Section &symtab, std::vector<Symbol> &symbols) const;
+
+    private:
+        const unsigned char *image;
+        size_t imageSize;
+        bool mapped;                    //!< image is mapped by mmap, not read into buffer
+        ELFIO::endianess_convertor conv;
+
+        //! Returns pointer to range in image, aborts if it's outside of file
+        const unsigned char *At(unsigned long offset, unsigned long size, const std::string &filename) const;
+        //! Returns string of a string table section
+        std::string String(const Section &strtab, unsigned long offset) const;
+};
+
+ELFImage::ELFImage(const std::string &filename):
+    image(NULL),
+    imageSize(0),
+    mapped(false)
+{
+    FILE *f = fopen(filename.c_str(), "rb");
+    if(f == NULL)
+        avr_error("File '%s' not found or isn't a elf object", filename.c_str());
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    if(size <= 0)
+        avr_error("File '%s' not found or isn't a elf object", filename.c_str());
+    imageSize = size;
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+    void *m = mmap(NULL, imageSize, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+    if(m != MAP_FAILED) {
+        image = (const unsigned char *)m;
+        mapped = true;
+    }
+#endif
+    if(!mapped) {
+        unsigned char *buf = new unsigned char[imageSize];
+        fseek(f, 0, SEEK_SET);
+        if(fread(buf, 1, imageSize, f) != imageSize)
+            avr_error("can't read file '%s'", filename.c_str());
+        image = buf;
+    }
+    fclose(f);
 
-    if(reader.get_machine() != EM_AVR)
+    ELFIO::Elf32_Ehdr header;
+    memcpy(&header, At(0, sizeof(header), filename), sizeof(header));
+    if(header.e_ident[EI_MAG0] != ELFMAG0 || header.e_ident[EI_MAG1] != ELFMAG1 ||
+       header.e_ident[EI_MAG2] != ELFMAG2 || header.e_ident[EI_MAG3] != ELFMAG3 ||
+       header.e_ident[EI_CLASS] != ELFCLASS32)
+        avr_error("File '%s' not found or isn't a elf object", filename.c_str());
+    conv.setup(header.e_ident[EI_DATA]);
+    if(conv(header.e_machine) != EM_AVR)
         avr_error("ELF file '%s' is not for Atmel AVR architecture (%d)",
-                  core->GetFname().c_str(),
-                  reader.get_machine());
+                  filename.c_str(),
+                  conv(header.e_machine));
+
+    // program headers
+    for(unsigned int i = 0; i < conv(header.e_phnum); i++) {
+        ELFIO::Elf32_Phdr ph;
+        memcpy(&ph, At(conv(header.e_phoff) + i * conv(header.e_phentsize), sizeof(ph), filename), sizeof(ph));
+        Segment seg;
+        seg.type = conv(ph.p_type);
+        seg.vaddr = conv(ph.p_vaddr);
+        seg.paddr = conv(ph.p_paddr);
+        seg.filesize = conv(ph.p_filesz);
+        seg.data = At(conv(ph.p_offset), seg.filesize, filename);
+        segments.push_back(seg);
+    }
+
+    // section headers, names are read from section name string table
+    for(unsigned int i = 0; i < conv(header.e_shnum); i++) {
+        ELFIO::Elf32_Shdr sh;
+        memcpy(&sh, At(conv(header.e_shoff) + i * conv(header.e_shentsize), sizeof(sh), filename), sizeof(sh));
+        Section sec;
+        sec.nameOffset = conv(sh.sh_name);
+        sec.type = conv(sh.sh_type);
+        sec.size = conv(sh.sh_size);
+        sec.link = conv(sh.sh_link);
+        sec.data = (sec.type == SHT_NOBITS) ? NULL : At(conv(sh.sh_offset), sec.size, filename);
+        sections.push_back(sec);
+    }
+    // second pass, string table can follow a section, which uses it
+    unsigned int strndx = conv(header.e_shstrndx);
+    if(strndx == SHN_UNDEF)
+        return;
+    if(strndx >= sections.size())
+        avr_error("ELF file '%s' is corrupted", filename.c_str());
+    for(unsigned int i = 0; i < sections.size(); i++)
+        sections[i].name = String(sections[strndx], sections[i].nameOffset);
+}
+
+ELFImage::~ELFImage() {
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+    if(mapped) {
+        munmap((void *)image, imageSize);
+        return;
+    }
+#endif
+    delete [] image;
+}
+
+const unsigned char *ELFImage::At(unsigned long offset, unsigned long size, const std::string &filename) const {
+    if(offset > imageSize || size > imageSize - offset)
+        avr_error("ELF file '%s' is corrupted", filename.c_str());
+    return image + offset;
+}
+
+std::string ELFImage::String(const Section &strtab, unsigned long offset) const {
+    if(strtab.data == NULL || offset >= strtab.size)
+        return "";
+    const char *p = (const char *)strtab.data + offset;
+    return std::string(p, strnlen(p, strtab.size - offset));
+}
+
+const ELFImage::Section *ELFImage::FindSection(const std::string &name) const {
+    for(unsigned int i = 0; i < sections.size(); i++)
+        if(sections[i].name == name)
+            return &sections[i];
+    return NULL;
+}
+
+void ELFImage::ReadSymbols(const Section &symtab, std::vector<Symbol> &symbols) const {
+    if(symtab.data == NULL || symtab.link >= sections.size())
+        return;
+    const Section &strtab = sections[symtab.link];
+    for(unsigned long pos = 0; pos + sizeof(ELFIO::Elf32_Sym) <= symtab.size; pos += sizeof(ELFIO::Elf32_Sym)) {
+        ELFIO::Elf32_Sym es;
+        memcpy(&es, symtab.data + pos, sizeof(es));
+        Symbol sym;
+        sym.name = String(strtab, conv(es.st_name));
+        sym.value = conv(es.st_value);
+        sym.size = conv(es.st_size);
+        sym.bind = ELF_ST_BIND(es.st_info);
+        sym.type = ELF_ST_TYPE(es.st_info);
+        sym.sectionIndex = conv(es.st_shndx);
+        symbols.push_back(sym);
+    }
+}
+
+void ELFLoad(AvrDevice * core) {
+    ELFImage reader(core->GetFname());
 
     // over all symbols ...
-    ELFIO::Elf_Half sec_num = reader.sections.size();
-
-    for(ELFIO::Elf_Half i = 0; i < sec_num; i++) {
-        ELFIO::section* psec = reader.sections[i];
-
-        if(psec->get_type() == SHT_SYMTAB) {
-            const ELFIO::symbol_section_accessor symbols(reader, psec);
-
-            for(ELFIO::Elf_Xword j = 0; j < symbols.get_symbols_num(); j++) {
-                std::string       name;
-                ELFIO::Elf64_Addr value = 0;
-                ELFIO::Elf_Xword  size = 0;
-                unsigned char     bind = 0;
-                unsigned char     type = 0;
-                ELFIO::Elf_Half   section_index = 0;
-                unsigned char     other = 0;
-                
-                // read symbol properties
-                symbols.get_symbol(j, name, value, size, bind,
-                                      type, section_index, other);
+    for(unsigned int i = 0; i < reader.sections.size(); i++) {
+        const ELFImage::Section *psec = &reader.sections[i];
+
+        if(psec->type == SHT_SYMTAB) {
+            std::vector<ELFImage::Symbol> symbols;
+            reader.ReadSymbols(*psec, symbols);
+
+            for(unsigned int j = 0; j < symbols.size(); j++) {
+                const std::string &name = symbols[j].name;
+                unsigned long      value = symbols[j].value;
+                unsigned char      bind = symbols[j].bind;
+                unsigned char      type = symbols[j].type;
+                unsigned int       section_index = symbols[j].sectionIndex;
 
                 // check zero length names
                 if(name.length() == 0)
@@ -192,13 +371,13 @@ void ELFLoad(AvrDevice * core) {
                     core->Flash->AddSymbol(p);
                 } else if(value < 0x810000) {
                     // range of ram (.data)
-                    ELFIO::Elf64_Addr offset = value - 0x800000;
+                    unsigned long offset = value - 0x800000;
                     std::pair<unsigned int, std::string> p(offset, name);
 
                     core->data->AddSymbol(p);
                 } else if(value < 0x820000) {
                     // range of eeprom (.eeprom)
-                    ELFIO::Elf64_Addr offset = value - 0x810000;
+                    unsigned long offset = value - 0x810000;
                     std::pair<unsigned int, std::string> p(offset, name);
 
                     core->eeprom->AddSymbol(p);
@@ -217,7 +396,7 @@ void ELFLoad(AvrDevice * core) {
 
             }
         }
-        if(psec->get_name() == ".siminfo") {
+        if(psec->name == ".siminfo") {
             /*
              * You wonder why SIMINFO is read here, ignoring symbols?
              * Well, doing things this way is pretty independent from ELF
@@ -225,8 +404,8 @@ void ELFLoad(AvrDevice * core) {
              * Accordingly, we can add pretty much anything, as long as the
              * interpretation here matches what's given in simulavr_info.h.
              */
-            ELFIO::Elf_Xword filesize = psec->get_size();
-            const char *data = psec->get_data();
+            unsigned long filesize = psec->size;
+            const char *data = (const char *)psec->data;
             const char *data_ptr = data, *data_end = data + filesize;
 
             while(data_ptr < data_end) {
@@ -279,20 +458,19 @@ void ELFLoad(AvrDevice * core) {
     }
 
     // load program, data and - if available - eeprom, fuses and signature
-    ELFIO::Elf_Half seg_num = reader.segments.size();
-
-    for(ELFIO::Elf_Half i = 0; i < seg_num; i++) {
-        ELFIO::segment* pseg = reader.segments[i];
+    for(unsigned int i = 0; i < reader.segments.size(); i++) {
+        const ELFImage::Segment *pseg = &reader.segments[i];
 
-        if(pseg->get_type() == PT_LOAD) {
-            ELFIO::Elf_Xword  filesize = pseg->get_file_size();
-            ELFIO::Elf64_Addr vma = pseg->get_virtual_address();
-            ELFIO::Elf64_Addr pma = pseg->get_physical_address();
+        if(pseg->type == PT_LOAD) {
+            unsigned long filesize = pseg->filesize;
+            unsigned long vma = pseg->vaddr;
+            unsigned long pma = pseg->paddr;
 
             if(filesize == 0)
                 continue;
 
-            const unsigned char* data = (const unsigned char*)pseg->get_data();
+            // data is read directly from mapped file
+            const unsigned char* data = pseg->data;
 
             if(vma < 0x810000) {
                 // read program, space below 0x810000 (.text)
@@ -332,26 +510,16 @@ void ELFLoad(AvrDevice * core) {
 unsigned int ELFGetDeviceNameAndSignature(const char *filename, char *devicename) {
     unsigned int signature = std::numeric_limits<unsigned int>::max();
     unsigned int new_sig = 0;
-    ELFIO::elfio reader;
-
-    if(!reader.load(filename))
-        avr_error("File '%s' not found or isn't a elf object", filename);
-
-    if(reader.get_machine() != EM_AVR)
-        avr_error("ELF file '%s' is not for Atmel AVR architecture (%d)",
-                  filename,
-                  reader.get_machine());
+    ELFImage reader(filename);
 
     // Command line takes precedence.
     if(!strcmp(devicename, "unknown")) {
-        ELFIO::Elf_Half seg_num = reader.segments.size();
+        for(unsigned int i = 0; i < reader.segments.size(); i++) {
+            const ELFImage::Segment *pseg = &reader.segments[i];
 
-        for(ELFIO::Elf_Half i = 0; i < seg_num; i++) {
-            ELFIO::segment* pseg = reader.segments[i];
-
-            if(pseg->get_type() == PT_LOAD) {
-                ELFIO::Elf_Xword  filesize = pseg->get_file_size();
-                ELFIO::Elf64_Addr vma = pseg->get_virtual_address();
+            if(pseg->type == PT_LOAD) {
+                unsigned long filesize = pseg->filesize;
+                unsigned long vma = pseg->vaddr;
 
                 if(filesize == 0)
                     continue;
@@ -362,7 +530,7 @@ unsigned int ELFGetDeviceNameAndSignature(const char *filename, char *devicename
                         avr_error("wrong device signature size in elf file, "
                                   "expected=3, given=%lu", filesize);
                     else {
-                        const unsigned char* data = (const unsigned char*)pseg->get_data();
+                        const unsigned char* data = pseg->data;
 
                         signature = (((data[2] << 8) + data[1]) << 8) + data[0];
                         break;
@@ -371,14 +539,12 @@ unsigned int ELFGetDeviceNameAndSignature(const char *filename, char *devicename
             }
         }
 
-        ELFIO::Elf_Half sec_num = reader.sections.size();
-
-        for(ELFIO::Elf_Half i = 0; i < sec_num; i++) {
-            ELFIO::section* psec = reader.sections[i];
+        for(unsigned int i = 0; i < reader.sections.size(); i++) {
+            const ELFImage::Section *psec = &reader.sections[i];
 
-            if(psec->get_name() == ".siminfo") {
-                ELFIO::Elf_Xword filesize = psec->get_size();
-                const char *data = psec->get_data();
+            if(psec->name == ".siminfo") {
+                unsigned long filesize = psec->size;
+                const char *data = (const char *)psec->data;
                 const char *data_ptr = data, *data_end = data + filesize;
 
                 while(data_ptr < data_end) {
@@ -445,6 +611,290 @@ unsigned int ELFGetDeviceNameAndSignature(const char *filename, char *devicename
     return signature;
 }
 
+//! Reads data of a DWARF section, little endian as AVR ELF files are
+class DwarfReader {
+
+    public:
+        DwarfReader(const char *_data, size_t _size):
+            data((const unsigned char *)_data), size(_size), pos(0) {}
+
+        bool End(void) const { return pos >= size; }
+        size_t Pos(void) const { return pos; }
+        void Seek(size_t p) { pos = p; }
+
+        unsigned long long Fixed(int bytes) {
+            unsigned long long v = 0;
+            for(int i = 0; i < bytes; i++)
+                v |= (unsigned long long)Byte() << (8 * i);
+            return v;
+        }
+        unsigned char Byte(void) {
+            if(pos >= size)
+                avr_error("DWARF line table is truncated");
+            return data[pos++];
+        }
+        unsigned long long ULEB(void) {
+            unsigned long long v = 0;
+            int shift = 0;
+            unsigned char b;
+            do {
+                b = Byte();
+                if(shift < 64)
+                    v |= (unsigned long long)(b & 0x7f) << shift;
+                shift += 7;
+            } while(b & 0x80);
+            return v;
+        }
+        long long SLEB(void) {
+            long long v = 0;
+            int shift = 0;
+            unsigned char b;
+            do {
+                b = Byte();
+                if(shift < 64)
+                    v |= (long long)(b & 0x7f) << shift;
+                shift += 7;
+            } while(b & 0x80);
+            if(shift < 64 && (b & 0x40))
+                v |= -((long long)1 << shift);
+            return v;
+        }
+        std::string String(void) {
+            std::string s;
+            char c;
+            while((c = Byte()) != 0)
+                s += c;
+            return s;
+        }
+
+    private:
+        const unsigned char *data;
+        size_t size;
+        size_t pos;
+};
+
+//! Reads a string at offset of a string section (.debug_str, .debug_line_str)
+static std::string DwarfSectionString(const ELFImage::Section *sec, unsigned long long offset) {
+    if(sec == NULL || sec->data == NULL || offset >= sec->size)
+        return "";
+    const char *p = (const char *)sec->data + offset;
+    return std::string(p, strnlen(p, sec->size - offset));
+}
+
+//! Reads entry of directory or file table of a DWARF 5 line table header
+/*! Returns path (DW_LNCT_path) and directory index (DW_LNCT_directory_index). */
+static void DwarfEntry(DwarfReader &r,
+                       const std::vector<std::pair<unsigned long long, unsigned long long> > &format,
+                       int offsetSize,
+                       const ELFImage::Section *str,
+                       const ELFImage::Section *lineStr,
+                       std::string &path,
+                       unsigned long long &dir) {
+    for(unsigned int i = 0; i < format.size(); i++) {
+        unsigned long long value = 0;
+        std::string text;
+        switch(format[i].second) {
+            case 0x08: text = r.String(); break;                                // DW_FORM_string
+            case 0x0e: text = DwarfSectionString(str, r.Fixed(offsetSize)); break;    // DW_FORM_strp
+            case 0x1f: text = DwarfSectionString(lineStr, r.Fixed(offsetSize)); break; // DW_FORM_line_strp
+            case 0x0b: value = r.Fixed(1); break;                               // DW_FORM_data1
+            case 0x05: value = r.Fixed(2); break;                               // DW_FORM_data2
+            case 0x06: value = r.Fixed(4); break;                               // DW_FORM_data4
+            case 0x07: value = r.Fixed(8); break;                               // DW_FORM_data8
+            case 0x0f: value = r.ULEB(); break;                                 // DW_FORM_udata
+            case 0x1e: r.Seek(r.Pos() + 16); break;                             // DW_FORM_data16
+            case 0x09: r.Seek(r.Pos() + r.ULEB()); break;                       // DW_FORM_block
+            default:
+                avr_error("unsupported form 0x%llx in DWARF line table", format[i].second);
+        }
+        if(format[i].first == 1)        // DW_LNCT_path
+            path = text;
+        else if(format[i].first == 2)   // DW_LNCT_directory_index
+            dir = value;
+    }
+}
+
+//! Joins directory and file name, if file name isn't absolute
+static std::string DwarfPath(const std::string &dir, const std::string &file) {
+    if(dir.empty() || file.empty() || file[0] == '/')
+        return file;
+    if(dir[dir.size() - 1] == '/')
+        return dir + file;
+    return dir + "/" + file;
+}
+
+//! Reads the line number program of one unit in .debug_line
+static void DwarfLineUnit(DwarfReader &r,
+                          const ELFImage::Section *str,
+                          const ELFImage::Section *lineStr,
+                          std::vector<ELFLineEntry> &lines) {
+    int offsetSize = 4;
+    unsigned long long length = r.Fixed(4);
+    if(length == 0xffffffff) {
+        offsetSize = 8;
+        length = r.Fixed(8);
+    }
+    size_t end = r.Pos() + length;
+    unsigned int version = r.Fixed(2);
+    if(version < 2 || version > 5) {
+        avr_warning("DWARF line table version %d isn't supported", version);
+        r.Seek(end);
+        return;
+    }
+    if(version >= 5)
+        r.Fixed(2);                     // address size and segment selector size
+    unsigned long long headerLength = r.Fixed(offsetSize);
+    size_t program = r.Pos() + headerLength;
+    unsigned int minInstLength = r.Byte();
+    if(version >= 4)
+        r.Byte();                       // maximum operations per instruction, always 1 on AVR
+    r.Byte();                           // default is_stmt
+    int lineBase = (signed char)r.Byte();
+    unsigned int lineRange = r.Byte();
+    unsigned int opcodeBase = r.Byte();
+    std::vector<unsigned int> opcodeLength(opcodeBase, 0);
+    for(unsigned int i = 1; i < opcodeBase; i++)
+        opcodeLength[i] = r.Byte();
+    if(lineRange == 0)
+        avr_error("DWARF line table is corrupted");
+
+    std::vector<std::string> dirs;
+    std::vector<std::string> files;
+    if(version >= 5) {
+        std::vector<std::pair<unsigned long long, unsigned long long> > format;
+        unsigned int count = r.Byte();
+        for(unsigned int i = 0; i < count; i++) {
+            unsigned long long type = r.ULEB();
+            format.push_back(std::make_pair(type, r.ULEB()));
+        }
+        unsigned long long n = r.ULEB();
+        for(unsigned long long i = 0; i < n; i++) {
+            std::string path;
+            unsigned long long dir = 0;
+            DwarfEntry(r, format, offsetSize, str, lineStr, path, dir);
+            dirs.push_back(path);
+        }
+        format.clear();
+        count = r.Byte();
+        for(unsigned int i = 0; i < count; i++) {
+            unsigned long long type = r.ULEB();
+            format.push_back(std::make_pair(type, r.ULEB()));
+        }
+        n = r.ULEB();
+        for(unsigned long long i = 0; i < n; i++) {
+            std::string path;
+            unsigned long long dir = 0;
+            DwarfEntry(r, format, offsetSize, str, lineStr, path, dir);
+            files.push_back(DwarfPath((dir < dirs.size()) ? dirs[dir] : "", path));
+        }
+    } else {
+        // index 0 is directory of compilation, which is only in .debug_info
+        dirs.push_back("");
+        files.push_back("");
+        std::string s;
+        while(!(s = r.String()).empty())
+            dirs.push_back(s);
+        while(!(s = r.String()).empty()) {
+            unsigned long long dir = r.ULEB();
+            r.ULEB();                   // modification time
+            r.ULEB();                   // file size
+            files.push_back(DwarfPath((dir < dirs.size()) ? dirs[dir] : "", s));
+        }
+    }
+    r.Seek(program);
+
+    // state machine, a row covers addresses till next row of sequence
+    unsigned long long address = 0;
+    unsigned int file = 1;
+    long long line = 1;
+    bool rowValid = false;
+    ELFLineEntry row;
+    while(r.Pos() < end) {
+        unsigned int op = r.Byte();
+        bool emit = false;
+        bool endSequence = false;
+        if(op >= opcodeBase) {
+            unsigned int adjusted = op - opcodeBase;
+            address += (adjusted / lineRange) * minInstLength;
+            line += lineBase + (int)(adjusted % lineRange);
+            emit = true;
+        } else if(op == 0) {
+            unsigned long long len = r.ULEB();
+            size_t next = r.Pos() + len;
+            unsigned int sub = (len > 0) ? r.Byte() : 0;
+            if(sub == 1) {              // DW_LNE_end_sequence
+                emit = true;
+                endSequence = true;
+            } else if(sub == 2)         // DW_LNE_set_address
+                address = r.Fixed(len - 1);
+            else if(sub == 3) {         // DW_LNE_define_file
+                std::string s = r.String();
+                unsigned long long dir = r.ULEB();
+                files.push_back(DwarfPath((dir < dirs.size()) ? dirs[dir] : "", s));
+            }
+            r.Seek(next);
+        } else {
+            switch(op) {
+                case 1: emit = true; break;                                 // DW_LNS_copy
+                case 2: address += r.ULEB() * minInstLength; break;         // DW_LNS_advance_pc
+                case 3: line += r.SLEB(); break;                            // DW_LNS_advance_line
+                case 4: file = r.ULEB(); break;                             // DW_LNS_set_file
+                case 8: address += ((255 - opcodeBase) / lineRange) * minInstLength; break; // DW_LNS_const_add_pc
+                case 9: address += r.Fixed(2); break;                       // DW_LNS_fixed_advance_pc
+                default:
+                    // DW_LNS_set_column and others: skip operands
+                    for(unsigned int i = 0; i < opcodeLength[op]; i++)
+                        r.ULEB();
+            }
+        }
+        if(!emit)
+            continue;
+        if(rowValid && address > row.start) {
+            row.end = address;
+            lines.push_back(row);
+        }
+        if(endSequence) {
+            rowValid = false;
+            address = 0;
+            file = 1;
+            line = 1;
+        } else {
+            row.start = address;
+            row.file = (file < files.size()) ? files[file] : "";
+            row.line = line;
+            rowValid = true;
+        }
+    }
+    r.Seek(end);
+}
+
+bool ELFReadLineTable(const std::string &filename, std::vector<ELFLineEntry> &lines) {
+    ELFImage reader(filename);
+
+    const ELFImage::Section *debugLine = reader.FindSection(".debug_line");
+    if(debugLine == NULL || debugLine->data == NULL)
+        return false;
+    DwarfReader r((const char *)debugLine->data, debugLine->size);
+    while(!r.End())
+        DwarfLineUnit(r, reader.FindSection(".debug_str"), reader.FindSection(".debug_line_str"), lines);
+    return true;
+}
+
+void ELFReadFunctions(const std::string &filename, std::map<unsigned int, std::string> &functions) {
+    ELFImage reader(filename);
+
+    for(unsigned int i = 0; i < reader.sections.size(); i++) {
+        if(reader.sections[i].type != SHT_SYMTAB)
+            continue;
+        std::vector<ELFImage::Symbol> symbols;
+        reader.ReadSymbols(reader.sections[i], symbols);
+        for(unsigned int j = 0; j < symbols.size(); j++) {
+            if(symbols[j].type == STT_FUNC && !symbols[j].name.empty() && symbols[j].value < 0x800000)
+                functions.insert(std::make_pair((unsigned int)symbols[j].value, symbols[j].name));
+        }
+    }
+}
+
 #endif
 
 // EOF
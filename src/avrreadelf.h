@@ -26,9 +26,28 @@
 #ifndef AVRREADELF
 #define AVRREADELF
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "avrdevice.h"
 
+//! Source line of a range of flash, from DWARF line table
+struct ELFLineEntry {
+    unsigned int start;     //!< first byte address of range
+    unsigned int end;       //!< byte address behind range
+    std::string file;       //!< source file, with directory from line table
+    unsigned int line;
+};
+
 unsigned int ELFGetDeviceNameAndSignature(const char *filename, char *devicename);
 void ELFLoad(AvrDevice * core);
 
+//! Reads DWARF line table (section .debug_line) of a ELF file
+/*! Line table versions 2 to 5 are supported. Returns false, if file has no
+  line table (program isn't compiled with -g). */
+bool ELFReadLineTable(const std::string &filename, std::vector<ELFLineEntry> &lines);
+//! Reads function symbols in flash of a ELF file, byte address to name
+void ELFReadFunctions(const std::string &filename, std::map<unsigned int, std::string> &functions);
+
 #endif
@@ -0,0 +1,222 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef _MSC_VER
+#   include "config.h"
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+#include "binarytrace.h"
+#include "avrdevice.h"
+#include "avrerror.h"
+
+#ifdef HAVE_LIBPTHREAD
+#   include <pthread.h>
+#endif
+
+using namespace std;
+
+//! Ring of buffers and writer thread of a BinaryTrace
+struct BinaryTraceWriter {
+    vector<BinaryTraceRecord *> buffers;     //!< all allocated buffers
+    vector<BinaryTraceRecord *> freeBuffers; //!< buffers, which could be filled
+    deque<pair<BinaryTraceRecord *, unsigned int> > fullBuffers; //!< buffers to write with count of records
+#ifdef HAVE_LIBPTHREAD
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t fullCond;    //!< signals a full buffer or stop to writer thread
+    pthread_cond_t freeCond;    //!< signals a written buffer to simulation
+    bool writing;               //!< writer thread writes a buffer just now
+    bool stop;                  //!< writer thread has to exit
+#endif
+};
+
+//! Header of trace file
+struct BinaryTraceHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t byteOrder;         //!< 0x01020304 in byte order of writer
+};
+
+const char BinaryTrace::magic[8] = { 'S', 'I', 'M', 'A', 'V', 'R', 'B', 'T' };
+
+//! All open traces, written on exit by CloseAll
+static vector<BinaryTrace *> openTraces;
+
+BinaryTrace::BinaryTrace(const string &filename,
+                         unsigned int _bufferSize,
+                         unsigned int bufferCount):
+    bufferSize(_bufferSize),
+    fill(0),
+    devices(0)
+{
+    file = fopen(filename.c_str(), "wb");
+    if(file == NULL)
+        avr_error("can't create binary trace file '%s'", filename.c_str());
+
+    BinaryTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = version;
+    header.recordSize = sizeof(BinaryTraceRecord);
+    header.byteOrder = 0x01020304;
+    Write(&header, sizeof(header));
+
+    writer = new BinaryTraceWriter;
+    if(bufferCount < 2)
+        bufferCount = 2;
+    for(unsigned int i = 0; i < bufferCount; i++) {
+        writer->buffers.push_back(new BinaryTraceRecord[bufferSize]);
+        writer->freeBuffers.push_back(writer->buffers[i]);
+    }
+    current = writer->freeBuffers.back();
+    writer->freeBuffers.pop_back();
+
+#ifdef HAVE_LIBPTHREAD
+    writer->writing = false;
+    writer->stop = false;
+    pthread_mutex_init(&writer->mutex, NULL);
+    pthread_cond_init(&writer->fullCond, NULL);
+    pthread_cond_init(&writer->freeCond, NULL);
+    if(pthread_create(&writer->thread, NULL, WriterThread, this) != 0)
+        avr_error("can't create writer thread for binary trace");
+#endif
+
+    // records have to be written, even if simulation is terminated by avr_error
+    if(openTraces.empty())
+        atexit(CloseAll);
+    openTraces.push_back(this);
+}
+
+BinaryTrace::~BinaryTrace() {
+    openTraces.erase(find(openTraces.begin(), openTraces.end(), this));
+    Flush();
+
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&writer->mutex);
+    writer->stop = true;
+    pthread_cond_signal(&writer->fullCond);
+    pthread_mutex_unlock(&writer->mutex);
+    pthread_join(writer->thread, NULL);
+    pthread_cond_destroy(&writer->freeCond);
+    pthread_cond_destroy(&writer->fullCond);
+    pthread_mutex_destroy(&writer->mutex);
+#endif
+
+    for(unsigned int i = 0; i < writer->buffers.size(); i++)
+        delete [] writer->buffers[i];
+    delete writer;
+    fclose(file);
+}
+
+unsigned char BinaryTrace::AddDevice(AvrDevice *dev) {
+    unsigned char index = devices++;
+    string text = dev->GetDeviceName() + "\n" + dev->GetFname();
+    Add(index, REC_DEVICE, text.size(), 0);
+    for(unsigned int pos = 0; pos < text.size(); pos += sizeof(BinaryTraceRecord)) {
+        if(fill == bufferSize)
+            NextBuffer();
+        BinaryTraceRecord *r = current + fill++;
+        memset(r, 0, sizeof(BinaryTraceRecord));
+        text.copy((char *)r, sizeof(BinaryTraceRecord), pos);
+    }
+    unsigned long long cycle = dev->GetCycleCount();
+    Add(index, REC_CYCLE, cycle & 0xffffffff, (cycle >> 32) & 0xffff);
+
+    dev->binaryTrace = this;
+    dev->binaryTraceIndex = index;
+    dev->UpdateDirectAccess(); // all writes have to be traced
+    return index;
+}
+
+void BinaryTrace::Write(const void *data, size_t size) {
+    if(fwrite(data, 1, size, file) != size)
+        avr_error("can't write binary trace file");
+}
+
+void BinaryTrace::NextBuffer(void) {
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&writer->mutex);
+    writer->fullBuffers.push_back(make_pair(current, fill));
+    pthread_cond_signal(&writer->fullCond);
+    while(writer->freeBuffers.empty())
+        pthread_cond_wait(&writer->freeCond, &writer->mutex);
+    current = writer->freeBuffers.back();
+    writer->freeBuffers.pop_back();
+    pthread_mutex_unlock(&writer->mutex);
+#else
+    Write(current, fill * sizeof(BinaryTraceRecord));
+#endif
+    fill = 0;
+}
+
+void BinaryTrace::Flush(void) {
+    NextBuffer();
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&writer->mutex);
+    while(!writer->fullBuffers.empty() || writer->writing)
+        pthread_cond_wait(&writer->freeCond, &writer->mutex);
+    pthread_mutex_unlock(&writer->mutex);
+#endif
+    fflush(file);
+}
+
+void *BinaryTrace::WriterThread(void *trace) {
+#ifdef HAVE_LIBPTHREAD
+    BinaryTrace *t = (BinaryTrace *)trace;
+    BinaryTraceWriter *w = t->writer;
+    pthread_mutex_lock(&w->mutex);
+    while(true) {
+        while(w->fullBuffers.empty() && !w->stop)
+            pthread_cond_wait(&w->fullCond, &w->mutex);
+        if(w->fullBuffers.empty())
+            break;
+        pair<BinaryTraceRecord *, unsigned int> b = w->fullBuffers.front();
+        w->fullBuffers.pop_front();
+        w->writing = true;
+        pthread_mutex_unlock(&w->mutex);
+
+        t->Write(b.first, b.second * sizeof(BinaryTraceRecord));
+
+        pthread_mutex_lock(&w->mutex);
+        w->writing = false;
+        w->freeBuffers.push_back(b.first);
+        pthread_cond_broadcast(&w->freeCond);
+    }
+    pthread_mutex_unlock(&w->mutex);
+#endif
+    return NULL;
+}
+
+void BinaryTrace::CloseAll(void) {
+    for(unsigned int i = 0; i < openTraces.size(); i++)
+        openTraces[i]->Flush();
+}
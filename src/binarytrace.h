@@ -0,0 +1,141 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef BINARYTRACE
+#define BINARYTRACE
+
+#include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+class AvrDevice;
+struct BinaryTraceWriter;
+
+//! One record of a binary execution trace, see BinaryTrace
+/*! All records have the same size. Which fields are used, depends on type. */
+struct BinaryTraceRecord {
+    uint32_t address;   //!< program counter (word address), data address or stack pointer
+    uint16_t value;     //!< opcode, written value, vector or status register
+    uint8_t type;       //!< record type, see BinaryTrace::RecordType
+    uint8_t device;     //!< index of device, see BinaryTrace::AddDevice
+};
+
+//! Writes a compact binary execution trace to file
+/*! This is a replacement for the text trace (option -t), which formats every
+  instruction by iostreams and slows down simulation very much. Every event
+  of the text trace is written as a fixed size BinaryTraceRecord to a ring of
+  buffers. Full buffers are written to file by a background thread (if
+  pthread is available, otherwise in place). The tool simulavr-tracedump
+  converts a binary trace back to the text trace format.
+
+  File layout: a header of 16 bytes ("SIMAVRBT", version, record size and a
+  byte order mark), then records. A record REC_DEVICE describes a device, it's
+  followed by 'address' bytes of text ("<device type>\n<program file>"),
+  padded to a multiple of record size, and a REC_CYCLE record.
+
+  Every trace line (one core cycle) starts with a record, which has REC_LINE
+  flag set, it's address is the program counter for this line. So the cycle
+  counter is the count of lines after REC_CYCLE. Records REC_WRITE (all
+  writes to registers and data memory) and REC_STATUS (status register and
+  stack pointer, written after a step, if changed) make it possible to
+  replay instructions in simulavr-tracedump. */
+class BinaryTrace {
+
+    public:
+        //! Record types, see BinaryTraceRecord::type
+        enum RecordType {
+            REC_DEVICE = 1,     //!< device description, followed by text
+            REC_INSTRUCTION,    //!< instruction executed, value is opcode
+            REC_OPERAND,        //!< second word of a 2 word instruction in value
+            REC_WAITSTATE,      //!< core waits for end of a multi cycle instruction
+            REC_SLEEP,          //!< core is in sleep mode
+            REC_HOLD,           //!< core is hold by hardware
+            REC_BREAKPOINT,     //!< breakpoint found
+            REC_IRQ,            //!< interrupt detected, value is vector address
+            REC_IRQ_PREPARED,   //!< interrupt prepared, value is vector address
+            REC_IRQ_PENDING,    //!< interrupt flag set, value is vector number
+            REC_IRQ_CLEARED,    //!< interrupt flag cleared, value is vector number
+            REC_IRQ_STARTED,    //!< interrupt handler started, value is vector number
+            REC_IRQ_FINISHED,   //!< interrupt handler finished, value is vector number
+            REC_WRITE,          //!< data memory written, address and new value
+            REC_STATUS,         //!< address is stack pointer, value is status register
+            REC_CYCLE,          //!< cycle counter of device: address bits 0-31, value bits 32-47
+            REC_TYPE_MASK = 0x7f,
+            REC_LINE = 0x80     //!< flag: record starts a new trace line
+        };
+
+        static const char magic[8];   //!< file magic "SIMAVRBT"
+        static const uint16_t version = 1;
+
+        //! Opens trace file and starts writer thread
+        /*! @param filename name of trace file
+          @param bufferSize count of records in one buffer
+          @param bufferCount count of buffers in ring */
+        BinaryTrace(const std::string &filename,
+                    unsigned int bufferSize = 4096,
+                    unsigned int bufferCount = 16);
+        //! Writes all buffered records, stops writer thread and closes file
+        ~BinaryTrace();
+
+        //! Adds a device to trace, returns index of device
+        /*! Enables binary trace on device, see AvrDevice::binaryTrace. Device
+          name and program file name must be set before. */
+        unsigned char AddDevice(AvrDevice *dev);
+
+        //! Adds a record to trace
+        void Add(unsigned char device,
+                 unsigned char type,
+                 uint32_t address,
+                 uint16_t value) {
+            if(fill == bufferSize)
+                NextBuffer();
+            BinaryTraceRecord *r = current + fill++;
+            r->address = address;
+            r->value = value;
+            r->type = type;
+            r->device = device;
+        }
+
+        //! Writes all records to file, which are added till now
+        void Flush(void);
+
+    protected:
+        FILE *file;                 //!< trace file
+        unsigned int bufferSize;    //!< count of records in one buffer
+        BinaryTraceRecord *current; //!< buffer, which is filled by Add
+        unsigned int fill;          //!< count of records in current
+        unsigned char devices;      //!< count of devices, see AddDevice
+        BinaryTraceWriter *writer;  //!< ring of buffers and writer thread
+
+        //! Gives current buffer to writer and gets a empty buffer
+        void NextBuffer(void);
+        //! Writes a raw block to file
+        void Write(const void *data, size_t size);
+
+        static void *WriterThread(void *trace);
+        static void CloseAll(void);
+};
+
+#endif
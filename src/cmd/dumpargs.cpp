@@ -32,6 +32,7 @@
 #include "dumpargs.h"
 #include "../helper.h"
 #include "../avrerror.h"
+#include "../compressedstream.h"
 #include "../flash.h"
 #include "../hweeprom.h"
 
@@ -54,7 +55,7 @@ void SetDumpTraceArgs(const vector<string> &traceopts, AvrDevice *dev) {
             d = new WarnUnknown(dev);
         } else if (ls[0] == "vcd") {
             cerr << "vcd'." << endl;
-            if(ls.size() < 3 || ls.size() > 4)
+            if(ls.size() < 3 || ls.size() > 5)
                 avr_error("Invalid number of options for 'vcd'.");
             cerr << "Reading values to trace from '" << ls[1] << "'." << endl;
         
@@ -65,18 +66,20 @@ void SetDumpTraceArgs(const vector<string> &traceopts, AvrDevice *dev) {
             cerr << "Output VCD file is '" << ls[2] << "'." << endl;
             ts = dman->load(is);
         
-            bool rs = false, ws = false;
-            if(ls.size() == 4) { // ReadStrobe/WriteStrobe display specified?
-                if(ls[3] == "rw") {
+            bool rs = false, ws = false, compress = false;
+            for(size_t j = 3; j < ls.size(); j++) {
+                if(ls[j] == "rw") { // ReadStrobe/WriteStrobe display specified?
                     rs = ws = true;
-                } else if(ls[3] == "r") {
+                } else if(ls[j] == "r") {
                     rs = true;
-                } else if(ls[3] == "w") {
+                } else if(ls[j] == "w") {
                     ws = true;
+                } else if(ls[j] == "gz") { // compressed output
+                    compress = true;
                 } else
-                    avr_error("Invalid read/write strobe specifier '%s'", ls[3].c_str());
+                    avr_error("Invalid read/write strobe specifier '%s'", ls[j].c_str());
             }
-            d = new DumpVCD(ls[2], "ns", rs, ws);
+            d = new DumpVCD(OpenTraceOutput(ls[2], compress), "ns", rs, ws);
         } else
             avr_error("Unknown tracer '%s'", ls[0].c_str());
         dman->addDumper(d, ts);
@@ -42,11 +42,13 @@
 #endif
 
 #include <vector>
+#include <string>
 #include "avrdevice.h"
 #include "types.h"
 #include "simulationmember.h"
 
 #define MAX_BUF 400 /* Maximum size of read/write buffers. */
+#define GDB_RX_BUFFER_SIZE 4096 /* Size of receive buffer of gdb socket. */
 
 // this are similar to unix signal numbers, but here used only as number, not
 // as signal! See signum.h on unix systems for the values.
@@ -60,9 +62,12 @@ class GdbServerSocket {
     public:
         //GdbServerSocket(int port);
         virtual void Close(void)=0;
+        //! Returns next received byte (0..255) or -1, if nothing is received in non blocking mode
         virtual int ReadByte(void)=0;
         virtual void Write(const void* buf, size_t count)=0;
         virtual void SetBlockingMode(int mode)=0;
+        //! True, if data from gdb (or end of connection) can be read without blocking
+        virtual bool DataAvailable(void)=0;
         virtual bool Connect(void)=0;
         virtual void CloseConnection(void)=0;
         virtual ~GdbServerSocket(){}
@@ -79,6 +84,10 @@ class GdbServerSocketMingW: public GdbServerSocket {
         static int socketCount;
         SOCKET _socket;
         SOCKET _conn;
+        int blockingMode;   //!< mode set by SetBlockingMode, -1 if unknown
+        char rxBuffer[GDB_RX_BUFFER_SIZE]; //!< received data, not read by ReadByte
+        int rxPos;          //!< next byte in rxBuffer to read
+        int rxCount;        //!< count of valid bytes in rxBuffer
         
     public:
         GdbServerSocketMingW(int port);
@@ -87,6 +96,7 @@ class GdbServerSocketMingW: public GdbServerSocket {
         virtual int ReadByte(void);
         virtual void Write(const void* buf, size_t count);
         virtual void SetBlockingMode(int mode);
+        virtual bool DataAvailable(void);
         virtual bool Connect(void);
         virtual void CloseConnection(void);
 };
@@ -98,6 +108,10 @@ class GdbServerSocketUnix: public GdbServerSocket {
     private:
         int sock;       //!< socket for listening for a new client
         int conn;       //!< the TCP connection from gdb client
+        int blockingMode; //!< mode set by SetBlockingMode, -1 if unknown
+        char rxBuffer[GDB_RX_BUFFER_SIZE]; //!< received data, not read by ReadByte
+        int rxPos;      //!< next byte in rxBuffer to read
+        int rxCount;    //!< count of valid bytes in rxBuffer
         struct sockaddr_in address[1];
 
     public:
@@ -107,6 +121,7 @@ class GdbServerSocketUnix: public GdbServerSocket {
         virtual int ReadByte(void);
         virtual void Write(const void* buf, size_t count);
         virtual void SetBlockingMode(int mode);
+        virtual bool DataAvailable(void);
         virtual bool Connect(void);
         virtual void CloseConnection(void);
 };
@@ -131,11 +146,16 @@ class GdbServer: public SimulationMember {
         bool exitOnKillRequest; //!< flag for regression test to shutdown simulator on kill request from gdb
         int runMode;
         bool lastCoreStepFinished;
+        unsigned int pollCountdown; //!< steps in continue mode till next look at wall clock
+        unsigned long lastPollTime; //!< wall clock in ms, when socket was polled last time
+        /*! breakpoints, if core has a execution history, they are checked here
+          and not by the core, so a replayed step is the same as the recorded */
+        Breakpoints historyBreakpoints;
 
         //old function local static vars, must move to class, no way to handle
         //method local static vars.
         char *last_reply;  //used in last_reply();
-        char buf[MAX_BUF]; //used in send_reply();
+        int packetLength;  //!< length of packet in gdb_parse_packet, binary data can contain 0
         int m_gdb_thread_id;  ///< For queries by GDB. First thread ID is 1. See http://sources.redhat.com/gdb/current/onlinedocs/gdb/Packets.html#thread-id
 
 
@@ -143,8 +163,11 @@ class GdbServer: public SimulationMember {
         void avr_core_flash_write(int addr, word val) ;
         void avr_core_flash_write_hi8( int addr, byte val) ;
         void avr_core_flash_write_lo8( int addr, byte val) ;
+        //! Breakpoints of core or historyBreakpoints
+        Breakpoints &GetBreakpoints(void);
         void avr_core_remove_breakpoint(dword pc) ;
-        void avr_core_insert_breakpoint(dword pc) ;
+        void avr_core_insert_breakpoint(dword pc, BreakpointCondition *cond = NULL) ;
+        BreakpointCondition *gdb_parse_conditions(const char *pkt);
         int signal_has_occurred(int signo); 
         void signal_watch_start(int signo);
         void signal_watch_stop(int signo);
@@ -162,13 +185,25 @@ class GdbServer: public SimulationMember {
         int gdb_get_addr_len(const char *pkt, char a_end, char l_end, unsigned int *addr, int *len);
         void gdb_read_memory(const char *pkt);
         void gdb_write_memory(const char *pkt);
+        void gdb_write_memory_binary(const char *pkt);
+        //! Writes data to flash, sram or eeprom, returns false on a invalid address
+        bool gdb_write_bytes(unsigned int addr, const byte *data, int len);
+        void gdb_flash_command(const char *pkt);
+        void gdb_send_xfer(const char *pkt, const std::string &data);
+        std::string gdb_memory_map(void);
         void gdb_break_point(const char *pkt);
+        //! Reverse step or continue in execution history ("bs", "bc")
+        void gdb_reverse(const char *pkt);
         void gdb_select_thread(const char *pkt);
         void gdb_is_thread_alive(const char *pkt);
         void gdb_get_thread_list(const char *pkt);
         int gdb_get_signal(const char *pkt);
         int gdb_parse_packet(const char *pkt);
         int gdb_receive_and_process_packet(int blocking);
+        //! True, if socket should be read in continue mode, see InternalStep
+        bool PollGdb(void);
+        //! Steps core, through it's execution history, if there is one
+        int CoreStep(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns);
         void gdb_main_loop(); 
         void gdb_interact(int port, int debug_on);
         void IdleStep();
@@ -177,7 +212,8 @@ class GdbServer: public SimulationMember {
         int Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns=0) ;
         int InternalStep(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns=0) ;
         void TryConnectGdb();
-        void SendPosition(int signal); //send gdb the actual position where the simulation is stopped
+        //! send gdb the actual position where the simulation is stopped, reason is a stop reason like "watch:<addr>;" or NULL
+        void SendPosition(int signal, const char *reason = NULL);
         int SleepStep();
         GdbServer( AvrDevice*, int port, int debugOn, int WaitForGdbConnection=true);
         virtual ~GdbServer();
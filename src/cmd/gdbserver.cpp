@@ -33,6 +33,10 @@ using namespace std;
 #ifndef _MSC_VER
 #include <unistd.h>
 #endif
+#if !defined(HAVE_SYS_MINGW) && !defined(_MSC_VER)
+#include <poll.h>
+#include <sys/time.h>
+#endif
 #include <fcntl.h>
 #include <time.h>
 #include <signal.h>
@@ -45,6 +49,7 @@ using namespace std;
 /* only for compilation ... later to be removed */
 #include "avrdevice.h"
 #include "avrdevice_impl.h"
+#include "executionhistory.h"
 #include "gdb.h"
 
 #ifdef _MSC_VER
@@ -61,6 +66,12 @@ enum {
     EEPROM_OFFSET  = 0x00810000,  /* Data in eeprom has this offset from gdb */
     SIGNATURE_OFFSET = 0x00840000,/* Present if application used "#include <avr/signature.h>" */
 
+    PACKET_SIZE    = 0x4000,      /* Maximum packet size, which is told to gdb */
+    FLASH_BLOCK_SIZE = 0x80,      /* Erase block size of flash in memory map for gdb */
+
+    POLL_STEPS     = 1000,        /* Steps in continue mode between looks at wall clock */
+    POLL_INTERVAL  = 10,          /* Minimal time in ms between polls of gdb socket in continue mode */
+
     GDB_BLOCKING_OFF = 0,         /* Signify that a read is non-blocking. */
     GDB_BLOCKING_ON  = 1,         /* Signify that a read will block. */
 
@@ -91,7 +102,7 @@ void GdbServerSocketMingW::End() {
     WSACleanup();
 }
 
-GdbServerSocketMingW::GdbServerSocketMingW(int port): _socket(0), _conn(0) {
+GdbServerSocketMingW::GdbServerSocketMingW(int port): _socket(0), _conn(0), blockingMode(-1), rxPos(0), rxCount(0) {
     sockaddr_in sa;
     
     Start();
@@ -126,18 +137,39 @@ void GdbServerSocketMingW::Close(void) {
 }
 
 int GdbServerSocketMingW::ReadByte(void) {
-    char buf[1];
-    int rv = recv(_conn, buf, 1, 0);
-    if(rv <= 0)
-        return -1;
-    return buf[0];
+    if(rxPos == rxCount) {
+        int rv = recv(_conn, rxBuffer, sizeof(rxBuffer), 0);
+        if(rv <= 0)
+            return -1;
+        rxPos = 0;
+        rxCount = rv;
+    }
+    return (unsigned char)rxBuffer[rxPos++];
 }
 
 void GdbServerSocketMingW::Write(const void* buf, size_t count) {
-    send(_conn, (const char *)buf, count, 0);
+    const char *p = (const char *)buf;
+    while(count > 0) {
+        int rv = send(_conn, p, count, 0);
+        if(rv == SOCKET_ERROR) {
+            if(WSAGetLastError() != WSAEWOULDBLOCK)
+                avr_error("send failed: %d", WSAGetLastError());
+            // socket is in non blocking mode, wait till it's writable
+            fd_set fds;
+            FD_ZERO(&fds);
+            FD_SET(_conn, &fds);
+            select(0, NULL, &fds, NULL, NULL);
+            continue;
+        }
+        p += rv;
+        count -= rv;
+    }
 }
 
 void GdbServerSocketMingW::SetBlockingMode(int mode) {
+    if(mode == blockingMode)
+        return;
+    blockingMode = mode;
     u_long arg = 1;
     if(mode)
         arg = 0;
@@ -146,7 +178,21 @@ void GdbServerSocketMingW::SetBlockingMode(int mode) {
         avr_warning( "fcntl failed: %d\n", WSAGetLastError() );
 }
 
+bool GdbServerSocketMingW::DataAvailable(void) {
+    if(rxPos < rxCount)
+        return true;
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(_conn, &fds);
+    timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 0;
+    return select(0, &fds, NULL, &fds, &tv) != 0;
+}
+
 bool GdbServerSocketMingW::Connect(void) {
+    blockingMode = -1;
+    rxPos = rxCount = 0;
     _conn = accept(_socket, 0, 0);
     if(_conn == INVALID_SOCKET) {
         int rc = WSAGetLastError();
@@ -166,6 +212,8 @@ void GdbServerSocketMingW::CloseConnection(void) {
 
 GdbServerSocketUnix::GdbServerSocketUnix(int port) {
     conn = -1;        //no connection opened
+    blockingMode = -1;
+    rxPos = rxCount = 0;
     
     if((sock = socket(PF_INET, SOCK_STREAM, 0)) < 0)
         avr_error("Can't create socket: %s", strerror(errno));
@@ -197,13 +245,17 @@ void GdbServerSocketUnix::Close(void) {
     close(sock);
 }
 
+/*! Data is read in blocks to rxBuffer, so a packet from gdb needs only
+  one system call, not one per byte. */
 int GdbServerSocketUnix::ReadByte(void) {
-    char c;
     int res;
     int cnt = MAX_READ_RETRY;
 
+    if(rxPos < rxCount)
+        return (unsigned char)rxBuffer[rxPos++];
+
     while(cnt--) {
-        res = read(conn, &c, 1);
+        res = read(conn, rxBuffer, sizeof(rxBuffer));
         if(res < 0) {
             if (errno == EAGAIN)
                 /* fd was set to non-blocking and no data was available */
@@ -217,7 +269,9 @@ int GdbServerSocketUnix::ReadByte(void) {
             avr_warning("incomplete read\n");
             continue;
         }
-        return c;
+        rxPos = 1;
+        rxCount = res;
+        return (unsigned char)rxBuffer[0];
     }
     avr_error("Maximum read reties reached");
 
@@ -225,21 +279,32 @@ int GdbServerSocketUnix::ReadByte(void) {
 }
 
 void GdbServerSocketUnix::Write(const void* buf, size_t count) {
-    int res;
+    const char *p = (const char *)buf;
 
-    res = write(conn, buf, count);
-
-    /* FIXME: should we try and catch interrupted system calls here? */
-    if(res < 0)
-        avr_error("write failed: %s", strerror(errno));
-
-    /* FIXME: if this happens a lot, we could try to resend the
-    unsent bytes. */
-    if((unsigned int)res != count)
-        avr_error("write only wrote %d of %d bytes", res, count);
+    while(count > 0) {
+        ssize_t res = write(conn, p, count);
+        if(res < 0) {
+            if(errno == EINTR)
+                continue;
+            if(errno != EAGAIN)
+                avr_error("write failed: %s", strerror(errno));
+            /* socket is in non blocking mode, wait till it's writable */
+            struct pollfd pfd;
+            pfd.fd = conn;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            poll(&pfd, 1, -1);
+            continue;
+        }
+        p += res;
+        count -= res;
+    }
 }
 
 void GdbServerSocketUnix::SetBlockingMode(int mode) {
+    if(mode == blockingMode)
+        return;
+    blockingMode = mode;
     if(mode) {
         /* turn non-blocking mode off */
         if(fcntl(conn, F_SETFL, fcntl(conn, F_GETFL, 0) & ~O_NONBLOCK) < 0)
@@ -251,6 +316,17 @@ void GdbServerSocketUnix::SetBlockingMode(int mode) {
     }
 }
 
+bool GdbServerSocketUnix::DataAvailable(void) {
+    if(rxPos < rxCount)
+        return true;
+    struct pollfd pfd;
+    pfd.fd = conn;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    // a error or hangup is also returned, so ReadByte will report it
+    return poll(&pfd, 1, 0) != 0;
+}
+
 bool GdbServerSocketUnix::Connect(void) {
     /* accept() needs this set, or it fails (sometimes) */
     socklen_t addrLength = sizeof(struct sockaddr_in);
@@ -258,6 +334,8 @@ bool GdbServerSocketUnix::Connect(void) {
     /* We only want to accept a single connection, thus don't need a loop. */
     /* Wait until we have a connection */
     conn = accept(sock, (struct sockaddr *)address, &addrLength);
+    blockingMode = -1;
+    rxPos = rxCount = 0;
     if(conn > 0) {
         /* Tell TCP not to delay small packets.  This greatly speeds up
         interactive response. WARNING: If TCP_NODELAY is set on, then gdb
@@ -292,8 +370,11 @@ GdbServer::GdbServer(AvrDevice *c, int _port, int debug, int _waitForGdbConnecti
     exitOnKillRequest(false)
 {
     last_reply = NULL; //init static var for last_reply()
+    packetLength = 0;
     runMode = GDB_RET_NOTHING_RECEIVED;
     lastCoreStepFinished = true;
+    pollCountdown = POLL_STEPS;
+    lastPollTime = 0;
     connState = false;
     m_gdb_thread_id = 1;  // we start with the first thread already created
 
@@ -343,13 +424,244 @@ void GdbServer::avr_core_flash_write_lo8(int addr, byte val) {
     core->Flash->Decode();
 }
 
+Breakpoints &GdbServer::GetBreakpoints(void) {
+    return (core->history != NULL) ? historyBreakpoints : core->BP;
+}
+
 void GdbServer::avr_core_remove_breakpoint(dword pc) {
-    Breakpoints::iterator ii;
-    if ((ii= find(core->BP.begin(), core->BP.end(), pc)) != core->BP.end()) core->BP.erase(ii);
+    Breakpoints &bp = GetBreakpoints();
+    if (bp.IsSet(pc))
+        bp.RemoveBreakpoint(pc);
+}
+
+/*! gdb sends a insert again, if conditions of a breakpoint are changed, so
+  the breakpoint is added only once. cond replaces the old condition. */
+void GdbServer::avr_core_insert_breakpoint(dword pc, BreakpointCondition *cond) {
+    Breakpoints &bp = GetBreakpoints();
+    if (!bp.IsSet(pc))
+        bp.AddBreakpoint(pc);
+    bp.SetCondition(pc, cond);
+}
+
+/*! Breakpoint condition from gdb, a list of agent expressions (bytecode, see
+  "Agent Expressions" in gdb manual). The breakpoint stops, if one of the
+  expressions is not 0 or can't be evaluated. */
+class GdbBreakpointCondition: public BreakpointCondition {
+
+    public:
+        std::vector<std::vector<byte> > expressions;
+
+        virtual bool IsTrue(AvrDevice *core) {
+            bool result = false;
+            for (unsigned int i = 0; i < expressions.size() && !result; i++)
+            {
+                bool error = false;
+                long long value = Evaluate(core, expressions[i], error);
+                result = error || value != 0;
+            }
+            /* reading memory here isn't a access of the program */
+            core->ClearWatchpointHit();
+            return result;
+        }
+
+    private:
+        enum { STACK_SIZE = 100, MAX_OPS = 10000 };
+
+        static long long ReadMemory(AvrDevice *core, unsigned int addr, int size, bool &error);
+        static long long Evaluate(AvrDevice *core, const std::vector<byte> &code, bool &error);
+};
+
+//! Reads size bytes (little endian) from gdb address space
+long long GdbBreakpointCondition::ReadMemory(AvrDevice *core, unsigned int addr, int size, bool &error) {
+    unsigned long long value = 0;
+    for (int i = size - 1; i >= 0; i--)
+    {
+        unsigned int a = addr + i;
+        byte b = 0;
+        if (a < SRAM_OFFSET)
+        {
+            if (a >= core->Flash->GetSize())
+                error = true;
+            else
+            {
+                word w = core->Flash->ReadMemRawWord(a & ~1);
+                b = (a & 1) ? (w >> 8) : (w & 0xff);
+            }
+        }
+        else if ((a & MEM_SPACE_MASK) == SRAM_OFFSET)
+            b = core->GetRWMem(a & ~MEM_SPACE_MASK);
+        else if ((a & MEM_SPACE_MASK) == EEPROM_OFFSET && core->eeprom != NULL)
+            b = core->eeprom->ReadFromAddress(a & ~MEM_SPACE_MASK);
+        else
+            error = true;
+        value = (value << 8) | b;
+    }
+    return value;
+}
+
+long long GdbBreakpointCondition::Evaluate(AvrDevice *core, const std::vector<byte> &code, bool &error) {
+    long long stack[STACK_SIZE];
+    int sp = 0;             /* count of values on stack */
+    unsigned int pc = 0;
+    long long a = 0, b = 0;
+
+    for (int ops = 0; ops < MAX_OPS; ops++)
+    {
+        if (pc >= code.size())
+            break;
+        byte op = code[pc++];
+        /* count of stack values, which are used by op */
+        int in = (op >= 0x02 && op <= 0x15 && op != 0x0e && op != 0x12) ? 2 :
+                 (op == 0x2b) ? 2 : (op == 0x33) ? 3 :
+                 (op == 0x0e || op == 0x12 || op == 0x16 || (op >= 0x17 && op <= 0x1a) ||
+                  op == 0x20 || op == 0x28 || op == 0x29 || op == 0x2a) ? 1 : 0;
+        if (sp < in || sp >= STACK_SIZE - 1)
+            break;
+        /* length of immediate operand */
+        unsigned int imm = (op == 0x16 || op == 0x22 || op == 0x2a || op == 0x32) ? 1 :
+                           (op == 0x20 || op == 0x21 || op == 0x23 || op == 0x26) ? 2 :
+                           (op == 0x24) ? 4 : (op == 0x25) ? 8 : 0;
+        if (pc + imm > code.size())
+            break;
+        unsigned long long n = 0;
+        for (unsigned int i = 0; i < imm; i++)
+            n = (n << 8) | code[pc++];      /* operands are big endian */
+        if (in == 2)
+        {
+            b = stack[--sp];
+            a = stack[--sp];
+        }
+
+        switch (op)
+        {
+            case 0x02: stack[sp++] = a + b; break;                          /* add */
+            case 0x03: stack[sp++] = a - b; break;                          /* sub */
+            case 0x04: stack[sp++] = a * b; break;                          /* mul */
+            case 0x05:                                                      /* div_signed */
+            case 0x06:                                                      /* div_unsigned */
+            case 0x07:                                                      /* rem_signed */
+            case 0x08:                                                      /* rem_unsigned */
+                if (b == 0)
+                {
+                    error = true;
+                    return 0;
+                }
+                if (op == 0x05)
+                    stack[sp++] = a / b;
+                else if (op == 0x06)
+                    stack[sp++] = (unsigned long long)a / (unsigned long long)b;
+                else if (op == 0x07)
+                    stack[sp++] = a % b;
+                else
+                    stack[sp++] = (unsigned long long)a % (unsigned long long)b;
+                break;
+            case 0x09: stack[sp++] = a << b; break;                         /* lsh */
+            case 0x0a: stack[sp++] = a >> b; break;                         /* rsh_signed */
+            case 0x0b: stack[sp++] = (unsigned long long)a >> b; break;     /* rsh_unsigned */
+            case 0x0e: stack[sp - 1] = !stack[sp - 1]; break;               /* log_not */
+            case 0x0f: stack[sp++] = a & b; break;                          /* bit_and */
+            case 0x10: stack[sp++] = a | b; break;                          /* bit_or */
+            case 0x11: stack[sp++] = a ^ b; break;                          /* bit_xor */
+            case 0x12: stack[sp - 1] = ~stack[sp - 1]; break;               /* bit_not */
+            case 0x13: stack[sp++] = a == b; break;                         /* equal */
+            case 0x14: stack[sp++] = a < b; break;                          /* less_signed */
+            case 0x15: stack[sp++] = (unsigned long long)a < (unsigned long long)b; break; /* less_unsigned */
+            case 0x16:                                                      /* ext */
+                if (n > 0 && n < 64)
+                    stack[sp - 1] = (long long)((unsigned long long)stack[sp - 1] << (64 - n)) >> (64 - n);
+                break;
+            case 0x2a:                                                      /* zero_ext */
+                if (n > 0 && n < 64)
+                    stack[sp - 1] &= (1ULL << n) - 1;
+                break;
+            case 0x17:                                                      /* ref8 */
+            case 0x18:                                                      /* ref16 */
+            case 0x19:                                                      /* ref32 */
+            case 0x1a:                                                      /* ref64 */
+                stack[sp - 1] = ReadMemory(core, (unsigned int)stack[sp - 1], 1 << (op - 0x17), error);
+                if (error)
+                    return 0;
+                break;
+            case 0x20:                                                      /* if_goto */
+                if (stack[--sp] != 0)
+                    pc = n;
+                break;
+            case 0x21: pc = n; break;                                       /* goto */
+            case 0x22: stack[sp++] = n; break;                              /* const8 */
+            case 0x23: stack[sp++] = n; break;                              /* const16 */
+            case 0x24: stack[sp++] = n; break;                              /* const32 */
+            case 0x25: stack[sp++] = n; break;                              /* const64 */
+            case 0x26:                                                      /* reg */
+                if (n < 32)
+                    stack[sp++] = core->GetCoreReg(n);
+                else if (n == 32)
+                    stack[sp++] = (int)(*(core->status));
+                else if (n == 33)
+                    stack[sp++] = core->stack->GetStackPointer();
+                else if (n == 34)
+                    stack[sp++] = core->PC * 2;
+                else
+                {
+                    error = true;
+                    return 0;
+                }
+                break;
+            case 0x27:                                                      /* end */
+                if (sp == 0)
+                    break;
+                return stack[sp - 1];
+            case 0x28: stack[sp] = stack[sp - 1]; sp++; break;              /* dup */
+            case 0x29: sp--; break;                                         /* pop */
+            case 0x2b: stack[sp++] = b; stack[sp++] = a; break;             /* swap */
+            case 0x32:                                                      /* pick */
+                if (n >= (unsigned int)sp)
+                {
+                    error = true;
+                    return 0;
+                }
+                stack[sp] = stack[sp - 1 - n];
+                sp++;
+                break;
+            case 0x33:                                                      /* rot: a b c => c a b */
+                a = stack[sp - 3];
+                stack[sp - 3] = stack[sp - 1];
+                stack[sp - 1] = stack[sp - 2];
+                stack[sp - 2] = a;
+                break;
+            default:
+                /* not supported in conditions (float, trace, variables, printf) */
+                error = true;
+                return 0;
+        }
+    }
+    /* without "end", out of code, stack error or endless loop */
+    error = true;
+    return 0;
 }
 
-void GdbServer::avr_core_insert_breakpoint(dword pc) {
-    core->BP.push_back(pc);
+/*! Parses conditions ";X<len>,<expression>" of a breakpoint insert packet,
+  returns NULL, if there is no condition. */
+BreakpointCondition *GdbServer::gdb_parse_conditions(const char *pkt) {
+    GdbBreakpointCondition *cond = NULL;
+    while (pkt != NULL && *pkt == ';')
+    {
+        pkt++;
+        if (*pkt != 'X')
+            break;  /* for instance target commands ";cmds:" */
+        pkt++;
+        int len = 0;
+        while (*pkt != ',' && *pkt != '\0')
+            len = (len << 4) + hex2nib(*pkt++);
+        if (*pkt == ',')
+            pkt++;
+        std::vector<byte> expr;
+        for (int i = 0; i < len && pkt[0] != '\0' && pkt[1] != '\0'; i++, pkt += 2)
+            expr.push_back((hex2nib(pkt[0]) << 4) + hex2nib(pkt[1]));
+        if (cond == NULL)
+            cond = new GdbBreakpointCondition;
+        cond->expressions.push_back(expr);
+    }
+    return cond;
 }
 
 int GdbServer::signal_has_occurred(int signo) {return 0;}
@@ -408,10 +720,11 @@ void GdbServer::gdb_send_ack( )
 }
 
 //! Send a reply to GDB.
+/*! The whole packet is written with one call, see GdbServerSocketUnix::Connect. */
 void GdbServer::gdb_send_reply( const char *reply )
 {
     int cksum = 0;
-    int bytes;
+    std::string packet;
 
     /* Save the reply to last reply so we can resend if need be. */
     gdb_last_reply( reply );
@@ -419,44 +732,22 @@ void GdbServer::gdb_send_reply( const char *reply )
     if (global_debug_on)
         fprintf( stderr, "Sent: $%s#", reply );
 
-    if (*reply == '\0')
+    packet.reserve( strlen(reply) + 4 );
+    packet += '$';
+    for (; *reply; reply++)
     {
-        server->Write( "$#00", 4 );
-
-        if (global_debug_on)
-            fprintf( stderr, "%02x\n", cksum & 0xff );
+        cksum += (unsigned char)*reply;
+        packet += *reply;
     }
-    else
-    {
-        memset( buf, '\0', sizeof(buf) );
-
-        buf[0] = '$';
-        bytes = 1;
-
-        while (*reply)
-        {
-            cksum += (unsigned char)*reply;
-            buf[bytes] = *reply;
-            bytes++;
-            reply++;
 
-            /* must account for "#cc" to be added */
-            if (bytes == (sizeof(buf) - 3))
-            {
-                /* FIXME: TRoth 2002/02/18 - splitting reply would be better */
-                avr_error( "buffer overflow" );
-            }
-        }
-
-        if (global_debug_on)
-            fprintf( stderr, "%02x\n", cksum & 0xff );
+    if (global_debug_on)
+        fprintf( stderr, "%02x\n", cksum & 0xff );
 
-        buf[bytes++] = '#';
-        buf[bytes++] = HEX_DIGIT[(cksum >> 4) & 0xf];
-        buf[bytes++] = HEX_DIGIT[cksum & 0xf];
+    packet += '#';
+    packet += HEX_DIGIT[(cksum >> 4) & 0xf];
+    packet += HEX_DIGIT[cksum & 0xf];
 
-        server->Write( buf, bytes );
-    }
+    server->Write( packet.data(), packet.size() );
 }
 
 void GdbServer::gdb_send_hex_reply(const char *reply, const char *reply_to_encode)
@@ -546,6 +837,9 @@ void GdbServer::gdb_write_registers(const char *pkt) {
     byte  bval;
     dword val;                  /* ensure it's a 32 bit value */
 
+    if (core->history != NULL)
+        core->history->Truncate();
+
     /* 32 gen purpose working registers */
     for ( i=0; i<32; i++ )
     {
@@ -672,6 +966,9 @@ void GdbServer::gdb_write_register(const char *pkt) {
     int val, hval;
     dword dval;
 
+    if (core->history != NULL)
+        core->history->Truncate();
+
     reg = gdb_extract_hex_num(&pkt, '=');
     pkt++;                      /* skip over '=' character */
 
@@ -807,11 +1104,10 @@ void GdbServer::gdb_read_memory(const char *pkt) {
             }
         }
     }
-    else if ( (addr & MEM_SPACE_MASK) == FLASH_OFFSET )
+    else if ( addr < SRAM_OFFSET )
     {
-        /* addressing flash */
-
-        addr = addr & ~MEM_SPACE_MASK; /* remove the offset bits */
+        /* addressing flash, it can be bigger than 64k, so all bits below
+        SRAM_OFFSET are address bits */
 
         is_odd_addr = addr % 2;
         i = 0;
@@ -856,23 +1152,17 @@ void GdbServer::gdb_read_memory(const char *pkt) {
     }
 
 
+    /* access by debugger isn't a watchpoint hit */
+    core->ClearWatchpointHit();
     gdb_send_reply( (char*)buf );
 
     avr_free( buf );
 }
 
-void GdbServer::gdb_write_memory(const char *pkt) {
-    unsigned int addr = 0;
-    int  len  = 0;
-    byte bval;
-    unsigned int  i;
-    char reply[10];
-
-    /* Set the default reply. */
-    strncpy( reply, "OK", sizeof(reply) );
-
-    pkt += gdb_get_addr_len( pkt, ',', ':', &addr, &len );
-
+bool GdbServer::gdb_write_bytes(unsigned int addr, const byte *data, int len) {
+    /* changed state has no recorded future */
+    if (core->history != NULL)
+        core->history->Truncate();
 
     if ( (addr & MEM_SPACE_MASK) == EEPROM_OFFSET )
     {
@@ -881,10 +1171,8 @@ void GdbServer::gdb_write_memory(const char *pkt) {
         addr = addr & ~MEM_SPACE_MASK; /* remove the offset bits */
 
         while (len>0) {
-            bval  = hex2nib(*pkt++) << 4;
-            bval += hex2nib(*pkt++);
+            core->eeprom->WriteAtAddress(addr, *data++);
             len--;
-            core->eeprom->WriteAtAddress(addr, bval);
             addr++;
         }
     }
@@ -894,47 +1182,27 @@ void GdbServer::gdb_write_memory(const char *pkt) {
 
         addr = addr & ~MEM_SPACE_MASK; /* remove the offset bits */
 
-        /* Return error. See gdb_read_memory for reasoning. */
-        /* FIXME: [TRoth 2002/03/31] This isn't working quite the way I
-        thought it would so I've removed it for now.*/
-        /* if ( (addr >= 0) && (addr < 32) ) */
-        if (0)
-        {
-            snprintf( reply, sizeof(reply), "E%02x", EIO );
-        }
-        else
-        {
-            for ( i=addr; i < addr+len; i++ )
-            {
-                bval  = hex2nib(*pkt++) << 4;
-                bval += hex2nib(*pkt++);
-                core->SetRWMem(i, bval);
-            }
-        }
+        for (unsigned int i = addr; i < addr + len; i++)
+            core->SetRWMem(i, *data++);
+        core->ClearWatchpointHit();
     }
-    else if ( (addr & MEM_SPACE_MASK) == FLASH_OFFSET )
+    else if ( addr < SRAM_OFFSET )
     {
-        /* addressing flash */
-
-        addr = addr & ~MEM_SPACE_MASK; /* remove the offset bits */
+        /* addressing flash, it can be bigger than 64k, so all bits below
+        SRAM_OFFSET are address bits */
 
         if (addr % 2)
         {
-            bval  = hex2nib(*pkt++) << 4;
-            bval += hex2nib(*pkt++);
-            avr_core_flash_write_hi8(addr, bval);
+            avr_core_flash_write_hi8(addr, *data++);
             len--;
             addr++;
         }
 
         while (len > 1)
         {
-            word wval;
-            wval  = hex2nib(*pkt++) << 4; /* low byte first */
-            wval += hex2nib(*pkt++);
-            wval += hex2nib(*pkt++) << 12; /* high byte last */
-            wval += hex2nib(*pkt++) << 8;
+            word wval = data[0] + (data[1] << 8); /* low byte first */
             avr_core_flash_write( addr, wval);
+            data += 2;
             len  -= 2;
             addr += 2;
         }
@@ -942,29 +1210,211 @@ void GdbServer::gdb_write_memory(const char *pkt) {
         if ( len == 1 )
         {
             /* one more byte to write */
-            bval  = hex2nib(*pkt++) << 4;
-            bval += hex2nib(*pkt++);
-            avr_core_flash_write_lo8( addr, bval );
+            avr_core_flash_write_lo8( addr, *data );
         }
     }
     else if ( (addr & MEM_SPACE_MASK) == SIGNATURE_OFFSET && len >= 3)
     {
-        int sig3 = (hex2nib(*pkt++) << 4); sig3 += hex2nib(*pkt++);
-        int sig2 = (hex2nib(*pkt++) << 4); sig2 += hex2nib(*pkt++);
-        int sig1 = (hex2nib(*pkt++) << 4); sig1 += hex2nib(*pkt++);
         if (global_debug_on)
-            fprintf(stderr, "Device signature %02x %02x %02x\n", sig1, sig2, sig3);
+            fprintf(stderr, "Device signature %02x %02x %02x\n", data[2], data[1], data[0]);
     }
     else
     {
         /* gdb asked for memory space which doesn't exist */
         avr_warning( "Invalid memory address: 0x%x.\n", addr );
+        return false;
+    }
+    return true;
+}
+
+void GdbServer::gdb_write_memory(const char *pkt) {
+    unsigned int addr = 0;
+    int  len  = 0;
+    char reply[10];
+
+    pkt += gdb_get_addr_len( pkt, ',', ':', &addr, &len );
+
+    std::vector<byte> data(len + 1);
+    for (int i = 0; i < len; i++)
+    {
+        data[i]  = hex2nib(*pkt++) << 4;
+        data[i] += hex2nib(*pkt++);
+    }
+
+    if (gdb_write_bytes(addr, &data[0], len))
+        strncpy( reply, "OK", sizeof(reply) );
+    else
         snprintf( reply, sizeof(reply), "E%02x", EIO );
+    gdb_send_reply( reply );
+}
+
+//! Decodes escaped binary data of a X or vFlashWrite packet, 0x7d escapes the next byte
+/*! Returns false, if the packet ends before len bytes are decoded. */
+static bool gdb_decode_binary(const char *pkt, const char *end, std::vector<byte> &data, int len) {
+    for (int i = 0; i < len; i++)
+    {
+        if (pkt >= end)
+            return false;
+        byte b = *pkt++;
+        if (b == 0x7d)
+        {
+            if (pkt >= end)
+                return false;
+            b = *pkt++ ^ 0x20;
+        }
+        data[i] = b;
     }
+    return true;
+}
 
+/*! Format: "X<addr>,<length>:<binary data>", gdb uses it instead of 'M' to
+  load a program, if the server answers a empty X packet with "OK". */
+void GdbServer::gdb_write_memory_binary(const char *pkt) {
+    unsigned int addr = 0;
+    int  len  = 0;
+    char reply[10];
+    // pkt starts behind the 'X', binary data can contain 0
+    const char *end = pkt - 1 + packetLength;
+
+    pkt += gdb_get_addr_len( pkt, ',', ':', &addr, &len );
+    if (len < 0 || pkt > end || len > end - pkt)
+    {
+        gdb_send_reply("E01");
+        return;
+    }
+
+    std::vector<byte> data(len + 1);
+    if (!gdb_decode_binary(pkt, end, data, len))
+    {
+        gdb_send_reply("E01");
+        return;
+    }
+
+    if (len == 0 || gdb_write_bytes(addr, &data[0], len))
+        strncpy( reply, "OK", sizeof(reply) );
+    else
+        snprintf( reply, sizeof(reply), "E%02x", EIO );
     gdb_send_reply( reply );
 }
 
+/*! Flash commands, gdb uses them to load a program, because flash is marked
+  as flash in the memory map (see gdb_memory_map):
+
+  "vFlashErase:<addr>,<length>"  -  erase flash (set to 0xff)
+  "vFlashWrite:<addr>:<binary data>"  -  write to erased flash
+  "vFlashDone"  -  all writes are done
+
+  The data of vFlashWrite is till end of packet, so the length of the
+  packet is taken from the packet buffer. */
+void GdbServer::gdb_flash_command(const char *pkt) {
+    unsigned int addr = 0;
+    int len = 0;
+    const char *end = pkt + packetLength;
+
+    if (memcmp(pkt, "vFlashErase:", 12) == 0)
+    {
+        gdb_get_addr_len( pkt + 12, ',', '\0', &addr, &len );
+        // flash is erased word by word
+        if ((addr & 1) != 0 || (len & 1) != 0 || len < 0 ||
+            addr > core->Flash->GetSize() || (unsigned int)len > core->Flash->GetSize() - addr)
+        {
+            gdb_send_reply("E01");
+            return;
+        }
+        if (core->history != NULL)
+            core->history->Truncate();
+        for (int i = 0; i < len; i += 2)
+            avr_core_flash_write(addr + i, 0xffff);
+        gdb_send_reply("OK");
+    }
+    else if (memcmp(pkt, "vFlashWrite:", 12) == 0)
+    {
+        pkt += 12;
+        while (pkt < end && *pkt != ':')
+            addr = (addr << 4) + hex2nib(*pkt++);
+        if (pkt >= end)
+        {
+            gdb_send_reply("E01");
+            return;
+        }
+        pkt++;
+        // count data bytes, escape char isn't counted
+        const char *p;
+        for (p = pkt; p < end; p++)
+        {
+            if (*p == 0x7d)
+                p++;
+            len++;
+        }
+        if (addr > core->Flash->GetSize() || (unsigned int)len > core->Flash->GetSize() - addr)
+        {
+            gdb_send_reply("E01");
+            return;
+        }
+        std::vector<byte> data(len + 1);
+        if (!gdb_decode_binary(pkt, end, data, len))
+        {
+            gdb_send_reply("E01");
+            return;
+        }
+        gdb_write_bytes(addr, &data[0], len);
+        gdb_send_reply("OK");
+    }
+    else if (strcmp(pkt, "vFlashDone") == 0)
+        gdb_send_reply("OK");
+    else
+    {
+        if(global_debug_on)
+            fprintf(stderr, "gdb command '%s' not supported\n", pkt);
+        gdb_send_reply("");
+    }
+}
+
+//! Memory map for gdb, it marks flash, so gdb uses vFlash commands for load
+std::string GdbServer::gdb_memory_map(void) {
+    char line[200];
+    std::string map = "<?xml version=\"1.0\"?>\n"
+                      "<!DOCTYPE memory-map PUBLIC \"+//IDN gnu.org//DTD GDB Memory Map V1.0//EN\" \"http://sourceware.org/gdb/gdb-memory-map.dtd\">\n"
+                      "<memory-map>\n";
+    snprintf(line, sizeof(line),
+             "    <memory type=\"flash\" start=\"0x%x\" length=\"0x%x\">\n"
+             "        <property name=\"blocksize\">0x%x</property>\n"
+             "    </memory>\n",
+             FLASH_OFFSET, core->Flash->GetSize(), FLASH_BLOCK_SIZE);
+    map += line;
+    snprintf(line, sizeof(line), "    <memory type=\"ram\" start=\"0x%x\" length=\"0x%x\"/>\n",
+             SRAM_OFFSET, EEPROM_OFFSET - SRAM_OFFSET);
+    map += line;
+    if (core->eeprom != NULL && core->eeprom->GetSize() > 0)
+    {
+        snprintf(line, sizeof(line), "    <memory type=\"ram\" start=\"0x%x\" length=\"0x%x\"/>\n",
+                 EEPROM_OFFSET, core->eeprom->GetSize());
+        map += line;
+    }
+    snprintf(line, sizeof(line), "    <memory type=\"ram\" start=\"0x%x\" length=\"0x3\"/>\n",
+             SIGNATURE_OFFSET);
+    map += line;
+    map += "</memory-map>\n";
+    return map;
+}
+
+/*! Reply to "qXfer:<object>:read:<annex>:<offset>,<length>", pkt points
+  to offset. Data is sent in parts, if gdb asks for less than all. */
+void GdbServer::gdb_send_xfer(const char *pkt, const std::string &data) {
+    unsigned int offset = 0;
+    int len = 0;
+
+    gdb_get_addr_len( pkt, ',', '\0', &offset, &len );
+    if (offset >= data.size())
+    {
+        gdb_send_reply("l");
+        return;
+    }
+    std::string reply = (data.size() - offset > (unsigned int)len) ? "m" : "l";
+    reply += data.substr(offset, len);
+    gdb_send_reply(reply.c_str());
+}
+
 /*! Format of breakpoint commands (both insert and remove):
 
 "z<t>,<addr>,<length>"  -  remove break/watch point
@@ -992,10 +1442,13 @@ void GdbServer::gdb_break_point(const char *pkt) {
     char t = *pkt++;
     pkt++;                      /* skip over first ',' */
 
-    gdb_get_addr_len( pkt, ',', '\0', &addr, &len );
+    /* insert can have conditions after kind: "Z0,<addr>,<kind>;X<len>,<expr>" */
+    const char *cond = strchr( pkt, ';' );
+    gdb_get_addr_len( pkt, ',', (cond != NULL) ? ';' : '\0', &addr, &len );
 
     switch (t) {
         case '0':               /* software breakpoint */
+        case '1':               /* hardware breakpoint, the same for a simulator */
             /* Both `addr' and GetSize() are in bytes. */
             if ( addr >= core->Flash->GetSize() )
             {
@@ -1014,42 +1467,105 @@ void GdbServer::gdb_break_point(const char *pkt) {
             {
                 //cout << "Try to SET a software breakpoint" << endl;
                 //cout << "at address :" << addr << " with len " << len << endl;
-                avr_core_insert_breakpoint( addr/2 );
+                avr_core_insert_breakpoint( addr/2, gdb_parse_conditions(cond) );
             }
             break;
 
-        case '1':               /* hardware breakpoint */
-            //cout << "Try to set a hardware breakpoint" << endl;
-            //cout << "at address :" << addr << " with len " << len << endl;
-
-            gdb_send_reply( "" );
-            return;
-            break;
-
         case '2':               /* write watchpoint */
-            //cout << "Try to set a watchpoint" << endl;
-            //cout << "at address :" << addr << " with len " << len << endl;
-            gdb_send_reply( "" );
-            return;
-            break;
-
         case '3':               /* read watchpoint */
-            //cout << "Try to set a read watchpoint" << endl;
-            //cout << "at address :" << addr << " with len " << len << endl;
-            gdb_send_reply( "" );
-            return;
-            break;
-
         case '4':               /* access watchpoint */
-            //cout << "try to set a access watchpoint" << endl;
-            //cout << "at address :" << addr << " with len " << len << endl;
-            gdb_send_reply( "" );
-            return;             /* unsupported yet */
+        {
+            /* only data memory can be watched */
+            if ( (addr & MEM_SPACE_MASK) != SRAM_OFFSET || len <= 0 )
+            {
+                gdb_send_reply( "E01" );
+                return;
+            }
+            addr &= ~MEM_SPACE_MASK;
+            int type = (t == '2') ? AvrDevice::WATCH_WRITE :
+                       (t == '3') ? AvrDevice::WATCH_READ : AvrDevice::WATCH_ACCESS;
+            if (z == 'z')
+                core->RemoveWatchpoint( addr, len, type );
+            else
+                core->InsertWatchpoint( addr, len, type );
+            break;
+        }
     }
 
     gdb_send_reply( "OK" );
 }
 
+//! Stop reason for a watchpoint hit, like "watch:<addr>;"
+static void WatchReason(char *reason, size_t size, int type, unsigned int addr) {
+    snprintf(reason, size, "%s:%x;",
+             (type == AvrDevice::WATCH_WRITE) ? "watch" :
+             (type == AvrDevice::WATCH_READ) ? "rwatch" : "awatch",
+             addr | SRAM_OFFSET);
+}
+
+/*! Stops reverse continue on a breakpoint (with true condition, ignore
+  counts aren't used backward) or after a instruction, which hits a
+  watchpoint. The watchpoint of the last stop is remembered for the stop
+  reason. */
+class GdbReverseStop: public HistoryStopCondition {
+
+    public:
+        int watchType;          //!< watchpoint type of last stop, 0 for a breakpoint
+        unsigned int watchAddr;
+
+        GdbReverseStop(Breakpoints &b): watchType(0), watchAddr(0), bp(b), breakpoint(false) {}
+
+        virtual bool BeforeInstruction(AvrDevice *core) {
+            breakpoint = !core->IsSleeping() && bp.IsSet(core->PC) && bp.ConditionIsTrue(core->PC, core);
+            return breakpoint;
+        }
+
+        virtual bool AfterInstruction(AvrDevice *core) {
+            unsigned int addr;
+            int type = core->GetWatchpointHit(addr);
+            if (type != 0) {
+                core->ClearWatchpointHit();
+                watchType = type;
+                watchAddr = addr;
+                return true;
+            }
+            if (breakpoint)
+                watchType = 0;
+            return false;
+        }
+
+    private:
+        Breakpoints &bp;
+        bool breakpoint;        //!< breakpoint on current instruction
+};
+
+/*! "bs" steps one instruction backward, "bc" runs backward till a
+  breakpoint or watchpoint. If the start of execution history is reached,
+  the stop reason is "replaylog:begin;". */
+void GdbServer::gdb_reverse(const char *pkt) {
+    ExecutionHistory *history = core->history;
+    if (history == NULL || (*pkt != 's' && *pkt != 'c'))
+    {
+        gdb_send_reply("");
+        return;
+    }
+
+    char reason[40] = "";
+    bool found;
+    if (*pkt == 's')
+        found = history->RunBackward(NULL);
+    else
+    {
+        GdbReverseStop stop(GetBreakpoints());
+        found = history->RunBackward(&stop);
+        if (found && stop.watchType != 0)
+            WatchReason(reason, sizeof(reason), stop.watchType, stop.watchAddr);
+    }
+    core->ClearWatchpointHit();
+    lastCoreStepFinished = true;
+    SendPosition(GDB_SIGTRAP, found ? reason : "replaylog:begin;");
+}
+
 void GdbServer::gdb_select_thread(const char *pkt)
 {
     if(pkt[0] == 'c') {
@@ -1149,6 +1665,8 @@ int GdbServer::gdb_get_signal(const char *pkt) {
             /* Gdb user issuing the 'signal SIGHUP' command tells sim to reset
             itself. We reply with a SIGTRAP the same as we do when gdb
             makes first connection with simulator. */
+            if (core->history != NULL)
+                core->history->Truncate();
             core->Reset( );
             gdb_send_reply( "S05" );
             break;
@@ -1196,6 +1714,21 @@ int GdbServer::gdb_parse_packet(const char *pkt) {
             gdb_write_memory(pkt);
             break;
 
+        case 'X':               /* write memory, binary data */
+            gdb_write_memory_binary(pkt);
+            break;
+
+        case 'v':               /* flash commands */
+            pkt--;
+            if(memcmp(pkt, "vFlash", 6) == 0)
+                gdb_flash_command(pkt);
+            else {
+                if(global_debug_on)
+                    fprintf(stderr, "gdb command '%s' not supported\n", pkt);
+                gdb_send_reply("");
+            }
+            break;
+
         case 'D':               /* detach the debugger */
         case 'k':               /* kill request */
             /* Reset the simulator since there may be another connection
@@ -1236,6 +1769,10 @@ int GdbServer::gdb_parse_packet(const char *pkt) {
             }
             return GDB_RET_SINGLE_STEP;
 
+        case 'b':               /* reverse step or continue */
+            gdb_reverse(pkt);
+            break;
+
         case 'z':               /* remove break/watch point */
         case 'Z':               /* insert break/watch point */
             gdb_break_point(pkt);
@@ -1244,17 +1781,26 @@ int GdbServer::gdb_parse_packet(const char *pkt) {
         case 'q':               /* query requests */
             pkt--;
             if(memcmp(pkt, "qSupported", 10) == 0) {
-                gdb_send_reply("PacketSize=800;qXfer:features:read+");
+                char size[32];
+                snprintf(size, sizeof(size), "PacketSize=%x", PACKET_SIZE);
+                std::string reply(size);
+                reply += ";qXfer:features:read+;qXfer:memory-map:read+;ConditionalBreakpoints+";
+                if(core->history != NULL)
+                    reply += ";ReverseStep+;ReverseContinue+";
+                gdb_send_reply(reply.c_str());
                 return GDB_RET_OK;
             } else if(memcmp(pkt, "qXfer:features:read:target.xml:", 31) == 0) {
                 // GDB XML target descriptions, since GDB 6.7 (2007-10-10)
                 // see http://sources.redhat.com/gdb/current/onlinedocs/gdb/Target-Descriptions.html
-                gdb_send_reply("l"
-                               "<?xml version=\"1.0\"?>\n"
-                               "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
-                               "<target version=\"1.0\">\n"
-                               "    <architecture>avr</architecture>\n"
-                               "</target>\n");
+                gdb_send_xfer(pkt + 31,
+                              "<?xml version=\"1.0\"?>\n"
+                              "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
+                              "<target version=\"1.0\">\n"
+                              "    <architecture>avr</architecture>\n"
+                              "</target>\n");
+                return GDB_RET_OK;
+            } else if(memcmp(pkt, "qXfer:memory-map:read::", 23) == 0) {
+                gdb_send_xfer(pkt + 23, gdb_memory_map());
                 return GDB_RET_OK;
             } else if(strcmp(pkt, "qC") == 0) {
                 int thread_id = core->stack->m_ThreadList.GetCurrentThreadForGDB();
@@ -1307,6 +1853,7 @@ int GdbServer::gdb_receive_and_process_packet(int blocking) {
             /* make sure we block on fd */
             server->SetBlockingMode(GDB_BLOCKING_ON);
 
+            pkt_buf.reserve(PACKET_SIZE);
             pkt_cksum = 0;
             c = server->ReadByte();
             while(c != '#') {
@@ -1334,6 +1881,7 @@ int GdbServer::gdb_receive_and_process_packet(int blocking) {
             /* always acknowledge a well formed packet immediately */
             gdb_send_ack();
 
+            packetLength = pkt_buf.size();
             res = gdb_parse_packet(pkt_buf.c_str());
             if(res < 0)
                 return res;
@@ -1426,7 +1974,7 @@ int GdbServer::Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns) {
     if(!connState) { // no connection established -> look for it
         TryConnectGdb();
         if (!waitForGdbConnection) {
-            core->Step(trueHwStep, timeToNextStepIn_ns);    //if not connected to gdb simple run it  
+            CoreStep(trueHwStep, timeToNextStepIn_ns);    //if not connected to gdb simple run it  
         } else {
             if (timeToNextStepIn_ns!=0) *timeToNextStepIn_ns=core->GetClockFreq();
         }
@@ -1436,6 +1984,39 @@ int GdbServer::Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns) {
     }
 }
 
+//! Wall clock in ms, only differences are used
+static unsigned long WallClockMs(void) {
+#if defined(HAVE_SYS_MINGW) || defined(_MSC_VER)
+    return GetTickCount();
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000UL + tv.tv_usec / 1000;
+#endif
+}
+
+/*! In continue mode the socket isn't read on every step, because a system
+  call per simulated cycle would slow down the simulation a lot. Wall clock is
+  only read every POLL_STEPS steps and the socket is polled (without reading
+  from it), if POLL_INTERVAL ms are gone since last poll. So Ctrl-C or a packet
+  from gdb is handled after some ms. */
+bool GdbServer::PollGdb(void) {
+    if(--pollCountdown != 0)
+        return false;
+    pollCountdown = POLL_STEPS;
+    unsigned long now = WallClockMs();
+    if(now - lastPollTime < POLL_INTERVAL)
+        return false;
+    lastPollTime = now;
+    return server->DataAvailable();
+}
+
+int GdbServer::CoreStep(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+    if(core->history != NULL)
+        return core->history->Step(untilCoreStepFinished, nextStepIn_ns);
+    return core->Step(untilCoreStepFinished, nextStepIn_ns);
+}
+
 void GdbServer::IdleStep() {
     int gdbRet=gdb_receive_and_process_packet(GDB_BLOCKING_OFF);
     cout << "IdleStep Instance" << this << " RunMode:" << dec << runMode << endl;
@@ -1472,7 +2053,11 @@ int GdbServer::InternalStep(bool &untilCoreStepFinished, SystemClockOffset *time
 
         do {
             //cout << "Loop" << endl;
-            int gdbRet=gdb_receive_and_process_packet((runMode==GDB_RET_CONTINUE) ? GDB_BLOCKING_OFF : GDB_BLOCKING_ON);
+            int gdbRet;
+            if(runMode == GDB_RET_CONTINUE)
+                gdbRet = PollGdb() ? gdb_receive_and_process_packet(GDB_BLOCKING_OFF) : GDB_RET_NOTHING_RECEIVED;
+            else
+                gdbRet = gdb_receive_and_process_packet(GDB_BLOCKING_ON);
 
             switch (gdbRet) { //GDB_RESULT TYPES
                 case GDB_RET_NOTHING_RECEIVED:  //nothing changes here
@@ -1503,6 +2088,9 @@ int GdbServer::InternalStep(bool &untilCoreStepFinished, SystemClockOffset *time
                     server->CloseConnection();   //we are not longer connected
                     connState = false;
                     core->DeleteAllBreakpoints();
+                    historyBreakpoints.Clear();
+                    if(core->history != NULL)
+                        core->history->Clear();
                     return 0; 
             } //end switch GDB_RETURN_VALUE
 
@@ -1512,6 +2100,17 @@ int GdbServer::InternalStep(bool &untilCoreStepFinished, SystemClockOffset *time
                 leave = false;
             }
 
+            if(leave && core->history != NULL && !core->IsSleeping()) {
+                /* breakpoints are checked here, the core doesn't stop on them,
+                stopping takes no time */
+                dword pc = core->PC;
+                if(historyBreakpoints.IsSet(pc) && historyBreakpoints.Hit(pc, core)) {
+                    runMode=GDB_RET_OK;
+                    SendPosition(GDB_SIGTRAP);
+                    leave = false;
+                }
+            }
+
             if(!leave) { //we can�t leave the loop so we have to request the other gdb instances now!
                 // step through all gdblist members WITHOUT my self!
                 //cout << "we do not leave and check for gdb events" << endl;
@@ -1526,7 +2125,7 @@ int GdbServer::InternalStep(bool &untilCoreStepFinished, SystemClockOffset *time
 
     } //last core step finished
 
-    int res=core->Step(untilCoreStepFinished, timeToNextStepIn_ns);
+    int res=CoreStep(untilCoreStepFinished, timeToNextStepIn_ns);
     lastCoreStepFinished=untilCoreStepFinished;
 
     if (res == BREAK_POINT) {
@@ -1534,6 +2133,20 @@ int GdbServer::InternalStep(bool &untilCoreStepFinished, SystemClockOffset *time
         SendPosition(GDB_SIGTRAP);
     }
 
+    if (lastCoreStepFinished && runMode != GDB_RET_OK) {
+        /* a watchpoint is reported after the instruction, which has accessed
+        the watched cell */
+        unsigned int addr;
+        int type = core->GetWatchpointHit(addr);
+        if (type != 0) {
+            char reason[40];
+            core->ClearWatchpointHit();
+            WatchReason(reason, sizeof(reason), type, addr);
+            runMode=GDB_RET_OK;
+            SendPosition(GDB_SIGTRAP, reason);
+        }
+    }
+
     if (res == INVALID_OPCODE)
     {
         //why we send here another reply??? is it not better to send it later
@@ -1553,7 +2166,7 @@ int GdbServer::InternalStep(bool &untilCoreStepFinished, SystemClockOffset *time
     return 0;
 }
 
-void GdbServer::SendPosition(int signo) {
+void GdbServer::SendPosition(int signo, const char *reason) {
     /* Send gdb PC, FP, SP */
     int bytes = 0;
     char reply[MAX_BUF + 1];
@@ -1563,7 +2176,7 @@ void GdbServer::SendPosition(int signo) {
     int pc = core->PC * 2;
     int thread_id = core->stack->m_ThreadList.GetCurrentThreadForGDB();
 
-    bytes = snprintf(reply, sizeof(reply), "T%02x", signo);
+    bytes = snprintf(reply, sizeof(reply), "T%02x%s", signo, (reason != NULL) ? reason : "");
 
     /* SREG, SP & PC */
     snprintf(reply + bytes, sizeof(reply) - bytes,
@@ -25,6 +25,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <fstream>
 #include <string>
 #include <cstring>
 #include <map>
@@ -35,6 +36,9 @@ using namespace std;
 #include <stdlib.h>
 #ifndef _MSC_VER
 #  include <getopt.h>
+#  include <unistd.h>
+#  include <sys/types.h>
+#  include <sys/wait.h>
 #else
 #  include "../getopt/getopt.h"
 #  define VERSION "(git-snapshot)"
@@ -50,6 +54,7 @@ using namespace std;
 #include "gdb.h"
 #include "ui/ui.h"
 #include "systemclock.h"
+#include "simulationcontext.h"
 #include "ui/lcd.h"
 #include "ui/keyboard.h"
 #include "traceval.h"
@@ -58,6 +63,11 @@ using namespace std;
 #include "helper.h"
 #include "specialmem.h"
 #include "irqsystem.h"
+#include "ui/pinstimulus.h"
+#include "binarytrace.h"
+#include "profiler.h"
+#include "coverage.h"
+#include "executionhistory.h"
 
 #include "dumpargs.h"
 
@@ -90,6 +100,56 @@ const char *SplitOffsetFile(const char *arg,
     return end;
 }
 
+//! Replaces "%d" in a file name by the number of the fork child, if child >= 0
+string ForkChildFileName(const string &name, int child)
+{
+    string::size_type pos = name.find("%d");
+    if(child < 0 || pos == string::npos)
+        return name;
+    ostringstream os;
+    os << child;
+    return name.substr(0, pos) + os.str() + name.substr(pos + 2);
+}
+
+static RWReadFromFile *readFromPipe = NULL; //!< register of -R option
+static RWWriteToFile *writeToPipe = NULL;   //!< register of -W option
+
+//! Adds special registers for -R and -W options to device
+/*! In fork mode openFiles is false: the registers are added before warm up
+  like in a normal run, but without file, see OpenPipeRegisters. */
+void AddPipeRegisters(AvrDevice *dev,
+                      unsigned long readFromPipeOffset,
+                      const string &readFromPipeFileName,
+                      unsigned long writeToPipeOffset,
+                      const string &writeToPipeFileName,
+                      bool openFiles)
+{
+    if(readFromPipeFileName != "") {
+        avr_message("Add ReadFromPipe-Register at 0x%lx and read from file: %s",
+                    readFromPipeOffset, readFromPipeFileName.c_str());
+        readFromPipe = new RWReadFromFile(dev, "FREAD", openFiles ? readFromPipeFileName : "");
+        dev->ReplaceIoRegister(readFromPipeOffset, readFromPipe);
+    }
+    
+    if(writeToPipeFileName != "") {
+        avr_message("Add WriteToPipe-Register at 0x%lx and write to file: %s",
+                    writeToPipeOffset, writeToPipeFileName.c_str());
+        writeToPipe = new RWWriteToFile(dev, "FWRITE", openFiles ? writeToPipeFileName : "");
+        dev->ReplaceIoRegister(writeToPipeOffset, writeToPipe);
+    }
+}
+
+//! Opens the files of registers, which were added without files, for a fork child
+void OpenPipeRegisters(const string &readFromPipeFileName,
+                       const string &writeToPipeFileName,
+                       int child)
+{
+    if(readFromPipe != NULL)
+        readFromPipe->Open(ForkChildFileName(readFromPipeFileName, child));
+    if(writeToPipe != NULL)
+        writeToPipe->Open(ForkChildFileName(writeToPipeFileName, child));
+}
+
 const char Usage[] = 
     "AVR-Simulator Version " VERSION "\n"
     "-u                    run with user interface for external pin\n"
@@ -99,17 +159,46 @@ const char Usage[] =
     "-g --gdbserver        listen for GDB connection on TCP port defined by -p\n"
     "-G --gdb-debug        listen for GDB connection and write debug info\n"
     "   --gdb-stdin        for use with GDB as 'target remote | ./simulavr'\n"
+    "-H --history <cycles> record execution for reverse debugging with gdb, a\n"
+    "                      checkpoint of device state is taken every <cycles> cycles\n"
+    "                      (not with -c, recorded pin changes are kept in memory)\n"
     "-m  <nanoseconds>     maximum run time of <nanoseconds>\n"
+    "-X --parallel <nanoseconds>\n"
+    "                      run device and other simulation parts (stimulus, serial\n"
+    "                      ports) on own threads, they synchronise every\n"
+    "                      <nanoseconds> (not with -g, -t, -c)\n"
     "-M                    disable messages for bad I/O and memory references\n"
     "-p  <port>            use <port> for gdb server\n"
     "-t --trace <file>     enable trace outputs to <file>\n"
     "-l --linestotrace <number>\n"
     "                      maximum number of lines in each trace file.\n"
     "                      0 means endless. Attention: if you use gdb & trace, please use always 0!\n"
+    "-j --binary-trace <file>\n"
+    "                      enable binary trace to <file>, it's much faster than -t,\n"
+    "                      convert it to trace output with simulavr-tracedump\n"
+    "-q --profile <file>   write flat profile and call graph (cycles per function)\n"
+    "                      to <file> at end of simulation\n"
+    "-Q --profile-stacks <file>\n"
+    "                      write cycles per call stack in collapsed stack format\n"
+    "                      (input for flame graph tools) to <file>\n"
+    "-D --function-stats <file>\n"
+    "                      write minimum, average and maximum cycles and maximum\n"
+    "                      stack depth of every function as table to <file>\n"
+    "-O --function-stats-json <file>\n"
+    "                      write the same function statistic as JSON to <file>\n"
+    "-L --coverage <file>  write executed lines, functions and branches as lcov\n"
+    "                      tracefile to <file> (program needs debug info, -g)\n"
     "-n --nogdbwait        do not wait for gdb connection\n"
     "-F --cpufrequency     set the cpu frequency to <Hz> \n"
     "-s --irqstatistic     prints statistic informations about irq usage after simulation\n"
     "                      is stopped\n"
+    "-b --blockcache       execute whole basic blocks per simulation step, this is\n"
+    "                      faster, but not available with gdb or trace\n"
+    "-E --engine <name>    select instruction execution engine, <name> is 'virtual'\n"
+    "                      (default) or 'threaded' (operand table in flash, runs\n"
+    "                      whole instruction chains together with -b)\n"
+    "-I --noidleloop       execute every pass of a polling loop, which doesn't change\n"
+    "                      anything (default is to skip them till the next event)\n"
     "-W --writetopipe <offset>,<file>\n"
     "                      add a special pipe register to device at\n"
     "                      IO-Offset and opens <file> for writing\n"
@@ -123,6 +212,19 @@ const char Usage[] =
     "                      add a special register at IO-offset\n"
     "                      which exits simulator run\n"
     "-C --core-dump <name> dump a core memory image <name> to file on exit\n"
+    "-S --snapshot <name>  save simulation state to file <name> on exit\n"
+    "-P --stimulus <name>  drive device pins by waveform script <name>, a line is:\n"
+    "                      <time offset in ns> <pin> <H|L|h|l|t|S>\n"
+    "-k --fork <count>     run simulation till fork point, then fork <count> child\n"
+    "                      processes, which continue the simulation. \"%d\" in file\n"
+    "                      names of -R, -W, -P, -C and -S is replaced by the child\n"
+    "                      number, so every child can get it's own stimulus\n"
+    "-K --fork-at <label> or <address>\n"
+    "                      fork point is, when PC reaches <label> or <address>\n"
+    "-J --fork-time <nanoseconds>\n"
+    "                      fork point is at simulation time <nanoseconds>\n"
+    "-r --restore <name>   restore simulation state from file <name> before start,\n"
+    "                      device and program must be the same as on saving\n"
     "-v --verbose          output some hints to console\n"
     "-T --terminate <label> or <address>\n"
     "                      stops simulation if PC runs on <label> or <address>\n"
@@ -133,6 +235,17 @@ const char Usage[] =
     "                      <tracer>[:further-options ...]\n"
     "-o <trace-value-file> Specifies a file into which all available trace value names\n"
     "                      will be written.\n"
+    "-w --trace-poll <cycles>\n"
+    "                      poll trace values without access notification (timer\n"
+    "                      shadow registers etc.) only every <cycles> cycles\n"
+    "-Y --trace-window <pre>[,<post>]\n"
+    "                      keep trace output (-t and -c) of last <pre> cycles in\n"
+    "                      memory and write it only, if a trigger fires, then\n"
+    "                      write <post> cycles more (default: <pre>), triggers\n"
+    "                      are breakpoints, exit points, invalid IO accesses,\n"
+    "                      watchdog resets and trigger points (-A)\n"
+    "-A --trigger-at <label> or <address>\n"
+    "                      trigger trace window, if PC reaches <label> or <address>\n"
     "-V --version          print out version and exit immediately\n"
     "-h --help             print this help\n"
     "\n";
@@ -141,6 +254,13 @@ int main(int argc, char *argv[]) {
     int c;
     bool gdbserver_flag = 0;
     string coredumpfile("unknown");
+    string snapshotfile("unknown");
+    string restorefile("unknown");
+    string stimulusfile("unknown");
+    unsigned long forkCount = 0;
+    string forkAtSymbol("");
+    unsigned long long forkTime = 0;
+    int forkChild = -1; // number of fork child, -1 if not a child
     string filename("unknown");
     string devicename("unknown");
     string tracefilename("unknown");
@@ -150,7 +270,18 @@ int main(int argc, char *argv[]) {
     int userinterface_flag = 0;
     unsigned long long fcpu = 0;
     unsigned long long maxRunTime = 0;
+    unsigned long long parallelQuantum = 0;
     unsigned long long linestotrace = 1000000;
+    string binaryTraceFile("");
+    string profileFile("");
+    string profileStacksFile("");
+    string functionStatsFile("");
+    string functionStatsJSONFile("");
+    string coverageFile("");
+    unsigned long long historyInterval = 0;
+    bool blockcache_flag = false;
+    bool noidleloop_flag = false;
+    bool threaded_flag = false;
     UserInterface *ui;
     
     unsigned long writeToPipeOffset = 0x20;
@@ -165,6 +296,10 @@ int main(int argc, char *argv[]) {
     vector<string> tracer_opts;
     bool tracer_dump_avail = false;
     string tracer_avail_out;
+    unsigned long tracePollInterval = 1;
+    unsigned long traceWindowPre = 0;
+    unsigned long traceWindowPost = 0;
+    vector<string> triggerArgs;
     
     while (1) {
         //int this_option_optind = optind ? optind : 1;
@@ -174,11 +309,18 @@ int main(int argc, char *argv[]) {
             {"device", 1, 0, 'd'},
             {"gdbserver", 0, 0, 'g'},
             {"gdb-debug", 0, 0, 'G'},
+            {"history", 1, 0, 'H'},
             {"debug-gdb", 0, 0, 'G'},
             {"linestotrace", 1, 0, 'l'},
             {"maxruntime", 1, 0, 'm'},
             {"nogdbwait", 0, 0, 'n'},
             {"trace", 1, 0, 't'},
+            {"binary-trace", 1, 0, 'j'},
+            {"profile", 1, 0, 'q'},
+            {"profile-stacks", 1, 0, 'Q'},
+            {"function-stats", 1, 0, 'D'},
+            {"function-stats-json", 1, 0, 'O'},
+            {"coverage", 1, 0, 'L'},
             {"version", 0, 0, 'V'},
             {"cpufrequency", 1, 0, 'F'},
             {"readfrompipe", 1, 0, 'R'},
@@ -189,12 +331,25 @@ int main(int argc, char *argv[]) {
             {"terminate", 1, 0, 'T'},
             {"breakpoint", 1, 0, 'B'},
             {"core-dump", 1, 0, 'C'},
+            {"trace-poll", 1, 0, 'w'},
+            {"trace-window", 1, 0, 'Y'},
+            {"trigger-at", 1, 0, 'A'},
+            {"snapshot", 1, 0, 'S'},
+            {"restore", 1, 0, 'r'},
+            {"stimulus", 1, 0, 'P'},
+            {"fork", 1, 0, 'k'},
+            {"fork-at", 1, 0, 'K'},
+            {"fork-time", 1, 0, 'J'},
             {"irqstatistic", 0, 0, 's'},
+            {"blockcache", 0, 0, 'b'},
+            {"noidleloop", 0, 0, 'I'},
+            {"engine", 1, 0, 'E'},
+            {"parallel", 1, 0, 'X'},
             {"help", 0, 0, 'h'},
             {0, 0, 0, 0}
         };
         
-        c = getopt_long(argc, argv, "a:e:f:d:gGm:p:t:uxyzhvnisF:R:W:VT:B:c:C:o:l:", long_options, &option_index);
+        c = getopt_long(argc, argv, "a:e:f:d:gGH:m:p:t:j:uxyzhvnisbIE:X:F:R:W:VT:B:c:C:S:r:P:k:K:J:o:l:w:Y:A:q:Q:D:O:L:", long_options, &option_index);
         if(c == -1)
             break;
         
@@ -287,6 +442,13 @@ int main(int argc, char *argv[]) {
                 gdbserver_flag = 1;
                 break;
             
+            case 'H':
+                if(!StringToUnsignedLongLong(optarg, &historyInterval, NULL, 10) || historyInterval == 0) {
+                    cerr << "history interval is not a positive number" << endl;
+                    exit(1);
+                }
+                break;
+            
             case 'p':
                 if(!StringToLong( optarg, &global_gdbserver_port, NULL, 10)) {
                     cerr << "GDB Server Port is not a number" << endl;
@@ -302,6 +464,31 @@ int main(int argc, char *argv[]) {
                 sysConHandler.SetTraceFile(optarg, linestotrace);
                 break;
             
+            case 'j':
+                avr_message("Running in binary trace mode, trace file: %s", optarg);
+                binaryTraceFile = optarg;
+                break;
+            
+            case 'q':
+                profileFile = optarg;
+                break;
+            
+            case 'Q':
+                profileStacksFile = optarg;
+                break;
+            
+            case 'D':
+                functionStatsFile = optarg;
+                break;
+            
+            case 'O':
+                functionStatsJSONFile = optarg;
+                break;
+            
+            case 'L':
+                coverageFile = optarg;
+                break;
+            
             case 'V':
                 cout << "SimulAVR " << VERSION << endl
                      << "See documentation for copyright and distribution terms" << endl
@@ -323,16 +510,104 @@ int main(int argc, char *argv[]) {
                 tracer_dump_avail = true;
                 tracer_avail_out = optarg;
                 break;
+            
+            case 'w':
+                if(!StringToUnsignedLong(optarg, &tracePollInterval, NULL, 10) || tracePollInterval == 0) {
+                    cerr << "trace poll interval is not a positive number" << endl;
+                    exit(1);
+                }
+                break;
+            
+            case 'Y': {
+                char *end;
+                if(!StringToUnsignedLong(optarg, &traceWindowPre, &end, 10) || traceWindowPre == 0
+                   || (*end != 0 && *end != ',')) {
+                    cerr << "trace window is not a positive number" << endl;
+                    exit(1);
+                }
+                traceWindowPost = traceWindowPre;
+                if(*end == ',' && !StringToUnsignedLong(end + 1, &traceWindowPost, NULL, 10)) {
+                    cerr << "post trigger window is not a number" << endl;
+                    exit(1);
+                }
+                break;
+            }
+            
+            case 'A':
+                triggerArgs.push_back(optarg);
+                break;
              
             case 's':
                 enableIRQStatistic = true;
                 break;
             
+            case 'b':
+                blockcache_flag = true;
+                break;
+            
+            case 'I':
+                noidleloop_flag = true;
+                break;
+            
+            case 'E':
+                if(strcmp(optarg, "threaded") == 0)
+                    threaded_flag = true;
+                else if(strcmp(optarg, "virtual") == 0)
+                    threaded_flag = false;
+                else {
+                    cerr << "unknown execution engine: " << optarg << endl;
+                    exit(1);
+                }
+                break;
+            
+            case 'X':
+                if(!StringToUnsignedLongLong(optarg, &parallelQuantum, NULL, 10) || parallelQuantum == 0) {
+                    cerr << "time window for parallel simulation is not a positive number" << endl;
+                    exit(1);
+                }
+                break;
+            
             case 'C':
                 avr_message("Write core dump on exit to file: %s", optarg);
                 coredumpfile = optarg;
                 break;
             
+            case 'S':
+                avr_message("Save simulation state on exit to file: %s", optarg);
+                snapshotfile = optarg;
+                break;
+            
+            case 'r':
+                avr_message("Restore simulation state from file: %s", optarg);
+                restorefile = optarg;
+                break;
+            
+            case 'P':
+                avr_message("Drive pins by stimulus file: %s", optarg);
+                stimulusfile = optarg;
+                break;
+            
+            case 'k':
+                if(!StringToUnsignedLong(optarg, &forkCount, NULL, 10) || forkCount == 0) {
+                    cerr << "fork count is not a positive number" << endl;
+                    exit(1);
+                }
+                avr_message("Fork %lu child processes", forkCount);
+                break;
+            
+            case 'K':
+                avr_message("Fork at symbol: %s", optarg);
+                forkAtSymbol = optarg;
+                break;
+            
+            case 'J':
+                if(!StringToUnsignedLongLong(optarg, &forkTime, NULL, 10)) {
+                    cerr << "fork time is not a number" << endl;
+                    exit(1);
+                }
+                avr_message("Fork at time: %lld", forkTime);
+                break;
+            
             default:
                 cout << Usage
                      << "Supported devices:" << endl
@@ -344,6 +619,7 @@ int main(int argc, char *argv[]) {
     /* get dump manager an inform it, that we have a single device application */
     DumpManager *dman = DumpManager::Instance();
     dman->SetSingleDeviceApp();
+    dman->SetPollInterval(tracePollInterval);
     
     /* check, if devicename is given or get it out from elf file, if given */
     unsigned int sig;
@@ -375,19 +651,9 @@ int main(int argc, char *argv[]) {
     }
     
     //if we want to insert some special "pipe" Registers we could do this here:
-    if(readFromPipeFileName != "") {
-        avr_message("Add ReadFromPipe-Register at 0x%lx and read from file: %s",
-                    readFromPipeOffset, readFromPipeFileName.c_str());
-        dev1->ReplaceIoRegister(readFromPipeOffset,
-            new RWReadFromFile(dev1, "FREAD", readFromPipeFileName.c_str()));
-    }
-    
-    if(writeToPipeFileName != "") {
-        avr_message("Add WriteToPipe-Register at 0x%lx and write to file: %s",
-                    writeToPipeOffset, writeToPipeFileName.c_str());
-        dev1->ReplaceIoRegister(writeToPipeOffset,
-            new RWWriteToFile(dev1, "FWRITE", writeToPipeFileName.c_str()));
-    }
+    //(in fork mode every child opens it's files after fork)
+    AddPipeRegisters(dev1, readFromPipeOffset, readFromPipeFileName,
+                     writeToPipeOffset, writeToPipeFileName, forkCount == 0);
     
     if(writeToAbort) {
         avr_message("Add WriteToAbort-Register at 0x%lx", writeToAbort);
@@ -410,6 +676,10 @@ int main(int argc, char *argv[]) {
         avr_message("Termination or Breakpoint Symbol: %s", (*ii).c_str());
         dev1->RegisterTerminationSymbol((*ii).c_str());
     }
+    for(ii = triggerArgs.begin(); ii != triggerArgs.end(); ii++) {
+        avr_message("Trigger Symbol: %s", (*ii).c_str());
+        dev1->RegisterTriggerSymbol((*ii).c_str());
+    }
     
     //if not gdb, the ui will be master controller :-)
     ui = (userinterface_flag == 1) ? new UserInterface(7777) : NULL;
@@ -431,16 +701,145 @@ int main(int argc, char *argv[]) {
     if(sysConHandler.GetTraceState())
         dev1->trace_on = 1;
     
+    BinaryTrace *binaryTrace = NULL;
+    if(binaryTraceFile != "") {
+        binaryTrace = new BinaryTrace(binaryTraceFile);
+        binaryTrace->AddDevice(dev1);
+    }
+    
+    Profiler *profiler = NULL;
+    if(profileFile != "" || profileStacksFile != ""
+       || functionStatsFile != "" || functionStatsJSONFile != "")
+        profiler = new Profiler(dev1);
+    
+    Coverage *coverage = NULL;
+    if(coverageFile != "")
+        coverage = new Coverage(dev1);
+    
+    dev1->useThreadedCode = threaded_flag;
+    
+    if(blockcache_flag) {
+        if(gdbserver_flag)
+            avr_warning("basic block execution isn't available with gdb, option ignored");
+        else
+            dev1->useBlockCache = true;
+    }
+    
+    if(noidleloop_flag)
+        dev1->useIdleLoopSkip = false;
+    
+    if(gdbserver_flag == 0) // without gdb the device is stepped by time table
+        SystemClock::Instance().Add(dev1);
+    
+    if(restorefile != "unknown") {
+        ifstream in(restorefile.c_str(), ios::in | ios::binary);
+        if(!in)
+            avr_error("can't open snapshot file '%s'", restorefile.c_str());
+        SimulationContext::Current()->RestoreState(in);
+    }
+    
+    if(forkCount > 0) {
+#ifdef HAVE_FORK
+        if(gdbserver_flag)
+            avr_error("fork mode isn't available with gdb server");
+        if(!tracer_opts.empty() || dev1->trace_on || binaryTrace != NULL)
+            avr_error("tracing isn't available in fork mode");
+        
+        // warm up: run till fork point, all children start from there
+        if(forkAtSymbol != "" || forkTime != 0) {
+            SystemClockOffset warmUpEnd = numeric_limits<SystemClockOffset>::max();
+            if(forkTime != 0)
+                warmUpEnd = forkTime;
+            if(maxRunTime != 0 && (SystemClockOffset)maxRunTime < warmUpEnd)
+                warmUpEnd = maxRunTime;
+            if(forkAtSymbol != "")
+                dev1->BP.AddBreakpoint(dev1->Flash->GetAddressAtSymbol(forkAtSymbol));
+            int res = SystemClock::Instance().RunTimeRange(warmUpEnd - SystemClock::Instance().GetCurrentTime());
+            if(forkAtSymbol != "") {
+                dev1->BP.RemoveBreakpoint(dev1->Flash->GetAddressAtSymbol(forkAtSymbol));
+                if(res != BREAK_POINT && forkTime == 0)
+                    avr_error("fork point '%s' isn't reached", forkAtSymbol.c_str());
+            }
+        }
+        avr_message("Fork at time %lld ns", SystemClock::Instance().GetCurrentTime());
+        
+        // don't give buffered output to every child
+        cout.flush();
+        cerr.flush();
+        fflush(stdout);
+        fflush(stderr);
+        vector<pid_t> children;
+        for(unsigned long i = 0; i < forkCount; i++) {
+            pid_t pid = fork();
+            if(pid < 0)
+                avr_error("fork failed");
+            if(pid == 0) {
+                forkChild = i;
+                break;
+            }
+            children.push_back(pid);
+        }
+        
+        if(forkChild < 0) {
+            // parent: wait for all children and report their results
+            int failed = 0;
+            for(unsigned int i = 0; i < children.size(); i++) {
+                int status;
+                waitpid(children[i], &status, 0);
+                if(WIFEXITED(status)) {
+                    avr_message("Fork child %d exited with code %d", i, WEXITSTATUS(status));
+                    if(WEXITSTATUS(status) != 0)
+                        failed++;
+                } else {
+                    avr_message("Fork child %d was terminated", i);
+                    failed++;
+                }
+            }
+            delete ui;
+            delete dev1;
+            return (failed == 0) ? 0 : 1;
+        }
+        
+        OpenPipeRegisters(readFromPipeFileName, writeToPipeFileName, forkChild);
+#else
+        avr_error("fork mode isn't available on this platform");
+#endif
+    }
+    
+    PinStimulus *stimulus = NULL;
+    if(stimulusfile != "unknown")
+        stimulus = new PinStimulus(dev1, ForkChildFileName(stimulusfile, forkChild));
+    
+    ExecutionHistory *history = NULL;
+    if(historyInterval > 0) {
+        if(gdbserver_flag)
+            history = new ExecutionHistory(dev1, historyInterval);
+        else
+            avr_warning("execution history is only used with gdb, option ignored");
+    }
+    
+    if(traceWindowPre > 0) {
+        if(tracer_opts.empty() && !sysConHandler.GetTraceState())
+            avr_warning("trace window is given without -t or -c, option ignored");
+        dman->SetTraceWindow(traceWindowPre, traceWindowPost);
+    }
+    
     dman->start(); // start dump session
     
     if(gdbserver_flag == 0) { // no gdb
-        SystemClock::Instance().Add(dev1);
-        if(maxRunTime == 0) {
+        if(parallelQuantum > 0) {
+            // devices and rest of simulation on threads, till maxRunTime or stop
+            SystemClockOffset endTime = (maxRunTime == 0) ? numeric_limits<SystemClockOffset>::max() : maxRunTime;
+            SystemClock::Instance().RunParallel(endTime - SystemClock::Instance().GetCurrentTime(), parallelQuantum);
+            Application::GetInstance()->PrintResults();
+        } else if(maxRunTime == 0) {
             SystemClock::Instance().Endless();
         } else {                                           // limited
             SystemClock::Instance().Run(maxRunTime);
         }
     } else { // gdb should be activated
+        if(parallelQuantum > 0)
+            avr_warning("parallel simulation isn't possible with gdb, option -X ignored");
         avr_message("Going to gdb...");
         GdbServer gdb1(dev1, global_gdbserver_port, global_gdb_debug, globalWaitForGdbConnection);
         SystemClock::Instance().Add(&gdb1);
@@ -451,11 +850,67 @@ int main(int argc, char *argv[]) {
     
     if(coredumpfile != "unknown") {
         avr_message("write core dump file ...");
-        WriteCoreDump(coredumpfile, dev1);
+        WriteCoreDump(ForkChildFileName(coredumpfile, forkChild), dev1);
+    }
+    
+    if(snapshotfile != "unknown") {
+        avr_message("write snapshot file ...");
+        string name = ForkChildFileName(snapshotfile, forkChild);
+        ofstream out(name.c_str(), ios::out | ios::binary);
+        if(!out)
+            avr_error("can't create snapshot file '%s'", name.c_str());
+        SimulationContext::Current()->SaveState(out);
+    }
+    
+    if(profileFile != "") {
+        string name = ForkChildFileName(profileFile, forkChild);
+        ofstream out(name.c_str());
+        if(!out)
+            avr_error("can't create profile file '%s'", name.c_str());
+        profiler->WriteFlat(out);
+        out << endl;
+        profiler->WriteCallGraph(out);
+    }
+    
+    if(profileStacksFile != "") {
+        string name = ForkChildFileName(profileStacksFile, forkChild);
+        ofstream out(name.c_str());
+        if(!out)
+            avr_error("can't create profile file '%s'", name.c_str());
+        profiler->WriteCollapsed(out);
+    }
+    
+    if(functionStatsFile != "") {
+        string name = ForkChildFileName(functionStatsFile, forkChild);
+        ofstream out(name.c_str());
+        if(!out)
+            avr_error("can't create function statistic file '%s'", name.c_str());
+        profiler->WriteFunctionStatistic(out);
+    }
+    
+    if(functionStatsJSONFile != "") {
+        string name = ForkChildFileName(functionStatsJSONFile, forkChild);
+        ofstream out(name.c_str());
+        if(!out)
+            avr_error("can't create function statistic file '%s'", name.c_str());
+        profiler->WriteFunctionStatisticJSON(out);
+    }
+    
+    if(coverageFile != "") {
+        string name = ForkChildFileName(coverageFile, forkChild);
+        ofstream out(name.c_str());
+        if(!out)
+            avr_error("can't create coverage file '%s'", name.c_str());
+        coverage->WriteLcov(out);
     }
 
-    // delete ui and device
+    // delete history, ui, stimulus, trace, profiler, coverage and device
+    delete history;
     delete ui;
+    delete stimulus;
+    delete binaryTrace;
+    delete profiler;
+    delete coverage;
     delete dev1;
     
     return 0;
@@ -0,0 +1,357 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+/*!
+   \file tracedump.cpp
+   \brief Converts a binary trace (simulavr option -j) to text trace format.
+
+   Instruction mnemonics are written by the same Trace() methods, which write
+   the text trace in simulavr. For that the instructions are replayed on a
+   shadow device of the same type: registers, RAM, status register and stack
+   pointer of the shadow device are set from the REC_WRITE and REC_STATUS
+   records, so the shadow device has the same state as the traced device
+   before every instruction. IO registers are not written to shadow device,
+   because this could trigger it's hardware. */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _MSC_VER
+#  include <getopt.h>
+#else
+#  include "../getopt/getopt.h"
+#endif
+
+#include "config.h"
+
+#include "binarytrace.h"
+#include "avrdevice.h"
+#include "avrfactory.h"
+#include "avrerror.h"
+#include "decoder.h"
+#include "flash.h"
+#include "helper.h"
+#include "hwsreg.h"
+#include "hwstack.h"
+
+const char Usage[] =
+    "simulavr-tracedump: converts a binary trace of simulavr (option -j) to text\n"
+    "Usage: simulavr-tracedump [options] <binary trace file>\n"
+    "-o --output <file>    write text trace to <file> instead of stdout\n"
+    "-f --file <name>      load program <name> for symbols and program\n"
+    "                      instead of program file named in trace\n"
+    "-d --device <name>    use device type <name> instead of device type in trace\n"
+    "-c --cycles           start every line with cycle counter of device\n"
+    "-h --help             print this help\n";
+
+//! Shadow device for one traced device
+struct TracedDevice {
+    AvrDevice *dev;         //!< shadow device, replays instructions
+    string filename;        //!< program file name of traced device
+    unsigned long long cycle; //!< cycle counter of traced device
+};
+
+//! Reads records of a binary trace file with one record look ahead
+class TraceReader {
+
+    public:
+        TraceReader(const char *name) {
+            file = fopen(name, "rb");
+            if(file == NULL)
+                avr_error("can't open binary trace file '%s'", name);
+            char header[16];
+            if(fread(header, sizeof(header), 1, file) != 1
+               || memcmp(header, BinaryTrace::magic, sizeof(BinaryTrace::magic)) != 0)
+                avr_error("file '%s' isn't a binary trace", name);
+            uint16_t version, recordSize;
+            uint32_t byteOrder;
+            memcpy(&version, header + 8, sizeof(version));
+            memcpy(&recordSize, header + 10, sizeof(recordSize));
+            memcpy(&byteOrder, header + 12, sizeof(byteOrder));
+            if(byteOrder != 0x01020304)
+                avr_error("binary trace '%s' was written on a host with different byte order", name);
+            if(version != BinaryTrace::version || recordSize != sizeof(BinaryTraceRecord))
+                avr_error("binary trace '%s' has unsupported version %d", name, version);
+            pos = count = 0;
+        }
+        ~TraceReader() { fclose(file); }
+
+        //! Returns next record without reading it, NULL on end of file
+        const BinaryTraceRecord *Peek(void) {
+            if(pos == count) {
+                count = fread(buffer, sizeof(BinaryTraceRecord), BUFFER_SIZE, file);
+                pos = 0;
+                if(count == 0)
+                    return NULL;
+            }
+            return buffer + pos;
+        }
+        //! Reads next record, returns false on end of file
+        bool Next(BinaryTraceRecord &r) {
+            const BinaryTraceRecord *p = Peek();
+            if(p == NULL)
+                return false;
+            r = *p;
+            pos++;
+            return true;
+        }
+
+    private:
+        enum { BUFFER_SIZE = 4096 };
+        FILE *file;
+        BinaryTraceRecord buffer[BUFFER_SIZE];
+        size_t pos;
+        size_t count;
+};
+
+//! Writes a instruction word to flash of shadow device, if it's different
+static void SetFlashWord(AvrDevice *dev, unsigned int pc, unsigned int opcode) {
+    if(dev->Flash->ReadMemWord(pc * 2) == opcode)
+        return;
+    unsigned char data[2];
+    data[0] = opcode & 0xff;
+    data[1] = (opcode >> 8) & 0xff;
+    dev->Flash->WriteMem(data, pc * 2, 2);
+}
+
+//! Creates shadow device from a REC_DEVICE record and it's text
+static TracedDevice CreateDevice(TraceReader &reader,
+                                 const BinaryTraceRecord &r,
+                                 const string &deviceOption,
+                                 const string &fileOption) {
+    string text;
+    for(unsigned int pos = 0; pos < r.address; pos += sizeof(BinaryTraceRecord)) {
+        BinaryTraceRecord t;
+        if(!reader.Next(t))
+            avr_error("binary trace is truncated");
+        text.append((const char *)&t, sizeof(BinaryTraceRecord));
+    }
+    text.resize(r.address);
+
+    TracedDevice d;
+    d.cycle = 0;
+    string::size_type nl = text.find('\n');
+    string devicename = (deviceOption != "") ? deviceOption : text.substr(0, nl);
+    d.filename = (nl == string::npos) ? "" : text.substr(nl + 1);
+    d.dev = AvrFactory::instance().makeDevice(devicename.c_str());
+
+    string program = (fileOption != "") ? fileOption : d.filename;
+    FILE *f = (program != "") ? fopen(program.c_str(), "rb") : NULL;
+    if(f != NULL) {
+        fclose(f);
+        d.dev->Load(program.c_str());
+    } else
+        avr_warning("program file '%s' not found, trace without symbols", program.c_str());
+
+    // stack writes trace output only with trace flag
+    d.dev->trace_on = 1;
+    return d;
+}
+
+int main(int argc, char *argv[]) {
+    string outputFile("");
+    string fileOption("");
+    string deviceOption("");
+    bool cycles = false;
+
+    while(1) {
+        static struct option long_options[] = {
+            {"output", 1, 0, 'o'},
+            {"file", 1, 0, 'f'},
+            {"device", 1, 0, 'd'},
+            {"cycles", 0, 0, 'c'},
+            {"help", 0, 0, 'h'},
+            {0, 0, 0, 0}
+        };
+
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "o:f:d:ch", long_options, &option_index);
+        if(c == -1)
+            break;
+
+        switch(c) {
+            case 'o':
+                outputFile = optarg;
+                break;
+
+            case 'f':
+                fileOption = optarg;
+                break;
+
+            case 'd':
+                deviceOption = optarg;
+                break;
+
+            case 'c':
+                cycles = true;
+                break;
+
+            default:
+                cout << Usage;
+                exit(0);
+        }
+    }
+    if(optind != argc - 1) {
+        cout << Usage;
+        exit(1);
+    }
+
+    ofstream out;
+    if(outputFile != "") {
+        out.open(outputFile.c_str());
+        if(!out)
+            avr_error("can't create output file '%s'", outputFile.c_str());
+        sysConHandler.SetTraceStream(&out);
+    } else
+        sysConHandler.SetTraceStream(&cout);
+
+    TraceReader reader(argv[optind]);
+    vector<TracedDevice> devices;
+    bool lineOpen = false;
+    unsigned int linePC = 0;
+    BinaryTraceRecord r;
+
+    while(reader.Next(r)) {
+        unsigned int type = r.type & BinaryTrace::REC_TYPE_MASK;
+
+        if(type == BinaryTrace::REC_DEVICE) {
+            if(r.device != devices.size())
+                avr_error("binary trace is corrupted: unexpected device %d", r.device);
+            devices.push_back(CreateDevice(reader, r, deviceOption, fileOption));
+            continue;
+        }
+        if(r.device >= devices.size())
+            avr_error("binary trace is corrupted: unknown device %d", r.device);
+        TracedDevice &d = devices[r.device];
+
+        if(r.type & BinaryTrace::REC_LINE) {
+            if(lineOpen)
+                traceOut << endl;
+            d.cycle++;
+            if(cycles)
+                traceOut << d.cycle << " ";
+            traceOut << d.filename << " ";
+            traceOut << HexShort(r.address << 1) << dec << ": ";
+            string sym(d.dev->Flash->GetSymbolAtAddress(r.address));
+            traceOut << sym << " ";
+            for(int len = sym.length(); len < 30; len++)
+                traceOut << " " ;
+            lineOpen = true;
+            linePC = r.address;
+        }
+
+        switch(type) {
+            case BinaryTrace::REC_INSTRUCTION: {
+                SetFlashWord(d.dev, r.address, r.value);
+                const BinaryTraceRecord *op = reader.Peek();
+                if(op != NULL && (op->type & BinaryTrace::REC_TYPE_MASK) == BinaryTrace::REC_OPERAND)
+                    SetFlashWord(d.dev, op->address, op->value);
+                d.dev->PC = r.address;
+                d.dev->cPC = r.address;
+                DecodedInstruction *instr = d.dev->Flash->GetInstruction(r.address);
+                if(dynamic_cast<avr_op_ILLEGAL *>(instr) != NULL)
+                    traceOut << "Invalid Instruction! ";
+                else
+                    instr->Trace(d.dev);
+                break;
+            }
+
+            case BinaryTrace::REC_WAITSTATE:
+                traceOut << "CPU-waitstate";
+                break;
+
+            case BinaryTrace::REC_SLEEP:
+                traceOut << "CPU-Sleep ";
+                break;
+
+            case BinaryTrace::REC_HOLD:
+                traceOut << "CPU-Hold by IO-Hardware ";
+                break;
+
+            case BinaryTrace::REC_BREAKPOINT:
+                traceOut << "Breakpoint found at 0x" << hex << r.address << dec << endl;
+                lineOpen = false;
+                break;
+
+            case BinaryTrace::REC_IRQ:
+                traceOut << "IRQ DETECTED: VectorAddr: " << r.value ;
+                break;
+
+            case BinaryTrace::REC_IRQ_PREPARED:
+                traceOut << "IRQ prepared for addr " << hex << r.value << dec << endl;
+                break;
+
+            case BinaryTrace::REC_IRQ_PENDING:
+                traceOut << d.filename << " interrupt on index " << r.value << " is pending" << endl;
+                break;
+
+            case BinaryTrace::REC_IRQ_CLEARED:
+                traceOut << d.filename << " interrupt on index " << r.value << "cleared" << endl;
+                break;
+
+            case BinaryTrace::REC_IRQ_STARTED:
+                traceOut << d.filename << " IrqSystem: IrqHandlerStarted Vec: " << r.value << endl;
+                // return address is pushed after start of irq handler
+                d.dev->stack->PushAddr(linePC);
+                break;
+
+            case BinaryTrace::REC_IRQ_FINISHED:
+                traceOut << d.filename << " IrqSystem: IrqHandler Finished Vec: " << r.value << endl;
+                break;
+
+            case BinaryTrace::REC_WRITE:
+                // registers and RAM, but not IO space
+                if(r.address < d.dev->GetMemRegisterSize()
+                   || r.address >= d.dev->GetMemRegisterSize() + d.dev->GetMemIOSize())
+                    d.dev->SetRWMem(r.address, r.value);
+                break;
+
+            case BinaryTrace::REC_STATUS:
+                *(d.dev->status) = r.value;
+                d.dev->stack->SetStackPointer(r.address);
+                break;
+
+            case BinaryTrace::REC_CYCLE:
+                d.cycle = ((unsigned long long)r.value << 32) + r.address;
+                break;
+
+            default:
+                break;
+        }
+    }
+    if(lineOpen)
+        traceOut << endl;
+
+    sysConHandler.StopTrace();
+    for(unsigned int i = 0; i < devices.size(); i++)
+        delete devices[i].dev;
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef _MSC_VER
+#   include "config.h"
+#endif
+
+#include <fstream>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "compressedstream.h"
+#include "avrerror.h"
+
+#ifdef HAVE_LIBPTHREAD
+#   include <pthread.h>
+#endif
+#ifdef HAVE_ZLIB
+#   include <zlib.h>
+#endif
+
+using namespace std;
+
+//! Second block and worker thread of a CompressedStreamBuf
+struct CompressedStreamWorker {
+    vector<char> block;         //!< block to compress, empty if worker is idle
+#ifdef HAVE_LIBPTHREAD
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;        //!< signals a new block, stop or a written block
+    bool stop;                  //!< worker thread has to exit
+#endif
+};
+
+//! All open compressed files, closed on exit by CloseAll
+static vector<CompressedStreamBuf *> openBuffers;
+
+//! Size of gzip member header with extra field
+static const size_t headerSize = 24;
+
+//! Stores a 32 bit value little endian
+static void PutLE32(unsigned char *p, unsigned long v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+CompressedStreamBuf::CompressedStreamBuf(const string &filename, unsigned int _blockSize):
+    file(NULL),
+    blockSize(_blockSize),
+    worker(NULL)
+{
+#ifdef HAVE_ZLIB
+    file = fopen(filename.c_str(), "wb");
+    if(file == NULL)
+        avr_error("can't create compressed file '%s'", filename.c_str());
+    block.resize(blockSize);
+    setp(&block[0], &block[0] + block.size());
+
+    worker = new CompressedStreamWorker;
+#ifdef HAVE_LIBPTHREAD
+    worker->stop = false;
+    pthread_mutex_init(&worker->mutex, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+    if(pthread_create(&worker->thread, NULL, WorkerThread, this) != 0)
+        avr_error("can't create worker thread for compressed file '%s'", filename.c_str());
+#endif
+
+    // file has to be complete, even if simulation is terminated by avr_error
+    if(openBuffers.empty())
+        atexit(CloseAll);
+    openBuffers.push_back(this);
+#else
+    avr_error("can't create compressed file '%s', simulavr is built without zlib", filename.c_str());
+#endif
+}
+
+CompressedStreamBuf::~CompressedStreamBuf() {
+    Close();
+}
+
+void CompressedStreamBuf::Close(void) {
+    if(file == NULL)
+        return;
+    openBuffers.erase(find(openBuffers.begin(), openBuffers.end(), this));
+    NextBlock();
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&worker->mutex);
+    worker->stop = true;
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+    pthread_join(worker->thread, NULL);
+    pthread_cond_destroy(&worker->cond);
+    pthread_mutex_destroy(&worker->mutex);
+#endif
+    delete worker;
+    worker = NULL;
+    fclose(file);
+    file = NULL;
+    setp(NULL, NULL);
+}
+
+void CompressedStreamBuf::CloseAll(void) {
+    while(!openBuffers.empty())
+        openBuffers.back()->Close();
+}
+
+CompressedStreamBuf::int_type CompressedStreamBuf::overflow(int_type c) {
+    if(file == NULL)
+        return traits_type::eof();
+    NextBlock();
+    if(!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+streamsize CompressedStreamBuf::xsputn(const char *s, streamsize n) {
+    if(file == NULL)
+        return 0;
+    streamsize done = 0;
+    while(done < n) {
+        streamsize room = epptr() - pptr();
+        if(room == 0) {
+            NextBlock();
+            continue;
+        }
+        streamsize len = (n - done < room) ? (n - done) : room;
+        memcpy(pptr(), s + done, len);
+        pbump(len);
+        done += len;
+    }
+    return n;
+}
+
+void CompressedStreamBuf::NextBlock(void) {
+    size_t size = pptr() - pbase();
+    if(size == 0)
+        return;
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&worker->mutex);
+    while(!worker->block.empty())
+        pthread_cond_wait(&worker->cond, &worker->mutex);
+    block.resize(size);
+    worker->block.swap(block);
+    pthread_cond_broadcast(&worker->cond);
+    pthread_mutex_unlock(&worker->mutex);
+    block.resize(blockSize);
+#else
+    WriteMember(pbase(), size);
+#endif
+    setp(&block[0], &block[0] + block.size());
+}
+
+void *CompressedStreamBuf::WorkerThread(void *buf) {
+#ifdef HAVE_LIBPTHREAD
+    CompressedStreamBuf *b = (CompressedStreamBuf *)buf;
+    CompressedStreamWorker *w = b->worker;
+    pthread_mutex_lock(&w->mutex);
+    while(true) {
+        while(w->block.empty() && !w->stop)
+            pthread_cond_wait(&w->cond, &w->mutex);
+        if(w->block.empty())
+            break;
+        // stream doesn't touch block, till it's empty again
+        pthread_mutex_unlock(&w->mutex);
+        b->WriteMember(&w->block[0], w->block.size());
+        pthread_mutex_lock(&w->mutex);
+        w->block.clear();
+        pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->mutex);
+#endif
+    return NULL;
+}
+
+void CompressedStreamBuf::WriteMember(const char *data, size_t size) {
+#ifdef HAVE_ZLIB
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    // raw deflate, gzip header and trailer are written here
+    if(deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        avr_error("can't initialize zlib for compressed file");
+    vector<unsigned char> out(headerSize + deflateBound(&z, size) + 8);
+    z.next_in = (Bytef *)data;
+    z.avail_in = size;
+    z.next_out = &out[headerSize];
+    z.avail_out = out.size() - headerSize - 8;
+    if(deflate(&z, Z_FINISH) != Z_STREAM_END)
+        avr_error("can't compress block of compressed file");
+    size_t member = headerSize + z.total_out + 8;
+    deflateEnd(&z);
+
+    unsigned char *h = &out[0];
+    h[0] = 0x1f; h[1] = 0x8b;   // gzip magic
+    h[2] = 8;                   // deflate
+    h[3] = 4;                   // FEXTRA
+    PutLE32(h + 4, 0);          // no modification time
+    h[8] = 0;                   // extra flags
+    h[9] = 255;                 // unknown OS
+    h[10] = 12; h[11] = 0;      // length of extra field
+    h[12] = 'S'; h[13] = 'B';   // subfield: simulavr block
+    h[14] = 8; h[15] = 0;
+    PutLE32(h + 16, member);
+    PutLE32(h + 20, size);
+    unsigned char *t = h + headerSize + z.total_out;
+    PutLE32(t, crc32(crc32(0, Z_NULL, 0), (const Bytef *)data, size));
+    PutLE32(t + 4, size);
+
+    if(fwrite(h, 1, member, file) != member)
+        avr_error("can't write compressed file");
+#endif
+}
+
+CompressedOStream::CompressedOStream(const string &filename, unsigned int blockSize):
+    std::ostream(NULL),
+    buf(filename, blockSize)
+{
+    init(&buf);
+}
+
+CompressedOStream::~CompressedOStream() {
+    buf.Close();
+}
+
+bool CompressedOStream::IsAvailable(void) {
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+ostream *OpenTraceOutput(const string &name, bool compress) {
+    if(compress || (name.size() > 3 && name.substr(name.size() - 3) == ".gz"))
+        return new CompressedOStream(name);
+    return new ofstream(name.c_str());
+}
@@ -0,0 +1,98 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef COMPRESSEDSTREAM
+#define COMPRESSEDSTREAM
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+struct CompressedStreamWorker;
+
+//! Stream buffer, which writes data compressed in independent blocks
+/*! Data is collected to blocks of blockSize bytes. Every full block is
+  compressed by a worker thread (if pthread is available) to a gzip member
+  of it's own, while the next block is filled.
+
+  The resulting file is a normal gzip file (members of a gzip file are
+  concatenated, gunzip and zlib read it as one stream). Every member has a
+  extra field 'S','B' in it's header with 8 bytes: size of the whole member
+  and size of uncompressed data, both 32 bit little endian. So a tool can
+  seek over blocks without decompressing them.
+
+  Open files are closed on exit of the program, so a file is complete, even
+  if the simulation ends by avr_error. */
+class CompressedStreamBuf: public std::streambuf {
+
+    public:
+        CompressedStreamBuf(const std::string &filename, unsigned int blockSize);
+        ~CompressedStreamBuf();
+
+        //! Writes remaining data, stops worker thread and closes file
+        void Close(void);
+        //! Closes all open files, called on exit (also by avr_error)
+        static void CloseAll(void);
+
+    protected:
+        virtual int_type overflow(int_type c);
+        virtual std::streamsize xsputn(const char *s, std::streamsize n);
+
+    private:
+        FILE *file;
+        unsigned int blockSize;             //!< size of uncompressed blocks
+        std::vector<char> block;            //!< block, which is filled now
+        CompressedStreamWorker *worker;     //!< second block and worker thread
+
+        //! Gives filled part of block to worker
+        void NextBlock(void);
+        //! Compresses data to a gzip member and writes it to file
+        void WriteMember(const char *data, size_t size);
+
+        static void *WorkerThread(void *buf);
+};
+
+//! Output stream, which writes a compressed file, see CompressedStreamBuf
+class CompressedOStream: public std::ostream {
+
+    public:
+        //! Creates compressed file filename, blockSize is size of uncompressed blocks
+        CompressedOStream(const std::string &filename, unsigned int blockSize = 1024 * 1024);
+        ~CompressedOStream();
+
+        //! True, if simulavr is built with compression support (zlib)
+        static bool IsAvailable(void);
+
+    private:
+        CompressedStreamBuf buf;
+};
+
+//! Opens a output file for trace data
+/*! The file is written by a CompressedOStream, if compress is true or
+  name ends with ".gz", otherwise by a std::ofstream. */
+std::ostream *OpenTraceOutput(const std::string &name, bool compress = false);
+
+#endif
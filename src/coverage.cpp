@@ -0,0 +1,157 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+
+#include <map>
+#include <set>
+#include <string>
+
+#include "coverage.h"
+#include "avrdevice.h"
+#include "avrerror.h"
+#include "avrreadelf.h"
+#include "decoder.h"
+#include "flash.h"
+
+using namespace std;
+
+Coverage::Coverage(AvrDevice *_core):
+    core(_core),
+    flags(_core->Flash->GetSize() / 2, 0)
+{
+    core->coverage = this;
+}
+
+Coverage::~Coverage() {
+    core->coverage = NULL;
+}
+
+bool Coverage::IsConditional(unsigned int pc) const {
+    DecodedInstruction *i = core->Flash->GetInstruction(pc);
+    return dynamic_cast<avr_op_BRBS *>(i) != NULL
+        || dynamic_cast<avr_op_BRBC *>(i) != NULL
+        || dynamic_cast<avr_op_CPSE *>(i) != NULL
+        || dynamic_cast<avr_op_SBRC *>(i) != NULL
+        || dynamic_cast<avr_op_SBRS *>(i) != NULL
+        || dynamic_cast<avr_op_SBIC *>(i) != NULL
+        || dynamic_cast<avr_op_SBIS *>(i) != NULL;
+}
+
+unsigned char Coverage::FirstExecuted(unsigned int pc) const {
+    return EXECUTED | (IsConditional(pc) ? CONDITIONAL : 0);
+}
+
+//! Coverage of a source line
+struct CoverageLine {
+    CoverageLine(): executed(false) {}
+    bool executed;
+    set<unsigned int> branches; //!< word addresses of conditional instructions
+};
+
+void Coverage::WriteLcov(ostream &os) {
+    vector<ELFLineEntry> lines;
+    if(!ELFReadLineTable(core->GetFname(), lines))
+        avr_warning("program '%s' has no DWARF line table, compile it with -g for coverage",
+                    core->GetFname().c_str());
+    map<unsigned int, string> functions;
+    ELFReadFunctions(core->GetFname(), functions);
+
+    unsigned int size = flags.size();
+    map<string, map<unsigned int, CoverageLine> > files;
+    for(unsigned int i = 0; i < lines.size(); i++) {
+        const ELFLineEntry &l = lines[i];
+        if(l.file.empty())
+            continue;
+        CoverageLine &c = files[l.file][l.line];
+        for(unsigned int pc = l.start / 2; pc < (l.end + 1) / 2 && pc < size; pc++) {
+            if(flags[pc] & EXECUTED)
+                c.executed = true;
+            if(IsConditional(pc))
+                c.branches.insert(pc);
+        }
+    }
+
+    // functions are placed at line of it's first instruction
+    map<string, map<string, pair<unsigned int, bool> > > fileFunctions;
+    for(map<unsigned int, string>::iterator f = functions.begin(); f != functions.end(); f++) {
+        for(unsigned int i = 0; i < lines.size(); i++) {
+            if(f->first >= lines[i].start && f->first < lines[i].end && !lines[i].file.empty()) {
+                unsigned int pc = f->first / 2;
+                fileFunctions[lines[i].file][f->second] =
+                    make_pair(lines[i].line, pc < size && (flags[pc] & EXECUTED) != 0);
+                break;
+            }
+        }
+    }
+
+    map<string, map<unsigned int, CoverageLine> >::iterator file;
+    for(file = files.begin(); file != files.end(); file++) {
+        os << "TN:" << endl << "SF:" << file->first << endl;
+
+        map<string, pair<unsigned int, bool> > &fn = fileFunctions[file->first];
+        map<string, pair<unsigned int, bool> >::iterator f;
+        unsigned int hit = 0;
+        for(f = fn.begin(); f != fn.end(); f++)
+            os << "FN:" << f->second.first << "," << f->first << endl;
+        for(f = fn.begin(); f != fn.end(); f++) {
+            os << "FNDA:" << (f->second.second ? 1 : 0) << "," << f->first << endl;
+            if(f->second.second)
+                hit++;
+        }
+        os << "FNF:" << fn.size() << endl << "FNH:" << hit << endl;
+
+        map<unsigned int, CoverageLine>::iterator l;
+        unsigned int branches = 0;
+        hit = 0;
+        for(l = file->second.begin(); l != file->second.end(); l++) {
+            unsigned int block = 0;
+            set<unsigned int>::iterator b;
+            for(b = l->second.branches.begin(); b != l->second.branches.end(); b++, block++) {
+                unsigned char fl = flags[*b];
+                for(int branch = 0; branch < 2; branch++) {
+                    bool taken = (fl & ((branch == 0) ? TAKEN : NOT_TAKEN)) != 0;
+                    os << "BRDA:" << l->first << "," << block << "," << branch << ",";
+                    if(fl & EXECUTED)
+                        os << (taken ? 1 : 0) << endl;
+                    else
+                        os << "-" << endl;
+                    branches++;
+                    if(taken)
+                        hit++;
+                }
+            }
+        }
+        os << "BRF:" << branches << endl << "BRH:" << hit << endl;
+
+        hit = 0;
+        for(l = file->second.begin(); l != file->second.end(); l++) {
+            os << "DA:" << l->first << "," << (l->second.executed ? 1 : 0) << endl;
+            if(l->second.executed)
+                hit++;
+        }
+        os << "LF:" << file->second.size() << endl << "LH:" << hit << endl
+           << "end_of_record" << endl;
+    }
+}
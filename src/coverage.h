@@ -0,0 +1,81 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+
+#ifndef COVERAGE
+#define COVERAGE
+
+#include <iostream>
+#include <vector>
+
+class AvrDevice;
+
+//! Code coverage of a device
+/*! A flag byte per flash word records, if the instruction at this word was
+  executed and, for conditional branches and skips (BRBS, BRBC, CPSE, SBRC,
+  SBRS, SBIC, SBIS), if the branch was taken (jump or skip) and if it wasn't
+  taken. The cost per instruction is one array access and a test.
+
+  Result is written as lcov tracefile (.info): the executed words are mapped
+  to source lines by the DWARF line table of the program file, functions by
+  the function symbols. Genhtml and other lcov tools read this format. */
+class Coverage {
+
+    public:
+        //! Creates coverage recording and enables it on device, see AvrDevice::coverage
+        Coverage(AvrDevice *core);
+        //! Disables coverage recording on device
+        ~Coverage();
+
+        //! Instruction at pc was executed, next is the following program counter
+        void Executed(unsigned int pc, unsigned int next) {
+            unsigned char &f = flags[pc];
+            if(f == 0)
+                f = FirstExecuted(pc);
+            if(f & CONDITIONAL)
+                f |= (next != pc + 1) ? TAKEN : NOT_TAKEN;
+        }
+
+        //! Writes lcov tracefile of executed lines, functions and branches
+        void WriteLcov(std::ostream &os);
+
+    private:
+        enum {
+            EXECUTED = 1,       //!< instruction was executed
+            CONDITIONAL = 2,    //!< instruction is a conditional branch or skip
+            TAKEN = 4,          //!< branch was taken or instruction skipped
+            NOT_TAKEN = 8       //!< branch wasn't taken
+        };
+
+        AvrDevice *core;
+        std::vector<unsigned char> flags; //!< flags per word address
+
+        //! Flags for first execution of instruction at pc
+        unsigned char FirstExecuted(unsigned int pc) const;
+        //! True, if instruction at pc is a conditional branch or skip
+        bool IsConditional(unsigned int pc) const;
+};
+
+#endif
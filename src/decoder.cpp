@@ -100,16 +100,16 @@ static int get_q( word opcode );
 static int get_A_5( word opcode );
 static int get_A_6( word opcode );
 
-avr_op_ADC::avr_op_ADC(word opcode, AvrDevice *c): 
-    DecodedInstruction(c),
+avr_op_ADC::avr_op_ADC(word opcode): 
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    R2(get_rr_5(opcode)),
-    status(c->status) {}
+    R2(get_rr_5(opcode)) {}
 
 unsigned char avr_op_ADC::GetModifiedR() const {
     return R1;
 }
-int avr_op_ADC::operator()() { 
+static inline int exec_ADC(AvrDevice *core, unsigned char R1, unsigned char R2) {
+    HWSreg *status = core->status;
     unsigned char rd = core->GetCoreReg(R1);
     unsigned char rr = core->GetCoreReg(R2);
     unsigned char res = rd + rr + status->C;
@@ -126,16 +126,20 @@ int avr_op_ADC::operator()() {
     return 1;   //used clocks
 }
 
-avr_op_ADD::avr_op_ADD(word opcode, AvrDevice *c): 
-    DecodedInstruction(c),
+int avr_op_ADC::operator()(AvrDevice *core) {
+    return exec_ADC(core, R1, R2);
+}
+
+avr_op_ADD::avr_op_ADD(word opcode): 
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    R2(get_rr_5(opcode)), 
-    status(c->status) {}
+    R2(get_rr_5(opcode)) {}
 
 unsigned char avr_op_ADD::GetModifiedR() const {
     return R1;
 }
-int avr_op_ADD::operator()() { 
+static inline int exec_ADD(AvrDevice *core, unsigned char R1, unsigned char R2) {
+    HWSreg *status = core->status;
     unsigned char rd = core->GetCoreReg(R1);
     unsigned char rr = core->GetCoreReg(R2);
     unsigned char res = rd + rr;
@@ -152,12 +156,15 @@ int avr_op_ADD::operator()() {
     return 1;   //used clocks
 }
 
-avr_op_ADIW::avr_op_ADIW(word opcode, AvrDevice *c): 
-    DecodedInstruction(c),
+int avr_op_ADD::operator()(AvrDevice *core) {
+    return exec_ADD(core, R1, R2);
+}
+
+avr_op_ADIW::avr_op_ADIW(word opcode): 
+    DecodedInstruction(),
     Rl(get_rd_2(opcode)),
     Rh(get_rd_2(opcode) + 1),
-    K(get_K_6(opcode)),
-    status(c->status) {
+    K(get_K_6(opcode)) {
     }
 
 unsigned char avr_op_ADIW::GetModifiedR() const {
@@ -166,7 +173,8 @@ unsigned char avr_op_ADIW::GetModifiedR() const {
 unsigned char avr_op_ADIW::GetModifiedRHi() const {
     return Rh;
 }
-int avr_op_ADIW::operator()() {
+static inline int exec_ADIW(AvrDevice *core, unsigned char Rl, unsigned char Rh, unsigned char K) {
+    HWSreg *status = core->status;
     word rd = (core->GetCoreReg(Rh) << 8) + core->GetCoreReg(Rl);
     word res = rd + K;
     unsigned char rdh = core->GetCoreReg(Rh);
@@ -184,13 +192,17 @@ int avr_op_ADIW::operator()() {
     return 2; 
 }
 
-avr_op_AND::avr_op_AND(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_ADIW::operator()(AvrDevice *core) {
+    return exec_ADIW(core, Rl, Rh, K);
+}
+
+avr_op_AND::avr_op_AND(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    R2(get_rr_5(opcode)),
-    status(c->status) {}
+    R2(get_rr_5(opcode)) {}
 
-int avr_op_AND::operator()() {
+static inline int exec_AND(AvrDevice *core, unsigned char R1, unsigned char R2) {
+    HWSreg *status = core->status;
     unsigned char res = core->GetCoreReg(R1) & core->GetCoreReg(R2);
 
     status->V = 0;
@@ -203,13 +215,17 @@ int avr_op_AND::operator()() {
     return 1; 
 }
 
-avr_op_ANDI::avr_op_ANDI(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_AND::operator()(AvrDevice *core) {
+    return exec_AND(core, R1, R2);
+}
+
+avr_op_ANDI::avr_op_ANDI(word opcode):
+    DecodedInstruction(),
     R1(get_rd_4(opcode)),
-    K(get_K_8(opcode)),
-    status(c->status) {}
+    K(get_K_8(opcode)) {}
 
-int avr_op_ANDI::operator()() {
+static inline int exec_ANDI(AvrDevice *core, unsigned char R1, unsigned char K) {
+    HWSreg *status = core->status;
     unsigned char rd = core->GetCoreReg(R1);
     unsigned char res = rd & K;
 
@@ -223,12 +239,16 @@ int avr_op_ANDI::operator()() {
     return 1;
 }
 
-avr_op_ASR::avr_op_ASR(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    R1(get_rd_5(opcode)),
-    status(c->status) {}
+int avr_op_ANDI::operator()(AvrDevice *core) {
+    return exec_ANDI(core, R1, K);
+}
+
+avr_op_ASR::avr_op_ASR(word opcode):
+    DecodedInstruction(),
+    R1(get_rd_5(opcode)) {}
 
-int avr_op_ASR::operator()() {
+static inline int exec_ASR(AvrDevice *core, unsigned char R1) {
+    HWSreg *status = core->status;
     unsigned char rd = core->GetCoreReg(R1); 
     unsigned char res = (rd >> 1) + (rd & 0x80);
 
@@ -243,25 +263,29 @@ int avr_op_ASR::operator()() {
     return 1;
 }
 
+int avr_op_ASR::operator()(AvrDevice *core) {
+    return exec_ASR(core, R1);
+}
+
 
-avr_op_BCLR::avr_op_BCLR(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    status(c->status),
+avr_op_BCLR::avr_op_BCLR(word opcode):
+    DecodedInstruction(),
     Kbit(get_sreg_bit(opcode)) {}
 
-int avr_op_BCLR::operator()() {
+int avr_op_BCLR::operator()(AvrDevice *core) {
+    HWSreg *status = core->status;
     *status = (*status) & ~(1 << Kbit);
     
     return 1;
 }
 
-avr_op_BLD::avr_op_BLD(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_BLD::avr_op_BLD(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    Kbit(get_reg_bit(opcode)),
-    status(c->status) {}
+    Kbit(get_reg_bit(opcode)) {}
 
-int avr_op_BLD::operator()() {
+static inline int exec_BLD(AvrDevice *core, unsigned char R1, unsigned char Kbit) {
+    HWSreg *status = core->status;
     unsigned char rd = core->GetCoreReg(R1);
     int T = status->T;
     unsigned char res;
@@ -276,13 +300,17 @@ int avr_op_BLD::operator()() {
     return 1;
 }
 
-avr_op_BRBC::avr_op_BRBC(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    status(c->status),
+int avr_op_BLD::operator()(AvrDevice *core) {
+    return exec_BLD(core, R1, Kbit);
+}
+
+avr_op_BRBC::avr_op_BRBC(word opcode):
+    DecodedInstruction(),
     bitmask(1 << get_reg_bit(opcode)),
     offset(n_bit_unsigned_to_signed(get_k_7(opcode), 7)) {}
 
-int avr_op_BRBC::operator()() {
+static inline int exec_BRBC(AvrDevice *core, unsigned char bitmask, signed char offset) {
+    HWSreg *status = core->status;
     int clks;
 
     if((bitmask & (*(status))) == 0) {
@@ -296,13 +324,17 @@ int avr_op_BRBC::operator()() {
     return clks;
 }
 
-avr_op_BRBS::avr_op_BRBS(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    status(c->status),
+int avr_op_BRBC::operator()(AvrDevice *core) {
+    return exec_BRBC(core, bitmask, offset);
+}
+
+avr_op_BRBS::avr_op_BRBS(word opcode):
+    DecodedInstruction(),
     bitmask(1 << get_reg_bit(opcode)),
     offset(n_bit_unsigned_to_signed(get_k_7(opcode), 7)) {}
 
-int avr_op_BRBS::operator()() {
+static inline int exec_BRBS(AvrDevice *core, unsigned char bitmask, signed char offset) {
+    HWSreg *status = core->status;
     int clks;
 
     if((bitmask & (*(status))) != 0) {
@@ -316,34 +348,42 @@ int avr_op_BRBS::operator()() {
     return clks;
 }
 
-avr_op_BSET::avr_op_BSET(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    status(c->status),
+int avr_op_BRBS::operator()(AvrDevice *core) {
+    return exec_BRBS(core, bitmask, offset);
+}
+
+avr_op_BSET::avr_op_BSET(word opcode):
+    DecodedInstruction(),
     Kbit(get_sreg_bit(opcode)) {}
 
-int avr_op_BSET::operator()() {
+int avr_op_BSET::operator()(AvrDevice *core) {
+    HWSreg *status = core->status;
     *(status) = *(status) | 1 << Kbit;
     
     return 1;
 }
 
-avr_op_BST::avr_op_BST(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_BST::avr_op_BST(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    Kbit(get_reg_bit(opcode)),
-    status(c->status) {}
+    Kbit(get_reg_bit(opcode)) {}
 
-int avr_op_BST::operator()() {
+static inline int exec_BST(AvrDevice *core, unsigned char R1, unsigned char Kbit) {
+    HWSreg *status = core->status;
     status->T = ((core->GetCoreReg(R1) & (1 << Kbit)) != 0); 
 
     return 1;
 }
 
-avr_op_CALL::avr_op_CALL(word opcode, AvrDevice *c):
-    DecodedInstruction(c, true),
+int avr_op_BST::operator()(AvrDevice *core) {
+    return exec_BST(core, R1, Kbit);
+}
+
+avr_op_CALL::avr_op_CALL(word opcode):
+    DecodedInstruction(true),
     KH(get_k_22(opcode)) {}
 
-int avr_op_CALL::operator()() 
+int avr_op_CALL::operator()(AvrDevice *core) 
 {
     word K_lsb = core->Flash->ReadMemWord((core->PC + 1) * 2);
     int k = (KH << 16) + K_lsb;
@@ -353,16 +393,18 @@ int avr_op_CALL::operator()()
     core->stack->PushAddr(core->PC + 2);
     core->DebugOnJump();
     core->PC = k - 1;
+    if(core->profiler != NULL)
+        core->profiler->Call(k);
 
     return core->PC_size + clkadd;
 }
 
-avr_op_CBI::avr_op_CBI(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_CBI::avr_op_CBI(word opcode):
+    DecodedInstruction(),
     ioreg(get_A_5(opcode)),
     Kbit(get_reg_bit(opcode)) {}
 
-int avr_op_CBI::operator()() {
+int avr_op_CBI::operator()(AvrDevice *core) {
     int clks = (core->flagXMega || core->flagTiny10) ? 1 : 2;
     
     core->SetIORegBit(ioreg, Kbit, false);
@@ -370,12 +412,12 @@ int avr_op_CBI::operator()() {
     return clks;
 }
 
-avr_op_COM::avr_op_COM(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    R1(get_rd_5(opcode)),
-    status(c->status) {}
+avr_op_COM::avr_op_COM(word opcode):
+    DecodedInstruction(),
+    R1(get_rd_5(opcode)) {}
 
-int avr_op_COM::operator()() {
+static inline int exec_COM(AvrDevice *core, unsigned char R1) {
+    HWSreg *status = core->status;
     byte rd  = core->GetCoreReg(R1);
     byte res = 0xff - rd;
 
@@ -390,13 +432,17 @@ int avr_op_COM::operator()() {
     return 1;
 }
 
-avr_op_CP::avr_op_CP(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_COM::operator()(AvrDevice *core) {
+    return exec_COM(core, R1);
+}
+
+avr_op_CP::avr_op_CP(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    R2(get_rr_5(opcode)),
-    status(c->status) {}
+    R2(get_rr_5(opcode)) {}
 
-int avr_op_CP::operator()() {
+static inline int exec_CP(AvrDevice *core, unsigned char R1, unsigned char R2) {
+    HWSreg *status = core->status;
     byte rd  = core->GetCoreReg(R1);
     byte rr  = core->GetCoreReg(R2);
     byte res = rd - rr;
@@ -411,13 +457,17 @@ int avr_op_CP::operator()() {
     return 1;
 }
 
-avr_op_CPC::avr_op_CPC(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_CP::operator()(AvrDevice *core) {
+    return exec_CP(core, R1, R2);
+}
+
+avr_op_CPC::avr_op_CPC(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    R2(get_rr_5(opcode)),
-    status(c->status) {}
+    R2(get_rr_5(opcode)) {}
 
-int avr_op_CPC::operator()() {
+static inline int exec_CPC(AvrDevice *core, unsigned char R1, unsigned char R2) {
+    HWSreg *status = core->status;
     byte rd  = core->GetCoreReg(R1);
     byte rr  = core->GetCoreReg(R2);
     byte res = rd - rr - status->C;
@@ -436,14 +486,18 @@ int avr_op_CPC::operator()() {
     return 1;
 }
 
+int avr_op_CPC::operator()(AvrDevice *core) {
+    return exec_CPC(core, R1, R2);
+}
+
 
-avr_op_CPI::avr_op_CPI(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_CPI::avr_op_CPI(word opcode):
+    DecodedInstruction(),
     R1(get_rd_4(opcode)),
-    K(get_K_8(opcode)), 
-    status(c->status) {}
+    K(get_K_8(opcode)) {}
 
-int avr_op_CPI::operator()() {
+static inline int exec_CPI(AvrDevice *core, unsigned char R1, unsigned char K) {
+    HWSreg *status = core->status;
     byte rd  = core->GetCoreReg(R1);
     byte res = rd - K;
 
@@ -457,19 +511,22 @@ int avr_op_CPI::operator()() {
     return 1;
 }
 
-avr_op_CPSE::avr_op_CPSE(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_CPI::operator()(AvrDevice *core) {
+    return exec_CPI(core, R1, K);
+}
+
+avr_op_CPSE::avr_op_CPSE(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    R2(get_rr_5(opcode)),
-    status(c->status) {}
+    R2(get_rr_5(opcode)) {}
 
-int avr_op_CPSE::operator()() {
+static inline int exec_CPSE(AvrDevice *core, unsigned char R1, unsigned char R2) {
     int skip;
     byte rd = core->GetCoreReg(R1);
     byte rr = core->GetCoreReg(R2);
     int clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->IsInstruction2Words(core->PC + 1))
         skip = 3;
     else
         skip = 2;
@@ -484,12 +541,16 @@ int avr_op_CPSE::operator()() {
     return clks;
 }
 
-avr_op_DEC::avr_op_DEC(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    R1(get_rd_5(opcode)),
-    status(c->status) {}
+int avr_op_CPSE::operator()(AvrDevice *core) {
+    return exec_CPSE(core, R1, R2);
+}
+
+avr_op_DEC::avr_op_DEC(word opcode):
+    DecodedInstruction(),
+    R1(get_rd_5(opcode)) {}
 
-int avr_op_DEC::operator()() {
+static inline int exec_DEC(AvrDevice *core, unsigned char R1) {
+    HWSreg *status = core->status;
     byte res = core->GetCoreReg(R1) - 1;
 
     status->N = (res >> 7) & 0x1;
@@ -502,10 +563,14 @@ int avr_op_DEC::operator()() {
     return 1;
 }
 
-avr_op_EICALL::avr_op_EICALL(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+int avr_op_DEC::operator()(AvrDevice *core) {
+    return exec_DEC(core, R1);
+}
+
+avr_op_EICALL::avr_op_EICALL(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_EICALL::operator()() {
+int avr_op_EICALL::operator()(AvrDevice *core) {
     unsigned new_PC = core->GetRegZ() + (core->eind->GetRegVal() << 16);
 
     core->stack->m_ThreadList.OnCall();
@@ -513,25 +578,27 @@ int avr_op_EICALL::operator()() {
 
     core->DebugOnJump();
     core->PC = new_PC;
+    if(core->profiler != NULL)
+        core->profiler->Call(new_PC);
 
     return core->flagXMega ? 3 : 4;
 }
 
-avr_op_EIJMP::avr_op_EIJMP(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+avr_op_EIJMP::avr_op_EIJMP(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_EIJMP::operator()() {
+int avr_op_EIJMP::operator()(AvrDevice *core) {
     core->DebugOnJump();
     core->PC = (core->eind->GetRegVal() << 16) + core->GetRegZ();
 
     return 2;
 }
 
-avr_op_ELPM_Z::avr_op_ELPM_Z(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_ELPM_Z::avr_op_ELPM_Z(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_ELPM_Z::operator()() {
+int avr_op_ELPM_Z::operator()(AvrDevice *core) {
     unsigned int Z;
     unsigned char rampz = 0;
 
@@ -544,11 +611,11 @@ int avr_op_ELPM_Z::operator()() {
     return 3;
 }
 
-avr_op_ELPM_Z_incr::avr_op_ELPM_Z_incr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_ELPM_Z_incr::avr_op_ELPM_Z_incr(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_ELPM_Z_incr::operator()() {
+int avr_op_ELPM_Z_incr::operator()(AvrDevice *core) {
     unsigned int Z;
     unsigned char rampz = 0;
 
@@ -568,10 +635,10 @@ int avr_op_ELPM_Z_incr::operator()() {
     return 3;
 }
 
-avr_op_ELPM::avr_op_ELPM(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+avr_op_ELPM::avr_op_ELPM(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_ELPM::operator()() {
+int avr_op_ELPM::operator()(AvrDevice *core) {
     unsigned char rampz = 0;
 
     if(core->rampz != NULL)
@@ -583,13 +650,13 @@ int avr_op_ELPM::operator()() {
     return 3;
 }
 
-avr_op_EOR::avr_op_EOR(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_EOR::avr_op_EOR(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    R2(get_rr_5(opcode)),
-    status(c->status) {}
+    R2(get_rr_5(opcode)) {}
 
-int avr_op_EOR::operator()() {
+static inline int exec_EOR(AvrDevice *core, unsigned char R1, unsigned char R2) {
+    HWSreg *status = core->status;
     byte rd = core->GetCoreReg(R1); 
     byte rr = core->GetCoreReg(R2);
     byte res = rd ^ rr;
@@ -604,10 +671,14 @@ int avr_op_EOR::operator()() {
     return 1;
 }
 
-avr_op_ESPM::avr_op_ESPM(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+int avr_op_EOR::operator()(AvrDevice *core) {
+    return exec_EOR(core, R1, R2);
+}
+
+avr_op_ESPM::avr_op_ESPM(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_ESPM::operator()() {
+int avr_op_ESPM::operator()(AvrDevice *core) {
     unsigned char xaddr = 0;
     int cycles = 1;
     if(core->rampz != NULL)
@@ -626,13 +697,13 @@ int avr_op_ESPM::operator()() {
     return cycles;
 }
 
-avr_op_FMUL::avr_op_FMUL(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_FMUL::avr_op_FMUL(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_3(opcode)),
-    Rr(get_rr_3(opcode)),
-    status(c->status) {}
+    Rr(get_rr_3(opcode)) {}
 
-int avr_op_FMUL::operator()() {
+int avr_op_FMUL::operator()(AvrDevice *core) {
+    HWSreg *status = core->status;
     byte rd = core->GetCoreReg(Rd);
     byte rr = core->GetCoreReg(Rr);
 
@@ -650,13 +721,13 @@ int avr_op_FMUL::operator()() {
 }
 
 
-avr_op_FMULS::avr_op_FMULS(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_FMULS::avr_op_FMULS(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_3(opcode)),
-    Rr(get_rr_3(opcode)),
-    status(c->status) {}
+    Rr(get_rr_3(opcode)) {}
 
-int avr_op_FMULS::operator()() {
+int avr_op_FMULS::operator()(AvrDevice *core) {
+    HWSreg *status = core->status;
     sbyte rd = core->GetCoreReg(Rd); 
     sbyte rr = core->GetCoreReg(Rr);
 
@@ -674,13 +745,13 @@ int avr_op_FMULS::operator()() {
 }
 
 
-avr_op_FMULSU::avr_op_FMULSU(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_FMULSU::avr_op_FMULSU(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_3(opcode)),
-    Rr(get_rr_3(opcode)),
-    status(c->status) {}
+    Rr(get_rr_3(opcode)) {}
 
-int avr_op_FMULSU::operator()() {
+int avr_op_FMULSU::operator()(AvrDevice *core) {
+    HWSreg *status = core->status;
     sbyte rd = core->GetCoreReg(Rd);
     byte rr = core->GetCoreReg(Rr);
 
@@ -696,10 +767,10 @@ int avr_op_FMULSU::operator()() {
     return 2;
 }
 
-avr_op_ICALL::avr_op_ICALL(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+avr_op_ICALL::avr_op_ICALL(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_ICALL::operator()() {
+int avr_op_ICALL::operator()(AvrDevice *core) {
     unsigned int pc = core->PC;
     /* Z is R31:R30 */
     unsigned int new_pc = core->GetRegZ();
@@ -709,14 +780,16 @@ int avr_op_ICALL::operator()() {
 
     core->DebugOnJump();
     core->PC = new_pc - 1;
+    if(core->profiler != NULL)
+        core->profiler->Call(new_pc);
 
     return core->PC_size + (core->flagXMega ? 0 : 1);
 }
 
-avr_op_IJMP::avr_op_IJMP(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+avr_op_IJMP::avr_op_IJMP(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_IJMP::operator()() {
+int avr_op_IJMP::operator()(AvrDevice *core) {
     int new_pc = core->GetRegZ();
     
     core->DebugOnJump();
@@ -725,23 +798,23 @@ int avr_op_IJMP::operator()() {
     return 2;
 }
 
-avr_op_IN::avr_op_IN(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_IN::avr_op_IN(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
     ioreg(get_A_6(opcode)) {}
 
-int avr_op_IN::operator()() {
+int avr_op_IN::operator()(AvrDevice *core) {
     core->SetCoreReg(R1, core->GetIOReg(ioreg));
 
     return 1;
 }
 
-avr_op_INC::avr_op_INC(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    R1(get_rd_5(opcode)),
-    status(c->status) {}
+avr_op_INC::avr_op_INC(word opcode):
+    DecodedInstruction(),
+    R1(get_rd_5(opcode)) {}
 
-int avr_op_INC::operator()() {
+static inline int exec_INC(AvrDevice *core, unsigned char R1) {
+    HWSreg *status = core->status;
     byte rd  = core->GetCoreReg(R1);
     byte res = rd + 1;
 
@@ -755,23 +828,27 @@ int avr_op_INC::operator()() {
     return 1;
 }
 
-avr_op_JMP::avr_op_JMP(word opcode, AvrDevice *c):
-    DecodedInstruction(c, true),
+int avr_op_INC::operator()(AvrDevice *core) {
+    return exec_INC(core, R1);
+}
+
+avr_op_JMP::avr_op_JMP(word opcode):
+    DecodedInstruction(true),
     K(get_k_22(opcode)) {}
 
-int avr_op_JMP::operator()() {
+int avr_op_JMP::operator()(AvrDevice *core) {
     word K_lsb = core->Flash->ReadMemWord((core->PC + 1) * 2);
     core->DebugOnJump();
     core->PC = (K << 16) + K_lsb - 1;
     return 3;
 }
 
-avr_op_LDD_Y::avr_op_LDD_Y(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_LDD_Y::avr_op_LDD_Y(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)),
     K(get_q(opcode)) {}
 
-int avr_op_LDD_Y::operator()() {
+static inline int exec_LDD_Y(AvrDevice *core, unsigned char Rd, unsigned char K) {
     /* Y is R29:R28 */
     word Y = core->GetRegY();
 
@@ -780,12 +857,16 @@ int avr_op_LDD_Y::operator()() {
     return ((core->flagXMega || core->flagTiny10) && K == 0) ? 1 : 2;
 }
 
-avr_op_LDD_Z::avr_op_LDD_Z(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LDD_Y::operator()(AvrDevice *core) {
+    return exec_LDD_Y(core, Rd, K);
+}
+
+avr_op_LDD_Z::avr_op_LDD_Z(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)),
     K(get_q(opcode)) {}
 
-int avr_op_LDD_Z::operator()() {
+static inline int exec_LDD_Z(AvrDevice *core, unsigned char Rd, unsigned char K) {
     /* Z is R31:R30 */
     word Z = core->GetRegZ();
 
@@ -794,25 +875,33 @@ int avr_op_LDD_Z::operator()() {
     return ((core->flagXMega || core->flagTiny10) && K == 0) ? 1 : 2;
 }
 
-avr_op_LDI::avr_op_LDI(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LDD_Z::operator()(AvrDevice *core) {
+    return exec_LDD_Z(core, Rd, K);
+}
+
+avr_op_LDI::avr_op_LDI(word opcode):
+    DecodedInstruction(),
     R1(get_rd_4(opcode)),
     K(get_K_8(opcode)) {}
 
 unsigned char avr_op_LDI::GetModifiedR() const {
     return R1;
 }
-int avr_op_LDI::operator()() { 
+static inline int exec_LDI(AvrDevice *core, unsigned char R1, unsigned char K) {
     core->SetCoreReg(R1, K);
 
     return 1;
 }
 
-avr_op_LDS::avr_op_LDS(word opcode, AvrDevice *c):
-    DecodedInstruction(c, true),
+int avr_op_LDI::operator()(AvrDevice *core) {
+    return exec_LDI(core, R1, K);
+}
+
+avr_op_LDS::avr_op_LDS(word opcode):
+    DecodedInstruction(true),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_LDS::operator()() {
+int avr_op_LDS::operator()(AvrDevice *core) {
     /* Get data at k in current data segment and put into Rd */
     word offset = core->Flash->ReadMemWord((core->PC + 1) * 2);
     
@@ -822,11 +911,15 @@ int avr_op_LDS::operator()() {
     return 2;
 }
 
-avr_op_LD_X::avr_op_LD_X(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LDS::GetDataReadAddress(AvrDevice *core, unsigned int pc) const {
+    return core->Flash->ReadMemWord((pc + 1) * 2);
+}
+
+avr_op_LD_X::avr_op_LD_X(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)) {}
 
-int avr_op_LD_X::operator()() {
+static inline int exec_LD_X(AvrDevice *core, unsigned char Rd) {
     /* X is R27:R26 */
     word X = core->GetRegX();
 
@@ -835,11 +928,15 @@ int avr_op_LD_X::operator()() {
     return (core->flagXMega || core->flagTiny10) ? 1 : 2;
 }
 
-avr_op_LD_X_decr::avr_op_LD_X_decr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LD_X::operator()(AvrDevice *core) {
+    return exec_LD_X(core, Rd);
+}
+
+avr_op_LD_X_decr::avr_op_LD_X_decr(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)) {}
 
-int avr_op_LD_X_decr::operator()() {
+static inline int exec_LD_X_decr(AvrDevice *core, unsigned char Rd) {
     /* X is R27:R26 */
     word X = core->GetRegX();
     if (Rd == 26 || Rd == 27)
@@ -854,11 +951,15 @@ int avr_op_LD_X_decr::operator()() {
     return core->flagTiny10 ? 3 : 2;
 }
 
-avr_op_LD_X_incr::avr_op_LD_X_incr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LD_X_decr::operator()(AvrDevice *core) {
+    return exec_LD_X_decr(core, Rd);
+}
+
+avr_op_LD_X_incr::avr_op_LD_X_incr(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)) {}
 
-int avr_op_LD_X_incr::operator()() {
+static inline int exec_LD_X_incr(AvrDevice *core, unsigned char Rd) {
     /* X is R27:R26 */
     word X = core->GetRegX();
     if (Rd == 26 || Rd == 27)
@@ -873,11 +974,15 @@ int avr_op_LD_X_incr::operator()() {
     return core->flagXMega ? 1 : 2;
 }
 
-avr_op_LD_Y_decr::avr_op_LD_Y_decr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LD_X_incr::operator()(AvrDevice *core) {
+    return exec_LD_X_incr(core, Rd);
+}
+
+avr_op_LD_Y_decr::avr_op_LD_Y_decr(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)) {}
 
-int avr_op_LD_Y_decr::operator()() {
+static inline int exec_LD_Y_decr(AvrDevice *core, unsigned char Rd) {
     /* Y is R29:R28 */
     word Y = core->GetRegY();
     if (Rd == 28 || Rd == 29)
@@ -892,11 +997,15 @@ int avr_op_LD_Y_decr::operator()() {
     return core->flagTiny10 ? 3 : 2;
 }
 
-avr_op_LD_Y_incr::avr_op_LD_Y_incr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LD_Y_decr::operator()(AvrDevice *core) {
+    return exec_LD_Y_decr(core, Rd);
+}
+
+avr_op_LD_Y_incr::avr_op_LD_Y_incr(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)) {}
 
-int avr_op_LD_Y_incr::operator()() {
+static inline int exec_LD_Y_incr(AvrDevice *core, unsigned char Rd) {
     /* Y is R29:R28 */
     word Y = core->GetRegY();
     if (Rd == 28 || Rd == 29)
@@ -911,11 +1020,15 @@ int avr_op_LD_Y_incr::operator()() {
     return core->flagXMega ? 1 : 2;
 }
 
-avr_op_LD_Z_incr::avr_op_LD_Z_incr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LD_Y_incr::operator()(AvrDevice *core) {
+    return exec_LD_Y_incr(core, Rd);
+}
+
+avr_op_LD_Z_incr::avr_op_LD_Z_incr(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)) {}
 
-int avr_op_LD_Z_incr::operator()() {
+static inline int exec_LD_Z_incr(AvrDevice *core, unsigned char Rd) {
     /* Z is R31:R30 */
     word Z = core->GetRegZ();
     if (Rd == 30 || Rd == 31)
@@ -930,11 +1043,15 @@ int avr_op_LD_Z_incr::operator()() {
     return core->flagXMega ? 1 : 2;
 }
 
-avr_op_LD_Z_decr::avr_op_LD_Z_decr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LD_Z_incr::operator()(AvrDevice *core) {
+    return exec_LD_Z_incr(core, Rd);
+}
+
+avr_op_LD_Z_decr::avr_op_LD_Z_decr(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)) {}
 
-int avr_op_LD_Z_decr::operator()() {
+static inline int exec_LD_Z_decr(AvrDevice *core, unsigned char Rd) {
     /* Z is R31:R30 */
     word Z = core->GetRegZ();
     if (Rd == 30 || Rd == 31)
@@ -949,11 +1066,15 @@ int avr_op_LD_Z_decr::operator()() {
     return core->flagTiny10 ? 3 : 2;
 }
 
-avr_op_LPM_Z::avr_op_LPM_Z(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LD_Z_decr::operator()(AvrDevice *core) {
+    return exec_LD_Z_decr(core, Rd);
+}
+
+avr_op_LPM_Z::avr_op_LPM_Z(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)) {}
 
-int  avr_op_LPM_Z::operator()() {
+int  avr_op_LPM_Z::operator()(AvrDevice *core) {
     /* Z is R31:R30 */
     word Z = core->GetRegZ();
 
@@ -963,10 +1084,10 @@ int  avr_op_LPM_Z::operator()() {
     return 3;
 }
 
-avr_op_LPM::avr_op_LPM(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+avr_op_LPM::avr_op_LPM(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_LPM::operator()() {
+int avr_op_LPM::operator()(AvrDevice *core) {
     /* Z is R31:R30 */
     word Z = core->GetRegZ();
     
@@ -976,11 +1097,11 @@ int avr_op_LPM::operator()() {
     return 3;
 }
 
-avr_op_LPM_Z_incr::avr_op_LPM_Z_incr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_LPM_Z_incr::avr_op_LPM_Z_incr(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)) {}
 
-int avr_op_LPM_Z_incr::operator()() {
+int avr_op_LPM_Z_incr::operator()(AvrDevice *core) {
     /* Z is R31:R30 */
     word Z = core->GetRegZ();
 
@@ -993,12 +1114,12 @@ int avr_op_LPM_Z_incr::operator()() {
     return 3;
 }
 
-avr_op_LSR::avr_op_LSR(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    Rd(get_rd_5(opcode)),
-    status(c->status) {}
+avr_op_LSR::avr_op_LSR(word opcode):
+    DecodedInstruction(),
+    Rd(get_rd_5(opcode)) {}
 
-int avr_op_LSR::operator()() {
+static inline int exec_LSR(AvrDevice *core, unsigned char Rd) {
+    HWSreg *status = core->status;
     byte rd = core->GetCoreReg(Rd); 
 
     byte res = (rd >> 1) & 0x7f;
@@ -1014,35 +1135,47 @@ int avr_op_LSR::operator()() {
     return 1;
 }
 
-avr_op_MOV::avr_op_MOV(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_LSR::operator()(AvrDevice *core) {
+    return exec_LSR(core, Rd);
+}
+
+avr_op_MOV::avr_op_MOV(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
     R2(get_rr_5(opcode)) {}
 
-int avr_op_MOV::operator()() {
+static inline int exec_MOV(AvrDevice *core, unsigned char R1, unsigned char R2) {
     core->SetCoreReg(R1, core->GetCoreReg(R2));
     return 1;
 }
 
-avr_op_MOVW::avr_op_MOVW(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_MOV::operator()(AvrDevice *core) {
+    return exec_MOV(core, R1, R2);
+}
+
+avr_op_MOVW::avr_op_MOVW(word opcode):
+    DecodedInstruction(),
     Rd((get_rd_4(opcode) - 16) << 1),
     Rs((get_rr_4(opcode) - 16) << 1) {}
 
-int avr_op_MOVW::operator()() {
+static inline int exec_MOVW(AvrDevice *core, unsigned char Rd, unsigned char Rs) {
     core->SetCoreReg(Rd, core->GetCoreReg(Rs));
     core->SetCoreReg(Rd + 1, core->GetCoreReg(Rs + 1));
 
     return 1;
 }
 
-avr_op_MUL::avr_op_MUL(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_MOVW::operator()(AvrDevice *core) {
+    return exec_MOVW(core, Rd, Rs);
+}
+
+avr_op_MUL::avr_op_MUL(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)),
-    Rr(get_rr_5(opcode)),
-    status(c->status) {}
+    Rr(get_rr_5(opcode)) {}
 
-int avr_op_MUL::operator()() {
+static inline int exec_MUL(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
     byte rd = core->GetCoreReg(Rd);
     byte rr = core->GetCoreReg(Rr);
 
@@ -1058,13 +1191,17 @@ int avr_op_MUL::operator()() {
     return 2;
 }
 
-avr_op_MULS::avr_op_MULS(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_MUL::operator()(AvrDevice *core) {
+    return exec_MUL(core, Rd, Rr);
+}
+
+avr_op_MULS::avr_op_MULS(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_4(opcode)),
-    Rr(get_rr_4(opcode)),
-    status(c->status) {}
+    Rr(get_rr_4(opcode)) {}
 
-int avr_op_MULS::operator()() {
+int avr_op_MULS::operator()(AvrDevice *core) {
+    HWSreg *status = core->status;
     sbyte rd = (sbyte)core->GetCoreReg(Rd);
     sbyte rr = (sbyte)core->GetCoreReg(Rr);
 
@@ -1080,13 +1217,13 @@ int avr_op_MULS::operator()() {
     return 2;
 }
 
-avr_op_MULSU::avr_op_MULSU(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_MULSU::avr_op_MULSU(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_3(opcode)),
-    Rr(get_rr_3(opcode)),
-    status(c->status) {}
+    Rr(get_rr_3(opcode)) {}
 
-int avr_op_MULSU::operator()() {
+int avr_op_MULSU::operator()(AvrDevice *core) {
+    HWSreg *status = core->status;
     sbyte rd = (sbyte)core->GetCoreReg(Rd);
     byte rr = core->GetCoreReg(Rr);
 
@@ -1103,12 +1240,12 @@ int avr_op_MULSU::operator()() {
     return 2;
 }
 
-avr_op_NEG::avr_op_NEG(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    Rd(get_rd_5(opcode)),
-    status(c->status) {}
+avr_op_NEG::avr_op_NEG(word opcode):
+    DecodedInstruction(),
+    Rd(get_rd_5(opcode)) {}
 
-int avr_op_NEG::operator()() {
+static inline int exec_NEG(AvrDevice *core, unsigned char Rd) {
+    HWSreg *status = core->status;
     byte rd  = core->GetCoreReg(Rd);
     byte res = (0x0 - rd) & 0xff;
 
@@ -1124,20 +1261,28 @@ int avr_op_NEG::operator()() {
     return 1;
 }
 
-avr_op_NOP::avr_op_NOP(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+int avr_op_NEG::operator()(AvrDevice *core) {
+    return exec_NEG(core, Rd);
+}
+
+avr_op_NOP::avr_op_NOP(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_NOP::operator()() {
+static inline int exec_NOP(AvrDevice *core) {
     return 1;
 }
 
-avr_op_OR::avr_op_OR(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_NOP::operator()(AvrDevice *core) {
+    return exec_NOP(core);
+}
+
+avr_op_OR::avr_op_OR(word opcode):
+    DecodedInstruction(),
     Rd(get_rd_5(opcode)),
-    Rr(get_rr_5(opcode)),
-    status(c->status) {}
+    Rr(get_rr_5(opcode)) {}
 
-int avr_op_OR::operator()() {
+static inline int exec_OR(AvrDevice *core, unsigned char Rd, unsigned char Rr) {
+    HWSreg *status = core->status;
     byte res = core->GetCoreReg(Rd) | core->GetCoreReg(Rr);
 
     status->V = 0;
@@ -1150,13 +1295,17 @@ int avr_op_OR::operator()() {
     return 1;
 }
 
-avr_op_ORI::avr_op_ORI(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_OR::operator()(AvrDevice *core) {
+    return exec_OR(core, Rd, Rr);
+}
+
+avr_op_ORI::avr_op_ORI(word opcode):
+    DecodedInstruction(),
     R1(get_rd_4(opcode)),
-    K(get_K_8(opcode)),
-    status(c->status) {}
+    K(get_K_8(opcode)) {}
 
-int avr_op_ORI::operator()() {
+static inline int exec_ORI(AvrDevice *core, unsigned char R1, unsigned char K) {
+    HWSreg *status = core->status;
     byte res = core->GetCoreReg(R1) | K;
 
     status->V = 0;
@@ -1169,47 +1318,53 @@ int avr_op_ORI::operator()() {
     return 1;
 }
 
-avr_op_OUT::avr_op_OUT(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_ORI::operator()(AvrDevice *core) {
+    return exec_ORI(core, R1, K);
+}
+
+avr_op_OUT::avr_op_OUT(word opcode):
+    DecodedInstruction(),
     ioreg(get_A_6(opcode)),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_OUT::operator()() {
+int avr_op_OUT::operator()(AvrDevice *core) {
     core->SetIOReg(ioreg, core->GetCoreReg(R1));
 
     return 1;
 }
 
-avr_op_POP::avr_op_POP(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_POP::avr_op_POP(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_POP::operator()() {
+int avr_op_POP::operator()(AvrDevice *core) {
     core->SetCoreReg(R1, core->stack->Pop());
 
     return 2;
 }
 
-avr_op_PUSH::avr_op_PUSH(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_PUSH::avr_op_PUSH(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_PUSH::operator()() {
+int avr_op_PUSH::operator()(AvrDevice *core) {
     core->stack->Push(core->GetCoreReg(R1));
 
     return core->flagXMega ? 1 : 2;
 }
 
-avr_op_RCALL::avr_op_RCALL(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_RCALL::avr_op_RCALL(word opcode):
+    DecodedInstruction(),
     K(n_bit_unsigned_to_signed(get_k_12(opcode), 12)) {}
 
-int avr_op_RCALL::operator()() {
+int avr_op_RCALL::operator()(AvrDevice *core) {
     core->stack->PushAddr(core->PC + 1);
     core->stack->m_ThreadList.OnCall();
     core->DebugOnJump();
     core->PC += K;
     core->PC &= (core->Flash->GetSize() - 1) >> 1;
+    if(core->profiler != NULL)
+        core->profiler->Call(core->PC + 1);
 
     if(core->flagTiny10)
         return 4;
@@ -1217,31 +1372,35 @@ int avr_op_RCALL::operator()() {
     
 }
 
-avr_op_RET::avr_op_RET(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+avr_op_RET::avr_op_RET(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_RET::operator()() {
+int avr_op_RET::operator()(AvrDevice *core) {
     core->PC = core->stack->PopAddr() - 1;
+    if(core->profiler != NULL)
+        core->profiler->Return();
 
     return core->PC_size + 2;
 }
 
-avr_op_RETI::avr_op_RETI(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    status(c->status) {}
+avr_op_RETI::avr_op_RETI(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_RETI::operator()() {
+int avr_op_RETI::operator()(AvrDevice *core) {
+    HWSreg *status = core->status;
     core->PC = core->stack->PopAddr() - 1;
+    if(core->profiler != NULL)
+        core->profiler->Return();
     status->I = 1;
 
     return core->PC_size + 2;
 }
 
-avr_op_RJMP::avr_op_RJMP(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_RJMP::avr_op_RJMP(word opcode):
+    DecodedInstruction(),
     K(n_bit_unsigned_to_signed(get_k_12(opcode), 12)) {}
 
-int avr_op_RJMP::operator()() {
+static inline int exec_RJMP(AvrDevice *core, signed int K) {
     core->DebugOnJump();
     core->PC += K;
     core->PC &= (core->Flash->GetSize() - 1) >> 1;
@@ -1249,12 +1408,16 @@ int avr_op_RJMP::operator()() {
     return 2;
 }
 
-avr_op_ROR::avr_op_ROR(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
-    R1(get_rd_5(opcode)),
-    status(c->status) {}
+int avr_op_RJMP::operator()(AvrDevice *core) {
+    return exec_RJMP(core, K);
+}
+
+avr_op_ROR::avr_op_ROR(word opcode):
+    DecodedInstruction(),
+    R1(get_rd_5(opcode)) {}
 
-int avr_op_ROR::operator()() {
+static inline int exec_ROR(AvrDevice *core, unsigned char R1) {
+    HWSreg *status = core->status;
     byte rd = core->GetCoreReg(R1);
 
     byte res = (rd >> 1) | ((status->C << 7) & 0x80);
@@ -1270,17 +1433,21 @@ int avr_op_ROR::operator()() {
     return 1;
 }
 
+int avr_op_ROR::operator()(AvrDevice *core) {
+    return exec_ROR(core, R1);
+}
+
 
-avr_op_SBC::avr_op_SBC(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_SBC::avr_op_SBC(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    R2(get_rr_5(opcode)),
-    status(c->status) {}
+    R2(get_rr_5(opcode)) {}
 
 unsigned char avr_op_SBC::GetModifiedR() const {
     return R1;
 }
-int avr_op_SBC::operator()() {
+static inline int exec_SBC(AvrDevice *core, unsigned char R1, unsigned char R2) {
+    HWSreg *status = core->status;
     byte rd = core->GetCoreReg(R1);
     byte rr = core->GetCoreReg(R2);
 
@@ -1300,16 +1467,20 @@ int avr_op_SBC::operator()() {
     return 1;
 }
 
-avr_op_SBCI::avr_op_SBCI(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_SBC::operator()(AvrDevice *core) {
+    return exec_SBC(core, R1, R2);
+}
+
+avr_op_SBCI::avr_op_SBCI(word opcode):
+    DecodedInstruction(),
     R1(get_rd_4(opcode)),
-    K(get_K_8(opcode)),
-    status(c->status) {}
+    K(get_K_8(opcode)) {}
 
 unsigned char avr_op_SBCI::GetModifiedR() const {
     return R1;
 }
-int avr_op_SBCI::operator()() {
+static inline int exec_SBCI(AvrDevice *core, unsigned char R1, unsigned char K) {
+    HWSreg *status = core->status;
     byte rd = core->GetCoreReg(R1);
 
     byte res = rd - K - status->C;
@@ -1328,12 +1499,16 @@ int avr_op_SBCI::operator()() {
     return 1;
 }
 
-avr_op_SBI::avr_op_SBI(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_SBCI::operator()(AvrDevice *core) {
+    return exec_SBCI(core, R1, K);
+}
+
+avr_op_SBI::avr_op_SBI(word opcode):
+    DecodedInstruction(),
     ioreg(get_A_5(opcode)),
     Kbit(get_reg_bit(opcode)) {}
 
-int avr_op_SBI::operator()() {
+int avr_op_SBI::operator()(AvrDevice *core) {
     int clks = (core->flagXMega || core->flagTiny10) ? 1 : 2;
     
     core->SetIORegBit(ioreg, Kbit, true);
@@ -1341,15 +1516,15 @@ int avr_op_SBI::operator()() {
     return clks;
 }
 
-avr_op_SBIC::avr_op_SBIC(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_SBIC::avr_op_SBIC(word opcode):
+    DecodedInstruction(),
     ioreg(get_A_5(opcode)),
     Kbit(get_reg_bit(opcode)) {}
 
-int avr_op_SBIC::operator()() {
+int avr_op_SBIC::operator()(AvrDevice *core) {
     int skip, clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->IsInstruction2Words(core->PC + 1))
         skip = 3;
     else
         skip = 2;
@@ -1367,15 +1542,15 @@ int avr_op_SBIC::operator()() {
     return clks;
 }
 
-avr_op_SBIS::avr_op_SBIS(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_SBIS::avr_op_SBIS(word opcode):
+    DecodedInstruction(),
     ioreg(get_A_5(opcode)),
     Kbit(get_reg_bit(opcode)) {}
 
-int avr_op_SBIS::operator()() {
+int avr_op_SBIS::operator()(AvrDevice *core) {
     int skip, clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->IsInstruction2Words(core->PC + 1))
         skip = 3;
     else
         skip = 2;
@@ -1394,11 +1569,10 @@ int avr_op_SBIS::operator()() {
 }
 
 
-avr_op_SBIW::avr_op_SBIW(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_SBIW::avr_op_SBIW(word opcode):
+    DecodedInstruction(),
     R1(get_rd_2(opcode)),
-    K(get_K_6(opcode)),
-    status(c->status) {}
+    K(get_K_6(opcode)) {}
 
 unsigned char avr_op_SBIW::GetModifiedR() const {
     return R1;
@@ -1406,7 +1580,8 @@ unsigned char avr_op_SBIW::GetModifiedR() const {
 unsigned char avr_op_SBIW::GetModifiedRHi() const {
     return R1 + 1;
 }
-int avr_op_SBIW::operator()() {
+static inline int exec_SBIW(AvrDevice *core, unsigned char R1, unsigned char K) {
+    HWSreg *status = core->status;
     byte rdl = core->GetCoreReg(R1);
     byte rdh = core->GetCoreReg(R1 + 1);
 
@@ -1425,15 +1600,19 @@ int avr_op_SBIW::operator()() {
     return 2;
 }
 
-avr_op_SBRC::avr_op_SBRC(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_SBIW::operator()(AvrDevice *core) {
+    return exec_SBIW(core, R1, K);
+}
+
+avr_op_SBRC::avr_op_SBRC(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
     Kbit(get_reg_bit(opcode)) {}
 
-int avr_op_SBRC::operator()() {
+static inline int exec_SBRC(AvrDevice *core, unsigned char R1, unsigned char Kbit) {
     int skip, clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->IsInstruction2Words(core->PC + 1))
         skip = 3;
     else
         skip = 2;
@@ -1448,15 +1627,19 @@ int avr_op_SBRC::operator()() {
     return clks;
 }
 
-avr_op_SBRS::avr_op_SBRS(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_SBRC::operator()(AvrDevice *core) {
+    return exec_SBRC(core, R1, Kbit);
+}
+
+avr_op_SBRS::avr_op_SBRS(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
     Kbit(get_reg_bit(opcode)) {}
 
-int avr_op_SBRS::operator()() {
+static inline int exec_SBRS(AvrDevice *core, unsigned char R1, unsigned char Kbit) {
     int skip, clks;
 
-    if(core->Flash->DecodedMem[core->PC + 1]->IsInstruction2Words())
+    if(core->Flash->IsInstruction2Words(core->PC + 1))
         skip = 3;
     else
         skip = 2;
@@ -1471,38 +1654,27 @@ int avr_op_SBRS::operator()() {
     return clks;
 }
 
-avr_op_SLEEP::avr_op_SLEEP(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
-
-int avr_op_SLEEP::operator()() {
-#if 0  //TODO
-    MCUCR *mcucr = (MCUCR *)avr_core_get_vdev_by_name( core, "MCUCR" );
+int avr_op_SBRS::operator()(AvrDevice *core) {
+    return exec_SBRS(core, R1, Kbit);
+}
 
-    if (mcucr == NULL)
-        avr_error( "MCUCR register not installed" );
+avr_op_SLEEP::avr_op_SLEEP(word opcode):
+    DecodedInstruction() {}
 
-    /* See if sleep mode is enabled */
-    if ( mcucr_get_bit(mcucr, bit_SE) )
-    {
-        if ( mcucr_get_bit(mcucr, bit_SM) == 0 )
-        {
-            /* Idle Mode */
-            avr_core_set_sleep_mode( core, SLEEP_MODE_IDLE);
-        }
-        else
-        {
-            /* Power Down Mode */
-            avr_core_set_sleep_mode( core, SLEEP_MODE_PWR_DOWN);
-        }
-    }
-#endif
+int avr_op_SLEEP::operator()(AvrDevice *core) {
+    // SLEEP is a NOP, if sleep enable bit (SE) isn't set. Sleep mode bits
+    // aren't simulated, so all sleep modes are handled as idle mode. Without
+    // I flag, core could never wake up by a interrupt, so SLEEP does nothing
+    // in this case.
+    if(core->status->I && core->IsSleepEnabled())
+        core->EnterSleepMode();
     return 1;
 }
 
-avr_op_SPM::avr_op_SPM(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+avr_op_SPM::avr_op_SPM(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_SPM::operator()() {
+int avr_op_SPM::operator()(AvrDevice *core) {
     unsigned char xaddr = 0;
     int cycles = 1;
     if(core->rampz != NULL)
@@ -1515,12 +1687,12 @@ int avr_op_SPM::operator()() {
     return cycles;
 }
 
-avr_op_STD_Y::avr_op_STD_Y(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_STD_Y::avr_op_STD_Y(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
     K(get_q(opcode)) {}
 
-int avr_op_STD_Y::operator()() {
+static inline int exec_STD_Y(AvrDevice *core, unsigned char R1, unsigned char K) {
     /* Y is R29:R28 */
     unsigned int Y = core->GetRegY();
 
@@ -1529,12 +1701,16 @@ int avr_op_STD_Y::operator()() {
     return (K == 0 && (core->flagXMega || core->flagTiny10)) ? 1 : 2;
 }
 
-avr_op_STD_Z::avr_op_STD_Z(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_STD_Y::operator()(AvrDevice *core) {
+    return exec_STD_Y(core, R1, K);
+}
+
+avr_op_STD_Z::avr_op_STD_Z(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
     K(get_q(opcode)) {}
 
-int avr_op_STD_Z::operator()() {
+static inline int exec_STD_Z(AvrDevice *core, unsigned char R1, unsigned char K) {
     /* Z is R31:R30 */
     int Z = core->GetRegZ();
 
@@ -1543,11 +1719,15 @@ int avr_op_STD_Z::operator()() {
     return (K == 0 && (core->flagXMega || core->flagTiny10)) ? 1 : 2;
 }
 
-avr_op_STS::avr_op_STS(word opcode, AvrDevice *c):
-    DecodedInstruction(c, true),
+int avr_op_STD_Z::operator()(AvrDevice *core) {
+    return exec_STD_Z(core, R1, K);
+}
+
+avr_op_STS::avr_op_STS(word opcode):
+    DecodedInstruction(true),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_STS::operator()() {
+int avr_op_STS::operator()(AvrDevice *core) {
     /* Get data at k in current data segment and put into Rd */
     word k = core->Flash->ReadMemWord((core->PC + 1) * 2);
 
@@ -1557,11 +1737,11 @@ int avr_op_STS::operator()() {
     return 2;
 }
 
-avr_op_ST_X::avr_op_ST_X(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+avr_op_ST_X::avr_op_ST_X(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_ST_X::operator()() {
+static inline int exec_ST_X(AvrDevice *core, unsigned char R1) {
     /* X is R27:R26 */
     word X = core->GetRegX();
     
@@ -1570,11 +1750,15 @@ int avr_op_ST_X::operator()() {
     return (core->flagXMega || core->flagTiny10) ? 1 : 2;
 }
 
-avr_op_ST_X_decr::avr_op_ST_X_decr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_ST_X::operator()(AvrDevice *core) {
+    return exec_ST_X(core, R1);
+}
+
+avr_op_ST_X_decr::avr_op_ST_X_decr(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_ST_X_decr::operator()() {
+static inline int exec_ST_X_decr(AvrDevice *core, unsigned char R1) {
     /* X is R27:R26 */
     word X = core->GetRegX();
     if (R1 == 26 || R1 == 27)
@@ -1589,11 +1773,15 @@ int avr_op_ST_X_decr::operator()() {
     return 2;
 }
 
-avr_op_ST_X_incr::avr_op_ST_X_incr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_ST_X_decr::operator()(AvrDevice *core) {
+    return exec_ST_X_decr(core, R1);
+}
+
+avr_op_ST_X_incr::avr_op_ST_X_incr(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_ST_X_incr::operator()() {
+static inline int exec_ST_X_incr(AvrDevice *core, unsigned char R1) {
     /* X is R27:R26 */
     word X = core->GetRegX();
     if (R1 == 26 || R1 == 27)
@@ -1609,11 +1797,15 @@ int avr_op_ST_X_incr::operator()() {
     return (core->flagXMega || core->flagTiny10) ? 1 : 2;
 }
 
-avr_op_ST_Y_decr::avr_op_ST_Y_decr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_ST_X_incr::operator()(AvrDevice *core) {
+    return exec_ST_X_incr(core, R1);
+}
+
+avr_op_ST_Y_decr::avr_op_ST_Y_decr(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_ST_Y_decr::operator()() {
+static inline int exec_ST_Y_decr(AvrDevice *core, unsigned char R1) {
     /* Y is R29:R28 */
     word Y = core->GetRegY();
     if (R1 == 28 || R1 == 29)
@@ -1628,11 +1820,15 @@ int avr_op_ST_Y_decr::operator()() {
     return 2;
 }
 
-avr_op_ST_Y_incr::avr_op_ST_Y_incr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_ST_Y_decr::operator()(AvrDevice *core) {
+    return exec_ST_Y_decr(core, R1);
+}
+
+avr_op_ST_Y_incr::avr_op_ST_Y_incr(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_ST_Y_incr::operator()() {
+static inline int exec_ST_Y_incr(AvrDevice *core, unsigned char R1) {
     /* Y is R29:R28 */
     word Y = core->GetRegY();
     if (R1 == 28 || R1 == 29)
@@ -1648,11 +1844,15 @@ int avr_op_ST_Y_incr::operator()() {
     return (core->flagXMega || core->flagTiny10) ? 1 : 2;
 }
 
-avr_op_ST_Z_decr::avr_op_ST_Z_decr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_ST_Y_incr::operator()(AvrDevice *core) {
+    return exec_ST_Y_incr(core, R1);
+}
+
+avr_op_ST_Z_decr::avr_op_ST_Z_decr(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_ST_Z_decr::operator()() {
+static inline int exec_ST_Z_decr(AvrDevice *core, unsigned char R1) {
     /* Z is R31:R30 */
     word Z = core->GetRegZ();
     if (R1 == 30 || R1 == 31)
@@ -1667,11 +1867,15 @@ int avr_op_ST_Z_decr::operator()() {
     return 2;
 }
 
-avr_op_ST_Z_incr::avr_op_ST_Z_incr(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_ST_Z_decr::operator()(AvrDevice *core) {
+    return exec_ST_Z_decr(core, R1);
+}
+
+avr_op_ST_Z_incr::avr_op_ST_Z_incr(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_ST_Z_incr::operator()() {
+static inline int exec_ST_Z_incr(AvrDevice *core, unsigned char R1) {
     /* Z is R31:R30 */
     word Z = core->GetRegZ();
     if (R1 == 30 || R1 == 31)
@@ -1687,16 +1891,20 @@ int avr_op_ST_Z_incr::operator()() {
     return (core->flagXMega || core->flagTiny10) ? 1 : 2;
 }
 
-avr_op_SUB::avr_op_SUB(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_ST_Z_incr::operator()(AvrDevice *core) {
+    return exec_ST_Z_incr(core, R1);
+}
+
+avr_op_SUB::avr_op_SUB(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)),
-    R2(get_rr_5(opcode)),
-    status(c->status) {}
+    R2(get_rr_5(opcode)) {}
 
 unsigned char avr_op_SUB::GetModifiedR() const {
     return R1;
 }
-int avr_op_SUB::operator()() {
+static inline int exec_SUB(AvrDevice *core, unsigned char R1, unsigned char R2) {
+    HWSreg *status = core->status;
     byte rd = core->GetCoreReg(R1);
     byte rr = core->GetCoreReg(R2);
 
@@ -1714,16 +1922,20 @@ int avr_op_SUB::operator()() {
     return 1;
 }
 
-avr_op_SUBI::avr_op_SUBI(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_SUB::operator()(AvrDevice *core) {
+    return exec_SUB(core, R1, R2);
+}
+
+avr_op_SUBI::avr_op_SUBI(word opcode):
+    DecodedInstruction(),
     R1(get_rd_4(opcode)),
-    status(c->status),
     K(get_K_8(opcode)) {}
 
 unsigned char avr_op_SUBI::GetModifiedR() const {
     return R1;
 }
-int avr_op_SUBI::operator()() {
+static inline int exec_SUBI(AvrDevice *core, unsigned char R1, unsigned char K) {
+    HWSreg *status = core->status;
     byte rd = core->GetCoreReg(R1);
     byte res = rd - K;
 
@@ -1739,11 +1951,15 @@ int avr_op_SUBI::operator()() {
     return 1;
 }
 
-avr_op_SWAP::avr_op_SWAP(word opcode, AvrDevice *c):
-    DecodedInstruction(c),
+int avr_op_SUBI::operator()(AvrDevice *core) {
+    return exec_SUBI(core, R1, K);
+}
+
+avr_op_SWAP::avr_op_SWAP(word opcode):
+    DecodedInstruction(),
     R1(get_rd_5(opcode)) {}
 
-int avr_op_SWAP::operator()() {
+static inline int exec_SWAP(AvrDevice *core, unsigned char R1) {
     byte rd = core->GetCoreReg(R1);
     byte res = ((rd << 4) & 0xf0) | ((rd >> 4) & 0x0f);
 
@@ -1752,27 +1968,31 @@ int avr_op_SWAP::operator()() {
     return 1;
 }
 
-avr_op_WDR::avr_op_WDR(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+int avr_op_SWAP::operator()(AvrDevice *core) {
+    return exec_SWAP(core, R1);
+}
+
+avr_op_WDR::avr_op_WDR(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_WDR::operator()() {
+int avr_op_WDR::operator()(AvrDevice *core) {
     if(core->wado != NULL)
         core->wado->Wdr();
 
     return 1;
 }
 
-avr_op_BREAK::avr_op_BREAK(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+avr_op_BREAK::avr_op_BREAK(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_BREAK::operator()() {
+int avr_op_BREAK::operator()(AvrDevice *core) {
     return BREAK_POINT+1;
 }
 
-avr_op_ILLEGAL::avr_op_ILLEGAL(word opcode, AvrDevice *c):
-    DecodedInstruction(c) {}
+avr_op_ILLEGAL::avr_op_ILLEGAL(word opcode):
+    DecodedInstruction() {}
 
-int avr_op_ILLEGAL::operator()() {
+int avr_op_ILLEGAL::operator()(AvrDevice *core) {
     avr_error("Illegal opcode '%02x %02x' executed at PC=0x%x (%d)! Simulation terminated!",
         core->Flash->myMemory[core->PC*2+1], core->Flash->myMemory[core->PC*2], core->PC*2, core->PC);
     return 0;
@@ -1954,234 +2174,234 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
         /* opcodes with no operands */
         case 0x9519:
             if(core->flagEIJMPInstructions)
-                return new avr_op_EICALL(opcode, core);                    /* 1001 0101 0001 1001 | EICALL */
+                return new avr_op_EICALL(opcode);                    /* 1001 0101 0001 1001 | EICALL */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new avr_op_ILLEGAL(opcode);
         case 0x9419:
             if(core->flagEIJMPInstructions)
-                return new avr_op_EIJMP(opcode, core);                     /* 1001 0100 0001 1001 | EIJMP */
+                return new avr_op_EIJMP(opcode);                     /* 1001 0100 0001 1001 | EIJMP */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new avr_op_ILLEGAL(opcode);
         case 0x95D8:
             if(core->flagELPMInstructions)
-                return new avr_op_ELPM(opcode, core);                      /* 1001 0101 1101 1000 | ELPM */
+                return new avr_op_ELPM(opcode);                      /* 1001 0101 1101 1000 | ELPM */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new avr_op_ILLEGAL(opcode);
         case 0x95F8:
             if(core->flagLPMInstructions)
-                return new avr_op_ESPM(opcode, core);                      /* 1001 0101 1111 1000 | ESPM */
+                return new avr_op_ESPM(opcode);                      /* 1001 0101 1111 1000 | ESPM */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new avr_op_ILLEGAL(opcode);
         case 0x9509:
             if(core->flagIJMPInstructions)
-                return new avr_op_ICALL(opcode, core);                     /* 1001 0101 0000 1001 | ICALL */
+                return new avr_op_ICALL(opcode);                     /* 1001 0101 0000 1001 | ICALL */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new avr_op_ILLEGAL(opcode);
         case 0x9409:
             if(core->flagIJMPInstructions)
-                return new avr_op_IJMP(opcode, core);                      /* 1001 0100 0000 1001 | IJMP */
+                return new avr_op_IJMP(opcode);                      /* 1001 0100 0000 1001 | IJMP */
             else
-                return new avr_op_ILLEGAL(opcode, core);
+                return new avr_op_ILLEGAL(opcode);
         case 0x95C8:
             if(!core->flagTiny10)
                 /* except tiny10, all devices provide LPM instruction! */
-                return new avr_op_LPM(opcode, core);                       /* 1001 0101 1100 1000 | LPM */
+                return new avr_op_LPM(opcode);                       /* 1001 0101 1100 1000 | LPM */
             else
-                return new avr_op_ILLEGAL(opcode, core);
-        case 0x0000: return new  avr_op_NOP(opcode, core);                 /* 0000 0000 0000 0000 | NOP */
-        case 0x9508: return new  avr_op_RET(opcode, core);                 /* 1001 0101 0000 1000 | RET */
-        case 0x9518: return new  avr_op_RETI(opcode, core);                /* 1001 0101 0001 1000 | RETI */
-        case 0x9588: return new  avr_op_SLEEP(opcode, core);               /* 1001 0101 1000 1000 | SLEEP */
+                return new avr_op_ILLEGAL(opcode);
+        case 0x0000: return new  avr_op_NOP(opcode);                       /* 0000 0000 0000 0000 | NOP */
+        case 0x9508: return new  avr_op_RET(opcode);                       /* 1001 0101 0000 1000 | RET */
+        case 0x9518: return new  avr_op_RETI(opcode);                      /* 1001 0101 0001 1000 | RETI */
+        case 0x9588: return new  avr_op_SLEEP(opcode);                     /* 1001 0101 1000 1000 | SLEEP */
         case 0x95E8:
             if(core->flagLPMInstructions)
-                return new avr_op_SPM(opcode, core);                       /* 1001 0101 1110 1000 | SPM */
+                return new avr_op_SPM(opcode);                       /* 1001 0101 1110 1000 | SPM */
             else
-                return new avr_op_ILLEGAL(opcode, core);
-        case 0x95A8: return new  avr_op_WDR(opcode, core);                 /* 1001 0101 1010 1000 | WDR */
-        case 0x9598: return new  avr_op_BREAK(opcode, core);               /* 1001 0101 1001 1000 | BREAK */
+                return new avr_op_ILLEGAL(opcode);
+        case 0x95A8: return new  avr_op_WDR(opcode);                       /* 1001 0101 1010 1000 | WDR */
+        case 0x9598: return new  avr_op_BREAK(opcode);                     /* 1001 0101 1001 1000 | BREAK */
         default:
                      {
                          /* opcodes with two 5-bit register (Rd and Rr) operands */
                          decode = opcode & ~(mask_Rd_5 | mask_Rr_5);
                          switch ( decode ) {
-                             case 0x1C00: return new  avr_op_ADC(opcode, core);         /* 0001 11rd dddd rrrr | ADC or ROL */
-                             case 0x0C00: return new  avr_op_ADD(opcode, core);         /* 0000 11rd dddd rrrr | ADD or LSL */
-                             case 0x2000: return new  avr_op_AND(opcode, core);         /* 0010 00rd dddd rrrr | AND or TST */
-                             case 0x1400: return new  avr_op_CP(opcode, core);          /* 0001 01rd dddd rrrr | CP */
-                             case 0x0400: return new  avr_op_CPC(opcode, core);         /* 0000 01rd dddd rrrr | CPC */
-                             case 0x1000: return new  avr_op_CPSE(opcode, core);        /* 0001 00rd dddd rrrr | CPSE */
-                             case 0x2400: return new  avr_op_EOR(opcode, core);         /* 0010 01rd dddd rrrr | EOR or CLR */
-                             case 0x2C00: return new  avr_op_MOV(opcode, core);         /* 0010 11rd dddd rrrr | MOV */
+                             case 0x1C00: return new  avr_op_ADC(opcode);               /* 0001 11rd dddd rrrr | ADC or ROL */
+                             case 0x0C00: return new  avr_op_ADD(opcode);               /* 0000 11rd dddd rrrr | ADD or LSL */
+                             case 0x2000: return new  avr_op_AND(opcode);               /* 0010 00rd dddd rrrr | AND or TST */
+                             case 0x1400: return new  avr_op_CP(opcode);                /* 0001 01rd dddd rrrr | CP */
+                             case 0x0400: return new  avr_op_CPC(opcode);               /* 0000 01rd dddd rrrr | CPC */
+                             case 0x1000: return new  avr_op_CPSE(opcode);              /* 0001 00rd dddd rrrr | CPSE */
+                             case 0x2400: return new  avr_op_EOR(opcode);               /* 0010 01rd dddd rrrr | EOR or CLR */
+                             case 0x2C00: return new  avr_op_MOV(opcode);               /* 0010 11rd dddd rrrr | MOV */
                              case 0x9C00:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_MUL(opcode, core);               /* 1001 11rd dddd rrrr | MUL */
+                                     return new avr_op_MUL(opcode);               /* 1001 11rd dddd rrrr | MUL */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x2800: return new  avr_op_OR(opcode, core);          /* 0010 10rd dddd rrrr | OR */
-                             case 0x0800: return new  avr_op_SBC(opcode, core);         /* 0000 10rd dddd rrrr | SBC */
-                             case 0x1800: return new  avr_op_SUB(opcode, core);         /* 0001 10rd dddd rrrr | SUB */
+                                     return new avr_op_ILLEGAL(opcode);
+                             case 0x2800: return new  avr_op_OR(opcode);                /* 0010 10rd dddd rrrr | OR */
+                             case 0x0800: return new  avr_op_SBC(opcode);               /* 0000 10rd dddd rrrr | SBC */
+                             case 0x1800: return new  avr_op_SUB(opcode);               /* 0001 10rd dddd rrrr | SUB */
                          }
 
                          /* opcode with a single register (Rd) as operand */
                          decode = opcode & ~(mask_Rd_5);
                          switch (decode) {
-                             case 0x9405: return new  avr_op_ASR(opcode, core);         /* 1001 010d dddd 0101 | ASR */
-                             case 0x9400: return new  avr_op_COM(opcode, core);         /* 1001 010d dddd 0000 | COM */
-                             case 0x940A: return new  avr_op_DEC(opcode, core);         /* 1001 010d dddd 1010 | DEC */
+                             case 0x9405: return new  avr_op_ASR(opcode);               /* 1001 010d dddd 0101 | ASR */
+                             case 0x9400: return new  avr_op_COM(opcode);               /* 1001 010d dddd 0000 | COM */
+                             case 0x940A: return new  avr_op_DEC(opcode);               /* 1001 010d dddd 1010 | DEC */
                              case 0x9006:
                                  if(core->flagELPMInstructions)
-                                     return new avr_op_ELPM_Z(opcode, core);            /* 1001 000d dddd 0110 | ELPM */
+                                     return new avr_op_ELPM_Z(opcode);            /* 1001 000d dddd 0110 | ELPM */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x9007:
                                  if(core->flagELPMInstructions)
-                                     return new avr_op_ELPM_Z_incr(opcode, core);       /* 1001 000d dddd 0111 | ELPM */
+                                     return new avr_op_ELPM_Z_incr(opcode);       /* 1001 000d dddd 0111 | ELPM */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x9403: return new  avr_op_INC(opcode, core);         /* 1001 010d dddd 0011 | INC */
-                             case 0x9000: return new  avr_op_LDS(opcode, core);         /* 1001 000d dddd 0000 | LDS */
+                                     return new avr_op_ILLEGAL(opcode);
+                             case 0x9403: return new  avr_op_INC(opcode);               /* 1001 010d dddd 0011 | INC */
+                             case 0x9000: return new  avr_op_LDS(opcode);               /* 1001 000d dddd 0000 | LDS */
                              case 0x900C:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_X(opcode, core);              /* 1001 000d dddd 1100 | LD */
+                                     return new avr_op_LD_X(opcode);              /* 1001 000d dddd 1100 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x900E:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_X_decr(opcode, core);         /* 1001 000d dddd 1110 | LD */
+                                     return new avr_op_LD_X_decr(opcode);         /* 1001 000d dddd 1110 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x900D:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_X_incr(opcode, core);         /* 1001 000d dddd 1101 | LD */
+                                     return new avr_op_LD_X_incr(opcode);         /* 1001 000d dddd 1101 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x8008:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LDD_Y(opcode, core);             /* 1000 000d dddd 1000 | LD */
+                                     return new avr_op_LDD_Y(opcode);             /* 1000 000d dddd 1000 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x900A:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_Y_decr(opcode, core);         /* 1001 000d dddd 1010 | LD */
+                                     return new avr_op_LD_Y_decr(opcode);         /* 1001 000d dddd 1010 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x9009:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_Y_incr(opcode, core);         /* 1001 000d dddd 1001 | LD */
+                                     return new avr_op_LD_Y_incr(opcode);         /* 1001 000d dddd 1001 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x8000: return new avr_op_LDD_Z(opcode, core);        /* 1000 000d dddd 0000 | LD */
+                                     return new avr_op_ILLEGAL(opcode);
+                             case 0x8000: return new avr_op_LDD_Z(opcode);        /* 1000 000d dddd 0000 | LD */
                              case 0x9002:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_Z_decr(opcode, core);         /* 1001 000d dddd 0010 | LD */
+                                     return new avr_op_LD_Z_decr(opcode);         /* 1001 000d dddd 0010 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x9001:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_LD_Z_incr(opcode, core);         /* 1001 000d dddd 0001 | LD */
+                                     return new avr_op_LD_Z_incr(opcode);         /* 1001 000d dddd 0001 | LD */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x9004:
                                  if(core->flagLPMInstructions)
-                                     return new avr_op_LPM_Z(opcode, core);             /* 1001 000d dddd 0100 | LPM */
+                                     return new avr_op_LPM_Z(opcode);             /* 1001 000d dddd 0100 | LPM */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x9005:
                                  if(core->flagLPMInstructions)
-                                     return new avr_op_LPM_Z_incr(opcode, core);        /* 1001 000d dddd 0101 | LPM */
+                                     return new avr_op_LPM_Z_incr(opcode);        /* 1001 000d dddd 0101 | LPM */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x9406: return new  avr_op_LSR(opcode, core);         /* 1001 010d dddd 0110 | LSR */
-                             case 0x9401: return new  avr_op_NEG(opcode, core);         /* 1001 010d dddd 0001 | NEG */
+                                     return new avr_op_ILLEGAL(opcode);
+                             case 0x9406: return new  avr_op_LSR(opcode);               /* 1001 010d dddd 0110 | LSR */
+                             case 0x9401: return new  avr_op_NEG(opcode);               /* 1001 010d dddd 0001 | NEG */
                              case 0x900F:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_POP(opcode, core);               /* 1001 000d dddd 1111 | POP */
+                                     return new avr_op_POP(opcode);               /* 1001 000d dddd 1111 | POP */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x920F:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_PUSH(opcode, core);              /* 1001 001d dddd 1111 | PUSH */
+                                     return new avr_op_PUSH(opcode);              /* 1001 001d dddd 1111 | PUSH */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x9407: return new  avr_op_ROR(opcode, core);         /* 1001 010d dddd 0111 | ROR */
-                             case 0x9200: return new  avr_op_STS(opcode, core);         /* 1001 001d dddd 0000 | STS */
+                                     return new avr_op_ILLEGAL(opcode);
+                             case 0x9407: return new  avr_op_ROR(opcode);               /* 1001 010d dddd 0111 | ROR */
+                             case 0x9200: return new  avr_op_STS(opcode);               /* 1001 001d dddd 0000 | STS */
                              case 0x920C:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_X(opcode, core);              /* 1001 001d dddd 1100 | ST */
+                                     return new avr_op_ST_X(opcode);              /* 1001 001d dddd 1100 | ST */
                              case 0x920E:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_X_decr(opcode, core);         /* 1001 001d dddd 1110 | ST */
+                                     return new avr_op_ST_X_decr(opcode);         /* 1001 001d dddd 1110 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x920D:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_X_incr(opcode, core);         /* 1001 001d dddd 1101 | ST */
+                                     return new avr_op_ST_X_incr(opcode);         /* 1001 001d dddd 1101 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x8208:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_STD_Y(opcode, core);             /* 1000 001d dddd 1000 | ST */
+                                     return new avr_op_STD_Y(opcode);             /* 1000 001d dddd 1000 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x920A:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_Y_decr(opcode, core);         /* 1001 001d dddd 1010 | ST */
+                                     return new avr_op_ST_Y_decr(opcode);         /* 1001 001d dddd 1010 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x9209:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_Y_incr(opcode, core);         /* 1001 001d dddd 1001 | ST */
+                                     return new avr_op_ST_Y_incr(opcode);         /* 1001 001d dddd 1001 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x8200: return new  avr_op_STD_Z(opcode, core);       /* 1000 001d dddd 0000 | ST */
+                                     return new avr_op_ILLEGAL(opcode);
+                             case 0x8200: return new  avr_op_STD_Z(opcode);             /* 1000 001d dddd 0000 | ST */
                              case 0x9202:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_Z_decr(opcode, core);         /* 1001 001d dddd 0010 | ST */
+                                     return new avr_op_ST_Z_decr(opcode);         /* 1001 001d dddd 0010 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x9201:
                                  if(!core->flagTiny1x)
-                                     return new avr_op_ST_Z_incr(opcode, core);         /* 1001 001d dddd 0001 | ST */
+                                     return new avr_op_ST_Z_incr(opcode);         /* 1001 001d dddd 0001 | ST */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
-                             case 0x9402: return new  avr_op_SWAP(opcode, core);        /* 1001 010d dddd 0010 | SWAP */
+                                     return new avr_op_ILLEGAL(opcode);
+                             case 0x9402: return new  avr_op_SWAP(opcode);              /* 1001 010d dddd 0010 | SWAP */
                          }
 
                          /* opcodes with a register (Rd) and a constant data (K) as operands */
                          decode = opcode & ~(mask_Rd_4 | mask_K_8);
                          switch ( decode ) {
-                             case 0x7000: return new  avr_op_ANDI(opcode, core);        /* 0111 KKKK dddd KKKK | CBR or ANDI */
-                             case 0x3000: return new  avr_op_CPI(opcode, core);         /* 0011 KKKK dddd KKKK | CPI */
-                             case 0xE000: return new  avr_op_LDI(opcode, core);         /* 1110 KKKK dddd KKKK | LDI or SER */
-                             case 0x6000: return new  avr_op_ORI(opcode, core);         /* 0110 KKKK dddd KKKK | SBR or ORI */
-                             case 0x4000: return new  avr_op_SBCI(opcode, core);        /* 0100 KKKK dddd KKKK | SBCI */
-                             case 0x5000: return new  avr_op_SUBI(opcode, core);        /* 0101 KKKK dddd KKKK | SUBI */
+                             case 0x7000: return new  avr_op_ANDI(opcode);              /* 0111 KKKK dddd KKKK | CBR or ANDI */
+                             case 0x3000: return new  avr_op_CPI(opcode);               /* 0011 KKKK dddd KKKK | CPI */
+                             case 0xE000: return new  avr_op_LDI(opcode);               /* 1110 KKKK dddd KKKK | LDI or SER */
+                             case 0x6000: return new  avr_op_ORI(opcode);               /* 0110 KKKK dddd KKKK | SBR or ORI */
+                             case 0x4000: return new  avr_op_SBCI(opcode);              /* 0100 KKKK dddd KKKK | SBCI */
+                             case 0x5000: return new  avr_op_SUBI(opcode);              /* 0101 KKKK dddd KKKK | SUBI */
                          }
 
                          /* opcodes with a register (Rd) and a register bit number (b) as operands */
                          decode = opcode & ~(mask_Rd_5 | mask_reg_bit);
                          switch ( decode ) {
-                             case 0xF800: return new  avr_op_BLD(opcode, core);         /* 1111 100d dddd 0bbb | BLD */
-                             case 0xFA00: return new  avr_op_BST(opcode, core);         /* 1111 101d dddd 0bbb | BST */
-                             case 0xFC00: return new  avr_op_SBRC(opcode, core);        /* 1111 110d dddd 0bbb | SBRC */
-                             case 0xFE00: return new  avr_op_SBRS(opcode, core);        /* 1111 111d dddd 0bbb | SBRS */
+                             case 0xF800: return new  avr_op_BLD(opcode);               /* 1111 100d dddd 0bbb | BLD */
+                             case 0xFA00: return new  avr_op_BST(opcode);               /* 1111 101d dddd 0bbb | BST */
+                             case 0xFC00: return new  avr_op_SBRC(opcode);              /* 1111 110d dddd 0bbb | SBRC */
+                             case 0xFE00: return new  avr_op_SBRS(opcode);              /* 1111 111d dddd 0bbb | SBRS */
                          }
 
                          /* opcodes with a relative 7-bit address (k) and a register bit number (b) as operands */
                          decode = opcode & ~(mask_k_7 | mask_reg_bit);
                          switch ( decode ) {
-                             case 0xF400: return new  avr_op_BRBC(opcode, core);        /* 1111 01kk kkkk kbbb | BRBC */
-                             case 0xF000: return new  avr_op_BRBS(opcode, core);        /* 1111 00kk kkkk kbbb | BRBS */
+                             case 0xF400: return new  avr_op_BRBC(opcode);              /* 1111 01kk kkkk kbbb | BRBC */
+                             case 0xF000: return new  avr_op_BRBS(opcode);              /* 1111 00kk kkkk kbbb | BRBS */
                          }
 
                          /* opcodes with a 6-bit address displacement (q) and a register (Rd) as operands */
                          if(!core->flagTiny10 && !core->flagTiny1x) {
                              decode = opcode & ~(mask_Rd_5 | mask_q_displ);
                              switch ( decode ) {
-                                 case 0x8008: return new  avr_op_LDD_Y(opcode, core);   /* 10q0 qq0d dddd 1qqq | LDD */
-                                 case 0x8000: return new  avr_op_LDD_Z(opcode, core);   /* 10q0 qq0d dddd 0qqq | LDD */
-                                 case 0x8208: return new  avr_op_STD_Y(opcode, core);   /* 10q0 qq1d dddd 1qqq | STD */
-                                 case 0x8200: return new  avr_op_STD_Z(opcode, core);   /* 10q0 qq1d dddd 0qqq | STD */
+                                 case 0x8008: return new  avr_op_LDD_Y(opcode);         /* 10q0 qq0d dddd 1qqq | LDD */
+                                 case 0x8000: return new  avr_op_LDD_Z(opcode);         /* 10q0 qq0d dddd 0qqq | LDD */
+                                 case 0x8208: return new  avr_op_STD_Y(opcode);         /* 10q0 qq1d dddd 1qqq | STD */
+                                 case 0x8200: return new  avr_op_STD_Z(opcode);         /* 10q0 qq1d dddd 0qqq | STD */
                              }
                          }
                          
@@ -2190,14 +2410,14 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              case 0x940E:
                                  if(core->flagJMPInstructions)
-                                     return new avr_op_CALL(opcode, core);              /* 1001 010k kkkk 111k | CALL */
+                                     return new avr_op_CALL(opcode);              /* 1001 010k kkkk 111k | CALL */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x940C:
                                  if(core->flagJMPInstructions)
-                                     return new avr_op_JMP(opcode, core);               /* 1001 010k kkkk 110k | JMP */
+                                     return new avr_op_JMP(opcode);               /* 1001 010k kkkk 110k | JMP */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                          }
 
                          /* opcode with a sreg bit select (s) operand */
@@ -2205,8 +2425,8 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              /* BCLR takes place of CL{C,Z,N,V,S,H,T,I} */
                              /* BSET takes place of SE{C,Z,N,V,S,H,T,I} */
-                             case 0x9488: return new  avr_op_BCLR(opcode, core);        /* 1001 0100 1sss 1000 | BCLR */
-                             case 0x9408: return new  avr_op_BSET(opcode, core);        /* 1001 0100 0sss 1000 | BSET */
+                             case 0x9488: return new  avr_op_BCLR(opcode);              /* 1001 0100 1sss 1000 | BCLR */
+                             case 0x9408: return new  avr_op_BSET(opcode);              /* 1001 0100 0sss 1000 | BSET */
                          }
 
                          /* opcodes with a 6-bit constant (K) and a register (Rd) as operands */
@@ -2214,37 +2434,37 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              case 0x9600:
                                  if(core->flagIWInstructions)
-                                     return new avr_op_ADIW(opcode, core);              /* 1001 0110 KKdd KKKK | ADIW */
+                                     return new avr_op_ADIW(opcode);              /* 1001 0110 KKdd KKKK | ADIW */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x9700:
                                  if(core->flagIWInstructions)
-                                     return new avr_op_SBIW(opcode, core);              /* 1001 0111 KKdd KKKK | SBIW */
+                                     return new avr_op_SBIW(opcode);              /* 1001 0111 KKdd KKKK | SBIW */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                          }
 
                          /* opcodes with a 5-bit IO Addr (A) and register bit number (b) as operands */
                          decode = opcode & ~(mask_A_5 | mask_reg_bit);
                          switch ( decode ) {
-                             case 0x9800: return new  avr_op_CBI(opcode, core);         /* 1001 1000 AAAA Abbb | CBI */
-                             case 0x9A00: return new  avr_op_SBI(opcode, core);         /* 1001 1010 AAAA Abbb | SBI */
-                             case 0x9900: return new  avr_op_SBIC(opcode, core);        /* 1001 1001 AAAA Abbb | SBIC */
-                             case 0x9B00: return new  avr_op_SBIS(opcode, core);        /* 1001 1011 AAAA Abbb | SBIS */
+                             case 0x9800: return new  avr_op_CBI(opcode);               /* 1001 1000 AAAA Abbb | CBI */
+                             case 0x9A00: return new  avr_op_SBI(opcode);               /* 1001 1010 AAAA Abbb | SBI */
+                             case 0x9900: return new  avr_op_SBIC(opcode);              /* 1001 1001 AAAA Abbb | SBIC */
+                             case 0x9B00: return new  avr_op_SBIS(opcode);              /* 1001 1011 AAAA Abbb | SBIS */
                          }
 
                          /* opcodes with a 6-bit IO Addr (A) and register (Rd) as operands */
                          decode = opcode & ~(mask_A_6 | mask_Rd_5);
                          switch ( decode ) {
-                             case 0xB000: return new  avr_op_IN(opcode, core);          /* 1011 0AAd dddd AAAA | IN */
-                             case 0xB800: return new  avr_op_OUT(opcode, core);         /* 1011 1AAd dddd AAAA | OUT */
+                             case 0xB000: return new  avr_op_IN(opcode);                /* 1011 0AAd dddd AAAA | IN */
+                             case 0xB800: return new  avr_op_OUT(opcode);               /* 1011 1AAd dddd AAAA | OUT */
                          }
 
                          /* opcodes with a relative 12-bit address (k) operand */
                          decode = opcode & ~(mask_k_12);
                          switch ( decode ) {
-                             case 0xD000: return new  avr_op_RCALL(opcode, core);       /* 1101 kkkk kkkk kkkk | RCALL */
-                             case 0xC000: return new  avr_op_RJMP(opcode, core);        /* 1100 kkkk kkkk kkkk | RJMP */
+                             case 0xD000: return new  avr_op_RCALL(opcode);             /* 1101 kkkk kkkk kkkk | RCALL */
+                             case 0xC000: return new  avr_op_RJMP(opcode);              /* 1100 kkkk kkkk kkkk | RJMP */
                          }
 
                          /* opcodes with two 4-bit register (Rd and Rr) operands */
@@ -2252,14 +2472,14 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              case 0x0100:
                                  if(core->flagMOVWInstruction)
-                                     return new avr_op_MOVW(opcode, core);              /* 0000 0001 dddd rrrr | MOVW */
+                                     return new avr_op_MOVW(opcode);              /* 0000 0001 dddd rrrr | MOVW */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x0200:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_MULS(opcode, core);              /* 0000 0010 dddd rrrr | MULS */
+                                     return new avr_op_MULS(opcode);              /* 0000 0010 dddd rrrr | MULS */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                          }
 
                          /* opcodes with two 3-bit register (Rd and Rr) operands */
@@ -2267,31 +2487,206 @@ DecodedInstruction* lookup_opcode( word opcode, AvrDevice *core )
                          switch ( decode ) {
                              case 0x0300:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_MULSU(opcode, core);             /* 0000 0011 0ddd 0rrr | MULSU */
+                                     return new avr_op_MULSU(opcode);             /* 0000 0011 0ddd 0rrr | MULSU */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x0308:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_FMUL(opcode, core);              /* 0000 0011 0ddd 1rrr | FMUL */
+                                     return new avr_op_FMUL(opcode);              /* 0000 0011 0ddd 1rrr | FMUL */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x0380:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_FMULS(opcode, core);             /* 0000 0011 1ddd 0rrr | FMULS */
+                                     return new avr_op_FMULS(opcode);             /* 0000 0011 1ddd 0rrr | FMULS */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                              case 0x0388:
                                  if(core->flagMULInstructions)
-                                     return new avr_op_FMULSU(opcode, core);            /* 0000 0011 1ddd 1rrr | FMULSU */
+                                     return new avr_op_FMULSU(opcode);            /* 0000 0011 1ddd 1rrr | FMULSU */
                                  else
-                                     return new avr_op_ILLEGAL(opcode, core);
+                                     return new avr_op_ILLEGAL(opcode);
                          }
 
                      } /* default */
     } /* first switch */
 
     //return NULL;
-    return new avr_op_ILLEGAL(opcode, core);
+    return new avr_op_ILLEGAL(opcode);
 
 } /* decode opcode function */
 
+/* Threaded code engine */
+
+//! Returns data address, which is accessed by threaded instruction `ti' (op >= TOP_LD_X)
+static unsigned int ThreadedDataAddress(AvrDevice *core, const ThreadedInstruction *ti) {
+    switch(ti->op) {
+        case TOP_LD_X: case TOP_LD_X_INCR: case TOP_ST_X: case TOP_ST_X_INCR:
+            return core->GetRegX();
+        case TOP_LD_X_DECR: case TOP_ST_X_DECR:
+            return (word)(core->GetRegX() - 1);
+        case TOP_LD_Y_INCR: case TOP_ST_Y_INCR:
+            return core->GetRegY();
+        case TOP_LD_Y_DECR: case TOP_ST_Y_DECR:
+            return (word)(core->GetRegY() - 1);
+        case TOP_LD_Z_INCR: case TOP_ST_Z_INCR:
+            return core->GetRegZ();
+        case TOP_LD_Z_DECR: case TOP_ST_Z_DECR:
+            return (word)(core->GetRegZ() - 1);
+        case TOP_LDD_Y: case TOP_STD_Y:
+            return core->GetRegY() + ti->b;
+        default: // TOP_LDD_Z, TOP_STD_Z
+            return core->GetRegZ() + ti->b;
+    }
+}
+
+//! Returns true, if threaded instruction `ti' could run in a chain, see ExecuteThreaded
+static bool IsChainable(AvrDevice *core, const ThreadedInstruction *ti) {
+    if(ti->op == TOP_OBJECT)
+        return false;
+    if(ti->op < TOP_LD_X)
+        return true;
+    // IO registers and traced cells have to be accessed in their own cycle
+    return core->IsDirectMemory(ThreadedDataAddress(core, ti));
+}
+
+#ifdef __GNUC__
+// computed goto, a chained instruction jumps into it's handler without the
+// range check of the switch
+#define THREADED_CASE(name) case TOP_##name: op_##name
+#define THREADED_DISPATCH goto *handler[ti->op]
+#else
+#define THREADED_CASE(name) case TOP_##name
+#define THREADED_DISPATCH goto dispatch
+#endif
+
+int ExecuteThreaded(AvrDevice *core, bool chain, unsigned long long &startCycle) {
+#ifdef __GNUC__
+    static void *const handler[TOP_COUNT] = {
+        &&op_OBJECT, &&op_OBJECT, &&op_ADC, &&op_ADD, &&op_ADIW, &&op_AND,
+        &&op_ANDI, &&op_ASR, &&op_BLD, &&op_BRBC, &&op_BRBS, &&op_BST, &&op_COM,
+        &&op_CP, &&op_CPC, &&op_CPI, &&op_CPSE, &&op_DEC, &&op_EOR, &&op_INC,
+        &&op_LDI, &&op_LSR, &&op_MOV, &&op_MOVW, &&op_MUL, &&op_NEG, &&op_NOP,
+        &&op_OR, &&op_ORI, &&op_RJMP, &&op_ROR, &&op_SBC, &&op_SBCI, &&op_SBIW,
+        &&op_SBRC, &&op_SBRS, &&op_SUB, &&op_SUBI, &&op_SWAP, &&op_LD_X,
+        &&op_LD_X_INCR, &&op_LD_X_DECR, &&op_LD_Y_INCR, &&op_LD_Y_DECR,
+        &&op_LD_Z_INCR, &&op_LD_Z_DECR, &&op_LDD_Y, &&op_LDD_Z, &&op_ST_X,
+        &&op_ST_X_INCR, &&op_ST_X_DECR, &&op_ST_Y_INCR, &&op_ST_Y_DECR,
+        &&op_ST_Z_INCR, &&op_ST_Z_DECR, &&op_STD_Y, &&op_STD_Z
+    };
+#endif
+    AvrFlash *flash = core->Flash;
+    unsigned int pc = core->PC;
+    unsigned long long maxCycles = 0;
+    bool maxCyclesKnown = false;
+    int clks = 0;
+
+    if(flash->IsRWWLock(pc * 2))
+        avr_error("flash is locked (RWW lock)");
+    ThreadedInstruction *ti = flash->Threaded(pc);
+    startCycle = 0;
+    // hardware could be changed by first instruction, nothing to chain then
+    if(!IsChainable(core, ti))
+        chain = false;
+
+#ifndef __GNUC__
+dispatch:
+#endif
+    switch(ti->op) {
+        case TOP_DECODE:
+        THREADED_CASE(OBJECT):
+            return (*flash->DecodedMem[pc])(core);
+        THREADED_CASE(ADC): clks = exec_ADC(core, ti->a, ti->b); goto next;
+        THREADED_CASE(ADD): clks = exec_ADD(core, ti->a, ti->b); goto next;
+        THREADED_CASE(ADIW): clks = exec_ADIW(core, ti->a, ti->a + 1, ti->b); goto next;
+        THREADED_CASE(AND): clks = exec_AND(core, ti->a, ti->b); goto next;
+        THREADED_CASE(ANDI): clks = exec_ANDI(core, ti->a, ti->b); goto next;
+        THREADED_CASE(ASR): clks = exec_ASR(core, ti->a); goto next;
+        THREADED_CASE(BLD): clks = exec_BLD(core, ti->a, ti->b); goto next;
+        THREADED_CASE(BRBC): clks = exec_BRBC(core, ti->a, ti->k); goto next;
+        THREADED_CASE(BRBS): clks = exec_BRBS(core, ti->a, ti->k); goto next;
+        THREADED_CASE(BST): clks = exec_BST(core, ti->a, ti->b); goto next;
+        THREADED_CASE(COM): clks = exec_COM(core, ti->a); goto next;
+        THREADED_CASE(CP): clks = exec_CP(core, ti->a, ti->b); goto next;
+        THREADED_CASE(CPC): clks = exec_CPC(core, ti->a, ti->b); goto next;
+        THREADED_CASE(CPI): clks = exec_CPI(core, ti->a, ti->b); goto next;
+        THREADED_CASE(CPSE): clks = exec_CPSE(core, ti->a, ti->b); goto next;
+        THREADED_CASE(DEC): clks = exec_DEC(core, ti->a); goto next;
+        THREADED_CASE(EOR): clks = exec_EOR(core, ti->a, ti->b); goto next;
+        THREADED_CASE(INC): clks = exec_INC(core, ti->a); goto next;
+        THREADED_CASE(LDI): clks = exec_LDI(core, ti->a, ti->b); goto next;
+        THREADED_CASE(LSR): clks = exec_LSR(core, ti->a); goto next;
+        THREADED_CASE(MOV): clks = exec_MOV(core, ti->a, ti->b); goto next;
+        THREADED_CASE(MOVW): clks = exec_MOVW(core, ti->a, ti->b); goto next;
+        THREADED_CASE(MUL): clks = exec_MUL(core, ti->a, ti->b); goto next;
+        THREADED_CASE(NEG): clks = exec_NEG(core, ti->a); goto next;
+        THREADED_CASE(NOP): clks = exec_NOP(core); goto next;
+        THREADED_CASE(OR): clks = exec_OR(core, ti->a, ti->b); goto next;
+        THREADED_CASE(ORI): clks = exec_ORI(core, ti->a, ti->b); goto next;
+        THREADED_CASE(RJMP): clks = exec_RJMP(core, ti->k); goto next;
+        THREADED_CASE(ROR): clks = exec_ROR(core, ti->a); goto next;
+        THREADED_CASE(SBC): clks = exec_SBC(core, ti->a, ti->b); goto next;
+        THREADED_CASE(SBCI): clks = exec_SBCI(core, ti->a, ti->b); goto next;
+        THREADED_CASE(SBIW): clks = exec_SBIW(core, ti->a, ti->b); goto next;
+        THREADED_CASE(SBRC): clks = exec_SBRC(core, ti->a, ti->b); goto next;
+        THREADED_CASE(SBRS): clks = exec_SBRS(core, ti->a, ti->b); goto next;
+        THREADED_CASE(SUB): clks = exec_SUB(core, ti->a, ti->b); goto next;
+        THREADED_CASE(SUBI): clks = exec_SUBI(core, ti->a, ti->b); goto next;
+        THREADED_CASE(SWAP): clks = exec_SWAP(core, ti->a); goto next;
+        THREADED_CASE(LD_X): clks = exec_LD_X(core, ti->a); goto next;
+        THREADED_CASE(LD_X_INCR): clks = exec_LD_X_incr(core, ti->a); goto next;
+        THREADED_CASE(LD_X_DECR): clks = exec_LD_X_decr(core, ti->a); goto next;
+        THREADED_CASE(LD_Y_INCR): clks = exec_LD_Y_incr(core, ti->a); goto next;
+        THREADED_CASE(LD_Y_DECR): clks = exec_LD_Y_decr(core, ti->a); goto next;
+        THREADED_CASE(LD_Z_INCR): clks = exec_LD_Z_incr(core, ti->a); goto next;
+        THREADED_CASE(LD_Z_DECR): clks = exec_LD_Z_decr(core, ti->a); goto next;
+        THREADED_CASE(LDD_Y): clks = exec_LDD_Y(core, ti->a, ti->b); goto next;
+        THREADED_CASE(LDD_Z): clks = exec_LDD_Z(core, ti->a, ti->b); goto next;
+        THREADED_CASE(ST_X): clks = exec_ST_X(core, ti->a); goto next;
+        THREADED_CASE(ST_X_INCR): clks = exec_ST_X_incr(core, ti->a); goto next;
+        THREADED_CASE(ST_X_DECR): clks = exec_ST_X_decr(core, ti->a); goto next;
+        THREADED_CASE(ST_Y_INCR): clks = exec_ST_Y_incr(core, ti->a); goto next;
+        THREADED_CASE(ST_Y_DECR): clks = exec_ST_Y_decr(core, ti->a); goto next;
+        THREADED_CASE(ST_Z_INCR): clks = exec_ST_Z_incr(core, ti->a); goto next;
+        THREADED_CASE(ST_Z_DECR): clks = exec_ST_Z_decr(core, ti->a); goto next;
+        THREADED_CASE(STD_Y): clks = exec_STD_Y(core, ti->a, ti->b); goto next;
+        THREADED_CASE(STD_Z): clks = exec_STD_Z(core, ti->a, ti->b); goto next;
+    }
+
+next:
+    // PC is on last word of instruction or on jump target - 1
+    if(!chain)
+        return clks;
+    {
+        unsigned int npc = core->PC + 1;
+        if(npc <= pc) {
+            // jump back, a idle loop is skipped by caller, see AvrDevice::FastForwardIdleLoop
+            if(core->useIdleLoopSkip && flash->IsIdleLoop(npc, pc))
+                return clks;
+            core->idleLoopValid = false;
+        }
+        if((npc << 1) >= flash->GetSize() || flash->IsRWWLock(npc * 2))
+            return clks;
+        if(core->BP.IsSet(npc) || core->EP.IsSet(npc) || core->TP.IsSet(npc))
+            return clks;
+        ThreadedInstruction *nti = flash->Threaded(npc);
+        if(!IsChainable(core, nti))
+            return clks;
+        if(!maxCyclesKnown) {
+            maxCycles = core->GetIdleCycles();
+            maxCyclesKnown = true;
+        }
+        if(startCycle + clks > maxCycles)
+            return clks;
+
+        // next instruction runs in this call
+        if(core->coverage != NULL)
+            core->coverage->Executed(pc, npc);
+        startCycle += clks;
+        pc = npc;
+        core->PC = core->cPC = pc;
+        ti = nti;
+        if(core->idleLoopValid && (pc < core->idleLoopStart || pc > core->idleLoopEnd))
+            core->idleLoopValid = false;
+    }
+    THREADED_DISPATCH;
+}
@@ -34,34 +34,86 @@
 
 class AvrFlash;
 
+//! Handler of a instruction in threaded code, see ThreadedInstruction
+enum ThreadedOp {
+    TOP_DECODE = 0, //!< word isn't decoded yet
+    TOP_OBJECT,     //!< executed by DecodedInstruction::operator(), never chained
+    TOP_ADC, TOP_ADD, TOP_ADIW, TOP_AND, TOP_ANDI, TOP_ASR, TOP_BLD, TOP_BRBC,
+    TOP_BRBS, TOP_BST, TOP_COM, TOP_CP, TOP_CPC, TOP_CPI, TOP_CPSE, TOP_DEC,
+    TOP_EOR, TOP_INC, TOP_LDI, TOP_LSR, TOP_MOV, TOP_MOVW, TOP_MUL, TOP_NEG,
+    TOP_NOP, TOP_OR, TOP_ORI, TOP_RJMP, TOP_ROR, TOP_SBC, TOP_SBCI, TOP_SBIW,
+    TOP_SBRC, TOP_SBRS, TOP_SUB, TOP_SUBI, TOP_SWAP,
+    // instructions from here on access data memory, see ThreadedDataAddress
+    TOP_LD_X, TOP_LD_X_INCR, TOP_LD_X_DECR, TOP_LD_Y_INCR, TOP_LD_Y_DECR,
+    TOP_LD_Z_INCR, TOP_LD_Z_DECR, TOP_LDD_Y, TOP_LDD_Z,
+    TOP_ST_X, TOP_ST_X_INCR, TOP_ST_X_DECR, TOP_ST_Y_INCR, TOP_ST_Y_DECR,
+    TOP_ST_Z_INCR, TOP_ST_Z_DECR, TOP_STD_Y, TOP_STD_Z,
+    TOP_COUNT
+};
+
+//! Instruction in compact form for the threaded code engine
+/*! AvrFlash holds one entry per flash word, which is filled on decode from
+  the operands of the decoded instruction, see DecodedInstruction::GetThreaded.
+  Instructions, which change nothing else than core registers, SREG, PC and
+  RAM cells, have an own handler in ExecuteThreaded, all others are executed
+  by their DecodedInstruction (TOP_OBJECT). */
+struct ThreadedInstruction {
+    unsigned char op; //!< handler, see ThreadedOp
+    unsigned char a;  //!< first operand: destination register or SREG bit mask
+    unsigned char b;  //!< second operand: source register, constant, bit or displacement
+    short k;          //!< relative jump offset in words
+
+    void Set(unsigned char o, unsigned char a_ = 0, unsigned char b_ = 0, short k_ = 0) {
+        op = o; a = a_; b = b_; k = k_;
+    }
+};
+
 //! Base class of core instruction
 /*! All instruction are derived from this class */
 class DecodedInstruction {
     
     protected:
-        AvrDevice *core; //!< Link to device instance
         bool size2Word; //!< Flag: true, if instruction has 2 words
 
     public:
-        DecodedInstruction(AvrDevice *c, bool s2w = false): core(c), size2Word(s2w) {}
+        DecodedInstruction(bool s2w = false): size2Word(s2w) {}
         virtual ~DecodedInstruction() {}
 
         //! Returns true, if instruction need 2 words (4byte)
         bool IsInstruction2Words() { return size2Word; } 
 
-        //! Performs instruction
-        virtual int operator()() = 0;
-        //! Performs instruction and write out instruction mnemonic for trace
-        virtual int Trace() = 0;
+        //! Performs instruction on device core
+        virtual int operator()(AvrDevice *core) = 0;
+        //! Performs instruction on device core and write out instruction mnemonic for trace
+        virtual int Trace(AvrDevice *core) = 0;
 		//! If this instruction modifies a R0-R31 register then return its number, otherwise -1.
 		virtual unsigned char GetModifiedR() const {return -1;}
 		//! If this instruction modifies a pair of R0-R31 registers then ...
 		virtual unsigned char GetModifiedRHi() const {return -1;}
+        //! Returns true, if instruction could change program flow (last instruction of a basic block)
+        virtual bool IsBlockEnd() const { return false; }
+        //! Returns true, if instruction changes nothing else than R0-R31, SREG and PC (used to find idle loops)
+        virtual bool IsSideEffectFree() const { return false; }
+        //! Returns data address, which is read by instruction on word index `pc', -1 if instruction doesn't read data
+        virtual int GetDataReadAddress(AvrDevice *core, unsigned int pc) const { return -1; }
+        //! Fills the threaded code entry for this instruction, default is a call of operator()
+        virtual void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_OBJECT); }
 };
 
 //! Translates an opcode to a instance of DecodedInstruction
 DecodedInstruction* lookup_opcode(word opcode, AvrDevice *core);
 
+//! Executes the instruction on PC from threaded code, see AvrDevice::useThreadedCode
+/*! If `chain' is true, following instructions are executed in the same call,
+  as long as hardware and other simulation members do nothing than counting
+  till they start (see AvrDevice::GetIdleCycles). Only instructions with a
+  own handler, which don't access IO registers or traced memory, are chained,
+  they stop on a break-, exit- or triggerpoint and on a jump back into a idle
+  loop. PC and cPC are left on the last executed instruction.
+  @param startCycle returns the cycle offset of the last executed instruction
+  @return clock cycles of the last executed instruction */
+int ExecuteThreaded(AvrDevice *core, bool chain, unsigned long long &startCycle);
+
 class avr_op_ADC: public DecodedInstruction {
     /*
      * Add with Carry.
@@ -75,13 +127,13 @@ class avr_op_ADC: public DecodedInstruction {
     protected:
         unsigned char R1;
         unsigned char R2;
-        HWSreg *status;
 
     public:
-        avr_op_ADC(word opcode, AvrDevice *c);
+        avr_op_ADC(word opcode);
         virtual unsigned char GetModifiedR() const;
-        int operator()();
-        int Trace(); 
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core); 
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ADC, R1, R2); }
 }; //end of class 
 
 class avr_op_ADD: public DecodedInstruction {
@@ -97,13 +149,13 @@ class avr_op_ADD: public DecodedInstruction {
     protected:
         unsigned char R1;
         unsigned char R2;
-        HWSreg *status;
 
     public:
-        avr_op_ADD(word opcode, AvrDevice *c); 
+        avr_op_ADD(word opcode); 
         virtual unsigned char GetModifiedR() const;
-        int operator()();
-        int Trace(); 
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core); 
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ADD, R1, R2); }
 }; //end of class 
 
 
@@ -125,14 +177,14 @@ class avr_op_ADIW: public DecodedInstruction
         unsigned char Rl;
         unsigned char Rh;
         unsigned char K;
-        HWSreg *status;
 
     public:
-        avr_op_ADIW(word opcode, AvrDevice *c);
+        avr_op_ADIW(word opcode);
         virtual unsigned char GetModifiedR() const;
         virtual unsigned char GetModifiedRHi() const;
-        int operator()();
-        int Trace();
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ADIW, Rl, K); }
 };
 
 class avr_op_AND: public DecodedInstruction
@@ -150,12 +202,13 @@ class avr_op_AND: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char R2;
-        HWSreg *status;
 
     public:
-        avr_op_AND(word opcode, AvrDevice *c); 
-        int operator()();
-        int Trace();
+        avr_op_AND(word opcode); 
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_AND, R1, R2); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_ANDI: public DecodedInstruction
@@ -173,12 +226,13 @@ class avr_op_ANDI: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char K;
-        HWSreg *status;
 
     public:
-        avr_op_ANDI(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ANDI(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ANDI, R1, K); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_ASR:public DecodedInstruction
@@ -195,12 +249,12 @@ class avr_op_ASR:public DecodedInstruction
 
     protected:
         unsigned char R1;
-        HWSreg *status;
 
     public:
-        avr_op_ASR(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ASR(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ASR, R1); }
 };
 
 class avr_op_BCLR: public DecodedInstruction
@@ -216,13 +270,12 @@ class avr_op_BCLR: public DecodedInstruction
      */
 
     protected:
-        HWSreg *status;
         unsigned char Kbit;
 
     public:
-        avr_op_BCLR(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_BCLR(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 
@@ -240,12 +293,12 @@ class avr_op_BLD: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char Kbit;
-        HWSreg *status;
 
     public:
-        avr_op_BLD(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_BLD(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_BLD, R1, Kbit); }
 };
 
 class avr_op_BRBC: public DecodedInstruction
@@ -266,14 +319,16 @@ class avr_op_BRBC: public DecodedInstruction
      */
 
     protected:
-        HWSreg *status;
         unsigned char bitmask;
         signed char offset;
 
     public:
-        avr_op_BRBC(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_BRBC(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_BRBC, bitmask, 0, offset); }
+        bool IsBlockEnd() const { return true; }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_BRBS: public DecodedInstruction
@@ -294,14 +349,16 @@ class avr_op_BRBS: public DecodedInstruction
      */
 
     protected:
-        HWSreg *status;
         unsigned char bitmask;
         signed char offset;
 
     public:
-        avr_op_BRBS(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_BRBS(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_BRBS, bitmask, 0, offset); }
+        bool IsBlockEnd() const { return true; }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_BSET: public DecodedInstruction
@@ -317,13 +374,12 @@ class avr_op_BSET: public DecodedInstruction
      */
 
     protected:
-        HWSreg *status;
         unsigned char Kbit;
 
     public:
-        avr_op_BSET(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_BSET(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_BST: public DecodedInstruction
@@ -341,12 +397,12 @@ class avr_op_BST: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char Kbit;
-        HWSreg *status;
 
     public:
-        avr_op_BST(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_BST(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_BST, R1, Kbit); }
 
 };
 
@@ -366,9 +422,10 @@ class avr_op_CALL: public DecodedInstruction
         unsigned char KH;
 
     public:
-        avr_op_CALL(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_CALL(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_CBI: public DecodedInstruction
@@ -386,12 +443,11 @@ class avr_op_CBI: public DecodedInstruction
     protected:
         unsigned char ioreg;
         unsigned char Kbit;
-        HWSreg *status;
 
     public:
-        avr_op_CBI(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_CBI(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_COM: public DecodedInstruction
@@ -408,12 +464,12 @@ class avr_op_COM: public DecodedInstruction
 
     protected:
         unsigned char R1;
-        HWSreg *status;
 
     public:
-        avr_op_COM(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_COM(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_COM, R1); }
 };
 
 class avr_op_CP: public DecodedInstruction
@@ -431,12 +487,13 @@ class avr_op_CP: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char R2;
-        HWSreg *status;
 
     public:
-        avr_op_CP(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_CP(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_CP, R1, R2); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_CPC: public DecodedInstruction
@@ -454,12 +511,13 @@ class avr_op_CPC: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char R2;
-        HWSreg *status;
 
     public:
-        avr_op_CPC(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_CPC(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_CPC, R1, R2); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_CPI: public DecodedInstruction
@@ -477,12 +535,13 @@ class avr_op_CPI: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char K;
-        HWSreg *status;
 
     public:
-        avr_op_CPI(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_CPI(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_CPI, R1, K); }
+        bool IsSideEffectFree() const { return true; }
 
 };
 
@@ -501,12 +560,14 @@ class avr_op_CPSE: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char R2;
-        HWSreg *status;
 
     public:
-        avr_op_CPSE(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_CPSE(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_CPSE, R1, R2); }
+        bool IsBlockEnd() const { return true; }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_DEC: public DecodedInstruction
@@ -523,12 +584,12 @@ class avr_op_DEC: public DecodedInstruction
 
     protected:
         unsigned char R1;
-        HWSreg *status;
 
     public:
-        avr_op_DEC(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_DEC(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_DEC, R1); }
 };
 
 class avr_op_EICALL: public DecodedInstruction
@@ -544,9 +605,10 @@ class avr_op_EICALL: public DecodedInstruction
      */
 
     public:
-        avr_op_EICALL(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_EICALL(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_EIJMP: public DecodedInstruction
@@ -562,9 +624,10 @@ class avr_op_EIJMP: public DecodedInstruction
      */
 
     public:
-        avr_op_EIJMP(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_EIJMP(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_ELPM_Z: public DecodedInstruction
@@ -583,9 +646,9 @@ class avr_op_ELPM_Z: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_ELPM_Z(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ELPM_Z(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_ELPM_Z_incr: public DecodedInstruction
@@ -604,9 +667,9 @@ class avr_op_ELPM_Z_incr: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_ELPM_Z_incr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ELPM_Z_incr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_ELPM: public DecodedInstruction
@@ -623,9 +686,9 @@ class avr_op_ELPM: public DecodedInstruction
      */
 
     public:
-        avr_op_ELPM(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ELPM(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_EOR: public DecodedInstruction
@@ -643,12 +706,13 @@ class avr_op_EOR: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char R2;
-        HWSreg *status;
 
     public:
-        avr_op_EOR(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_EOR(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_EOR, R1, R2); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_ESPM: public DecodedInstruction
@@ -665,9 +729,10 @@ class avr_op_ESPM: public DecodedInstruction
      */
 
     public:
-        avr_op_ESPM(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ESPM(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_FMUL:public DecodedInstruction
@@ -685,12 +750,11 @@ class avr_op_FMUL:public DecodedInstruction
     protected:
         unsigned char Rd;
         unsigned char Rr;
-        HWSreg *status;
 
     public:
-        avr_op_FMUL(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_FMUL(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_FMULS: public DecodedInstruction
@@ -708,12 +772,11 @@ class avr_op_FMULS: public DecodedInstruction
     protected:
         unsigned char Rd;
         unsigned char Rr;
-        HWSreg *status;
 
     public:
-        avr_op_FMULS(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_FMULS(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_FMULSU: public DecodedInstruction
@@ -731,12 +794,11 @@ class avr_op_FMULSU: public DecodedInstruction
     protected:
         unsigned char Rd;
         unsigned char Rr;
-        HWSreg *status;
 
     public:
-        avr_op_FMULSU(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_FMULSU(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_ICALL: public DecodedInstruction
@@ -752,9 +814,10 @@ class avr_op_ICALL: public DecodedInstruction
      */
 
     public:
-        avr_op_ICALL(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ICALL(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_IJMP: public DecodedInstruction
@@ -770,9 +833,10 @@ class avr_op_IJMP: public DecodedInstruction
      */
 
     public:
-        avr_op_IJMP (word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_IJMP(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_IN: public DecodedInstruction
@@ -792,9 +856,11 @@ class avr_op_IN: public DecodedInstruction
         unsigned char ioreg;
 
     public:
-        avr_op_IN(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_IN(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsSideEffectFree() const { return true; }
+        int GetDataReadAddress(AvrDevice *core, unsigned int pc) const { return ioreg + 0x20; }
 };
 
 class avr_op_INC: public DecodedInstruction
@@ -811,12 +877,12 @@ class avr_op_INC: public DecodedInstruction
 
     protected:
         unsigned char R1;
-        HWSreg *status;
 
     public:
-        avr_op_INC(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_INC(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_INC, R1); }
 };
 
 class avr_op_JMP: public DecodedInstruction
@@ -835,9 +901,10 @@ class avr_op_JMP: public DecodedInstruction
         unsigned int K;
 
     public:
-        avr_op_JMP (word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_JMP(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_LDD_Y: public DecodedInstruction
@@ -857,9 +924,10 @@ class avr_op_LDD_Y: public DecodedInstruction
         unsigned char K;
 
     public:
-        avr_op_LDD_Y(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LDD_Y(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LDD_Y, Rd, K); }
 };
 
 class avr_op_LDD_Z: public DecodedInstruction
@@ -879,9 +947,10 @@ class avr_op_LDD_Z: public DecodedInstruction
         unsigned char K;
 
     public:
-        avr_op_LDD_Z(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LDD_Z(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LDD_Z, Rd, K); }
 };
 
 class avr_op_LDI: public DecodedInstruction
@@ -901,10 +970,11 @@ class avr_op_LDI: public DecodedInstruction
         unsigned char K;
 
     public:
-        avr_op_LDI(word opcode, AvrDevice *c);
+        avr_op_LDI(word opcode);
         virtual unsigned char GetModifiedR() const;
-        int operator()();
-        int Trace();
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LDI, R1, K); }
 };
 
 class avr_op_LDS: public DecodedInstruction
@@ -923,9 +993,11 @@ class avr_op_LDS: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_LDS(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LDS(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsSideEffectFree() const { return true; }
+        int GetDataReadAddress(AvrDevice *core, unsigned int pc) const;
 };
 
 class avr_op_LD_X: public DecodedInstruction
@@ -944,9 +1016,10 @@ class avr_op_LD_X: public DecodedInstruction
         unsigned char Rd;
 
     public:
-        avr_op_LD_X(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LD_X(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LD_X, Rd); }
 };
 
 class avr_op_LD_X_decr: public DecodedInstruction
@@ -965,9 +1038,10 @@ class avr_op_LD_X_decr: public DecodedInstruction
         unsigned char Rd;
 
     public:
-        avr_op_LD_X_decr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LD_X_decr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LD_X_DECR, Rd); }
 };
 
 class avr_op_LD_X_incr: public DecodedInstruction
@@ -986,9 +1060,10 @@ class avr_op_LD_X_incr: public DecodedInstruction
         unsigned char Rd;
 
     public:
-        avr_op_LD_X_incr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LD_X_incr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LD_X_INCR, Rd); }
 };
 
 class avr_op_LD_Y_decr: public DecodedInstruction
@@ -1008,9 +1083,10 @@ class avr_op_LD_Y_decr: public DecodedInstruction
         unsigned char Rd;
 
     public:
-        avr_op_LD_Y_decr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LD_Y_decr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LD_Y_DECR, Rd); }
 };
 
 class avr_op_LD_Y_incr: public DecodedInstruction
@@ -1029,9 +1105,10 @@ class avr_op_LD_Y_incr: public DecodedInstruction
         unsigned char Rd;
 
     public:
-        avr_op_LD_Y_incr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LD_Y_incr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LD_Y_INCR, Rd); }
 };
 
 class avr_op_LD_Z_incr: public DecodedInstruction
@@ -1050,9 +1127,10 @@ class avr_op_LD_Z_incr: public DecodedInstruction
         unsigned char Rd;
 
     public:
-        avr_op_LD_Z_incr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LD_Z_incr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LD_Z_INCR, Rd); }
 };
 
 class avr_op_LD_Z_decr: public DecodedInstruction
@@ -1071,9 +1149,10 @@ class avr_op_LD_Z_decr: public DecodedInstruction
         unsigned char Rd;
 
     public:
-        avr_op_LD_Z_decr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LD_Z_decr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LD_Z_DECR, Rd); }
 };
 
 class avr_op_LPM_Z: public DecodedInstruction
@@ -1092,9 +1171,9 @@ class avr_op_LPM_Z: public DecodedInstruction
         unsigned char Rd;
 
     public:
-        avr_op_LPM_Z(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LPM_Z(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_LPM: public DecodedInstruction
@@ -1112,9 +1191,9 @@ class avr_op_LPM: public DecodedInstruction
     //return avr_op_LPM_Z:public DecodedInstruction
 
     public:
-        avr_op_LPM(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LPM(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_LPM_Z_incr: public DecodedInstruction
@@ -1133,9 +1212,9 @@ class avr_op_LPM_Z_incr: public DecodedInstruction
         unsigned char Rd;
 
     public:
-        avr_op_LPM_Z_incr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LPM_Z_incr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_LSR: public DecodedInstruction
@@ -1152,12 +1231,12 @@ class avr_op_LSR: public DecodedInstruction
 
     protected:
         unsigned char Rd;
-        HWSreg *status;
 
     public:
-        avr_op_LSR(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_LSR(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_LSR, Rd); }
 };
 
 class avr_op_MOV: public DecodedInstruction
@@ -1176,9 +1255,11 @@ class avr_op_MOV: public DecodedInstruction
         unsigned char R2;
 
     public:
-        avr_op_MOV(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_MOV(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_MOV, R1, R2); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_MOVW: public DecodedInstruction
@@ -1198,9 +1279,11 @@ class avr_op_MOVW: public DecodedInstruction
         unsigned char Rs;
 
     public:
-        avr_op_MOVW(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_MOVW(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_MOVW, Rd, Rs); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_MUL: public DecodedInstruction
@@ -1218,12 +1301,12 @@ class avr_op_MUL: public DecodedInstruction
     protected:
         unsigned char Rd;
         unsigned char Rr;
-        HWSreg *status;
 
     public:
-        avr_op_MUL(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_MUL(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_MUL, Rd, Rr); }
 };
 
 class avr_op_MULS: public DecodedInstruction
@@ -1241,12 +1324,11 @@ class avr_op_MULS: public DecodedInstruction
     protected:
         unsigned char Rd;
         unsigned char Rr;
-        HWSreg *status;
 
     public:
-        avr_op_MULS(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_MULS(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_MULSU: public DecodedInstruction
@@ -1267,12 +1349,11 @@ class avr_op_MULSU: public DecodedInstruction
     protected:
         unsigned char Rd;
         unsigned char Rr;
-        HWSreg *status;
 
     public:
-        avr_op_MULSU(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_MULSU(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_NEG: public DecodedInstruction
@@ -1289,12 +1370,12 @@ class avr_op_NEG: public DecodedInstruction
 
     protected:
         unsigned char Rd;
-        HWSreg *status;
 
     public:
-        avr_op_NEG(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_NEG(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_NEG, Rd); }
 };
 
 class avr_op_NOP: public DecodedInstruction
@@ -1311,9 +1392,11 @@ class avr_op_NOP: public DecodedInstruction
 
 
     public:
-        avr_op_NOP(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_NOP(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_NOP); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_OR:public DecodedInstruction
@@ -1331,12 +1414,13 @@ class avr_op_OR:public DecodedInstruction
     protected:
         unsigned char Rd;
         unsigned char Rr;
-        HWSreg *status;
 
     public:
-        avr_op_OR(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_OR(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_OR, Rd, Rr); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_ORI: public DecodedInstruction
@@ -1354,12 +1438,13 @@ class avr_op_ORI: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char K;
-        HWSreg *status;
 
     public:
-        avr_op_ORI(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ORI(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ORI, R1, K); }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_OUT: public DecodedInstruction
@@ -1379,9 +1464,9 @@ class avr_op_OUT: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_OUT(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_OUT(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 
     friend class AvrFlash;  // AvrFlash::LooksLikeContextSwitch() needs to read ioreg
 };
@@ -1402,9 +1487,9 @@ class avr_op_POP: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_POP(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_POP(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_PUSH: public DecodedInstruction
@@ -1423,9 +1508,9 @@ class avr_op_PUSH: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_PUSH(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_PUSH(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_RCALL: public DecodedInstruction
@@ -1444,9 +1529,10 @@ class avr_op_RCALL: public DecodedInstruction
         signed int K;
 
     public:
-        avr_op_RCALL(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_RCALL(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_RET: public DecodedInstruction
@@ -1462,9 +1548,10 @@ class avr_op_RET: public DecodedInstruction
      */
 
     public:
-        avr_op_RET(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_RET(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_RETI: public DecodedInstruction
@@ -1480,12 +1567,12 @@ class avr_op_RETI: public DecodedInstruction
      */
 
     protected:
-        HWSreg *status;
 
     public:
-        avr_op_RETI(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_RETI(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_RJMP: public DecodedInstruction
@@ -1504,9 +1591,12 @@ class avr_op_RJMP: public DecodedInstruction
         signed int K;
 
     public:
-        avr_op_RJMP(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_RJMP(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_RJMP, 0, 0, K); }
+        bool IsBlockEnd() const { return true; }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_ROR: public DecodedInstruction
@@ -1523,12 +1613,12 @@ class avr_op_ROR: public DecodedInstruction
 
     protected:
         unsigned char R1;
-        HWSreg *status;
 
     public:
-        avr_op_ROR(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ROR(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ROR, R1); }
 };
 
 class avr_op_SBC: public DecodedInstruction
@@ -1546,13 +1636,13 @@ class avr_op_SBC: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char R2;
-        HWSreg *status;
 
     public:
-        avr_op_SBC(word opcode, AvrDevice *c);
+        avr_op_SBC(word opcode);
         virtual unsigned char GetModifiedR() const;
-        int operator()();
-        int Trace();
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_SBC, R1, R2); }
 };
 
 class avr_op_SBCI: public DecodedInstruction
@@ -1570,13 +1660,13 @@ class avr_op_SBCI: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char K;
-        HWSreg *status;
 
     public:
-        avr_op_SBCI(word opcode, AvrDevice *c);
+        avr_op_SBCI(word opcode);
         virtual unsigned char GetModifiedR() const;
-        int operator()();
-        int Trace();
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_SBCI, R1, K); }
 };
 
 class avr_op_SBI: public DecodedInstruction
@@ -1596,9 +1686,9 @@ class avr_op_SBI: public DecodedInstruction
         unsigned char Kbit;
 
     public:
-        avr_op_SBI(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_SBI(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_SBIC: public DecodedInstruction
@@ -1618,9 +1708,12 @@ class avr_op_SBIC: public DecodedInstruction
         unsigned char Kbit;
 
     public:
-        avr_op_SBIC(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_SBIC(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
+        bool IsSideEffectFree() const { return true; }
+        int GetDataReadAddress(AvrDevice *core, unsigned int pc) const { return ioreg + 0x20; }
 };
 
 class avr_op_SBIS: public DecodedInstruction
@@ -1640,9 +1733,12 @@ class avr_op_SBIS: public DecodedInstruction
         unsigned char Kbit;
 
     public:
-        avr_op_SBIS(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_SBIS(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
+        bool IsSideEffectFree() const { return true; }
+        int GetDataReadAddress(AvrDevice *core, unsigned int pc) const { return ioreg + 0x20; }
 };
 
 class avr_op_SBIW: public DecodedInstruction
@@ -1660,14 +1756,14 @@ class avr_op_SBIW: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char K;
-        HWSreg *status;
 
     public:
-        avr_op_SBIW(word opcode, AvrDevice *c);
+        avr_op_SBIW(word opcode);
         virtual unsigned char GetModifiedR() const;
         virtual unsigned char GetModifiedRHi() const;
-        int operator()();
-        int Trace();
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_SBIW, R1, K); }
 };
 
 class avr_op_SBRC: public DecodedInstruction
@@ -1687,9 +1783,12 @@ class avr_op_SBRC: public DecodedInstruction
         unsigned char Kbit;
 
     public:
-        avr_op_SBRC(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_SBRC(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_SBRC, R1, Kbit); }
+        bool IsBlockEnd() const { return true; }
+        bool IsSideEffectFree() const { return true; }
 };
 
 class avr_op_SBRS: public DecodedInstruction
@@ -1709,12 +1808,16 @@ class avr_op_SBRS: public DecodedInstruction
         unsigned char Kbit;
 
     public:
-        avr_op_SBRS(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_SBRS(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_SBRS, R1, Kbit); }
+        bool IsBlockEnd() const { return true; }
+        bool IsSideEffectFree() const { return true; }
 };
 
-/*! \todo SLEEP instruction not implemented */
+/*! SLEEP stops instruction execution till the next interrupt, sleep mode
+  bits aren't simulated, see AvrDevice::EnterSleepMode */
 class avr_op_SLEEP: public DecodedInstruction
 {
     /*
@@ -1731,9 +1834,10 @@ class avr_op_SLEEP: public DecodedInstruction
 
 
     public:
-        avr_op_SLEEP(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_SLEEP(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_SPM: public DecodedInstruction
@@ -1749,9 +1853,10 @@ class avr_op_SPM: public DecodedInstruction
      */
 
     public:
-        avr_op_SPM(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_SPM(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_STD_Y: public DecodedInstruction
@@ -1771,9 +1876,10 @@ class avr_op_STD_Y: public DecodedInstruction
         unsigned char K;
 
     public:
-        avr_op_STD_Y(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_STD_Y(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_STD_Y, R1, K); }
 };
 
 class avr_op_STD_Z: public DecodedInstruction
@@ -1793,9 +1899,10 @@ class avr_op_STD_Z: public DecodedInstruction
         unsigned char K;
 
     public:
-        avr_op_STD_Z(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_STD_Z(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_STD_Z, R1, K); }
 };
 
 class avr_op_STS: public DecodedInstruction
@@ -1814,9 +1921,9 @@ class avr_op_STS: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_STS(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_STS(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_ST_X: public DecodedInstruction
@@ -1835,9 +1942,10 @@ class avr_op_ST_X: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_ST_X(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ST_X(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ST_X, R1); }
 };
 
 class avr_op_ST_X_decr: public DecodedInstruction
@@ -1856,9 +1964,10 @@ class avr_op_ST_X_decr: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_ST_X_decr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ST_X_decr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ST_X_DECR, R1); }
 };
 
 class avr_op_ST_X_incr: public DecodedInstruction
@@ -1877,9 +1986,10 @@ class avr_op_ST_X_incr: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_ST_X_incr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ST_X_incr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ST_X_INCR, R1); }
 };
 
 class avr_op_ST_Y_decr: public DecodedInstruction
@@ -1898,9 +2008,10 @@ class avr_op_ST_Y_decr: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_ST_Y_decr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ST_Y_decr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ST_Y_DECR, R1); }
 };
 
 class avr_op_ST_Y_incr: public DecodedInstruction
@@ -1919,9 +2030,10 @@ class avr_op_ST_Y_incr: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_ST_Y_incr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ST_Y_incr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ST_Y_INCR, R1); }
 };
 
 class avr_op_ST_Z_decr: public DecodedInstruction
@@ -1940,9 +2052,10 @@ class avr_op_ST_Z_decr: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_ST_Z_decr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ST_Z_decr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ST_Z_DECR, R1); }
 };
 
 class avr_op_ST_Z_incr: public DecodedInstruction
@@ -1961,9 +2074,10 @@ class avr_op_ST_Z_incr: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_ST_Z_incr(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ST_Z_incr(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_ST_Z_INCR, R1); }
 };
 
 class avr_op_SUB: public DecodedInstruction
@@ -1981,13 +2095,13 @@ class avr_op_SUB: public DecodedInstruction
     protected:
         unsigned char R1;
         unsigned char R2;
-        HWSreg *status;
 
     public:
-        avr_op_SUB(word opcode, AvrDevice *c);
+        avr_op_SUB(word opcode);
         virtual unsigned char GetModifiedR() const;
-        int operator()();
-        int Trace();
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_SUB, R1, R2); }
 };
 
 class avr_op_SUBI: public DecodedInstruction
@@ -2004,14 +2118,14 @@ class avr_op_SUBI: public DecodedInstruction
 
     protected:
         unsigned char R1;
-        HWSreg *status;
         unsigned char K;
 
     public:
-        avr_op_SUBI(word opcode, AvrDevice *c);
+        avr_op_SUBI(word opcode);
         virtual unsigned char GetModifiedR() const;
-        int operator()();
-        int Trace();
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_SUBI, R1, K); }
 };
 
 class avr_op_SWAP: public DecodedInstruction
@@ -2030,9 +2144,10 @@ class avr_op_SWAP: public DecodedInstruction
         unsigned char R1;
 
     public:
-        avr_op_SWAP(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_SWAP(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        void GetThreaded(ThreadedInstruction &ti) const { ti.Set(TOP_SWAP, R1); }
 };
 
 class avr_op_WDR: public DecodedInstruction
@@ -2050,9 +2165,9 @@ class avr_op_WDR: public DecodedInstruction
      */
 
     public:
-        avr_op_WDR(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_WDR(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
 };
 
 class avr_op_BREAK: public DecodedInstruction
@@ -2070,9 +2185,10 @@ class avr_op_BREAK: public DecodedInstruction
      */
 
     public:
-        avr_op_BREAK(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_BREAK(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 class avr_op_ILLEGAL: public DecodedInstruction
@@ -2080,9 +2196,10 @@ class avr_op_ILLEGAL: public DecodedInstruction
     //illegal instruction
 
     public:
-        avr_op_ILLEGAL(word opcode, AvrDevice *c);
-        int operator()();
-        int Trace();
+        avr_op_ILLEGAL(word opcode);
+        int operator()(AvrDevice *core);
+        int Trace(AvrDevice *core);
+        bool IsBlockEnd() const { return true; }
 };
 
 #endif
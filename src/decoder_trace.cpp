@@ -56,44 +56,44 @@ int abort_in_expression()
     return 0;
 }
 
-int avr_op_ADC::Trace()  {
+int avr_op_ADC::Trace(AvrDevice *core)  {
     traceOut << "ADC R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_ADD::Trace() {
+int avr_op_ADD::Trace(AvrDevice *core) {
     traceOut << "ADD R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_ADIW::Trace() {
+int avr_op_ADIW::Trace(AvrDevice *core) {
     traceOut << "ADIW R" << (int)Rl << ", " << (int)K << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_AND::Trace() {
+int avr_op_AND::Trace(AvrDevice *core) {
     traceOut << "AND R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret=this->operator()();
+    int ret=this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_ANDI::Trace() {
+int avr_op_ANDI::Trace(AvrDevice *core) {
     traceOut << "ANDI R" << (int)R1 << ", " << HexChar(K) << " ";
-    int ret=this->operator()();
+    int ret=this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_ASR::Trace() {
+int avr_op_ASR::Trace(AvrDevice *core) {
     traceOut << "ASR R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
@@ -109,16 +109,16 @@ const char *opcodes_bclr[8]= {
     "CLI"
 };
 
-int avr_op_BCLR::Trace() {
+int avr_op_BCLR::Trace(AvrDevice *core) {
     traceOut << opcodes_bclr[Kbit] << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_BLD::Trace() {
+int avr_op_BLD::Trace(AvrDevice *core) {
     traceOut << "BLD R" << (int)R1 << ", " << (int)Kbit << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
@@ -133,11 +133,11 @@ const char *branch_opcodes_clear[8] = {
     "BRID"
 };
 
-int avr_op_BRBC::Trace() {
+int avr_op_BRBC::Trace(AvrDevice *core) {
     traceOut << branch_opcodes_clear[INDEX_FROM_BITMASK(bitmask)]
              << " ->" << HexShort(offset * 2) << " ";
     string sym(core->Flash->GetSymbolAtAddress(core->PC+1+offset));
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     
     traceOut << sym << " ";
     for(int len = sym.length(); len < 30; len++)
@@ -157,11 +157,11 @@ const char *branch_opcodes_set[8] = {
     "BRIE"
 };
 
-int avr_op_BRBS::Trace() {
+int avr_op_BRBS::Trace(AvrDevice *core) {
     traceOut << branch_opcodes_set[INDEX_FROM_BITMASK(bitmask)]
              << " ->" << HexShort(offset * 2) << " ";
     string sym(core->Flash->GetSymbolAtAddress(core->PC+1+offset));
-    int ret=this->operator()();
+    int ret=this->operator()(core);
 
     traceOut << sym << " ";
     for(int len = sym.length(); len < 30; len++)
@@ -181,90 +181,90 @@ const char *opcodes_bset[8]= {
     "SEI"
 };
 
-int avr_op_BSET::Trace() {
+int avr_op_BSET::Trace(AvrDevice *core) {
     traceOut << opcodes_bset[Kbit] << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_BST::Trace() {
+int avr_op_BST::Trace(AvrDevice *core) {
     traceOut << "BST R" << (int)R1 << ", " << (int)Kbit << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_CALL::Trace() {
+int avr_op_CALL::Trace(AvrDevice *core) {
     word K_lsb = core->Flash->ReadMemWord((core->PC + 1) * 2);
     int k = (KH << 16) | K_lsb;
     traceOut << "CALL 0x" << hex << k * 2 << dec << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_CBI::Trace() {
+int avr_op_CBI::Trace(AvrDevice *core) {
     traceOut << "CBI " << HexChar(ioreg) << ", " << (int)Kbit << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_COM::Trace() {
+int avr_op_COM::Trace(AvrDevice *core) {
     traceOut << "COM R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_CP::Trace() {
+int avr_op_CP::Trace(AvrDevice *core) {
     traceOut << "CP R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_CPC::Trace() {
+int avr_op_CPC::Trace(AvrDevice *core) {
     traceOut << "CPC R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_CPI::Trace() {
+int avr_op_CPI::Trace(AvrDevice *core) {
     traceOut << "CPI R" << (int)R1 << ", " << HexChar(K) << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_CPSE::Trace() {
+int avr_op_CPSE::Trace(AvrDevice *core) {
     traceOut << "CPSE R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_DEC::Trace() {
+int avr_op_DEC::Trace(AvrDevice *core) {
     traceOut << "DEC R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_EICALL::Trace() {
+int avr_op_EICALL::Trace(AvrDevice *core) {
     traceOut << "EICALL ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_EIJMP::Trace() {
+int avr_op_EIJMP::Trace(AvrDevice *core) {
     traceOut << "EIJMP ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ELPM_Z::Trace() {
+int avr_op_ELPM_Z::Trace(AvrDevice *core) {
     traceOut << "ELPM R" << (int)R1 << ", Z " ;
-    int ret = this->operator()();
+    int ret = this->operator()(core);
 
     unsigned char rampz = 0;
     if(core->rampz != NULL)
@@ -276,22 +276,22 @@ int avr_op_ELPM_Z::Trace() {
     return ret;
 }
 
-int avr_op_ELPM_Z_incr::Trace() {
+int avr_op_ELPM_Z_incr::Trace(AvrDevice *core) {
     traceOut << "ELPM R" << (int)R1 << ", Z+ ";
     unsigned char rampz = 0;
     if(core->rampz != NULL)
         rampz = core->rampz->GetRegVal();
     unsigned int Z = (rampz << 16) + core->GetRegZ();
-    int ret = this->operator()();
+    int ret = this->operator()(core);
 
     traceOut << " Flash[0x" << hex << Z << dec << "] ";
 
     return ret;
 }
 
-int avr_op_ELPM::Trace() {
+int avr_op_ELPM::Trace(AvrDevice *core) {
     traceOut << "ELPM ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
 
     unsigned char rampz = 0;
     if(core->rampz != NULL)
@@ -303,69 +303,69 @@ int avr_op_ELPM::Trace() {
     return ret;
 }
 
-int avr_op_EOR::Trace() {
+int avr_op_EOR::Trace(AvrDevice *core) {
     traceOut << "EOR R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_ESPM::Trace() {
+int avr_op_ESPM::Trace(AvrDevice *core) {
     traceOut << "SPM Z+ ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_FMUL::Trace() {
+int avr_op_FMUL::Trace(AvrDevice *core) {
     traceOut << "FMUL R" << (int)Rd << ", R" << (int)Rr << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_FMULS::Trace() {
+int avr_op_FMULS::Trace(AvrDevice *core) {
     traceOut << "FMULS R" << (int)Rd << ", R" << (int)Rr << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_FMULSU::Trace() {
+int avr_op_FMULSU::Trace(AvrDevice *core) {
     traceOut << "FMULSU R" << (int)Rd << ", R" << (int)Rr << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_ICALL::Trace() {
+int avr_op_ICALL::Trace(AvrDevice *core) {
     traceOut << "ICALL Z " ;
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_IJMP::Trace() {
+int avr_op_IJMP::Trace(AvrDevice *core) {
     traceOut << "IJMP Z " ;
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_IN::Trace() {
+int avr_op_IN::Trace(AvrDevice *core) {
     traceOut << "IN R" << (int)R1 << ", " << HexChar(ioreg) << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_INC::Trace() {
+int avr_op_INC::Trace(AvrDevice *core) {
     traceOut << "INC R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_JMP::Trace() {
+int avr_op_JMP::Trace(AvrDevice *core) {
     traceOut << "JMP ";
     word offset = core->Flash->ReadMemWord((core->PC + 1) * 2);  //this is k!
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     traceOut << hex << 2 * offset << dec << " ";
 
     string sym(core->Flash->GetSymbolAtAddress(offset));
@@ -376,76 +376,76 @@ int avr_op_JMP::Trace() {
     return ret;
 }
 
-int avr_op_LDD_Y::Trace() {
+int avr_op_LDD_Y::Trace(AvrDevice *core) {
     traceOut << "LDD R" << (int)Rd << ", Y+" << (int)K << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LDD_Z::Trace() {
+int avr_op_LDD_Z::Trace(AvrDevice *core) {
     traceOut << "LDD R" << (int)Rd << ", Z+" << (int)K << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LDI::Trace() {
+int avr_op_LDI::Trace(AvrDevice *core) {
     traceOut << "LDI R" << (int)R1 << ", " << HexChar(K) << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LDS::Trace() {
+int avr_op_LDS::Trace(AvrDevice *core) {
     word offset = core->Flash->ReadMemWord((core->PC + 1) * 2);  //this is k!
     traceOut << "LDS R" << (int)R1 << ", " << hex << "0x" << offset << dec  << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LD_X::Trace() {
+int avr_op_LD_X::Trace(AvrDevice *core) {
     traceOut << "LD R" << (int)Rd << ", X ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LD_X_decr::Trace() {
+int avr_op_LD_X_decr::Trace(AvrDevice *core) {
     traceOut << "LD R" << (int)Rd << ", -X ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LD_X_incr::Trace() {
+int avr_op_LD_X_incr::Trace(AvrDevice *core) {
     traceOut << "LD R" << (int)Rd << ", X+ ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LD_Y_decr::Trace() {
+int avr_op_LD_Y_decr::Trace(AvrDevice *core) {
     traceOut << "LD R" << (int)Rd << ", -Y ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LD_Y_incr::Trace() {
+int avr_op_LD_Y_incr::Trace(AvrDevice *core) {
     traceOut << "LD R" << (int)Rd << ", Y+ " ;
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LD_Z_incr::Trace() {
+int avr_op_LD_Z_incr::Trace(AvrDevice *core) {
     traceOut << "LD R" << (int)Rd << ", Z+ ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LD_Z_decr::Trace() {
+int avr_op_LD_Z_decr::Trace(AvrDevice *core) {
     traceOut << "LD R" << (int)Rd << ", -Z";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_LPM_Z::Trace() {
+int avr_op_LPM_Z::Trace(AvrDevice *core) {
     traceOut << "LPM R" << (int)Rd << ", Z ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
 
     /* Z is R31:R30 */
     unsigned int Z = core->GetRegZ();
@@ -455,9 +455,9 @@ int avr_op_LPM_Z::Trace() {
     return ret;
 }
 
-int avr_op_LPM::Trace() {
+int avr_op_LPM::Trace(AvrDevice *core) {
     traceOut << "LPM R0, Z "; 
-    int ret = this->operator()();
+    int ret = this->operator()(core);
 
     /* Z is R31:R30 */
     unsigned int Z = core->GetRegZ();
@@ -467,292 +467,292 @@ int avr_op_LPM::Trace() {
     return ret;
 }
 
-int avr_op_LPM_Z_incr::Trace() {
+int avr_op_LPM_Z_incr::Trace(AvrDevice *core) {
     traceOut << "LPM R" << (int)Rd << ", Z+ " ;
     /* Z is R31:R30 */
     unsigned int Z = core->GetRegZ();
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     
     string sym(core->Flash->GetSymbolAtAddress(Z));
     traceOut << "FLASH[" << hex << Z << dec << "," << sym << "] ";
     return ret;
 }
 
-int avr_op_LSR::Trace() {
+int avr_op_LSR::Trace(AvrDevice *core) {
     traceOut << "LSR R" << (int)Rd << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_MOV::Trace() {
+int avr_op_MOV::Trace(AvrDevice *core) {
     traceOut << "MOV R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_MOVW::Trace() {
+int avr_op_MOVW::Trace(AvrDevice *core) {
     traceOut << "MOVW R" << (int)Rd << ", R" << (int)Rs << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_MUL::Trace() {
+int avr_op_MUL::Trace(AvrDevice *core) {
     traceOut << "MUL R" << (int)Rd << ", R" << (int)Rr << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_MULS::Trace() {
+int avr_op_MULS::Trace(AvrDevice *core) {
     traceOut << "MULS R" << (int)Rd << ", R" << (int)Rr << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_MULSU::Trace() {
+int avr_op_MULSU::Trace(AvrDevice *core) {
     traceOut << "MULSU R" << (int)Rd << ", R" << (int)Rr << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_NEG::Trace() {
+int avr_op_NEG::Trace(AvrDevice *core) {
     traceOut << "NEG R" << (int)Rd <<" ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_NOP::Trace() {
+int avr_op_NOP::Trace(AvrDevice *core) {
     traceOut << "NOP ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_OR::Trace() {
+int avr_op_OR::Trace(AvrDevice *core) {
     traceOut << "OR R" << (int)Rd << ", R" << (int)Rr << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_ORI::Trace() {
+int avr_op_ORI::Trace(AvrDevice *core) {
     traceOut << "ORI R" << (int)R1 << ", " << HexChar(K) << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_OUT::Trace() {
+int avr_op_OUT::Trace(AvrDevice *core) {
     traceOut << "OUT " << HexChar(ioreg) << ", R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_POP::Trace() {
+int avr_op_POP::Trace(AvrDevice *core) {
     traceOut << "POP R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_PUSH::Trace() {
+int avr_op_PUSH::Trace(AvrDevice *core) {
     traceOut << "PUSH R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_RCALL::Trace() {
+int avr_op_RCALL::Trace(AvrDevice *core) {
     traceOut << "RCALL " << hex << ((core->PC + K + 1) << 1) << dec << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_RET::Trace() {
+int avr_op_RET::Trace(AvrDevice *core) {
     traceOut << "RET " ;
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_RETI::Trace() {
+int avr_op_RETI::Trace(AvrDevice *core) {
     traceOut << "RETI ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_RJMP::Trace() {
+int avr_op_RJMP::Trace(AvrDevice *core) {
     traceOut << "RJMP " << hex << ((core->PC + K + 1) << 1) << dec << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ROR::Trace() {
+int avr_op_ROR::Trace(AvrDevice *core) {
     traceOut << "ROR R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_SBC::Trace() {
+int avr_op_SBC::Trace(AvrDevice *core) {
     traceOut << "SBC R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_SBCI::Trace() {
+int avr_op_SBCI::Trace(AvrDevice *core) {
     traceOut << "SBCI R" << (int)R1 << ", " << HexChar(K) << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_SBI::Trace() {
+int avr_op_SBI::Trace(AvrDevice *core) {
     traceOut << "SBI " << HexChar(ioreg) << ", " << (int)Kbit << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_SBIC::Trace() {
+int avr_op_SBIC::Trace(AvrDevice *core) {
     traceOut << "SBIC " << HexChar(ioreg) << ", " << (int)Kbit << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_SBIS::Trace() {
+int avr_op_SBIS::Trace(AvrDevice *core) {
     traceOut << "SBIS " << HexChar(ioreg) << ", " << (int)Kbit << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_SBIW::Trace( ) {
+int avr_op_SBIW::Trace(AvrDevice *core) {
     traceOut << "SBIW R" << (int)R1 << ", " << HexChar(K) << " ";
-    int ret=this->operator()();
+    int ret=this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_SBRC::Trace() {
+int avr_op_SBRC::Trace(AvrDevice *core) {
     traceOut << "SBRC R" << (int)R1 << ", " << (int)Kbit << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_SBRS::Trace() {
+int avr_op_SBRS::Trace(AvrDevice *core) {
     traceOut << "SBRS R" << (int)R1 << ", " << (int)Kbit << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_SLEEP::Trace() {
+int avr_op_SLEEP::Trace(AvrDevice *core) {
     traceOut << "SLEEP " ;
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_SPM::Trace() {
+int avr_op_SPM::Trace(AvrDevice *core) {
     traceOut << "SPM " ;
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_STD_Y::Trace() {
+int avr_op_STD_Y::Trace(AvrDevice *core) {
     traceOut << "STD Y+" << (int)K << ", R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_STD_Z::Trace() {
+int avr_op_STD_Z::Trace(AvrDevice *core) {
     traceOut << "STD Z+" << (int)K << ", R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_STS::Trace() {
+int avr_op_STS::Trace(AvrDevice *core) {
     word offset = core->Flash->ReadMemWord((core->PC + 1) * 2);  //this is k!
     traceOut << "STS " << "0x" << hex << offset << dec << ", R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ST_X::Trace() {
+int avr_op_ST_X::Trace(AvrDevice *core) {
     traceOut << "ST X, R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ST_X_decr::Trace() {
+int avr_op_ST_X_decr::Trace(AvrDevice *core) {
     traceOut << "ST -X, R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ST_X_incr::Trace() {
+int avr_op_ST_X_incr::Trace(AvrDevice *core) {
     traceOut << "ST X+, R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ST_Y_decr::Trace() {
+int avr_op_ST_Y_decr::Trace(AvrDevice *core) {
     traceOut << "ST -Y, R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ST_Y_incr::Trace() {
+int avr_op_ST_Y_incr::Trace(AvrDevice *core) {
     traceOut << "ST Y+, R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ST_Z_decr::Trace() {
+int avr_op_ST_Z_decr::Trace(AvrDevice *core) {
     traceOut << "ST -Z, R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ST_Z_incr::Trace() {
+int avr_op_ST_Z_incr::Trace(AvrDevice *core) {
     traceOut << "ST Z+, R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_SUB::Trace() {
+int avr_op_SUB::Trace(AvrDevice *core) {
     traceOut << "SUB R" << (int)R1 << ", R" << (int)R2 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_SUBI::Trace() {
+int avr_op_SUBI::Trace(AvrDevice *core) {
     traceOut << "SUBI R" << (int)R1 << ", " << HexChar(K) << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     MONSREG;
     return ret;
 }
 
-int avr_op_SWAP::Trace() {
+int avr_op_SWAP::Trace(AvrDevice *core) {
     traceOut << "SWAP R" << (int)R1 << " ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_WDR::Trace() {
+int avr_op_WDR::Trace(AvrDevice *core) {
     traceOut << "WDR ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_BREAK::Trace() {
+int avr_op_BREAK::Trace(AvrDevice *core) {
     traceOut << "BREAK ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
-int avr_op_ILLEGAL::Trace() {
+int avr_op_ILLEGAL::Trace(AvrDevice *core) {
     traceOut << "Invalid Instruction! ";
-    int ret = this->operator()();
+    int ret = this->operator()(core);
     return ret;
 }
 
@@ -0,0 +1,340 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <sstream>
+#include <algorithm>
+
+#include "executionhistory.h"
+#include "avrdevice.h"
+#include "avrerror.h"
+#include "snapshot.h"
+#include "systemclock.h"
+#include "traceval.h"
+
+using namespace std;
+
+ExecutionHistory::ExecutionHistory(AvrDevice *_core, unsigned long long _interval):
+    core(_core),
+    interval((_interval > 0) ? _interval : 1),
+    calcCount(0),
+    inCalc(false)
+{
+    if(DumpManager::Instance()->IsActive())
+        avr_error("execution history can't be used with active trace dumpers");
+    const map<string, Pin *> &all = core->GetAllPins();
+    for(map<string, Pin *>::const_iterator i = all.begin(); i != all.end(); i++) {
+        if(pinIndex.find(i->second) != pinIndex.end())
+            continue;
+        pinIndex[i->second] = pins.size();
+        pins.push_back(i->second);
+        i->second->RegisterCallback(this);
+    }
+    lastInputs.resize(pins.size());
+    Clear();
+    core->history = this;
+}
+
+ExecutionHistory::~ExecutionHistory() {
+    for(unsigned int i = 0; i < pins.size(); i++) {
+        vector<HasPinNotifyFunction *> &l = pins[i]->notifyList;
+        l.erase(remove(l.begin(), l.end(), (HasPinNotifyFunction *)this), l.end());
+    }
+    core->history = NULL;
+}
+
+int ExecutionHistory::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
+    int res;
+    if(replaying)
+        res = ReplayStep(untilCoreStepFinished);
+    else {
+        if(atInstruction && (forceCheckpoint || checkpoints.empty()
+                             || position - checkpoints.back().position >= interval))
+            TakeCheckpoint();
+        // without nextStepIn_ns the core makes exactly one cycle
+        res = core->Step(untilCoreStepFinished, NULL);
+        position++;
+        livePosition = position;
+        atInstruction = untilCoreStepFinished;
+    }
+    if(nextStepIn_ns != NULL)
+        *nextStepIn_ns = core->GetClockFreq();
+    return res;
+}
+
+bool ExecutionHistory::RunBackward(HistoryStopCondition *stop) {
+    unsigned long long end = position;
+    int idx = checkpoints.size() - 1;
+    while(idx >= 0 && checkpoints[idx].position >= end)
+        idx--;
+
+    // search from last checkpoint backward, till a instruction is found
+    for(; idx >= 0; idx--) {
+        Restore(idx);
+        bool found = false;
+        unsigned long long stopPosition = 0;
+        while(position < end) {
+            unsigned long long start = position;
+            bool hit = (stop == NULL) || stop->BeforeInstruction(core);
+            bool finished;
+            do {
+                ReplayStep(finished);
+                SystemClock::Instance().IncrTime(core->GetClockFreq());
+            } while(!finished && position < end);
+            if(stop != NULL && stop->AfterInstruction(core))
+                hit = true;
+            if(hit) {
+                found = true;
+                stopPosition = start;
+            }
+        }
+        if(found) {
+            Restore(idx);
+            ReplayTo(stopPosition);
+            return true;
+        }
+        end = checkpoints[idx].position;
+    }
+    // nothing found, device goes to start of history
+    if(end < position)
+        Restore(0);
+    return false;
+}
+
+void ExecutionHistory::Truncate(void) {
+    // a checkpoint on current position has the old state
+    while(!checkpoints.empty() && checkpoints.back().position >= position)
+        checkpoints.pop_back();
+    if(replaying) {
+        inputs.erase(inputs.begin() + inputIndex, inputs.end());
+        reads.erase(reads.begin() + readIndex, reads.end());
+        livePosition = position;
+        GoLive();
+    }
+    forceCheckpoint = true;
+}
+
+void ExecutionHistory::Clear(void) {
+    checkpoints.clear();
+    inputs.clear();
+    reads.clear();
+    position = livePosition = 0;
+    atInstruction = true;
+    restoring = false;
+    forceCheckpoint = false;
+    diverged = false;
+    inputIndex = readIndex = 0;
+    GoLive();
+}
+
+void ExecutionHistory::ReplayPortInputs(Pin *portPins, unsigned int count) {
+    // restored pin inputs are set by Restore
+    if(restoring)
+        return;
+    calcCount++;
+    for(unsigned int i = 0; i < count; i++) {
+        if(inputIndex < inputs.size() && inputs[inputIndex].inCalc
+           && inputs[inputIndex].calc == calcCount && inputs[inputIndex].pin == &portPins[i]) {
+            ApplyInput(inputs[inputIndex++]);
+        } else {
+            // unchanged input, but listeners are called like in live execution
+            InputChange c;
+            c.pin = &portPins[i];
+            c.value = GetInput(&portPins[i]);
+            ApplyInput(c);
+        }
+    }
+    // other pins of device on the same nets
+    while(inputIndex < inputs.size() && inputs[inputIndex].inCalc
+          && inputs[inputIndex].calc == calcCount)
+        ApplyInput(inputs[inputIndex++]);
+}
+
+void ExecutionHistory::RecordRead(unsigned char value) {
+    if(!replaying)
+        reads.push_back(value);
+}
+
+unsigned char ExecutionHistory::ReplayRead(void) {
+    if(readIndex >= reads.size()) {
+        Diverged();
+        return 0;
+    }
+    return reads[readIndex++];
+}
+
+void ExecutionHistory::PinStateHasChanged(Pin *pin) {
+    if(replaying)
+        return;
+    map<Pin *, unsigned int>::iterator idx = pinIndex.find(pin);
+    if(idx == pinIndex.end())
+        return;
+    PinInput v = GetInput(pin);
+    PinInput &last = lastInputs[idx->second];
+    // port calculations are replayed, only changes have to be recorded there
+    if(inCalc && v.level == last.level && v.analog.getD() == last.analog.getD()
+       && v.analog.getRaw() == last.analog.getRaw())
+        return;
+    last = v;
+    InputChange c;
+    c.position = position;
+    c.calc = calcCount;
+    c.inCalc = inCalc;
+    c.pin = pin;
+    c.value = v;
+    inputs.push_back(c);
+}
+
+void ExecutionHistory::TakeCheckpoint(void) {
+    if(checkpoints.size() >= MAX_CHECKPOINTS) {
+        // keep every second checkpoint, first one stays
+        unsigned int n = 0;
+        for(unsigned int i = 0; i < checkpoints.size(); i += 2, n++) {
+            if(i != n) {
+                Checkpoint &c = checkpoints[n];
+                c = checkpoints[i];
+            }
+        }
+        checkpoints.resize(n);
+        interval *= 2;
+    }
+
+    checkpoints.push_back(Checkpoint());
+    Checkpoint &cp = checkpoints.back();
+    cp.position = position;
+    cp.time = SystemClock::Instance().GetCurrentTime();
+    cp.calcCount = calcCount;
+    cp.inputIndex = inputs.size();
+    cp.readIndex = reads.size();
+    ostringstream os(ios::out | ios::binary);
+    Snapshot snap(os);
+    core->SerializeState(snap);
+    cp.state = os.str();
+    cp.pinInputs.resize(pins.size());
+    for(unsigned int i = 0; i < pins.size(); i++)
+        cp.pinInputs[i] = GetInput(pins[i]);
+    forceCheckpoint = false;
+}
+
+void ExecutionHistory::Restore(unsigned int index) {
+    Checkpoint &cp = checkpoints[index];
+    istringstream is(cp.state, ios::in | ios::binary);
+    Snapshot snap(is);
+    replaying = true;
+    restoring = true;
+    core->SerializeState(snap);
+    restoring = false;
+
+    // pin inputs without calling listeners, their state is restored
+    for(unsigned int i = 0; i < pins.size(); i++) {
+        Pin *p = pins[i];
+        p->analogVal = cp.pinInputs[i].analog;
+        if(p->pinOfPort != NULL) {
+            if(cp.pinInputs[i].level)
+                *p->pinOfPort |= p->mask;
+            else
+                *p->pinOfPort &= ~p->mask;
+        }
+    }
+
+    SystemClock::Instance().SetCurrentTime(cp.time);
+    position = cp.position;
+    calcCount = cp.calcCount;
+    inputIndex = cp.inputIndex;
+    readIndex = cp.readIndex;
+    atInstruction = true;
+    if(position == livePosition)
+        GoLive();
+}
+
+int ExecutionHistory::ReplayStep(bool &untilCoreStepFinished) {
+    // output of replayed execution was written in live execution
+    int traceOn = core->trace_on;
+    BinaryTrace *binaryTrace = core->binaryTrace;
+    Profiler *profiler = core->profiler;
+    Coverage *coverage = core->coverage;
+    core->trace_on = 0;
+    core->binaryTrace = NULL;
+    core->profiler = NULL;
+    core->coverage = NULL;
+
+    int res = core->Step(untilCoreStepFinished, NULL);
+
+    core->trace_on = traceOn;
+    core->binaryTrace = binaryTrace;
+    core->profiler = profiler;
+    core->coverage = coverage;
+
+    position++;
+    atInstruction = untilCoreStepFinished;
+    ApplyStepInputs();
+    if(position == livePosition)
+        GoLive();
+    return res;
+}
+
+void ExecutionHistory::ReplayTo(unsigned long long target) {
+    while(position < target) {
+        bool finished;
+        ReplayStep(finished);
+        SystemClock::Instance().IncrTime(core->GetClockFreq());
+    }
+}
+
+void ExecutionHistory::ApplyInput(const InputChange &i) {
+    Pin p(i.value.level ? Pin::HIGH : Pin::LOW);
+    p.analogVal = i.value.analog;
+    i.pin->SetInState(p);
+}
+
+void ExecutionHistory::ApplyStepInputs(void) {
+    // inputs of a earlier step are left, if a port calculation wasn't replayed
+    while(inputIndex < inputs.size() && inputs[inputIndex].position < position) {
+        Diverged();
+        inputIndex++;
+    }
+    while(inputIndex < inputs.size() && inputs[inputIndex].position == position
+          && !inputs[inputIndex].inCalc)
+        ApplyInput(inputs[inputIndex++]);
+}
+
+void ExecutionHistory::Diverged(void) {
+    if(!diverged)
+        avr_warning("replay of execution history differs from recorded execution");
+    diverged = true;
+}
+
+void ExecutionHistory::GoLive(void) {
+    replaying = false;
+    for(unsigned int i = 0; i < pins.size(); i++)
+        lastInputs[i] = GetInput(pins[i]);
+}
+
+ExecutionHistory::PinInput ExecutionHistory::GetInput(Pin *pin) const {
+    PinInput v;
+    v.level = (pin->pinOfPort != NULL) && ((*pin->pinOfPort & pin->mask) != 0);
+    v.analog = pin->analogVal;
+    return v;
+}
+
@@ -0,0 +1,185 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef EXECUTIONHISTORY
+#define EXECUTIONHISTORY
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "systemclocktypes.h"
+#include "pin.h"
+#include "pinnotify.h"
+
+class AvrDevice;
+
+//! Stop condition for ExecutionHistory::RunBackward
+class HistoryStopCondition {
+
+    public:
+        virtual ~HistoryStopCondition() {}
+        //! Called, before the instruction on PC is replayed, true stops before it
+        virtual bool BeforeInstruction(AvrDevice *core)=0;
+        //! Called, after the instruction is replayed, true stops before it
+        virtual bool AfterInstruction(AvrDevice *core)=0;
+};
+
+//! Execution history of a device for reverse debugging
+/*! The history steps the core instead of the owner (gdb server) and counts
+  the steps as position. Every `interval' cycles a checkpoint is taken at a
+  instruction start: the device state (see AvrDevice::SerializeState) and the
+  simulation time. Besides that all inputs from outside the device are
+  recorded with their position: changes of pin input values (stimuli, serial
+  input, user interface, other devices) and bytes read by RWReadFromFile.
+
+  A earlier position is reached by restoring the last checkpoint before it
+  and replaying the core from there. While replaying, the recorded input
+  values are given to the pins in place of nets, the device doesn't change
+  nets and doesn't write RWWriteToFile, trace, profile or coverage again.
+  Trace dumpers (VCD) aren't suppressed, they would get the replayed values
+  again with a simulation time going backward, so the history can't be used
+  together with dumpers. When the replay reaches the position of live
+  execution, inputs come from nets again.
+
+  A step of the core is one cycle here, the core doesn't skip sleeping cycles
+  or idle loop passes (this would depend on the other simulation members),
+  so the replay is exact. If there are more than MAX_CHECKPOINTS checkpoints,
+  every second one is dropped and interval is doubled, so memory is limited
+  and the whole history stays reachable. Recorded inputs aren't limited: every
+  input change costs sizeof(InputChange) (40 byte on 64 bit hosts), this
+  includes changes of the PIN bit of a pin, which is driven by the device
+  itself, and every byte read by RWReadFromFile costs one byte. So a long
+  session with a toggling output needs a lot of memory, use Clear to free
+  it. */
+class ExecutionHistory: public HasPinNotifyFunction {
+
+    public:
+        //! Creates the history and enables it on device, see AvrDevice::history
+        /*! Fails with avr_error, if there are active trace dumpers. */
+        ExecutionHistory(AvrDevice *core, unsigned long long interval);
+        //! Disables history on device
+        ~ExecutionHistory();
+
+        //! Steps the core like AvrDevice::Step, in live execution or in replay
+        int Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns);
+        //! Moves device backward to the start of the last instruction, where stop is true
+        /*! stop NULL stops at the previous instruction (reverse step). Returns
+          false, if there is no such instruction, then device is on start of
+          history. */
+        bool RunBackward(HistoryStopCondition *stop);
+        //! Discards the recorded future, call before the state is changed from outside
+        /*! Device goes live on current position, next step takes a checkpoint
+          with the changed state. */
+        void Truncate(void);
+        //! Discards the whole history, recording starts again with next step
+        void Clear(void);
+
+        //! Count of core steps since start of history
+        unsigned long long GetPosition(void) const { return position; }
+        //! Position of live execution
+        unsigned long long GetLivePosition(void) const { return livePosition; }
+        //! True, if device is replayed, inputs are taken from history
+        bool IsReplaying(void) const { return replaying; }
+
+        //! Called by HWPort, before it calculates it's pins in live execution
+        void BeginPortCalc(void) { calcCount++; inCalc = true; }
+        //! Called by HWPort, after it has calculated it's pins in live execution
+        void EndPortCalc(void) { inCalc = false; }
+        //! Called by HWPort in replay in place of calculating it's pins from nets
+        void ReplayPortInputs(Pin *pins, unsigned int count);
+        //! Records a byte read from outside (RWReadFromFile)
+        void RecordRead(unsigned char value);
+        //! Returns the byte, which was read at this place in live execution
+        unsigned char ReplayRead(void);
+
+        //! Records a change of a input value, see HasPinNotifyFunction
+        virtual void PinStateHasChanged(Pin *pin);
+
+    private:
+        enum { MAX_CHECKPOINTS = 256 };
+
+        //! Input value of a pin
+        struct PinInput {
+            bool level;             //!< bit in PIN register, for port pins
+            AnalogValue analog;
+        };
+        //! Saved device state on a instruction start
+        struct Checkpoint {
+            unsigned long long position;
+            SystemClockOffset time;
+            unsigned long long calcCount;
+            size_t inputIndex;      //!< first input recorded after checkpoint
+            size_t readIndex;       //!< first read recorded after checkpoint
+            std::string state;
+            std::vector<PinInput> pinInputs; //!< input values of all pins, nets aren't part of state
+        };
+        //! Changed input value of a pin
+        struct InputChange {
+            unsigned long long position; //!< step, while or before which input was changed
+            unsigned long long calc; //!< calcCount at change
+            Pin *pin;
+            PinInput value;
+            bool inCalc;            //!< changed by a calculation of a device port
+        };
+
+        AvrDevice *core;
+        unsigned long long interval; //!< cycles between checkpoints
+        std::vector<Checkpoint> checkpoints;
+        std::vector<InputChange> inputs;
+        std::vector<unsigned char> reads;
+        std::vector<Pin *> pins; //!< all pins of device
+        std::map<Pin *, unsigned int> pinIndex; //!< index of pin in pins
+        std::vector<PinInput> lastInputs; //!< input values of pins, to find changes in live execution
+        unsigned long long position;
+        unsigned long long livePosition;
+        bool atInstruction;     //!< last step has finished a instruction
+        bool replaying;
+        bool restoring;         //!< checkpoint is restored, pins must not be touched
+        bool forceCheckpoint;   //!< take a checkpoint on next step, state was changed from outside
+        bool diverged;          //!< replay has missed a recorded input, warning is given
+        unsigned long long calcCount; //!< count of port calculations
+        bool inCalc;            //!< a port calculation is running
+        size_t inputIndex;      //!< next input to replay
+        size_t readIndex;       //!< next read to replay
+
+        void TakeCheckpoint(void);
+        void Restore(unsigned int index);
+        //! Replays one step of the core
+        int ReplayStep(bool &untilCoreStepFinished);
+        //! Replays till position target, simulation time is moved forward
+        void ReplayTo(unsigned long long target);
+        //! Sets recorded input value on pin
+        void ApplyInput(const InputChange &i);
+        //! Sets inputs, which were changed before the step on position
+        void ApplyStepInputs(void);
+        //! Reports a replay, which doesn't match recording
+        void Diverged(void);
+        //! Switches from replay to live execution
+        void GoLive(void);
+        PinInput GetInput(Pin *pin) const;
+};
+
+#endif
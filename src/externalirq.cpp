@@ -25,6 +25,7 @@
 
 #include "externalirq.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 ExternalIRQHandler::ExternalIRQHandler(AvrDevice* c,
                                        HWIrqSystem* irqsys,
@@ -107,6 +108,13 @@ void ExternalIRQHandler::Reset(void) {
         extirqs[idx]->ResetMode();
 }
 
+void ExternalIRQHandler::SerializeState(Snapshot &snap) {
+    snap.Value(irq_mask);
+    snap.Value(irq_flag);
+    for(unsigned int idx = 0; idx < extirqs.size(); idx++)
+        extirqs[idx]->SerializeState(snap);
+}
+
 unsigned char ExternalIRQHandler::set_from_reg(const IOSpecialReg* reg, unsigned char nv) {
     if(reg == mask_reg) {
         // mask register: trigger interrupt, if mask bit is new set and flag is true or fireAgain()
@@ -64,6 +64,7 @@ class ExternalIRQHandler: public Hardware, public IOSpecialRegClient {
         // from Hardware
         virtual void ClearIrqFlag(unsigned int vector);
         virtual void Reset(void);
+        virtual void SerializeState(Snapshot &snap);
         virtual bool IsLevelInterrupt(unsigned int vector);
         virtual bool LevelInterruptPending(unsigned int vector);
         
@@ -89,6 +90,8 @@ class ExternalIRQ: public IOSpecialRegClient {
         void fireInterrupt(void) { handler->fireInterrupt(handlerIndex); }
         //! Reset mode
         virtual void ResetMode(void) { mode = 0; }
+        //! Saves or restores mode and pin states, see Snapshot
+        virtual void SerializeState(Snapshot &snap) { snap.Value(mode); }
         //! Handle change of control register
         virtual void ChangeMode(unsigned char m) { mode = m; }
         //! does the interrupt source fire again? (for interrupt on level)
@@ -128,6 +131,7 @@ class ExternalIRQSingle: public ExternalIRQ, public HasPinNotifyFunction {
         void ChangeMode(unsigned char m);
         bool fireAgain(void);
         bool mustSetFlagOnFire(void);
+        void SerializeState(Snapshot &snap) { ExternalIRQ::SerializeState(snap); snap.Value(state); }
         
         // from HasPinNotifyFunction
         void PinStateHasChanged(Pin *pin);
@@ -144,6 +148,9 @@ class ExternalIRQPort: public ExternalIRQ, public HasPinNotifyFunction {
     public:
         ExternalIRQPort(IOSpecialReg *ctrl, HWPort *port);
         
+        // from ExternalIRQ
+        void SerializeState(Snapshot &snap) { ExternalIRQ::SerializeState(snap); snap.Value(state); }
+        
         // from HasPinNotifyFunction
         void PinStateHasChanged(Pin *pin);
 };
@@ -27,13 +27,87 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <map>
 
+#ifndef _MSC_VER
+#   include "config.h"
+#endif
 
+#ifdef HAVE_LIBPTHREAD
+#   include <pthread.h>
+#endif
 
 #include "flash.h"
+#include "avrdevice.h"
 #include "helper.h"
 #include "memory.h"
 #include "avrerror.h"
+#include "snapshot.h"
+
+//! Decoded instructions of all flashes, keyed by decoder flags of core and opcode
+/*! Decoded instructions don't depend on address or device (the core is given
+  on execution) and aren't changed after decoding, so every opcode is decoded
+  once for all devices with the same instruction set. Instructions are deleted
+  at program exit. */
+class InstructionPool {
+    
+    private:
+        std::map<unsigned int, DecodedInstruction*> pool;
+#ifdef HAVE_LIBPTHREAD
+        pthread_mutex_t mutex; //!< devices could decode in parallel, see SystemClock::RunParallel
+#endif
+        
+        //! Core flags, which select the instruction for a opcode in lookup_opcode
+        static unsigned int DecoderFlags(const AvrDevice *core) {
+            return core->flagIWInstructions
+                | (core->flagJMPInstructions << 1)
+                | (core->flagIJMPInstructions << 2)
+                | (core->flagEIJMPInstructions << 3)
+                | (core->flagLPMInstructions << 4)
+                | (core->flagELPMInstructions << 5)
+                | (core->flagMULInstructions << 6)
+                | (core->flagMOVWInstruction << 7)
+                | (core->flagTiny10 << 8)
+                | (core->flagTiny1x << 9);
+        }
+        
+    public:
+        InstructionPool() {
+#ifdef HAVE_LIBPTHREAD
+            pthread_mutex_init(&mutex, NULL);
+#endif
+        }
+        ~InstructionPool() {
+            std::map<unsigned int, DecodedInstruction*>::iterator i;
+            for(i = pool.begin(); i != pool.end(); i++)
+                delete i->second; // delete Instruction
+#ifdef HAVE_LIBPTHREAD
+            pthread_mutex_destroy(&mutex);
+#endif
+        }
+        
+        //! Returns decoded instruction for opcode on this core
+        DecodedInstruction *Get(word opcode, AvrDevice *core) {
+#ifdef HAVE_LIBPTHREAD
+            pthread_mutex_lock(&mutex);
+#endif
+            DecodedInstruction *&de = pool[(DecoderFlags(core) << 16) | opcode];
+            if(de == NULL)
+                de = lookup_opcode(opcode, core);
+            DecodedInstruction *res = de;
+#ifdef HAVE_LIBPTHREAD
+            pthread_mutex_unlock(&mutex);
+#endif
+            return res;
+        }
+        
+        //! The pool shared by all flashes
+        static InstructionPool &Instance(void) {
+            static InstructionPool instance;
+            return instance;
+        }
+};
 
 void AvrFlash::Decode(){
     for(unsigned int addr = 0; addr < size ; addr += 2)
@@ -43,20 +117,19 @@ void AvrFlash::Decode(){
 AvrFlash::AvrFlash(AvrDevice *c, int _size):
     Memory(_size),
     core(c),
-    DecodedMem(_size),
+    BlockSize(_size / 2),
+    DecodedMem(_size / 2),
+    ThreadedMem(_size / 2),
+    IdleLoop(_size / 2),
     flashLoaded(false) {
     for(unsigned int tt = 0; tt < size; tt++)
         myMemory[tt] = 0xff;  // Safeguard, will be decoded as avr_op_ILLEGAL
     rww_lock = 0;
-    // initialize DecodedMem
-    Decode();
+    // nothing is decoded yet, DecodedMem is initialized with NULL, ThreadedMem with TOP_DECODE
 }
 
 AvrFlash::~AvrFlash() {
-    for(unsigned int i = 0; i < size; i++) {
-       if(DecodedMem[i] != NULL)
-          delete DecodedMem[i]; // delete Instruction
-    }
+    // decoded instructions are owned by InstructionPool
 }
 
 void AvrFlash::WriteMem(const unsigned char *src, unsigned int offset, unsigned int secSize) {
@@ -80,7 +153,7 @@ void AvrFlash::WriteMemByte(unsigned char val, unsigned int offset) {
 DecodedInstruction* AvrFlash::GetInstruction(unsigned int pc) {
     if(IsRWWLock(pc * 2))
         avr_error("flash is locked (RWW lock)");
-    return DecodedMem[pc];
+    return Decoded(pc);
 }
 
 unsigned char AvrFlash::ReadMem(unsigned int offset) {
@@ -106,14 +179,77 @@ void AvrFlash::Decode(unsigned int offset, int secSize) {
         Decode(offset);
 }
 
+DecodedInstruction *AvrFlash::DecodeWord(unsigned int index) const {
+    assert(index < DecodedMem.size());
+    word opcode = (myMemory[index * 2] << 8) + myMemory[index * 2 + 1];
+    DecodedInstruction *de = InstructionPool::Instance().Get(opcode, core);
+    DecodedMem[index] = de;
+    de->GetThreaded(ThreadedMem[index]);
+    return de;
+}
+
 void AvrFlash::Decode(unsigned int addr) {
     assert((unsigned)addr < size);
     assert((addr % 2) == 0);
-    word opcode = (myMemory[addr] << 8) + myMemory[addr + 1];
     unsigned int index = addr / 2;
-    if(DecodedMem[index] != NULL)
-        delete DecodedMem[index];                     //delete old Instruction here 
-    DecodedMem[index] = lookup_opcode(opcode, core);  //and set new one
+    // instruction stays in pool, new one is taken on first use
+    DecodedMem[index] = NULL;
+    ThreadedMem[index].op = TOP_DECODE;
+
+    // invalidate all cached basic blocks, which could contain this word
+    unsigned int first = (index < maxBlockWords) ? 0 : index - maxBlockWords + 1;
+    for(unsigned int i = first; i <= index; i++)
+        BlockSize[i] = 0;
+
+    // invalidate all cached idle loop results, where loop could contain this word
+    unsigned int last = std::min(index + maxIdleLoopWords, (unsigned int)IdleLoop.size());
+    for(unsigned int i = index; i < last; i++)
+        IdleLoop[i] = 0;
+}
+
+void AvrFlash::SerializeState(Snapshot &snap) {
+    snap.Check("flash");
+    snap.Value(rww_lock);
+    snap.Value(flashLoaded);
+    if(snap.IsRestoring()) {
+        std::vector<unsigned char> content(size);
+        snap.Block(&content[0], size);
+        for(unsigned int addr = 0; addr < size; addr += 2) {
+            if(myMemory[addr] == content[addr] && myMemory[addr + 1] == content[addr + 1])
+                continue;
+            myMemory[addr] = content[addr];
+            myMemory[addr + 1] = content[addr + 1];
+            Decode(addr);
+        }
+    } else
+        snap.Block(myMemory, size);
+}
+
+unsigned int AvrFlash::ScanBlock(unsigned int pc) const {
+    unsigned int words = size / 2;
+    unsigned int idx = pc;
+    while(idx < words && (idx - pc) < maxBlockWords) {
+        DecodedInstruction *de = Decoded(idx);
+        unsigned int len = de->IsInstruction2Words() ? 2 : 1;
+        if(idx + len > words || (idx + len - pc) > maxBlockWords)
+            break;  // instruction does not fit into flash or block
+        idx += len;
+        if(de->IsBlockEnd())
+            break;
+    }
+    return idx - pc;
+}
+
+bool AvrFlash::ScanIdleLoop(unsigned int start, unsigned int end) const {
+    unsigned int idx = start;
+    while(idx < end) {
+        DecodedInstruction *de = Decoded(idx);
+        if(!de->IsSideEffectFree())
+            return false;
+        idx += de->IsInstruction2Words() ? 2 : 1;
+    }
+    // last instruction is the jump back
+    return idx == end && Decoded(end)->IsSideEffectFree();
 }
 
 /** Returns true if insn at address index*2 looks like switching thread stacks (heuristics).
@@ -132,7 +268,7 @@ bool AvrFlash::LooksLikeContextSwitch(unsigned int addr) const
 {
     assert(addr < size);
     word index = addr/2;
-    DecodedInstruction * instr = DecodedMem[index];
+    DecodedInstruction * instr = Decoded(index);
     avr_op_OUT * out_instr = dynamic_cast<avr_op_OUT*>(instr);
     if(out_instr == NULL)
         return false;
@@ -144,7 +280,7 @@ bool AvrFlash::LooksLikeContextSwitch(unsigned int addr) const
     unsigned char out_R = out_instr->R1;  // We have "OUT SP, R"
 
     for(int i = 1; i < 8 && i <= index; i++) {
-        instr = DecodedMem[index - i];
+        instr = Decoded(index - i);
         byte Rlo = instr->GetModifiedR();  // "sbiw r28:r29, 42" returns 28
         byte Rhi = instr->GetModifiedRHi();  // "sbiw r28:r29, 42" returns 29
         if(out_R == Rlo || (is_SPH && out_R == Rhi)) {
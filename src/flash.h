@@ -33,33 +33,52 @@
 #include "memory.h"
 
 class DecodedInstruction;
+class Snapshot;
 
 //! Holds AVR flash content and symbol informations.
 class AvrFlash: public Memory {
   
     protected:
         AvrDevice *core;
-        std::vector <DecodedInstruction*> DecodedMem;
+        std::vector <unsigned char> BlockSize; //!< Cached size (in words) of basic block starting at this word, 0 if unknown
+        mutable std::vector <DecodedInstruction*> DecodedMem; //!< Decoded instruction per word (shared by all flashes, see InstructionPool), NULL if not decoded yet
+        mutable std::vector <ThreadedInstruction> ThreadedMem; //!< Threaded code per word, see ExecuteThreaded, op is TOP_DECODE if not decoded yet
+        std::vector <unsigned char> IdleLoop; //!< Cached result of IsIdleLoop for jump back on this word, 0 if unknown
         unsigned int rww_lock; //!< When Flash write is in progress then addresses below this are inaccesible, otherwise 0.
         bool flashLoaded; //!< Flag, true if there was a write to Flash after constructor call (program load)
         
-        friend int avr_op_CPSE::operator()();
-        friend int avr_op_SBIC::operator()();
-        friend int avr_op_SBIS::operator()();
-        friend int avr_op_SBRC::operator()();
-        friend int avr_op_SBRS::operator()();
+        friend int ExecuteThreaded(AvrDevice *core, bool chain, unsigned long long &startCycle);
+
+        //! Returns instruction at word index, decodes it on first request
+        DecodedInstruction *Decoded(unsigned int index) const {
+            DecodedInstruction *de = DecodedMem[index];
+            return (de != NULL) ? de : DecodeWord(index);
+        }
+        //! Returns threaded code at word index, decodes it on first request
+        ThreadedInstruction *Threaded(unsigned int index) const {
+            ThreadedInstruction *ti = &ThreadedMem[index];
+            if(ti->op == TOP_DECODE)
+                DecodeWord(index);
+            return ti;
+        }
+        //! Decodes instruction at word index (or takes it from InstructionPool) and enters it in DecodedMem and ThreadedMem
+        DecodedInstruction *DecodeWord(unsigned int index) const;
 
     public:
       
         AvrFlash(AvrDevice *c, int size);
         ~AvrFlash();
         
-        void Decode(); /*!< Decode/create all instructions */
+        /*! Invalidates all instructions, they are decoded again on first use */
+        void Decode();
         
-        /*! Decode/create instruction at address 'addr'. */
+        /*! Invalidates instruction at address 'addr' after flash content is
+          changed. Instructions are decoded lazy, on first execution or request
+          by GetInstruction, so loading a program or starting a simulator with
+          a big flash doesn't decode words, which are never used. */
         void Decode(unsigned int addr);
         
-        /*! Decode memory block with offset and size
+        /*! Invalidates memory block with offset and size
           @param offset data offset in memory block, beginning from start of THIS memory block!
           @param secSize count of available data (bytes) in src */
         void Decode(unsigned int addr, int secSize);
@@ -75,6 +94,10 @@ class AvrFlash: public Memory {
         /*! True if flash was written, i.e. a program was loaded */
         bool IsProgramLoaded(void) { return flashLoaded; }
         
+        /*! Saves or restores flash content and RWW lock, see Snapshot. On
+          restore only changed words are decoded again. */
+        void SerializeState(Snapshot &snap);
+        
         /*! True if simulated Flash write is in progress and the address is in locked area. */
         bool IsRWWLock(unsigned int addr) { return (addr < rww_lock);}
         
@@ -82,6 +105,9 @@ class AvrFlash: public Memory {
           @param addr address, below flash is locked, 0 to disable lock */
         void SetRWWLock(unsigned int addr) { rww_lock = addr;}
         
+        /*! Returns true, if instruction at word index has 2 words (used by skip instructions) */
+        bool IsInstruction2Words(unsigned int index) const { return Decoded(index)->IsInstruction2Words(); }
+        
         /*! Returns instruction at pointer PC. Aborts if Flash write is in progress. */
         DecodedInstruction* GetInstruction(unsigned int pc);
         
@@ -98,6 +124,51 @@ class AvrFlash: public Memory {
         unsigned int ReadMemWord(unsigned int addr);
 
         bool LooksLikeContextSwitch(unsigned int addr) const;
+
+        /*! Maximum size of a basic block in words, longer straight code is split
+          into more blocks */
+        static const unsigned int maxBlockWords = 64;
+
+        /*! Returns size of the basic block starting at word index `pc'
+
+          A basic block is a sequence of instructions without any program flow
+          change in between, only the last instruction may jump, call, branch
+          or skip. The size is calculated on first request and cached till
+          Decode() changes a instruction inside the block.
+          @param pc word index of first instruction in block
+          @return count of words in block, 0 if there is no valid block */
+        unsigned int GetBlockSize(unsigned int pc) {
+            if(pc >= BlockSize.size())
+                return 0;
+            if(BlockSize[pc] == 0)
+                BlockSize[pc] = ScanBlock(pc);
+            return BlockSize[pc];
+        }
+
+        /*! Maximum size of a loop in words, which is checked by IsIdleLoop */
+        static const unsigned int maxIdleLoopWords = 16;
+
+        /*! Returns true, if the loop from word index `start' up to the jump back
+          on word index `end' contains only side effect free instructions
+
+          Such a loop could only change core registers and SREG, so it runs
+          the same way again and again, if one pass hasn't changed them. The
+          result is cached till Decode() changes a instruction inside the loop.
+          @param start word index of jump target
+          @param end word index of jump back instruction */
+        bool IsIdleLoop(unsigned int start, unsigned int end) {
+            if(end >= IdleLoop.size() || start > end || (end - start) >= maxIdleLoopWords)
+                return false;
+            if(IdleLoop[end] == 0)
+                IdleLoop[end] = ScanIdleLoop(start, end) ? 1 : 2;
+            return IdleLoop[end] == 1;
+        }
+
+    protected:
+        //! Calculates size of basic block starting at word index `pc'
+        unsigned int ScanBlock(unsigned int pc) const;
+        //! Checks all instructions in loop from `start' to `end', see IsIdleLoop
+        bool ScanIdleLoop(unsigned int start, unsigned int end) const;
 };
 
 #endif
@@ -28,6 +28,7 @@
 #include "systemclock.h"
 #include "avrmalloc.h"
 #include "flash.h"
+#include "snapshot.h"
 
 //#include <iostream>
 //using namespace std;
@@ -78,9 +79,6 @@ FlashProgramming::FlashProgramming(AvrDevice *c,
     
     // reset processing engine
     Reset();
-    
-    // add to cycle list
-    core->AddToCycleList(this);
 }
 
 FlashProgramming::~FlashProgramming() {
@@ -100,6 +98,9 @@ unsigned int FlashProgramming::CpuCycle() {
             return 1;
         ClearOperationBits();
     }
+    // remove from cycle list, if nothing to do
+    if(opr_enable_count == 0)
+        core->RemoveFromCycleList(this);
     return 0;
 }
 
@@ -111,6 +112,15 @@ void FlashProgramming::Reset() {
     timeout = 0;
 }
 
+void FlashProgramming::SerializeState(Snapshot &snap) {
+    snap.Value(spmcr_val);
+    snap.Value(opr_enable_count);
+    snap.Value(action);
+    snap.Value(spm_opr);
+    snap.Value(timeout);
+    snap.Block(tempBuffer, pageSize * 2);
+}
+
 unsigned char FlashProgramming::LPM_action(unsigned int xaddr, unsigned int addr) {
     return 0;
 }
@@ -156,6 +166,7 @@ int FlashProgramming::SPM_action(unsigned int data, unsigned int xaddr, unsigned
             timeout = SystemClock::Instance().GetCurrentTime() + FlashProgramming::SPM_TIMEOUT;
             // lock cpu while writing flash
             action = SPM_ACTION_LOCKCPU;
+            core->AddToCycleList(this);
             // lock RWW, if necessary
             SetRWWLock(addr);
             //cout << "write buffer: [0x" << hex << addr << "]" << endl;
@@ -172,6 +183,7 @@ int FlashProgramming::SPM_action(unsigned int data, unsigned int xaddr, unsigned
             timeout = SystemClock::Instance().GetCurrentTime() + FlashProgramming::SPM_TIMEOUT;
             // lock cpu while erasing flash
             action = SPM_ACTION_LOCKCPU;
+            core->AddToCycleList(this);
             // lock RWW, if necessary
             SetRWWLock(addr);
             //cout << "erase page: [0x" << hex << addr << "]" << endl;
@@ -227,6 +239,9 @@ void FlashProgramming::SetSpmcr(unsigned char v) {
                 break;
         }
     }
+    // add to cycle list, if operation is enabled
+    if(opr_enable_count > 0)
+        core->AddToCycleList(this);
     //cout << "spmcr=0x" << hex << (unsigned int)spmcr_val << "," << action << "," << spm_opr << endl;
 }
 
@@ -307,6 +322,12 @@ unsigned int AvrFuses::GetResetAddr(void) {
         return GetBLSStart();
 }
 
+void AvrFuses::SerializeState(Snapshot &snap) {
+    snap.Value(fuseBits);
+    snap.Value(flagBOOTRST);
+    snap.Value(valueBOOTSZ);
+}
+
 AvrLockBits::AvrLockBits(void):
     lockBitsSize(2),
     lockBits(0xff)
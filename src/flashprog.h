@@ -29,6 +29,7 @@
 #include "rwmem.h"
 #include "hardware.h"
 #include "systemclocktypes.h"
+#include "snapshot.h"
 
 class AvrDevice;
 
@@ -86,6 +87,7 @@ class FlashProgramming: public Hardware {
         
         unsigned int CpuCycle();
         void Reset();
+        void SerializeState(Snapshot &snap);
         
         unsigned char LPM_action(unsigned int xaddr, unsigned int addr);
         int SPM_action(unsigned int data, unsigned int xaddr, unsigned int addr);
@@ -131,6 +133,8 @@ class AvrFuses {
         unsigned int GetBLSStart(void);
         //! Get reset address
         unsigned int GetResetAddr(void);
+        //! Saves or restores fuse values, see Snapshot
+        void SerializeState(Snapshot &snap);
 
 };
 
@@ -151,6 +155,8 @@ class AvrLockBits {
         unsigned char GetLockByte(void) { return lockBits; }
         //! Set lock bits (from a SPM instruction)
         void SetLockBits(unsigned char bits);
+        //! Saves or restores lock bits, see Snapshot
+        void SerializeState(Snapshot &snap) { snap.Value(lockBits); }
 
 };
 
@@ -27,6 +27,8 @@
 #define HARDWARE
 
 class AvrDevice;
+class RWMemoryMember;
+class Snapshot;
 
 /*! Hardware objects are the subsystems of an AVR device. They have a clock and
   reset input and in addition will define various memory registers through
@@ -45,10 +47,30 @@ class Hardware {
           not be executed (e.g. a Flash write is in progress). */
         virtual unsigned int CpuCycle(void) { return 0; }
 
+        /*! Returns the count of following cycles, in which CpuCycle would do
+          nothing else than counting internal counters. Used to fast forward a
+          sleeping core. The default is 0, e.g. hardware has to be clocked on
+          every cycle. */
+        virtual unsigned long long CyclesIdle(void) { return 0; }
+
+        /*! Moves internal counters forward by the given count of cycles,
+          instead of calling CpuCycle for each cycle. Count is never greater
+          than the value returned by CyclesIdle just before. */
+        virtual void SkipCycles(unsigned long long cycles) {}
+
+        /*! Returns true, if the value of this register (owned by hardware) is
+          changed by SkipCycles, e.g. a counter register. */
+        virtual bool IsChangedBySkip(const RWMemoryMember *reg) { return false; }
+
         /*! Implement the hardware's reset functionality here. The default
           is no action on reset. */
         virtual void Reset(void) {};
 
+        /*! Saves or restores the internal state of the hardware, see
+          Snapshot. Configuration, which is set on creation of the device,
+          isn't part of it. The default is hardware without state. */
+        virtual void SerializeState(Snapshot &snap) {}
+
         /*! This signals the hardware that the given IRQ vector has been handled
           by the AVR core. */
         virtual void ClearIrqFlag(unsigned int vector) {}
@@ -100,6 +100,8 @@ class HWAcomp: public Hardware,
         void SetAcsr(unsigned char val);
         //! Reset the unit
         void Reset();
+        //! Saves or restores ACSR register and comparator state, see Snapshot
+        void SerializeState(Snapshot &snap) { snap.Value(enabled); snap.Value(acsr); snap.Value(acme_sfior); }
         //! Reflect irq processing, reset interrupt source
         void ClearIrqFlag(unsigned int vec);
         //! Get informed about input pin change
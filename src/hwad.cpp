@@ -26,6 +26,7 @@
 #include "hwad.h"
 #include "irqsystem.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 HWARefPin::HWARefPin(AvrDevice *_core):
     HWARef(_core),
@@ -315,7 +316,6 @@ HWAd::HWAd(AvrDevice *c, int _typ, HWIrqSystem *i, unsigned int iv, HWAdmux *a,
     admux_reg(this, "ADMUX", this, &HWAd::GetAdmux, &HWAd::SetAdmux) {
     mux->RegisterNotifyClient(this);
     irqSystem->DebugVerifyInterruptVector(irqVec, this);
-    core->AddToCycleList(this);
 
     Reset();
 }
@@ -331,6 +331,25 @@ void HWAd::Reset(void) {
     conversionState = 0;
     firstConversion = true;
     adchLocked = false;
+    // ADC is disabled, no need for cpu cycles
+    core->RemoveFromCycleList(this);
+}
+
+void HWAd::SerializeState(Snapshot &snap) {
+    snap.Value(adch);
+    snap.Value(adcl);
+    snap.Value(adcsra);
+    snap.Value(adcsrb);
+    snap.Value(admux);
+    snap.Value(adchLocked);
+    snap.Value(adSample);
+    snap.Value(adMuxConfig);
+    snap.Value(prescaler);
+    snap.Value(prescalerSelect);
+    snap.Value(conversionState);
+    snap.Value(firstConversion);
+    snap.Value(state);
+    mux->SerializeState(snap);
 }
 
 void HWAd::NotifySignalChanged(void) {
@@ -368,6 +387,14 @@ void HWAd::SetAdcsrA(unsigned char val) {
     if(!enabled && ((adcsra & ADEN) == ADEN))
         firstConversion = true;
 
+    // ADC needs cpu cycles only, if enabled. On disable prescaler remains in reset
+    if((adcsra & ADEN) == ADEN)
+        core->AddToCycleList(this);
+    else {
+        prescaler = 0;
+        core->RemoveFromCycleList(this);
+    }
+
     // handle interrupt, if fresh enabled
     if((adcsra & (ADIE | ADIF)) == (ADIE | ADIF))
         irqSystem->SetIrqFlag(this, irqVec);
@@ -28,6 +28,7 @@
 #include "systemclock.h"
 #include "irqsystem.h"
 #include "avrerror.h"
+#include "snapshot.h"
 #include <assert.h>
 
 using namespace std;
@@ -103,6 +104,20 @@ void HWEeprom::Reset() {
     cpuHoldCycles = 0;
 }
 
+void HWEeprom::SerializeState(Snapshot &snap) {
+    snap.Check("eeprom", size);
+    snap.Block(myMemory, size);
+    snap.Value(eear);
+    snap.Value(eecr);
+    snap.Value(eedr);
+    snap.Value(opEnableCycles);
+    snap.Value(cpuHoldCycles);
+    snap.Value(opState);
+    snap.Value(opMode);
+    snap.Value(opAddr);
+    snap.Value(writeDoneTime);
+}
+
 
 HWEeprom::~HWEeprom() {
     avr_free(myMemory);
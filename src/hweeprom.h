@@ -81,6 +81,8 @@ class HWEeprom: public Hardware, public Memory, public TraceValueRegister {
 
         virtual unsigned int CpuCycle();
         void Reset();
+        //! Saves or restores eeprom content and state machine, see Snapshot
+        void SerializeState(Snapshot &snap);
         void ClearIrqFlag(unsigned int vector);
 
         void WriteMem(const unsigned char *, unsigned int offset, unsigned int size);
@@ -102,6 +102,8 @@ class HWPcir : public HWPcifrApi , public HWPcirMaskApi , public Hardware {
 	private:	// Hardware
         void Reset();
         void ClearIrqFlag(unsigned int vector);
+        //! Saves or restores flag and control register (devices use ExternalIRQHandler, see there)
+        void SerializeState(Snapshot &snap) { snap.Value(_pcifr); snap.Value(_pcicr); }
 
 	
 	};
@@ -128,6 +130,9 @@ class HWPcmsk : public HWPcmskApi , public HWPcmskPinApi {
 	public: // HWPcmskPinApi
 		void			pinChanged(unsigned bit) throw();
 
+		//! Saves or restores mask, called by owner (this isn't a Hardware)
+		void			SerializeState(Snapshot &snap) { snap.Value(_pcmsk); }
+
         IOReg<HWPcmsk> pcmsk_reg;
 	};
 
@@ -149,6 +154,9 @@ class PinChange : public HasPinNotifyFunction {
 					HWPcmskPinApi&	pcmskPinApi,
 					unsigned		pcmskBit
 					) throw();
+
+		//! Saves or restores previous pin state, called by owner
+		void	SerializeState(Snapshot &snap) { snap.Value(_prevState); }
         
         
 	private:	// HasPinNotifyFunction
@@ -29,11 +29,14 @@ using namespace std;
 #include "hwport.h"
 #include "avrdevice.h"
 #include "avrerror.h"
+#include "snapshot.h"
+#include "executionhistory.h"
 #include <assert.h>
 
 HWPort::HWPort(AvrDevice *core, const string &name, bool portToggle, int size):
     Hardware(core),
     TraceValueRegister(core, "PORT" + name),
+    core(core),
     myName(name),
     portToggleFeature(portToggle),
     port_reg(this, "PORT",
@@ -47,6 +50,8 @@ HWPort::HWPort(AvrDevice *core, const string &name, bool portToggle, int size):
         size = 8;
     portSize = size;
     portMask = (unsigned char)((1 << size) - 1);
+    // polling a pin doesn't change anything, a idle loop could wait for it
+    pin_reg.SetReadSideEffectFree();
 
     for(unsigned int tt = 0; tt < portSize; tt++) {
         // register pin to give access to pin by name
@@ -88,16 +93,40 @@ void HWPort::Reset(void) {
     CalcOutputs();
 }
 
+void HWPort::SerializeState(Snapshot &snap) {
+    snap.Value(port);
+    snap.Value(ddr);
+    snap.Value(alternateDdr);
+    snap.Value(useAlternateDdr);
+    snap.Value(alternatePort);
+    snap.Value(useAlternatePort);
+    snap.Value(useAlternatePortIfDdrSet);
+    // output stages and pin register depend only on the registers above
+    // and connected nets
+    if(snap.IsRestoring())
+        CalcOutputs();
+}
+
 Pin& HWPort::GetPin(unsigned char pinNo) {
     return p[pinNo];
 }
 
 void HWPort::CalcPin(void) {
     // calculating the value for register "pin" from the Pin p[] array
+    ExecutionHistory *history = core->history;
+    if(history != NULL && history->IsReplaying()) {
+        // nets aren't touched in replay, inputs come from history
+        history->ReplayPortInputs(p, portSize);
+        return;
+    }
+    if(history != NULL)
+        history->BeginPortCalc();
     pin = 0;
     for(unsigned int tt = 0; tt < portSize; tt++) {
         if(p[tt].CalcPin()) pin |= (1 << tt);
     }
+    if(history != NULL)
+        history->EndPortCalc();
 }
 
 void HWPort::CalcOutputs(void) { // Calculate the new output value to be transmitted to the environment
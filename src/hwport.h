@@ -46,6 +46,7 @@ class HWPort: public Hardware, public TraceValueRegister {
         void CalcPin(void); //!< calculating the value for register "pin" from the Pin p[] array
         
     protected:
+        AvrDevice *core; //!< the device, which owns the port
         std::string myName; //!< the "name" of the port
 
         unsigned char port; //!< port output register
@@ -75,6 +76,8 @@ class HWPort: public Hardware, public TraceValueRegister {
         void CalcOutputs(void);  //!< Calculate the new output value to be transmitted to the environment
         std::string GetPortString(void); //!< returns a string representation of output states
         void Reset(void);
+        //! Saves or restores registers and output states, see Snapshot
+        void SerializeState(Snapshot &snap);
         std::string GetName(void) { return myName; } //!< returns the port name as given in constructor
         Pin& GetPin(unsigned char pinNo); //!< returns a pin reference of pin with pin number
         int GetPortSize(void) { return portSize; } //!< returns, how much bits this port controls
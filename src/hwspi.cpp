@@ -32,6 +32,7 @@
 #include "traceval.h"
 #include "irqsystem.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 //configuration
 #define SPIE 0x80
@@ -197,6 +198,21 @@ void HWSpi::Reset() {
     data_write=data_read=shift_in=0;
 }
 
+void HWSpi::SerializeState(Snapshot &snap) {
+    snap.Value(shift_in);
+    snap.Value(data_read);
+    snap.Value(data_write);
+    snap.Value(spsr);
+    snap.Value(spcr);
+    snap.Value(clkdiv);
+    snap.Value(spsr_read);
+    snap.Value(oldsck);
+    snap.Value(bitcnt);
+    snap.Value(clkcnt);
+    snap.Value(spi_cycles);
+    snap.Value(finished);
+}
+
 void HWSpi::ClearIrqFlag(unsigned int vector) {
     if (vector==irq_vector) {
         spsr&=~SPIF;
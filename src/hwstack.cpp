@@ -27,6 +27,8 @@
 #include "avrerror.h"
 #include "avrmalloc.h"
 #include "flash.h"
+#include "irqsystem.h"
+#include "snapshot.h"
 #include <assert.h>
 #include <cstdio>  // NULL
 
@@ -60,6 +62,43 @@ void HWStack::SetReturnPoint(unsigned long stackPointer, Funktor *f) {
     returnPointList.insert(make_pair(stackPointer, f));
 }
 
+void HWStack::SerializeState(Snapshot &snap) {
+    typedef multimap<unsigned long, Funktor *>::iterator I;
+
+    snap.Check("stack");
+    snap.Value(stackPointer);
+    snap.Value(lowestStackPointer);
+
+    // only end of interrupt handlers is known as return point
+    unsigned int count = 0;
+    for(I i = returnPointList.begin(); i != returnPointList.end(); i++)
+        if(dynamic_cast<IrqFunktor *>(i->second) != NULL)
+            count++;
+    snap.Value(count);
+    if(snap.IsRestoring()) {
+        for(I i = returnPointList.begin(); i != returnPointList.end(); i++)
+            delete i->second;
+        returnPointList.clear();
+        for(unsigned int n = 0; n < count; n++) {
+            unsigned long sp;
+            unsigned int vector;
+            snap.Value(sp);
+            snap.Value(vector);
+            SetReturnPoint(sp, new IrqFunktor(core->irqSystem, &HWIrqSystem::IrqHandlerFinished, vector));
+        }
+    } else {
+        for(I i = returnPointList.begin(); i != returnPointList.end(); i++) {
+            IrqFunktor *f = dynamic_cast<IrqFunktor *>(i->second);
+            if(f == NULL)
+                continue;
+            unsigned long sp = i->first;
+            unsigned int vector = f->GetVector();
+            snap.Value(sp);
+            snap.Value(vector);
+        }
+    }
+}
+
 HWStackSram::HWStackSram(AvrDevice *c, int bs, bool initRE):
     HWStack(c),
     TraceValueRegister(c, "STACK"),
@@ -100,6 +139,8 @@ void HWStackSram::Push(unsigned char val) {
     // measure stack usage, calculate lowest stack pointer
     if(lowestStackPointer > stackPointer)
         lowestStackPointer = stackPointer;
+    if(core->profiler != NULL)
+        core->profiler->StackPointer(stackPointer);
 }
 
 unsigned char HWStackSram::Pop() {
@@ -149,8 +190,11 @@ void HWStackSram::SetSpl(unsigned char val) {
     
     if(core->trace_on == 1)
         traceOut << "SP=0x" << hex << stackPointer << dec << " " ; 
-    if(oldSP != stackPointer)
+    if(oldSP != stackPointer) {
         m_ThreadList.OnSPWrite(stackPointer);
+        if(core->profiler != NULL)
+            core->profiler->StackPointer(stackPointer);
+    }
     CheckReturnPoints();
 }
 
@@ -166,8 +210,11 @@ void HWStackSram::SetSph(unsigned char val) {
 
     if(core->trace_on == 1)
         traceOut << "SP=0x" << hex << stackPointer << dec << " " ; 
-    if(oldSP != stackPointer)
+    if(oldSP != stackPointer) {
         m_ThreadList.OnSPWrite(stackPointer);
+        if(core->profiler != NULL)
+            core->profiler->StackPointer(stackPointer);
+    }
     CheckReturnPoints();
 }
 
@@ -196,6 +243,11 @@ ThreeLevelStack::~ThreeLevelStack() {
     avr_free(stackArea);
 }
 
+void ThreeLevelStack::SerializeState(Snapshot &snap) {
+    HWStack::SerializeState(snap);
+    snap.Block(stackArea, 3 * sizeof(unsigned long));
+}
+
 void ThreeLevelStack::Reset(void) {
     returnPointList.clear();
     stackPointer = 3;
@@ -33,6 +33,8 @@
 
 #include <map>
 
+class Snapshot;
+
 /** A thread automatically detected in simulated program.
 * We keep track of them in core->stack.m_ThreadList.m_threads[] and
 * report them to GDB.
@@ -111,6 +113,8 @@ class HWStack {
         virtual unsigned long PopAddr()=0; //!< Pops a address from stack
 
         virtual void Reset(); //!< Resets stack pointer and listener table
+        //! Saves or restores stack pointer and return points of running interrupt handlers, see Snapshot
+        virtual void SerializeState(Snapshot &snap);
 
         //! Returns current stack pointer value
         unsigned long GetStackPointer() const { return stackPointer; }
@@ -171,6 +175,7 @@ class ThreeLevelStack: public HWStack, public TraceValueRegister {
         virtual unsigned long PopAddr();
 
         virtual void Reset();
+        virtual void SerializeState(Snapshot &snap);
 };
 
 #endif
@@ -29,6 +29,7 @@
 #include "hwtimer.h"
 #include "../helper.h"
 #include "systemclock.h"
+#include "snapshot.h"
 
 #include <cstdlib>
 #include <time.h>
@@ -82,6 +83,16 @@ BasicTimerUnit::BasicTimerUnit(AvrDevice *core,
     icapNCcounter = 0;
     icapNCstate = false;
     
+    // timer is in cycle list, while it's clocked
+    scheduled = false;
+    lastCycle = 0;
+    nextPulseCycle = 0;
+    pulseDivider = 1;
+    
+    // capture pin wakes up timer
+    if(icapSource != NULL)
+        icapSource->RegisterTimer(core, this);
+    
     // reset internal values
     Reset();
     
@@ -194,7 +205,32 @@ void BasicTimerUnit::InputCapture(void) {
     }
 }
 
+void BasicTimerUnit::UpdateCounter(void) {
+    if(scheduled)
+        CatchUp(core->GetCycleCount());
+}
+
+void BasicTimerUnit::WakeUp(void) {
+    if(scheduled) {
+        CatchUp(core->GetCycleCount());
+        scheduled = false;
+        core->WakeUpHardware(this);
+    }
+}
+
+void BasicTimerUnit::CatchUp(unsigned long long cycle) {
+    if(cycle <= lastCycle)
+        return;
+    if(cycle >= nextPulseCycle) {
+        unsigned long long pulses = (cycle - nextPulseCycle) / pulseDivider + 1;
+        nextPulseCycle += pulses * pulseDivider;
+        SkipPulses((unsigned long)pulses);
+    }
+    lastCycle = cycle;
+}
+
 void BasicTimerUnit::SetClockMode(int mode) {
+    WakeUp();
     cs = mode;
     if(cs != 0) {
         core->AddToCycleList(this);
@@ -204,6 +240,7 @@ void BasicTimerUnit::SetClockMode(int mode) {
 }
 
 void BasicTimerUnit::SetCounter(unsigned long val) {
+    WakeUp();
     vtcnt = val;
     vlast_tcnt = 0x10000; // set to a invalid value!
     counterTrace->change(val);
@@ -544,6 +581,7 @@ void BasicTimerUnit::WGMfunc_pfcpwm(CEtype event) {
 }
 
 void BasicTimerUnit::Reset() {
+    scheduled = false;
     vtcnt = 0;
     limit_bottom = 0;
     limit_top = limit_max;
@@ -562,13 +600,138 @@ void BasicTimerUnit::Reset() {
     icapNoiseCanceler = false;
 }
 
+void BasicTimerUnit::SerializeState(Snapshot &snap) {
+    snap.Value(cs);
+    snap.Value(captureInputState);
+    snap.Value(icapNCcounter);
+    snap.Value(icapNCstate);
+    snap.Value(scheduled);
+    snap.Value(lastCycle);
+    snap.Value(nextPulseCycle);
+    snap.Value(pulseDivider);
+    snap.Value(vtcnt);
+    snap.Value(vlast_tcnt);
+    snap.Value(updown_counting);
+    snap.Value(count_down);
+    snap.Value(limit_bottom);
+    snap.Value(limit_top);
+    snap.Value(limit_max);
+    snap.Value(icapRegister);
+    snap.Value(icapRisingEdge);
+    snap.Value(icapNoiseCanceler);
+    snap.Value(wgm);
+    snap.Value(compare);
+    snap.Value(compare_dbl);
+    snap.Value(compareEnable);
+    snap.Value(com);
+    snap.Value(compare_output_state);
+    premx->SerializeState(snap);
+    if(icapSource != NULL)
+        icapSource->SerializeState(snap);
+}
+
 unsigned int BasicTimerUnit::CpuCycle() {
+    unsigned long long cycle = core->GetCycleCount();
+    if(scheduled) {
+        // count the pulses, while timer was out of cycle list
+        CatchUp(cycle - 1);
+        scheduled = false;
+    }
+    // timer has joined cycle list again after it was counted in this cycle
+    if(cycle == lastCycle)
+        return 0;
+    lastCycle = cycle;
+
     if(premx->isClock(cs))
         CountTimer();
     InputCapture();
+
+    // nothing else than counting till the next event, leave cycle list till then
+    unsigned int divider, offset;
+    unsigned long long idle = CyclesIdle();
+    if(idle > 0 && premx->GetClockPhase(cs, divider, offset) &&
+       core->ScheduleHardware(this, cycle + idle + 1)) {
+        scheduled = true;
+        nextPulseCycle = cycle + 1 + offset;
+        pulseDivider = divider;
+    }
     return 0;
 }
 
+bool BasicTimerUnit::InputCaptureIdle(void) {
+    if(icapSource == NULL || WGMuseICR())
+        return true;
+    // analog comparator output has to be polled
+    if(!icapSource->IsChangeNotified())
+        return false;
+    bool state = icapSource->GetSourceState();
+    if(state != captureInputState)
+        return false;
+    // noise canceler has to see the input for 4 cycles
+    return !icapNoiseCanceler || (icapNCstate == state && icapNCcounter >= 4);
+}
+
+unsigned long long BasicTimerUnit::CyclesIdle(void) {
+    unsigned int divider, offset;
+    if(!InputCaptureIdle() || !premx->GetClockPhase(cs, divider, offset))
+        return 0;
+
+    // next counter value, on which the count pulse causes a event
+    unsigned long next, pulses;
+    if(updown_counting && count_down) {
+        // counts down to BOTTOM
+        if(limit_bottom > vtcnt)
+            return 0;
+        next = limit_bottom;
+        if(limit_top <= vtcnt && limit_top > next)
+            next = limit_top;
+        for(int i = 0; i < OCRIDX_maxUnits; i++) {
+            if(compareEnable[i] && compare[i] <= vtcnt && compare[i] > next)
+                next = compare[i];
+        }
+        pulses = vtcnt - next;
+    } else {
+        // counts up to TOP (up/down counting) or till limit_max overflows
+        next = updown_counting ? limit_top : limit_max;
+        if(next < vtcnt)
+            return 0;
+        if(limit_bottom >= vtcnt && limit_bottom < next)
+            next = limit_bottom;
+        if(limit_top >= vtcnt && limit_top < next)
+            next = limit_top;
+        for(int i = 0; i < OCRIDX_maxUnits; i++) {
+            if(compareEnable[i] && compare[i] >= vtcnt && compare[i] < next)
+                next = compare[i];
+        }
+        pulses = next - vtcnt;
+    }
+
+    // count pulses without event, the pulse with event must be processed by CpuCycle
+    return offset + (unsigned long long)pulses * divider;
+}
+
+void BasicTimerUnit::SkipCycles(unsigned long long cycles) {
+    unsigned int divider, offset;
+    if(!premx->GetClockPhase(cs, divider, offset) || cycles <= offset)
+        return;
+    SkipPulses((unsigned long)((cycles - offset - 1) / divider + 1));
+}
+
+void BasicTimerUnit::SkipPulses(unsigned long pulses) {
+    if(updown_counting && count_down) {
+        vtcnt -= pulses;
+        vlast_tcnt = vtcnt + 1;
+        if(vtcnt == limit_bottom)
+            count_down = false; // now count up
+    } else {
+        vtcnt += pulses;
+        vlast_tcnt = vtcnt - 1;
+        if(updown_counting && vtcnt == limit_top)
+            count_down = true; // now count down
+    }
+    counterTrace->change(vtcnt);
+}
+
 void BasicTimerUnit::RegisterACompForICapture(HWAcomp *acomp) {
     if(icapSource != NULL)
         icapSource->RegisterAComp(acomp);
@@ -619,6 +782,7 @@ void HWTimer8::Reset(void) {
 }
 
 void HWTimer8::ChangeWGM(WGMtype mode) {
+    WakeUp();
     wgm = mode;
     switch(wgm) {
         case WGM_PCPWM_9BIT:
@@ -660,6 +824,7 @@ void HWTimer8::ChangeWGM(WGMtype mode) {
 }
 
 void HWTimer8::SetCompareRegister(int idx, unsigned char val) {
+    WakeUp();
     if(WGMisPWM())
         compare_dbl[idx] = val;
     else {
@@ -766,11 +931,17 @@ void HWTimer16::Reset(void) {
     accessTempRegister = 0;
 }
 
+void HWTimer16::SerializeState(Snapshot &snap) {
+    BasicTimerUnit::SerializeState(snap);
+    snap.Value(accessTempRegister);
+}
+
 void HWTimer16::SetCompareRegister(int idx, bool high, unsigned char val) {
     unsigned long temp;
     if(high) {
         accessTempRegister = val;
     } else {
+        WakeUp();
         temp = (accessTempRegister << 8) + val;
         if(WGMisPWM())
             compare_dbl[idx] = temp;
@@ -806,6 +977,7 @@ void HWTimer16::SetComplexRegister(bool is_icr, bool high, unsigned char val) {
     } else {
         if(is_icr) {
             if(WGMuseICR()) {
+                WakeUp();
                 icapRegister = (accessTempRegister << 8) + val;
                 if(wgm == WGM_FASTPWM_ICR)
                     limit_top = icapRegister;
@@ -824,6 +996,7 @@ unsigned char HWTimer16::GetComplexRegister(bool is_icr, bool high) {
             accessTempRegister =  (icapRegister >> 8) & 0xff;
             return icapRegister & 0xff;
         } else {
+            UpdateCounter();
             accessTempRegister =  (vtcnt >> 8) & 0xff;
             return vtcnt & 0xff;
         }
@@ -831,6 +1004,7 @@ unsigned char HWTimer16::GetComplexRegister(bool is_icr, bool high) {
 }
 
 void HWTimer16::ChangeWGM(WGMtype mode) {
+    WakeUp();
     wgm = mode;
     switch(wgm) {
         case WGM_RESERVED:
@@ -932,6 +1106,11 @@ void HWTimer8_0C::Reset() {
     tccr_val = 0;
 }
 
+void HWTimer8_0C::SerializeState(Snapshot &snap) {
+    HWTimer8::SerializeState(snap);
+    snap.Value(tccr_val);
+}
+
 HWTimer8_1C::HWTimer8_1C(AvrDevice *core,
                          PrescalerMultiplexer *p,
                          int unit,
@@ -967,6 +1146,11 @@ void HWTimer8_1C::Reset() {
     tccr_val = 0;
 }
 
+void HWTimer8_1C::SerializeState(Snapshot &snap) {
+    HWTimer8::SerializeState(snap);
+    snap.Value(tccr_val);
+}
+
 HWTimer8_2C::HWTimer8_2C(AvrDevice *core,
                          PrescalerMultiplexer *p,
                          int unit,
@@ -1037,6 +1221,13 @@ void HWTimer8_2C::Reset() {
     wgm_raw = 0;
 }
 
+void HWTimer8_2C::SerializeState(Snapshot &snap) {
+    HWTimer8::SerializeState(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+    snap.Value(wgm_raw);
+}
+
 HWTimer16_1C::HWTimer16_1C(AvrDevice *core,
                            PrescalerMultiplexer *p,
                            int unit,
@@ -1100,6 +1291,13 @@ void HWTimer16_1C::Reset() {
     wgm_raw = 0;
 }
 
+void HWTimer16_1C::SerializeState(Snapshot &snap) {
+    HWTimer16::SerializeState(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+    snap.Value(wgm_raw);
+}
+
 HWTimer16_2C2::HWTimer16_2C2(AvrDevice *core,
                              PrescalerMultiplexer *p,
                              int unit,
@@ -1181,6 +1379,13 @@ void HWTimer16_2C2::Reset() {
     wgm_raw = 0;
 }
 
+void HWTimer16_2C2::SerializeState(Snapshot &snap) {
+    HWTimer16::SerializeState(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+    snap.Value(wgm_raw);
+}
+
 HWTimer16_2C3::HWTimer16_2C3(AvrDevice *core,
                              PrescalerMultiplexer *p,
                              int unit,
@@ -1241,6 +1446,12 @@ void HWTimer16_2C3::Reset() {
     tccrb_val = 0;
 }
 
+void HWTimer16_2C3::SerializeState(Snapshot &snap) {
+    HWTimer16::SerializeState(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+}
+
 HWTimer16_3C::HWTimer16_3C(AvrDevice *core,
                            PrescalerMultiplexer *p,
                            int unit,
@@ -1307,6 +1518,12 @@ void HWTimer16_3C::Reset() {
     tccrb_val = 0;
 }
 
+void HWTimer16_3C::SerializeState(Snapshot &snap) {
+    HWTimer16::SerializeState(snap);
+    snap.Value(tccra_val);
+    snap.Value(tccrb_val);
+}
+
 //! Step time in ns for async clock by pll
 /*! Because system clock steps are counted in ns, we have to calculate so many steps to get
  * over all steps a time in ns without fraction. For 64MHz, e.g. 15,625 ns period, this step
@@ -1412,6 +1629,47 @@ void HWTimerTinyX5::Reset() {
     SetPrescalerClock(false); // reset prescaler to sync. clock mode, if necessary!
 }
 
+void HWTimerTinyX5::SerializeState(Snapshot &snap) {
+    snap.Value(counter);
+    snap.Value(prescaler);
+    snap.Value(dtprescaler);
+    tccr_inout_val.SerializeState(snap);
+    ocra_inout_val.SerializeState(snap);
+    ocrb_inout_val.SerializeState(snap);
+    ocrc_inout_val.SerializeState(snap);
+    gtccr_in_val.SerializeState(snap);
+    snap.Value(dtps1_inout_val);
+    dt1a_inout_val.SerializeState(snap);
+    dt1b_inout_val.SerializeState(snap);
+    snap.Value(tcnt_out_val);
+    snap.Value(tcnt_out_async_tmp);
+    snap.Value(tcnt_in_val);
+    snap.Value(tcnt_set_flag);
+    snap.Value(tov_internal_flag);
+    snap.Value(tocra_internal_flag);
+    snap.Value(tocrb_internal_flag);
+    snap.Value(ocra_internal_val);
+    snap.Value(ocra_compare);
+    ocra_unit.SerializeState(snap);
+    snap.Value(ocrb_internal_val);
+    snap.Value(ocrb_compare);
+    ocrb_unit.SerializeState(snap);
+    snap.Value(cfg_prescaler);
+    snap.Value(cfg_dtprescaler);
+    snap.Value(cfg_mode);
+    snap.Value(cfg_ctc);
+    snap.Value(cfg_com_a);
+    snap.Value(cfg_com_b);
+    snap.Value(asyncClock_step);
+    snap.Value(asyncClock_async);
+    snap.Value(asyncClock_lsm);
+    snap.Value(asyncClock_pll);
+    snap.Value(asyncClock_plllock);
+    snap.Value(asyncClock_locktime);
+    // in async mode the timer has it's own place in time table
+    SystemClock::Instance().SerializeMember(snap, this);
+}
+
 int HWTimerTinyX5::Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns) {
     if(asyncClock_async) {
         *nextStepIn_ns = HWTimerTinyX5_nextdelay[asyncClock_step];
@@ -1762,6 +2020,15 @@ void TimerTinyX5_OCR::Reset() {
     dtCounter = 0;
 }
 
+void TimerTinyX5_OCR::SerializeState(Snapshot &snap) {
+    snap.Value(ocrComMode);
+    snap.Value(ocrPWM);
+    snap.Value(ocrOut);
+    snap.Value(dtHigh);
+    snap.Value(dtLow);
+    snap.Value(dtCounter);
+}
+
 void TimerTinyX5_OCR::DTClockCycle() {
     if(dtCounter > 0) {
         dtCounter--;
@@ -46,6 +46,17 @@ class BasicTimerUnit: public Hardware, public TraceValueRegister {
         bool captureInputState; //!< saved state for input capture
         int icapNCcounter; //!< counter for input capture noise canceler
         bool icapNCstate; //!< state for input capture noise canceler
+        bool scheduled; //!< timer has left cycle list till next event, see AvrDevice::ScheduleHardware
+        unsigned long long lastCycle; //!< last core cycle, which is counted
+        unsigned long long nextPulseCycle; //!< core cycle of next count pulse, while scheduled
+        unsigned int pulseDivider; //!< core cycles between two count pulses, while scheduled
+
+        //! Counts the pulses till core cycle `cycle', while timer is scheduled
+        void CatchUp(unsigned long long cycle);
+        //! Moves counter forward by count pulses without events
+        void SkipPulses(unsigned long pulses);
+        //! Returns true, if input capture can't happen till the input changes
+        bool InputCaptureIdle(void);
         
     protected:
         //! types of waveform generation modes
@@ -134,6 +145,10 @@ class BasicTimerUnit: public Hardware, public TraceValueRegister {
           for at least one counting cycle. It can happen, that more than one event
           could occur in the same count cycle! */
         void HandleEvent(CEtype event) { (this->*wgmfunc[wgm])(event); }
+        //! Counts the pulses, missed while scheduled, called before counter is read
+        void UpdateCounter(void);
+        //! Puts timer back into cycle list, called before timer settings are changed
+        void WakeUp(void);
         //! Set clock mode
         void SetClockMode(int _cs);
         //! Set the counter itself
@@ -174,15 +189,31 @@ class BasicTimerUnit: public Hardware, public TraceValueRegister {
         ~BasicTimerUnit();
         //! Perform a reset of this unit
         void Reset();
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
         
         //! Process timer/counter unit operations by CPU cycle
+        /*! Called on core cycles, while the timer is clocked (clock select
+          isn't 0). After a cycle the timer leaves cycle list till the cycle
+          of the next event (see CyclesIdle), counter is caught up from core
+          cycle count, if it's read or timer settings are changed. */
         virtual unsigned int CpuCycle();
+        //! Returns count of cycles till next timer event, if timer counts core clock
+        /*! Returns 0 (timer has to be clocked every cycle), if input capture
+          is possible by analog comparator or after a change on capture pin,
+          which isn't seen by noise canceler so far, or if the timer isn't
+          clocked by prescaled core clock (external clock pin). The async
+          timer of HWTimerTinyX5 doesn't implement CyclesIdle, it returns 0
+          too. */
+        virtual unsigned long long CyclesIdle(void);
+        //! Counts timer for the given count of cycles without events
+        virtual void SkipCycles(unsigned long long cycles);
 
         //! register analog comparator unit for input capture source
         void RegisterACompForICapture(HWAcomp *acomp);
 
         //! reflect ACIC flag to input capture source
-        void SetACIC(bool acic) { if(icapSource != NULL) icapSource->SetACIC(acic); }
+        void SetACIC(bool acic) { if(icapSource != NULL) { WakeUp(); icapSource->SetACIC(acic); } }
 };
 
 //! Extends BasicTimerUnit to provide common support to all types of 8Bit timer units
@@ -200,7 +231,7 @@ class HWTimer8: public BasicTimerUnit {
         //! Register access to set counter register high byte
         void Set_TCNT(unsigned char val) { SetCounter(val); }
         //! Register access to read counter register high byte
-        unsigned char Get_TCNT() { return vtcnt & 0xff; }
+        unsigned char Get_TCNT() { UpdateCounter(); return vtcnt & 0xff; }
 
         //! Register access to set output compare register A
         void Set_OCRA(unsigned char val) { SetCompareRegister(0, val); }
@@ -227,6 +258,8 @@ class HWTimer8: public BasicTimerUnit {
                  PinAtPort* outB);
         //! Perform a reset of this unit
         void Reset();
+        //! Counter register is changed by SkipCycles
+        bool IsChangedBySkip(const RWMemoryMember *reg) { return reg == &tcnt_reg; }
 };
 
 //! Extends BasicTimerUnit to provide common support to all types of 16Bit timer units
@@ -319,6 +352,10 @@ class HWTimer16: public BasicTimerUnit {
                   ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
+        //! Counter registers are changed by SkipCycles
+        bool IsChangedBySkip(const RWMemoryMember *reg) { return reg == &tcnt_h_reg || reg == &tcnt_l_reg; }
 };
 
 //! Timer unit with 8Bit counter and no output compare unit
@@ -350,6 +387,8 @@ class HWTimer8_0C: public HWTimer8 {
                     IRQLine* tov);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
 };
 
 //! Timer unit with 8Bit counter and one output compare unit
@@ -382,6 +421,8 @@ class HWTimer8_1C: public HWTimer8 {
                     PinAtPort* outA);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
 };
 
 //! Timer unit with 8Bit counter and 2 output compare unit
@@ -436,6 +477,8 @@ class HWTimer8_2C: public HWTimer8 {
                     PinAtPort* outB);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
 };
 
 //! Timer unit with 16Bit counter and one output compare unit
@@ -490,6 +533,8 @@ class HWTimer16_1C: public HWTimer16 {
                      ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
 };
 
 //! Timer unit with 16Bit counter and 2 output compare units and 2 config registers
@@ -552,6 +597,8 @@ class HWTimer16_2C2: public HWTimer16 {
                       bool is_at8515);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
 };
 
 //! Timer unit with 16Bit counter and 2 output compare units, but 3 config registers
@@ -615,6 +662,8 @@ class HWTimer16_2C3: public HWTimer16 {
                       ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
 };
 
 //! Timer unit with 16Bit counter and 3 output compare units
@@ -680,6 +729,8 @@ class HWTimer16_3C: public HWTimer16 {
                      ICaptureSource* icapsrc);
         //! Perform a reset of this unit
         void Reset(void);
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
 };
 
 //! PWM output unit for timer 1 on ATtiny25/45/85
@@ -709,6 +760,8 @@ class TimerTinyX5_OCR {
 
         //! Reset internal states on device reset
         void Reset();
+        //! Saves or restores internal states, see Snapshot
+        void SerializeState(Snapshot &snap);
 
         //! Run one clock cycle from dead time prescaler
         void DTClockCycle();
@@ -755,6 +808,9 @@ class HWTimerTinyX5_SyncReg {
 
         //! Mask out a value inside sync area and do not force a change event
         void MaskOutSync(unsigned char mask) { inValue &= ~mask; regValue = inValue; }
+
+        //! Saves or restores both register values, see Snapshot
+        void SerializeState(Snapshot &snap) { snap.Value(inValue); snap.Value(regValue); }
 };
 
 //! timer unit for timer 1 on ATtiny25/45/85
@@ -920,8 +976,12 @@ class HWTimerTinyX5: public Hardware,
 
         //! Performs the async clocking, if necessary
         int Step(bool &untilCoreStepFinished, SystemClockOffset *nextStepIn_ns);
+        //! Async clock is part of the device, see SimulationMember::GetOwnerDevice
+        AvrDevice *GetOwnerDevice(void) { return core; }
         //! Perform a reset of this unit
         void Reset();
+        //! Saves or restores timer state, see Snapshot
+        void SerializeState(Snapshot &snap);
         //! Process timer/counter unit operations by CPU cycle
         unsigned int CpuCycle();
 };
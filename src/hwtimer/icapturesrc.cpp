@@ -25,11 +25,25 @@
 
 #include "icapturesrc.h"
 #include "hwacomp.h"
+#include "../avrdevice.h"
 
 ICaptureSource::ICaptureSource(PinAtPort cp):
     capturePin(cp),
     acomp(NULL),
-    acic(false) {}
+    acic(false),
+    core(NULL),
+    timer(NULL) {}
+
+void ICaptureSource::RegisterTimer(AvrDevice *_core, Hardware *_timer) {
+    core = _core;
+    timer = _timer;
+    capturePin.GetPin().RegisterCallback(this);
+}
+
+void ICaptureSource::PinStateHasChanged(Pin *p) {
+    if(timer != NULL)
+        core->WakeUpHardware(timer);
+}
 
 bool ICaptureSource::GetSourceState(void) {
     if(acic && acomp != NULL)
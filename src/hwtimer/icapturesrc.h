@@ -27,16 +27,22 @@
 #define ICAPTURESRC
 
 #include "../pinatport.h"
+#include "../pinnotify.h"
+#include "../snapshot.h"
 
 class HWAcomp;
+class AvrDevice;
+class Hardware;
 
 //! Class, which provides input capture source for 16bit timers
-class ICaptureSource {
+class ICaptureSource: public HasPinNotifyFunction {
     
     protected:
         PinAtPort capturePin;
         HWAcomp *acomp;
         bool acic;
+        AvrDevice *core; //!< device of timer
+        Hardware *timer; //!< timer, which is woken up on change of capture pin
   
     public:
         ICaptureSource(PinAtPort cp);
@@ -45,11 +51,25 @@ class ICaptureSource {
         //! Returns the digital input state of input capture source(s)
         virtual bool GetSourceState(void);
 
+        //! Register timer, which is woken up on change of capture pin, see AvrDevice::WakeUpHardware
+        void RegisterTimer(AvrDevice *core, Hardware *timer);
+
+        //! Returns true, if a change of source state wakes up the timer
+        /*! False, if analog comparator is source, it's output has to be
+          polled. */
+        bool IsChangeNotified(void) const { return !(acic && acomp != NULL); }
+
+        //! Wakes up timer, see HasPinNotifyFunction
+        void PinStateHasChanged(Pin *p);
+
         //! Register analog comparator
         void RegisterAComp(HWAcomp *_acomp) { acomp = _acomp; }
 
         //! Reflect ACIC flag state
         void SetACIC(bool _acic) { acic = _acic; }
+
+        //! Saves or restores ACIC flag state, see Snapshot
+        void SerializeState(Snapshot &snap) { snap.Value(acic); }
 };
 
 #endif
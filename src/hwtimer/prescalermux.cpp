@@ -62,6 +62,26 @@ bool PrescalerMultiplexer::isClock(unsigned int cs) {
     }
 }
 
+unsigned int PrescalerMultiplexer::GetDivider(unsigned int cs) {
+    static const unsigned int dividers[8] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+    return (cs < 8) ? dividers[cs] : 0;
+}
+
+bool PrescalerMultiplexer::GetClockPhase(unsigned int cs, unsigned int &divider, unsigned int &offset) {
+    divider = GetDivider(cs);
+    if(divider == 0)
+        return false;
+    offset = 0;
+    if(divider == 1)
+        return true; // clock on every cycle, independent from prescaler
+    if(!prescaler->IsCoreClocked())
+        return false;
+    // prescaler value in next cycle
+    unsigned int pv = (prescaler->GetValue() + 1) % 1024;
+    offset = (divider - (pv % divider)) % divider;
+    return true;
+}
+
 PrescalerMultiplexerExt::PrescalerMultiplexerExt(HWPrescaler *ps, PinAtPort pi):
     PrescalerMultiplexer(ps),
     clkpin(pi) {
@@ -105,6 +125,12 @@ bool PrescalerMultiplexerExt::isClock(unsigned int cs) {
     }
 }
 
+unsigned int PrescalerMultiplexerExt::GetDivider(unsigned int cs) {
+    // external pin clock (cs 6 and 7) can't be calculated
+    static const unsigned int dividers[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+    return (cs < 8) ? dividers[cs] : 0;
+}
+
 PrescalerMultiplexerT15::PrescalerMultiplexerT15(HWPrescaler *ps):
     PrescalerMultiplexer(ps) {}
 
@@ -44,6 +44,18 @@ class PrescalerMultiplexer {
         //! @param cs multiplexer select value
         //! @return true, if a clock event occured
         virtual bool isClock(unsigned int cs);
+        //! Returns the prescaler divider for cs
+        //! @param cs multiplexer select value
+        //! @return count of core cycles between clock events, 0 if not derived from core clock
+        virtual unsigned int GetDivider(unsigned int cs);
+        //! Calculates clock events for the following core cycles
+        //! @param cs multiplexer select value
+        //! @param divider count of core cycles between two clock events
+        //! @param offset count of core cycles before the next clock event
+        //! @return false, if clock events can't be calculated
+        bool GetClockPhase(unsigned int cs, unsigned int &divider, unsigned int &offset);
+        //! Saves or restores internal state, see Snapshot
+        virtual void SerializeState(Snapshot &snap) {}
     
 };
 
@@ -61,6 +73,8 @@ class PrescalerMultiplexerExt: public PrescalerMultiplexer {
         //! Creates a multiplexer instance with a count input pin, connected with prescaler
         PrescalerMultiplexerExt(HWPrescaler *ps, PinAtPort pi);
         virtual bool isClock(unsigned int cs);
+        virtual unsigned int GetDivider(unsigned int cs);
+        virtual void SerializeState(Snapshot &snap) { snap.Value(clkpin_old); }
     
 };
 
@@ -72,6 +86,7 @@ class PrescalerMultiplexerT15: public PrescalerMultiplexer {
         //! Creates a multiplexer instance for timer 1 on ATTiny15, connected with prescaler
         PrescalerMultiplexerT15(HWPrescaler *ps);
         virtual bool isClock(unsigned int cs);
+        virtual unsigned int GetDivider(unsigned int cs) { return 0; }
     
 };
 
@@ -25,15 +25,40 @@
 
 #include "timerprescaler.h"
 #include "traceval.h"
+#include "snapshot.h"
+
+//! Trace value for HWPrescaler, counter value is calculated on request
+class PrescalerTraceValue: public TraceValue {
+    public:
+        PrescalerTraceValue(const std::string &name, HWPrescaler *p):
+            TraceValue(16, name),
+            prescaler(p) {}
+
+        virtual void cycle() {
+            change(prescaler->GetValue());
+            set_written();
+        }
+        virtual bool polled() const { return true; }
+
+    private:
+        HWPrescaler *prescaler;
+};
+
+static void trace_prescaler(AvrDevice *core, const std::string &tracename, HWPrescaler *p) {
+    TraceValueRegister *t = &(core->coreTraceGroup);
+    t->RegisterTraceValue(new PrescalerTraceValue(t->GetTraceValuePrefix() + "PRESCALER" + tracename, p));
+}
 
 HWPrescaler::HWPrescaler(AvrDevice *core, const std::string &tracename):
     Hardware(core),
     _resetBit(-1),
     _resetSyncBit(-1),
-    countEnable(true)
+    _core(core),
+    countEnable(true),
+    countCoreClock(true)
 {
-    core->AddToCycleList(this);
-    trace_direct(&(core->coreTraceGroup), "PRESCALER" + tracename, &preScaleValue);
+    Reset();
+    trace_prescaler(core, tracename, this);
     resetRegister = NULL;
 }
 
@@ -44,10 +69,12 @@ HWPrescaler::HWPrescaler(AvrDevice *core,
     Hardware(core),
     _resetBit(resetBit),
     _resetSyncBit(-1),
-    countEnable(true)
+    _core(core),
+    countEnable(true),
+    countCoreClock(true)
 {
-    core->AddToCycleList(this);
-    trace_direct(&(core->coreTraceGroup), "PRESCALER" + tracename, &preScaleValue);
+    Reset();
+    trace_prescaler(core, tracename, this);
     resetRegister = ioreg;
     ioreg->connectSRegClient(this);
 }
@@ -60,10 +87,12 @@ HWPrescaler::HWPrescaler(AvrDevice *core,
     Hardware(core),
     _resetBit(resetBit),
     _resetSyncBit(resetSyncBit),
-    countEnable(true)
+    _core(core),
+    countEnable(true),
+    countCoreClock(true)
 {
-    core->AddToCycleList(this);
-    trace_direct(&(core->coreTraceGroup), "PRESCALER" + tracename, &preScaleValue);
+    Reset();
+    trace_prescaler(core, tracename, this);
     resetRegister = ioreg;
     ioreg->connectSRegClient(this);
 }
@@ -79,6 +108,9 @@ unsigned char HWPrescaler::set_from_reg(const IOSpecialReg *reg, unsigned char n
         sync = (1 << _resetSyncBit) & nv;
     
     if(reset) {
+        // timers, which have left cycle list, count with the old prescaler phase
+        _core->WakeUpAllHardware();
+        UpdateValue();
         Reset();  // reset requested
         if(sync)
             countEnable = false; // sync asserted, stop counting
@@ -90,6 +122,13 @@ unsigned char HWPrescaler::set_from_reg(const IOSpecialReg *reg, unsigned char n
     return nv;  // return value unchanged
 }
 
+void HWPrescaler::SerializeState(Snapshot &snap) {
+    snap.Value(preScaleValue);
+    snap.Value(preScaleCycle);
+    snap.Value(countEnable);
+    snap.Value(countCoreClock);
+}
+
 HWPrescalerAsync::HWPrescalerAsync(AvrDevice *core,
                                    const std::string &tracename,
                                    PinAtPort tosc,
@@ -126,12 +165,11 @@ HWPrescalerAsync::HWPrescalerAsync(AvrDevice *core,
 }
 
 unsigned int HWPrescalerAsync::CpuCycle() {
+    // only in cycle list, if external clock is selected
     bool e = true;
-    if(clockselect) {
-      bool ps = tosc_pin.GetPin();
-      if(pinstate || !ps) e = false; // count on positive edge!
-      pinstate = ps;
-    }
+    bool ps = tosc_pin.GetPin();
+    if(pinstate || !ps) e = false; // count on positive edge!
+    pinstate = ps;
     if(e && countEnable) {
       preScaleValue++;
       if(preScaleValue > 1023) preScaleValue = 0;
@@ -139,10 +177,27 @@ unsigned int HWPrescalerAsync::CpuCycle() {
     return 0;
 }
 
+void HWPrescalerAsync::SerializeState(Snapshot &snap) {
+    HWPrescaler::SerializeState(snap);
+    snap.Value(pinstate);
+    snap.Value(clockselect);
+}
+
 unsigned char HWPrescalerAsync::set_from_reg(const IOSpecialReg *reg, unsigned char nv) {
     unsigned char v = HWPrescaler::set_from_reg(reg, nv);
     if(reg != asyncRegister) return v;
-    if((1 << clockSelectBit) & v) {
+    bool sel = ((1 << clockSelectBit) & v) != 0;
+    if(sel != clockselect) {
+        // count core clock till now, then switch clock source
+        _core->WakeUpAllHardware();
+        UpdateValue();
+        countCoreClock = !sel;
+        if(sel)
+            _core->AddToCycleList(this);
+        else
+            _core->RemoveFromCycleList(this);
+    }
+    if(sel) {
         clockselect = true;
         //tosc_pin.SetAlternatePort(true);
     } else {
@@ -33,7 +33,10 @@
 
 //! Prescaler unit for support timers with clock
 /*! This is a prescaler unit without external clock input, features reset and
-  reset sync bit. Size of prescaler is 10 bit.*/
+  reset sync bit. Size of prescaler is 10 bit.
+
+  The prescaler isn't clocked by core cycle list, counter value is calculated
+  from core cycle count on request. */
 class HWPrescaler: public Hardware, public IOSpecialRegClient {
     
     private:
@@ -41,9 +44,19 @@ class HWPrescaler: public Hardware, public IOSpecialRegClient {
         int _resetSyncBit; //!< holds sync bit position for prescaler reset synchronisation
         
     protected:
+        AvrDevice *_core; //!< link to device, for core cycle count
         IOSpecialReg* resetRegister; //!< instance of IO register with reset bits
-        unsigned short preScaleValue; //!< prescaler counter value
+        unsigned short preScaleValue; //!< prescaler counter value on core cycle preScaleCycle
+        unsigned long long preScaleCycle; //!< core cycle count, on which preScaleValue was calculated
         bool countEnable;  //!< enables counting of prescaler (for reset sync)
+        bool countCoreClock; //!< prescaler counts core clock, otherwise it's counted by CpuCycle
+        //! Calculates preScaleValue for current core cycle
+        void UpdateValue() {
+            unsigned long long now = _core->GetCycleCount();
+            if(countEnable && countCoreClock)
+                preScaleValue = (preScaleValue + (now - preScaleCycle)) % 1024;
+            preScaleCycle = now;
+        }
         //! IO register interface set method, see IOSpecialRegClient
         unsigned char set_from_reg(const IOSpecialReg *reg, unsigned char nv);
         //! IO register interface get method, see IOSpecialRegClient
@@ -63,18 +76,14 @@ class HWPrescaler: public Hardware, public IOSpecialRegClient {
                     IOSpecialReg *ioreg,
                     int resetBit,
                     int resetSyncBit);
-        //! Count functionality for prescaler
-        virtual unsigned int CpuCycle() {
-            if(countEnable) {
-              preScaleValue++;
-              if(preScaleValue > 1023) preScaleValue = 0;
-            }
-            return 0;
-        }
         //! Get method for current prescaler counter value
-        unsigned short GetValue() { return preScaleValue; }
+        unsigned short GetValue() { UpdateValue(); return preScaleValue; }
+        //! Returns true, if prescaler counts core clock cycles
+        bool IsCoreClocked() const { return countEnable && countCoreClock; }
         //! Reset method, sets prescaler counter to 0
-        void Reset(){ preScaleValue = 0; }
+        void Reset(){ preScaleValue = 0; preScaleCycle = _core->GetCycleCount(); }
+        //! Saves or restores prescaler counter, see Snapshot
+        void SerializeState(Snapshot &snap);
 };
 
 //! Extends HWPrescaler with a external clock oszillator pin
@@ -100,8 +109,10 @@ class HWPrescalerAsync: public HWPrescaler {
                          IOSpecialReg *resreg,
                          int resetBit,
                          int resetSyncBit);
-        //! Count functionality for prescaler
+        //! Count functionality for prescaler on external clock
         virtual unsigned int CpuCycle();
+        //! Saves or restores prescaler counter and clock pin state, see Snapshot
+        void SerializeState(Snapshot &snap);
         
     protected:
         //! IO register interface set method, see IOSpecialRegClient
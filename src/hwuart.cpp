@@ -23,8 +23,11 @@
  *  $Id$
  */
 
+#include <limits>
+
 #include "hwuart.h"
 #include "helper.h"
+#include "snapshot.h"
 
 //usr & ucsra
 #define RXC 0x80
@@ -145,15 +148,8 @@ void HWUart::SetUcr(unsigned char val) {
         pinRx.SetAlternateDdr(0);       // input 
     }
 
-    //prepared for later remove from hwuart from every cpu cycle (only on demand)
-#if 0
-    //Check if one of Rx or Tx is enabled NEW!
-    if ( ucr & ( RXEN|TXEN) ) {//now one of rx or tx is on
-        if ( !(ucrold & (RXEN|TXEN)) ) { //but there was nothing on before
-            core->AddToCycleList(this); //enable the cpu cycle list!
-        }
-    }
-#endif
+    //remove hwuart from cpu cycle list, if rx and tx are disabled (only on demand)
+    UpdateCycleList();
 
     unsigned char irqold= ucrold&usr;
     unsigned char irqnew= ucr&usr;
@@ -176,12 +172,62 @@ unsigned int HWUart::CpuCycle() {
     }
 
     // controling read sequence down counter
-    if(regSeq > 0)
+    if(regSeq > 0) {
         regSeq--;
+        if(regSeq == 0)
+            UpdateCycleList();
+    }
       
     return 0;
 }
 
+void HWUart::UpdateCycleList(void) {
+    bool active = ((ucr & (RXEN | TXEN)) != 0) || (regSeq > 0);
+    if(active == cycleActive)
+        return;
+    if(active) {
+        // catch up baud rate counters for the cycles, uart was not clocked
+        CountBaudCycles(core->GetCycleCount() - idleSince);
+        core->AddToCycleList(this);
+    } else {
+        idleSince = core->GetCycleCount();
+        core->RemoveFromCycleList(this);
+    }
+    cycleActive = active;
+}
+
+void HWUart::CountBaudCycles(unsigned long long cycles) {
+    unsigned long long period = ubrr + 1;
+    unsigned long long ticks = 0;
+    if(cycles > 0 && (unsigned long long)(baudCnt + 1) >= period) {
+        baudCnt = 0;
+        ticks = 1;
+        cycles--;
+    }
+    ticks += (baudCnt + cycles) / period;
+    baudCnt = (baudCnt + cycles) % period;
+    baudCnt16 = (baudCnt16 + ticks) % 16;
+}
+
+unsigned long long HWUart::CyclesIdle(void) {
+    if(regSeq > 0)
+        return 0;
+    // receiver waits for start bit (and rx line isn't changed by core cycles)
+    if((ucr & RXEN) &&
+       !((rxState == RX_WAIT_FOR_HIGH && pinRx == 0) ||
+         (rxState == RX_WAIT_FOR_LOWEDGE && pinRx == 1 && cntRxSamples == 0 && rxLowCnt == 0 && rxHighCnt == 0)))
+        return 0;
+    // transmitter has nothing to send
+    if((ucr & TXEN) &&
+       !((usr & UDRE) && (txState == TX_FIRST_RUN || txState == TX_FINISH)))
+        return 0;
+    return std::numeric_limits<unsigned long long>::max();
+}
+
+void HWUart::SkipCycles(unsigned long long cycles) {
+    CountBaudCycles(cycles);
+}
+
 unsigned int HWUart::CpuCycleRx() {
     // receiver part
     //
@@ -532,6 +578,7 @@ HWUart::HWUart(AvrDevice *core,
                int instance_id):
     Hardware(core),
     TraceValueRegister(core, "UART" + int2str(instance_id)),
+    core(core),
     irqSystem(s),
     pinTx(tx),
     pinRx(rx),
@@ -557,7 +604,9 @@ HWUart::HWUart(AvrDevice *core,
     irqSystem->DebugVerifyInterruptVector(vectorUdre, this);
     irqSystem->DebugVerifyInterruptVector(vectorTx, this);
 
-    core->AddToCycleList(this);
+    // not in cycle list till rx or tx is enabled
+    cycleActive = false;
+    idleSince = core->GetCycleCount();
 
     trace_direct(this, "UDR_write", &udrWrite);
     trace_direct(this, "UDR_read", &udrRead);
@@ -619,6 +668,36 @@ void HWUart::Reset() {
     txState = TX_FIRST_RUN;
 
     SetFrameLengthFromRegister(); 
+
+    // baud rate counters start again from now
+    idleSince = core->GetCycleCount();
+    UpdateCycleList();
+}
+
+void HWUart::SerializeState(Snapshot &snap) {
+    snap.Value(udrWrite);
+    snap.Value(udrRead);
+    snap.Value(usr);
+    snap.Value(ucr);
+    snap.Value(ucsrc);
+    snap.Value(ubrr);
+    snap.Value(readParity);
+    snap.Value(writeParity);
+    snap.Value(frameLength);
+    snap.Value(regSeq);
+    snap.Value(baudCnt);
+    snap.Value(rxState);
+    snap.Value(txState);
+    snap.Value(cntRxSamples);
+    snap.Value(rxLowCnt);
+    snap.Value(rxHighCnt);
+    snap.Value(rxDataTmp);
+    snap.Value(rxBitCnt);
+    snap.Value(baudCnt16);
+    snap.Value(txDataTmp);
+    snap.Value(txBitCnt);
+    snap.Value(cycleActive);
+    snap.Value(idleSince);
 }
 
 // implementation of HWUsart
@@ -641,9 +720,11 @@ unsigned char HWUsart::GetUcsrc() { return ucsrc; }
 unsigned char HWUsart::GetUcsrcUbrrh() {
     if(regSeq == 0) {
         regSeq = 2;
+        UpdateCycleList();
         return GetUbrrhi();
     } else {
         regSeq = 0;
+        UpdateCycleList();
         return GetUcsrc();
     }
 }
@@ -50,6 +50,7 @@ class HWUart: public Hardware, public TraceValueRegister {
 
         int frameLength;        //!< Hold length of UART frame
 
+        AvrDevice *core;        //!< Link to device
         HWIrqSystem *irqSystem; //!< Connection to interrupt system
 
         PinAtPort pinTx;        //!< TX pin
@@ -102,6 +103,14 @@ class HWUart: public Hardware, public TraceValueRegister {
         unsigned char txDataTmp;
         int txBitCnt;
 
+        bool cycleActive;            //!< Flag, uart is in core cycle list
+        unsigned long long idleSince; //!< Core cycle count, where uart was removed from cycle list
+
+        //! Adds uart to core cycle list, if rx, tx or read sequence is active, otherwise removes it
+        void UpdateCycleList(void);
+        //! Moves baud rate counters forward by the given count of cycles
+        void CountBaudCycles(unsigned long long cycles);
+
     public:
         //! Creates a instance of HWUart class
         HWUart(AvrDevice *core,
@@ -113,8 +122,14 @@ class HWUart: public Hardware, public TraceValueRegister {
                unsigned int tx_interrupt,
                int instance_id = 0);
         virtual unsigned int CpuCycle();
+        //! Returns unlimited cycles, if receiver waits for start bit and transmitter is idle
+        virtual unsigned long long CyclesIdle(void);
+        //! Counts baud rate counters for idle cycles
+        virtual void SkipCycles(unsigned long long cycles);
 
         void Reset();
+        //! Saves or restores registers and rx/tx state, see Snapshot
+        void SerializeState(Snapshot &snap);
 
         void SetUdr(unsigned char val);  
         void SetUsr(unsigned char val);  
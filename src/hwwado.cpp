@@ -26,6 +26,7 @@
 #include "hwwado.h"
 #include "avrdevice.h"
 #include "systemclock.h"
+#include "traceval.h"
 
 #define WDTOE 0x10
 #define WDE 0x08
@@ -47,20 +48,44 @@ void HWWado::SetWdtcr(unsigned char val) {
 		cntWde=4;
 	}
 
+	UpdateCycleList();
 } 
 
+void HWWado::UpdateCycleList() {
+	// cpu cycles are only needed for WDTOE timeout or enabled wado, the
+	// next cycle schedules the timeout check
+	if ((cntWde > 0) || ((wdtcr & (WDE | WDTOE)) != 0))
+		core->AddToCycleList(this);
+	else
+		core->RemoveFromCycleList(this);
+}
+
+void HWWado::ScheduleTimeout() {
+	// first cycle behind timeOutAt, SystemClock time is the time of current cycle here
+	SystemClockOffset now = SystemClock::Instance().GetCurrentTime();
+	SystemClockOffset period = core->GetClockFreq();
+	if ((period > 0) && (timeOutAt >= now))
+		core->ScheduleHardware(this, core->GetCycleCount() + (timeOutAt - now) / period + 1);
+}
+
 unsigned int HWWado::CpuCycle() {
 	if ( cntWde > 0) {
 		cntWde--;
-
+		if (cntWde==0) {
+			wdtcr&=(0xff-WDTOE); //clear WDTOE after 4 cpu cycles
+			UpdateCycleList();
+		}
 	}
 
-	if (cntWde==0) wdtcr&=(0xff-WDTOE); //clear WDTOE after 4 cpu cycles
-
 	if ((( wdtcr& WDE )!= 0 ) && (timeOutAt < SystemClock::Instance().GetCurrentTime() )) {
+		DumpManager::Instance()->Trigger("watchdog reset");
 		core->Reset();
+		return 0;
 	}
 
+	// wado is enabled, nothing to do till timeout
+	if ((cntWde == 0) && (( wdtcr& WDE )!= 0 ))
+		ScheduleTimeout();
 
 	return 0;
 }
@@ -71,13 +96,14 @@ HWWado::HWWado(AvrDevice *c):
     core(c),
     wdtcr_reg(this, "WDTCR",
               this, &HWWado::GetWdtcr, &HWWado::SetWdtcr) {
-	core->AddToCycleList(this);
 	Reset();
 }
 
 void HWWado::Reset() {
 	timeOutAt=0;
 	wdtcr=0;
+	cntWde=0;
+	UpdateCycleList();
 }
 
 
@@ -117,4 +143,5 @@ void HWWado::Wdr() {
 			break;
 
 	}
+	UpdateCycleList();
 }
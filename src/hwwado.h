@@ -42,6 +42,9 @@ class HWWado: public Hardware, public TraceValueRegister {
 	SystemClockOffset timeOutAt; 
 	AvrDevice *core;
 
+	void UpdateCycleList(); //!< add to or remove from core cycle list, if needed
+	void ScheduleTimeout(); //!< leave core cycle list till timeout, see AvrDevice::ScheduleHardware
+
 	public:
 		HWWado(AvrDevice *); // { irqSystem= s;}
 		virtual unsigned int CpuCycle();
@@ -50,6 +53,7 @@ class HWWado: public Hardware, public TraceValueRegister {
 		unsigned char GetWdtcr() { return wdtcr; }
 		void Wdr(); //reset the wado counter
 		void Reset();
+		void SerializeState(Snapshot &snap) { snap.Value(wdtcr); snap.Value(cntWde); snap.Value(timeOutAt); }
 
         IOReg<HWWado> wdtcr_reg;
 };
@@ -39,6 +39,7 @@ class AddressExtensionRegister: public Hardware, public TraceValueRegister {
     public:
         AddressExtensionRegister(AvrDevice *core, const std::string &regname, unsigned bitsize);
         void Reset() { reg_val = 0; }
+        void SerializeState(Snapshot &snap) { snap.Value(reg_val); }
         unsigned char GetRegVal() { return reg_val; }
         void SetRegVal(unsigned char val) { reg_val = val & reg_mask; }
 
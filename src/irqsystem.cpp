@@ -29,12 +29,14 @@
 #include "systemclock.h"
 #include "helper.h"
 #include "avrerror.h"
+#include "snapshot.h"
 
 #include "application.h"
 
 #include <iostream>
 #include <assert.h>
 #include <typeinfo>
+#include <algorithm>
 
 using namespace std;
 
@@ -237,6 +239,8 @@ void HWIrqSystem::SetIrqFlag(Hardware *hwp, unsigned int vector) {
     if (core->trace_on) {
         traceOut << core->GetFname() << " interrupt on index " << vector << " is pending" << endl;
     }
+    if(core->binaryTrace != NULL)
+        core->TraceBinary(BinaryTrace::REC_IRQ_PENDING, vector);
 
     if ( irqStatistic.entries[vector].actual.flagSet==0) { //the actual entry was not used before... fine!
         irqStatistic.entries[vector].actual.flagSet=SystemClock::Instance().GetCurrentTime();
@@ -248,6 +252,8 @@ void HWIrqSystem::ClearIrqFlag(unsigned int vector) {
     if (core->trace_on) {
         traceOut << core->GetFname() << " interrupt on index " << vector << "cleared" << endl;
     }
+    if(core->binaryTrace != NULL)
+        core->TraceBinary(BinaryTrace::REC_IRQ_CLEARED, vector);
 
     if (irqStatistic.entries[vector].actual.flagCleared==0) {
         irqStatistic.entries[vector].actual.flagCleared=SystemClock::Instance().GetCurrentTime();
@@ -256,11 +262,41 @@ void HWIrqSystem::ClearIrqFlag(unsigned int vector) {
     irqStatistic.entries[vector].CheckComplete();
 } 
 
+void HWIrqSystem::SerializeState(Snapshot &snap) {
+    snap.Check("irq");
+    unsigned int count = irqPartnerList.size();
+    snap.Value(count);
+    if(snap.IsRestoring()) {
+        irqPartnerList.clear();
+        for(unsigned int i = 0; i < count; i++) {
+            unsigned int vec, hwIndex;
+            snap.Value(vec);
+            snap.Value(hwIndex);
+            if(vec >= vectorTableSize || hwIndex >= core->hwResetList.size())
+                avr_error("snapshot doesn't match: invalid interrupt source");
+            irqPartnerList[vec] = core->hwResetList[hwIndex];
+        }
+    } else {
+        map<unsigned int, Hardware *>::iterator ii;
+        for(ii = irqPartnerList.begin(); ii != irqPartnerList.end(); ii++) {
+            unsigned int vec = ii->first;
+            vector<Hardware *>::iterator hw = find(core->hwResetList.begin(), core->hwResetList.end(), ii->second);
+            if(hw == core->hwResetList.end())
+                avr_error("can't save interrupt source for vector %d", vec);
+            unsigned int hwIndex = hw - core->hwResetList.begin();
+            snap.Value(vec);
+            snap.Value(hwIndex);
+        }
+    }
+}
+
 void HWIrqSystem::IrqHandlerStarted(unsigned int vector) {
     irqTrace[vector]->change(1);
     if (core->trace_on) {
         traceOut << core->GetFname() << " IrqSystem: IrqHandlerStarted Vec: " << vector << endl;
     }
+    if(core->binaryTrace != NULL)
+        core->TraceBinary(BinaryTrace::REC_IRQ_STARTED, vector);
 
     if (irqStatistic.entries[vector].actual.handlerStarted==0) {
         irqStatistic.entries[vector].actual.handlerStarted=SystemClock::Instance().GetCurrentTime();
@@ -273,6 +309,8 @@ void HWIrqSystem::IrqHandlerFinished(unsigned int vector) {
     if (core->trace_on) {
         traceOut << core->GetFname() << " IrqSystem: IrqHandler Finished Vec: " << vector << endl;
     }
+    if(core->binaryTrace != NULL)
+        core->TraceBinary(BinaryTrace::REC_IRQ_FINISHED, vector);
 
     if (irqStatistic.entries[vector].actual.handlerFinished==0) {
         irqStatistic.entries[vector].actual.handlerFinished=SystemClock::Instance().GetCurrentTime();
@@ -141,6 +141,8 @@ class HWIrqSystem: public TraceValueRegister {
         /// In datasheets RESET vector is index 1 but we use 0! And not a byte address.
         void DebugVerifyInterruptVector(unsigned int vector_index, const Hardware* source);
         void DebugDumpTable();
+        //! Saves or restores pending interrupts, see Snapshot
+        void SerializeState(Snapshot &snap);
 };
 
 #ifndef SWIG
@@ -159,6 +161,7 @@ class IrqFunktor: public Funktor {
             vectorNo(_vector) {}
         void operator()() { (irqSystem->*fp)(vectorNo); }
         Funktor* clone() { return new IrqFunktor(*this); }
+        unsigned int GetVector(void) const { return vectorNo; }
 };
 
 #endif // ifndef SWIG
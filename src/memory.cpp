@@ -74,6 +74,9 @@ string Memory::GetSymbolAtAddress(unsigned int add){
     last_ii = ii;
     if(ii == sym.end())
         return ""; // we have no symbols at all
+    // first symbol, also if it's at address 0
+    lastName = ii->second;
+    lastAddr = ii->first;
     do {
         if(lastAddr != ii->first) {
             last_ii = ii;
@@ -25,6 +25,7 @@
 
 #include "net.h"
 #include "pin.h"
+#include "systemclock.h"
 
 void Net::Add(Pin *p) {
     push_back(p);
@@ -48,6 +49,10 @@ Net::~Net() {
 }
 
 bool Net::CalcNet() {
+    // pins of other threads can't be touched here, calculate later
+    if(shared && SystemClock::Instance().QueueNetCalculation(this))
+        return lastState;
+
     Pin result(Pin::TRISTATE);
     iterator ii;
     for(ii = begin(); ii != end(); ii++)
@@ -57,6 +62,7 @@ bool Net::CalcNet() {
     for(ii = begin(); ii != end(); ii++)
         (*ii)->SetInState( result); //In-State that means the state of register PIN not the complete pin here
 
-    return (bool)result;
+    lastState = (bool)result;
+    return lastState;
 }
 
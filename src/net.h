@@ -37,13 +37,20 @@ class Net
 #endif
 {
     public:
-        //Net() {} //!< Common Constructor, initially it'a a "empty net" and useless!
+        Net(): shared(false), lastState(false) {} //!< Common Constructor, initially it'a a "empty net" and useless!
         virtual ~Net(); //!< Destructor, disconnects save all pins, which are connected
         void Add(Pin *p); //!< Add a pin to net, e.g. connect a pin to others
         virtual void Delete(Pin *p); //!< Remove a pin from net
          //! Calculate a "electrical potential" on the net and set all pin inputs with this value
         virtual bool CalcNet();
-        
+
+        //! Pins of this net belong to different partitions of SystemClock::RunParallel
+        /*! Then CalcNet is delayed till end of current time window */
+        bool shared;
+
+    protected:
+        bool lastState; //!< result of last CalcNet calculation
+
     private:
         friend void Pin::RegisterNet(Net*);
 };
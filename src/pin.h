@@ -155,10 +155,12 @@ class Pin {
 
         bool isPortPin(void) { return pinOfPort != NULL; } //!< True, if it's a port pin
         bool isConnected(void) { return connectedTo != NULL; } //!< True, if it's connected to other pins
+        Net *GetNet(void) const { return connectedTo; } //!< Returns the connected net or NULL
         bool hasListener(void) { return notifyList.size() != 0; } //!< True, if there change listeners
 
         friend class HWPort;
         friend class Net;
+        friend class ExecutionHistory;
 
 };
 
@@ -0,0 +1,379 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdio.h>
+
+#include "profiler.h"
+#include "avrdevice.h"
+#include "flash.h"
+#include "hwstack.h"
+#include "helper.h"
+
+using namespace std;
+
+Profiler::Profiler(AvrDevice *_core):
+    core(_core),
+    pcCycles(_core->Flash->GetSize() / 2, 0),
+    sleepCycles(0),
+    cycleCount(0)
+{
+    InitNode(&root, core->PC, -1, NULL);
+    current = top = lastTop = &root;
+    lastPC = core->PC;
+    lowestSP = core->stack->GetStackPointer();
+    core->profiler = this;
+}
+
+Profiler::~Profiler() {
+    core->profiler = NULL;
+    DeleteChildren(&root);
+}
+
+void Profiler::DeleteChildren(Node *n) {
+    map<pair<unsigned int, int>, Node *>::iterator i;
+    for(i = n->children.begin(); i != n->children.end(); i++) {
+        DeleteChildren(i->second);
+        delete i->second;
+    }
+    n->children.clear();
+}
+
+void Profiler::InitNode(Node *n, unsigned int function, int vector, Node *parent) {
+    n->function = function;
+    n->vector = vector;
+    n->parent = parent;
+    n->cycles = n->sleepCycles = n->calls = 0;
+    n->returns = n->minCycles = n->maxCycles = n->sumCycles = 0;
+    n->maxDepth = 0;
+}
+
+void Profiler::Enter(unsigned int target, int vector) {
+    Node *&child = top->children[make_pair(target, vector)];
+    if(child == NULL) {
+        child = new Node;
+        InitNode(child, target, vector, top);
+    }
+    child->calls++;
+    Frame f;
+    // return address is pushed already
+    unsigned long sp = core->stack->GetStackPointer();
+    f.sp = sp + core->PC_size;
+    f.outerLowestSP = lowestSP;
+    f.start = cycleCount;
+    frames.push_back(f);
+    lowestSP = sp;
+    top = child;
+}
+
+void Profiler::Return(void) {
+    unsigned long sp = core->stack->GetStackPointer();
+    while(!frames.empty() && frames.back().sp <= sp) {
+        Frame &f = frames.back();
+        if(f.sp - lowestSP > top->maxDepth)
+            top->maxDepth = f.sp - lowestSP;
+        returned.push_back(make_pair(top, f.start));
+        if(f.outerLowestSP < lowestSP)
+            lowestSP = f.outerLowestSP;
+        frames.pop_back();
+        top = top->parent;
+    }
+}
+
+void Profiler::FinishReturns(void) {
+    for(unsigned int i = 0; i < returned.size(); i++) {
+        Node *n = returned[i].first;
+        unsigned long long c = cycleCount - returned[i].second;
+        if(n->returns == 0 || c < n->minCycles)
+            n->minCycles = c;
+        if(c > n->maxCycles)
+            n->maxCycles = c;
+        n->sumCycles += c;
+        n->returns++;
+    }
+    returned.clear();
+}
+
+void Profiler::Reset(void) {
+    frames.clear();
+    returned.clear();
+    current = top = lastTop = &root;
+    lowestSP = core->stack->GetStackPointer();
+}
+
+string Profiler::FunctionName(unsigned int pc) const {
+    string s = core->Flash->GetSymbolAtAddress(pc);
+    string::size_type p = s.find("+0x");
+    if(p != string::npos)
+        s.erase(p);
+    if(s.empty())
+        s = "0x" + int2hex(pc * 2);
+    return s;
+}
+
+unsigned int Profiler::JumpTarget(unsigned int pc) const {
+    unsigned int op = core->Flash->ReadMemWord(pc * 2);
+    if((op & 0xf000) == 0xc000) {
+        // RJMP
+        int k = op & 0xfff;
+        if(k & 0x800)
+            k -= 0x1000;
+        return pc + 1 + k;
+    }
+    if((op & 0xfe0e) == 0x940c) {
+        // JMP
+        unsigned int kh = ((op >> 3) & 0x3e) | (op & 1);
+        return (kh << 16) + core->Flash->ReadMemWord((pc + 1) * 2);
+    }
+    return pc;
+}
+
+string Profiler::NodeFunction(const Node *n) const {
+    if(n->vector >= 0)
+        return FunctionName(JumpTarget(n->function));
+    return FunctionName(n->function);
+}
+
+unsigned long long Profiler::CollectCalls(const Node *n,
+                                          map<string, FunctionInfo> &info,
+                                          vector<string> &path) const {
+    string name = NodeFunction(n);
+    bool recursive = find(path.begin(), path.end(), name) != path.end();
+
+    path.push_back(name);
+    unsigned long long total = n->cycles + n->sleepCycles;
+    map<pair<unsigned int, int>, Node *>::const_iterator i;
+    for(i = n->children.begin(); i != n->children.end(); i++)
+        total += CollectCalls(i->second, info, path);
+    path.pop_back();
+
+    FunctionInfo &f = info[name];
+    f.calls += n->calls;
+    // cycles of a recursive call are counted by outermost call already
+    if(!recursive)
+        f.total += total;
+    if(n->parent != NULL) {
+        if(n->vector >= 0)
+            f.callers["[irq " + int2str(n->vector) + "]"] += n->calls;
+        else {
+            f.callers[NodeFunction(n->parent)] += n->calls;
+            pair<unsigned long long, unsigned long long> &c = info[NodeFunction(n->parent)].callees[name];
+            c.first += n->calls;
+            c.second += total;
+        }
+    }
+    return total;
+}
+
+//! Writes percent of total with 2 digits
+static string Percent(unsigned long long part, unsigned long long total) {
+    ostringstream os;
+    os << fixed << setprecision(2) << ((total > 0) ? 100.0 * part / total : 0.0);
+    return os.str();
+}
+
+void Profiler::WriteFlat(ostream &os) {
+    map<string, FunctionInfo> info;
+    vector<string> path;
+    unsigned long long total = CollectCalls(&root, info, path);
+
+    // self cycles by program counter, not by call tree
+    map<string, unsigned long long> self;
+    for(unsigned int pc = 0; pc < pcCycles.size(); pc++)
+        if(pcCycles[pc] != 0)
+            self[FunctionName(pc)] += pcCycles[pc];
+    if(sleepCycles != 0)
+        self["[sleep]"] = sleepCycles;
+
+    vector<pair<unsigned long long, string> > sorted;
+    for(map<string, unsigned long long>::iterator i = self.begin(); i != self.end(); i++)
+        sorted.push_back(make_pair(i->second, i->first));
+    sort(sorted.rbegin(), sorted.rend());
+
+    os << "Flat profile of " << core->GetFname() << ": " << total << " cycles, "
+       << sleepCycles << " sleeping" << endl << endl;
+    os << "      self       %       total       %      calls  function" << endl;
+    for(unsigned int i = 0; i < sorted.size(); i++) {
+        const string &name = sorted[i].second;
+        map<string, FunctionInfo>::iterator f = info.find(name);
+        unsigned long long t = (f != info.end() && f->second.total > 0) ? f->second.total : sorted[i].first;
+        os << setw(10) << sorted[i].first << setw(8) << Percent(sorted[i].first, total)
+           << setw(12) << t << setw(8) << Percent(t, total)
+           << setw(11) << ((f != info.end()) ? f->second.calls : 0) << "  " << name << endl;
+    }
+}
+
+void Profiler::WriteCallGraph(ostream &os) {
+    map<string, FunctionInfo> info;
+    vector<string> path;
+    unsigned long long total = CollectCalls(&root, info, path);
+
+    vector<pair<unsigned long long, string> > sorted;
+    for(map<string, FunctionInfo>::iterator i = info.begin(); i != info.end(); i++)
+        sorted.push_back(make_pair(i->second.total, i->first));
+    sort(sorted.rbegin(), sorted.rend());
+
+    os << "Call graph of " << core->GetFname() << ": " << total << " cycles" << endl;
+    for(unsigned int i = 0; i < sorted.size(); i++) {
+        FunctionInfo &f = info[sorted[i].second];
+        os << endl << sorted[i].second << ": " << f.total << " cycles ("
+           << Percent(f.total, total) << "%), " << f.calls << " calls" << endl;
+        map<string, unsigned long long>::iterator c;
+        for(c = f.callers.begin(); c != f.callers.end(); c++)
+            os << "    called by " << c->first << ": " << c->second << " calls" << endl;
+        map<string, pair<unsigned long long, unsigned long long> >::iterator e;
+        for(e = f.callees.begin(); e != f.callees.end(); e++)
+            os << "    calls " << e->first << ": " << e->second.first << " calls, "
+               << e->second.second << " cycles" << endl;
+    }
+}
+
+void Profiler::WriteCollapsedNode(ostream &os, const Node *n, const string &path) {
+    string name = path;
+    if(!name.empty())
+        name += ";";
+    name += NodeFunction(n);
+    if(n->vector >= 0)
+        name += " [irq " + int2str(n->vector) + "]";
+    if(n->cycles != 0)
+        os << name << " " << n->cycles << endl;
+    if(n->sleepCycles != 0)
+        os << name << ";[sleep] " << n->sleepCycles << endl;
+    map<pair<unsigned int, int>, Node *>::const_iterator i;
+    for(i = n->children.begin(); i != n->children.end(); i++)
+        WriteCollapsedNode(os, i->second, name);
+}
+
+void Profiler::WriteCollapsed(ostream &os) {
+    WriteCollapsedNode(os, &root, "");
+}
+
+void Profiler::CollectStatistic(const Node *n, map<string, FunctionStatistic> &stat) const {
+    if(n->returns != 0) {
+        string name = NodeFunction(n);
+        map<string, FunctionStatistic>::iterator i = stat.find(name);
+        if(i == stat.end()) {
+            FunctionStatistic &f = stat[name];
+            f.address = (n->vector >= 0) ? JumpTarget(n->function) : n->function;
+            f.returns = n->returns;
+            f.minCycles = n->minCycles;
+            f.maxCycles = n->maxCycles;
+            f.sumCycles = n->sumCycles;
+            f.maxDepth = n->maxDepth;
+        } else {
+            FunctionStatistic &f = i->second;
+            f.returns += n->returns;
+            f.minCycles = min(f.minCycles, n->minCycles);
+            f.maxCycles = max(f.maxCycles, n->maxCycles);
+            f.sumCycles += n->sumCycles;
+            f.maxDepth = max(f.maxDepth, n->maxDepth);
+        }
+    }
+    map<pair<unsigned int, int>, Node *>::const_iterator i;
+    for(i = n->children.begin(); i != n->children.end(); i++)
+        CollectStatistic(i->second, stat);
+}
+
+//! Orders function statistic by maximum cycles, biggest first
+static bool MaxCyclesGreater(const pair<string, Profiler::FunctionStatistic> &a,
+                             const pair<string, Profiler::FunctionStatistic> &b) {
+    if(a.second.maxCycles != b.second.maxCycles)
+        return a.second.maxCycles > b.second.maxCycles;
+    return a.first < b.first;
+}
+
+vector<pair<string, Profiler::FunctionStatistic> > Profiler::SortedStatistic(void) const {
+    map<string, FunctionStatistic> stat;
+    CollectStatistic(&root, stat);
+    vector<pair<string, FunctionStatistic> > sorted(stat.begin(), stat.end());
+    sort(sorted.begin(), sorted.end(), MaxCyclesGreater);
+    return sorted;
+}
+
+//! Writes average cycles with 2 digits
+static string Average(unsigned long long sum, unsigned long long count) {
+    ostringstream os;
+    os << fixed << setprecision(2) << ((count > 0) ? (double)sum / count : 0.0);
+    return os.str();
+}
+
+void Profiler::WriteFunctionStatistic(ostream &os) {
+    vector<pair<string, FunctionStatistic> > sorted = SortedStatistic();
+    SystemClockOffset ns = core->GetClockFreq();
+
+    os << "Function statistic of " << core->GetFname()
+       << ": inclusive cycles of completed calls, stack depth in bytes" << endl << endl;
+    os << "     calls  min cycles    avg cycles  max cycles    max time/ns  max stack  function" << endl;
+    for(unsigned int i = 0; i < sorted.size(); i++) {
+        const FunctionStatistic &f = sorted[i].second;
+        os << setw(10) << f.returns << setw(12) << f.minCycles
+           << setw(14) << Average(f.sumCycles, f.returns) << setw(12) << f.maxCycles
+           << setw(15) << f.maxCycles * ns << setw(11) << f.maxDepth
+           << "  " << sorted[i].first << endl;
+    }
+}
+
+//! Quotes a string for JSON
+static string JSONString(const string &s) {
+    string r("\"");
+    for(unsigned int i = 0; i < s.size(); i++) {
+        unsigned char c = s[i];
+        if(c == '"' || c == '\\') {
+            r += '\\';
+            r += c;
+        } else if(c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            r += buf;
+        } else
+            r += c;
+    }
+    return r + "\"";
+}
+
+void Profiler::WriteFunctionStatisticJSON(ostream &os) {
+    vector<pair<string, FunctionStatistic> > sorted = SortedStatistic();
+    SystemClockOffset ns = core->GetClockFreq();
+
+    os << "{" << endl
+       << "  \"program\": " << JSONString(core->GetFname()) << "," << endl
+       << "  \"cycle_ns\": " << ns << "," << endl
+       << "  \"functions\": [";
+    for(unsigned int i = 0; i < sorted.size(); i++) {
+        const FunctionStatistic &f = sorted[i].second;
+        os << ((i == 0) ? "" : ",") << endl
+           << "    {\"name\": " << JSONString(sorted[i].first)
+           << ", \"address\": " << f.address * 2
+           << ", \"calls\": " << f.returns
+           << ", \"min_cycles\": " << f.minCycles
+           << ", \"max_cycles\": " << f.maxCycles
+           << ", \"avg_cycles\": " << Average(f.sumCycles, f.returns)
+           << ", \"max_ns\": " << f.maxCycles * ns
+           << ", \"max_stack\": " << f.maxDepth << "}";
+    }
+    os << endl << "  ]" << endl << "}" << endl;
+}
@@ -0,0 +1,192 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef PROFILER
+#define PROFILER
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+class AvrDevice;
+
+//! Cycle accurate profiler of a device
+/*! Every core cycle is counted on the program counter of the instruction,
+  which is processed in this cycle (including wait states of multi cycle
+  instructions), and on the current node of a call tree. The call tree is
+  built by call instructions (CALL, RCALL, ICALL, EICALL), interrupts and
+  RET/RETI. A return leaves all calls, which have pushed their return
+  address at or below the stack pointer after the return, so a manipulated
+  stack (setjmp/longjmp, task switch) doesn't break the tree.
+
+  Cycles, where the core sleeps, are counted separate as "[sleep]".
+
+  Results are written as flat profile (cycles per function), as call graph
+  (callers and callees of every function) or in collapsed stack format, one
+  line per call stack with it's cycles ("main;foo;bar 1234"), which is read
+  by flame graph tools.
+
+  Besides that every completed call (from call instruction or interrupt
+  entry till the first instruction after RET/RETI) is measured: the
+  inclusive cycles, that is the function, it's callees and all interrupts,
+  which are handled meanwhile, and the stack depth, the difference between
+  stack pointer before call and lowest stack pointer till return (return
+  address, saved registers and local frame of function and callees). The
+  function statistic has minimum, maximum and average of these per function
+  symbol. */
+class Profiler {
+
+    public:
+        //! Cycles and stack depth of a function, collected from call tree
+        struct FunctionStatistic {
+            unsigned int address;       //!< word address of function
+            unsigned long long returns;
+            unsigned long long minCycles;
+            unsigned long long maxCycles;
+            unsigned long long sumCycles;
+            unsigned long maxDepth;
+        };
+
+        //! Creates a profiler and enables it on device, see AvrDevice::profiler
+        /*! Program must be loaded before, symbols are taken from flash. */
+        Profiler(AvrDevice *core);
+        //! Disables profiler on device
+        ~Profiler();
+
+        //! Counts a cycle on instruction at pc
+        void Cycle(unsigned int pc) {
+            // a instruction is counted on the call, which was active
+            // before it, calls and returns take effect with next instruction
+            if(pc != lastPC) {
+                if(!returned.empty())
+                    FinishReturns();
+                current = lastTop;
+                lastPC = pc;
+            }
+            cycleCount++;
+            pcCycles[pc]++;
+            current->cycles++;
+            lastTop = top;
+        }
+        //! Counts cycles, where the core sleeps
+        void Sleep(unsigned long long cycles) {
+            current = lastTop = top;
+            cycleCount += cycles;
+            sleepCycles += cycles;
+            current->sleepCycles += cycles;
+        }
+        //! A call instruction is processed, target is the called address
+        void Call(unsigned int target) { Enter(target, -1); }
+        //! A interrupt handler is started, target is the vector address
+        void Interrupt(unsigned int vector, unsigned int target) { Enter(target, vector); }
+        //! A RET or RETI instruction is processed
+        void Return(void);
+        //! Stack pointer is decremented by push or set by program
+        void StackPointer(unsigned long sp) {
+            if(sp < lowestSP)
+                lowestSP = sp;
+        }
+        //! Device is reset, call stack is cleared
+        void Reset(void);
+
+        //! Writes cycles per function, sorted by self cycles
+        void WriteFlat(std::ostream &os);
+        //! Writes callers and callees of every function
+        void WriteCallGraph(std::ostream &os);
+        //! Writes cycles per call stack in collapsed stack format
+        void WriteCollapsed(std::ostream &os);
+        //! Writes cycles and stack depth per function as table
+        void WriteFunctionStatistic(std::ostream &os);
+        //! Writes cycles and stack depth per function as JSON document
+        void WriteFunctionStatisticJSON(std::ostream &os);
+
+    private:
+        //! Node of call tree: a function, called on a unique path
+        struct Node {
+            unsigned int function;      //!< word address of function or interrupt vector
+            int vector;                 //!< interrupt vector number, -1 for a call
+            Node *parent;
+            std::map<std::pair<unsigned int, int>, Node *> children;
+            unsigned long long cycles;  //!< cycles in function itself
+            unsigned long long sleepCycles; //!< sleeping cycles in function itself
+            unsigned long long calls;   //!< count of calls on this path
+            unsigned long long returns; //!< count of completed calls on this path
+            unsigned long long minCycles; //!< minimum inclusive cycles of a completed call
+            unsigned long long maxCycles; //!< maximum inclusive cycles of a completed call
+            unsigned long long sumCycles; //!< inclusive cycles of all completed calls
+            unsigned long maxDepth;     //!< maximum stack depth in bytes
+        };
+        //! A call on path to top, which isn't returned
+        struct Frame {
+            unsigned long sp;           //!< stack pointer before call
+            unsigned long outerLowestSP; //!< lowestSP of caller at time of call
+            unsigned long long start;   //!< cycleCount at time of call
+        };
+        //! Statistics of a function for flat profile and call graph
+        struct FunctionInfo {
+            unsigned long long self;    //!< cycles in function itself
+            unsigned long long total;   //!< cycles in function and it's callees
+            unsigned long long calls;
+            std::map<std::string, unsigned long long> callers; //!< calls from other functions
+            std::map<std::string, std::pair<unsigned long long, unsigned long long> > callees; //!< calls and cycles of called functions
+        };
+
+        AvrDevice *core;
+        std::vector<unsigned long long> pcCycles; //!< cycles per word address
+        unsigned long long sleepCycles;
+        Node root;
+        Node *current;          //!< node, which gets the cycles of current instruction
+        Node *top;              //!< node of last call, which isn't returned
+        Node *lastTop;          //!< top at last counted cycle
+        unsigned int lastPC;    //!< instruction of last counted cycle
+        std::vector<Frame> frames; //!< for every node on path to top
+        unsigned long long cycleCount; //!< all counted cycles, including sleep
+        unsigned long lowestSP; //!< lowest stack pointer since call of top
+        //! Returned calls with cycleCount at call, they are completed with next instruction
+        std::vector<std::pair<Node *, unsigned long long> > returned;
+
+        void Enter(unsigned int target, int vector);
+        //! Adds cycles of returned calls to their nodes
+        void FinishReturns(void);
+        void InitNode(Node *n, unsigned int function, int vector, Node *parent);
+        void DeleteChildren(Node *n);
+        //! Name of function containing pc, symbol without offset
+        std::string FunctionName(unsigned int pc) const;
+        //! Name of function of call tree node, for interrupts the handler behind vector
+        std::string NodeFunction(const Node *n) const;
+        //! Target of a jump instruction at pc (vector table), pc if it isn't a jump
+        unsigned int JumpTarget(unsigned int pc) const;
+        //! Collects function statistics from call tree, returns cycles in node and all children
+        unsigned long long CollectCalls(const Node *n,
+                                        std::map<std::string, FunctionInfo> &info,
+                                        std::vector<std::string> &path) const;
+        void WriteCollapsedNode(std::ostream &os, const Node *n, const std::string &path);
+        //! Collects function statistic from call tree, sorted by maximum cycles
+        void CollectStatistic(const Node *n, std::map<std::string, FunctionStatistic> &stat) const;
+        std::vector<std::pair<std::string, FunctionStatistic> > SortedStatistic(void) const;
+};
+
+#endif
@@ -5,6 +5,7 @@
   #include "systemclocktypes.h"
   #include "avrdevice.h"
   #include "systemclock.h"
+  #include "simulationcontext.h"
   #include "hardware.h"
   #include "externaltype.h"
   #include "irqsystem.h"
@@ -106,6 +107,7 @@ namespace std {
 }
 
 %include "systemclock.h"
+%include "simulationcontext.h"
 
 %extend SystemClock {
   int Step() {
@@ -169,16 +171,6 @@ namespace std {
 %include "flash.h"
 %include "hweeprom.h"
 
-%extend Breakpoints {
-  void RemoveBreakpoint(unsigned bp) {
-    Breakpoints::iterator ii;
-    if ((ii = find($self->begin(), $self->end(), bp)) != $self->end()) $self->erase(ii);
-  }
-  void AddBreakpoint(unsigned bp) {
-    $self->push_back(bp);
-  }
-}
-
 %include "avrsignature.h"
 
 %include "avrerror.h"
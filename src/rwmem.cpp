@@ -101,9 +101,6 @@ CLKPRRegister::CLKPRRegister(AvrDevice *core,
     else
         value = 0;
     activate = 0;
-
-    // connect to core to get core cycles
-    core->AddToCycleList(this);
 }
 
 void CLKPRRegister::Reset(void) {
@@ -120,13 +117,19 @@ unsigned int CLKPRRegister::CpuCycle(void) {
         activate--;
         value &= 0x7f; // reset CLKPCE, if set
     }
+    // core cycles are only needed while activation period
+    if(activate == 0)
+        _core->RemoveFromCycleList(this);
     return 0;
 }
 
 void CLKPRRegister::set(unsigned char v) {
     if(v == 0x80) {
-        // set activation period
-        if(activate == 0) activate = 4;
+        // set activation period and connect to core to get core cycles
+        if(activate == 0) {
+            activate = 4;
+            _core->AddToCycleList(this);
+        }
     } else if((v & 0x80) == 0) {
         if(activate > 0) {
             string buf = "<invalid>";
@@ -192,23 +195,31 @@ void OSCCALRegister::set(unsigned char v) {
     value = v;
 }
 
-RAM::RAM(TraceValueCoreRegister *_reg, const std::string &name, const size_t number, const size_t maxsize) {
-    corereg = _reg;
-    value = 0xaa;
+RAM::RAM(TraceValueCoreRegister *_reg, const std::string &name, const size_t number, const size_t maxsize, unsigned char *store) {
+    value = store;
+    *value = 0xaa;
+    directValue = *value;
     if(name.size()) {
-        tv = new TraceValue(8, corereg->GetTraceValuePrefix() + name, number);
-        if(!corereg) {
+        tv = new TraceValue(8, _reg->GetTraceValuePrefix() + name, number);
+        if(!_reg) {
             avr_error("registry not initialized for RWMemoryMember '%s'.", name.c_str());
         }
-        corereg->RegisterTraceSetValue(tv, name, maxsize);
+        _reg->RegisterTraceSetValue(tv, name, maxsize);
     } else {
         tv = NULL;
     }
 }
 
-unsigned char RAM::get() const { return value; }
+unsigned char RAM::get() const { return *value; }
+
+void RAM::set(unsigned char v) { *value=v; }
 
-void RAM::set(unsigned char v) { value=v; }
+void RAM::SetDirectAccess(bool direct) {
+    if(direct)
+        directValue = *value;
+    else if(tv != NULL && *value != directValue)
+        tv->set_written(*value);
+}
 
 InvalidMem::InvalidMem(AvrDevice* _c, int _a):
     RWMemoryMember(),
@@ -217,8 +228,11 @@ InvalidMem::InvalidMem(AvrDevice* _c, int _a):
 
 unsigned char InvalidMem::get() const {
     string s = "Invalid read access from IO[0x" + int2hex(addr) + "], PC=0x" + int2hex(core->PC * 2);
-    if(core->abortOnInvalidAccess)
+    DumpManager::Instance()->Trigger("invalid read access");
+    if(core->abortOnInvalidAccess) {
+        DumpManager::Instance()->stopApplication(); // write trace window before exit
         avr_error("%s", s.c_str());
+    }
     avr_warning("%s", s.c_str());
     return 0;
 }
@@ -226,8 +240,11 @@ unsigned char InvalidMem::get() const {
 void InvalidMem::set(unsigned char c) {
     string s = "Invalid write access to IO[0x" + int2hex(addr) +
         "]=0x" + int2hex(c) + ", PC=0x" + int2hex(core->PC * 2);
-    if(core->abortOnInvalidAccess)
+    DumpManager::Instance()->Trigger("invalid write access");
+    if(core->abortOnInvalidAccess) {
+        DumpManager::Instance()->stopApplication(); // write trace window before exit
         avr_error("%s", s.c_str());
+    }
     avr_warning("%s", s.c_str());
 }
 
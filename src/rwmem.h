@@ -33,6 +33,7 @@
 #include "traceval.h"
 #include "avrerror.h"
 #include "hardware.h"
+#include "snapshot.h"
 
 class TraceValue;
 
@@ -66,6 +67,8 @@ class RWMemoryMember {
         virtual ~RWMemoryMember();
         const std::string &GetTraceName(void) { return tracename; }
         bool IsInvalid(void) const { return isInvalid; } 
+        //! Returns true, if a read access changes nothing (used to find idle loops)
+        virtual bool IsReadSideEffectFree(void) const { return false; }
 
     protected:
         /*! This function is the function which will
@@ -101,6 +104,8 @@ class GPIORegister: public RWMemoryMember, public Hardware {
         
         // from Hardware
         void Reset(void) { value = 0; }
+        void SerializeState(Snapshot &snap) { snap.Value(value); }
+        bool IsReadSideEffectFree(void) const { return true; }
         
     protected:
         unsigned char get() const { return value; }
@@ -120,6 +125,7 @@ class CLKPRRegister: public RWMemoryMember, public Hardware {
         // from Hardware
         void Reset(void);
         unsigned int CpuCycle(void);
+        void SerializeState(Snapshot &snap) { snap.Value(value); snap.Value(activate); }
 
     protected:
         unsigned char get() const { return value; }
@@ -140,6 +146,7 @@ class XDIVRegister: public RWMemoryMember, public Hardware {
 
         // from Hardware
         void Reset(void) { value = 0; }
+        void SerializeState(Snapshot &snap) { snap.Value(value); }
 
     protected:
         unsigned char get() const { return value; }
@@ -166,6 +173,7 @@ class OSCCALRegister: public RWMemoryMember, public Hardware {
 
         // from Hardware
         void Reset(void);
+        void SerializeState(Snapshot &snap) { snap.Value(value); }
 
     protected:
         unsigned char get() const { return value; }
@@ -184,15 +192,25 @@ class RAM : public RWMemoryMember {
         RAM(TraceValueCoreRegister *registry,
             const std::string &tracename,
             const size_t number,
-            const size_t maxsize);
+            const size_t maxsize,
+            unsigned char *store);
+
+        //! Returns true, if the trace value of this cell is used by a dumper
+        bool IsTraced(void) const { return tv != NULL && tv->enabled(); }
+        //! Informs cell, that AvrDevice starts or stops to access the value directly
+        /*! Direct access bypasses the TraceValue. If the value was changed
+          while access was direct, the TraceValue gets the current value (as
+          written value) on end of direct access. */
+        void SetDirectAccess(bool direct);
+        bool IsReadSideEffectFree(void) const { return true; }
         
     protected:
         unsigned char get() const;
         void set(unsigned char);
         
     private:
-        unsigned char value;
-        TraceValueCoreRegister *corereg;
+        unsigned char *value; //!< value of this cell in the memory store of the device
+        unsigned char directValue; //!< value on start of direct access
 };
 
 //! Memory on which access should be avoided! :-)
@@ -245,7 +263,8 @@ class IOReg: public RWMemoryMember {
             RWMemoryMember(registry, tracename),
             p(_p),
             g(_g),
-            s(_s)
+            s(_s),
+            readSideEffectFree(false)
         {
             // 'undefined state' doesn't really make sense for IO registers 
             if (tv)
@@ -255,6 +274,10 @@ class IOReg: public RWMemoryMember {
         /*! Reflects a value change from hardware (for example timer count occured)
           @param val the new register value */
         void hardwareChange(unsigned char val) { if(tv) tv->change(val); }
+        /*! Marks register as free of side effects on read (like PINx, but
+          not UDR or SPDR), see RWMemoryMember::IsReadSideEffectFree */
+        void SetReadSideEffectFree(void) { readSideEffectFree = true; }
+        bool IsReadSideEffectFree(void) const { return readSideEffectFree; }
         /*! Releases the TraceValue to hide this IOReg from registry */
         void releaseTraceValue(void) {
             if(tv) {
@@ -285,6 +308,7 @@ class IOReg: public RWMemoryMember {
         P *p;
         getter_t g;
         setter_t s;
+        bool readSideEffectFree; //!< read of register changes nothing, see SetReadSideEffectFree
 };
 
 class IOSpecialReg;
@@ -348,6 +372,12 @@ class IOSpecialReg: public RWMemoryMember {
           @param val the new register value
           @param mask the bitmask for val */
         void hardwareChangeMask(unsigned char val, unsigned char mask) { if(tv) tv->change(val, mask); }
+
+        //! Returns internal register value, without informing clients and TraceValue
+        unsigned char GetValue(void) const { return value; }
+
+        //! Saves or restores register value, see Snapshot
+        void SerializeState(Snapshot &snap) { snap.Value(value); }
         
     protected:
         std::vector<IOSpecialRegClient*> clients; //!< clients-list with registered clients
@@ -0,0 +1,105 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph		
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include "simulationcontext.h"
+#include "systemclock.h"
+#include "traceval.h"
+#include "application.h"
+#include "avrdevice.h"
+#include "snapshot.h"
+
+#ifdef _MSC_VER
+#   define THREAD_LOCAL __declspec(thread)
+#else
+#   define THREAD_LOCAL __thread
+#endif
+
+//! Context, which is set by SimulationContext::SetCurrent for the calling thread
+static THREAD_LOCAL SimulationContext *currentContext = NULL;
+
+SimulationContext::SimulationContext() {
+    clock = new SystemClock();
+    dumpManager = new DumpManager();
+    application = new Application();
+}
+
+SimulationContext::~SimulationContext() {
+    SimulationContext *old = currentContext;
+    currentContext = this;
+
+    // a device unregisters itself from DumpManager on destruction
+    while(!dumpManager->devices.empty())
+        delete dumpManager->devices.back();
+    delete dumpManager;
+    delete application;
+    delete clock;
+
+    currentContext = (old == this) ? NULL : old;
+}
+
+SimulationContext *SimulationContext::Current(void) {
+    if(currentContext != NULL)
+        return currentContext;
+    return Default();
+}
+
+SimulationContext *SimulationContext::Default(void) {
+    // never destroyed, like the former singletons
+    static SimulationContext *ctx = new SimulationContext();
+    return ctx;
+}
+
+void SimulationContext::SetCurrent(SimulationContext *ctx) {
+    currentContext = ctx;
+}
+
+void SimulationContext::SerializeState(Snapshot &snap) {
+    // hardware units use the SystemClock of current context
+    SimulationContext *old = currentContext;
+    currentContext = this;
+
+    snap.Check("simulavr snapshot", 1);
+    snap.Check("device count", dumpManager->devices.size());
+    snap.Value(clock->currentTime);
+    for(unsigned int i = 0; i < dumpManager->devices.size(); i++) {
+        AvrDevice *dev = dumpManager->devices[i];
+        // a device is in time table or stepped by gdb server, this depends
+        // on setup of simulation and not on snapshot
+        clock->SerializeMember(snap, dev, true);
+        dev->SerializeState(snap);
+    }
+
+    currentContext = old;
+}
+
+void SimulationContext::SaveState(std::ostream &out) {
+    Snapshot snap(out);
+    SerializeState(snap);
+}
+
+void SimulationContext::RestoreState(std::istream &in) {
+    Snapshot snap(in);
+    SerializeState(snap);
+}
@@ -0,0 +1,96 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph		
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef SIMULATIONCONTEXT
+#define SIMULATIONCONTEXT
+
+#include <iostream>
+
+class SystemClock;
+class DumpManager;
+class Application;
+class Snapshot;
+
+//! Holds all objects, which are global for one simulation
+/*! A simulation context owns the time table (SystemClock), the DumpManager
+    and the Application instance of a simulation. SystemClock::Instance(),
+    DumpManager::Instance() and Application::GetInstance() return the objects
+    of the context, which is current for the calling thread. If no context is
+    set for a thread, it's the default context, so applications with only one
+    simulation don't need to care about contexts at all.
+
+    Devices are bound to the current context on creation. So, to run many
+    independent simulations in one process, create a context for each
+    simulation, make it current with SetCurrent, create the devices and run
+    the simulation. Contexts can run concurrently on different threads, but
+    one context must be used only by one thread at a time. Deleting a
+    context deletes also all devices, which were created within it. */
+class SimulationContext {
+
+    private:
+        SystemClock *clock;        //!< time table of this simulation
+        DumpManager *dumpManager;  //!< dumpers and devices of this simulation
+        Application *application;  //!< printables of this simulation
+
+        SimulationContext(const SimulationContext &); //!< no copy of a context
+
+        //! Saves or restores simulation time and all devices, see Snapshot
+        void SerializeState(Snapshot &snap);
+
+    public:
+        SimulationContext();
+        //! Destroys all devices of this context and the context itself
+        ~SimulationContext();
+
+        SystemClock &GetSystemClock(void) { return *clock; }
+        DumpManager *GetDumpManager(void) { return dumpManager; }
+        Application *GetApplication(void) { return application; }
+
+        //! Saves the state of the simulation to a stream
+        /*! The snapshot holds simulation time and the complete state of all
+            devices: registers, RAM, flash, eeprom, hardware units, pending
+            interrupts and the place of every device in time table. Other
+            simulation members (gdb server, external parts like serial
+            consoles) and dumpers aren't saved. */
+        void SaveState(std::ostream &out);
+        //! Restores a state, which was saved by SaveState
+        /*! The context must hold the same devices (same types, created in
+            same order) like the saved context, so normally the simulation is
+            set up the same way (device, program) before the state is restored.
+            A mismatch aborts with a error. TraceValue shadow values and
+            dumpers aren't updated on restore: a trace (VCD or other dumper)
+            shows a restored value only, when it's changed again by the
+            simulation. */
+        void RestoreState(std::istream &in);
+
+        //! Returns the context, which is current for the calling thread
+        static SimulationContext *Current(void);
+        //! Returns the default context, used, if no context is set by SetCurrent
+        static SimulationContext *Default(void);
+        //! Sets the current context for the calling thread, NULL switches back to default context
+        static void SetCurrent(SimulationContext *ctx);
+};
+
+#endif
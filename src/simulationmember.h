@@ -28,6 +28,8 @@
 
 #include "systemclocktypes.h"
 
+class AvrDevice;
+
 /** Any class which is needs to be notified at certain time implements this.
 * Implementor usually calls SystemClock::Add(this) and its SimulationMember::Step()
 * will be called later. People, please avoid polling. */
@@ -36,6 +38,9 @@ class SimulationMember {
         virtual ~SimulationMember() { }
         /// Return nonzero if a breakpoint was hit.
         virtual int Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns=0)=0;
+        /// Return the device, which owns this member, NULL for a independent member.
+        /// Members of a device run in the partition of their device, see SystemClock::RunParallel.
+        virtual AvrDevice *GetOwnerDevice(void) { return 0; }
 };
 
 #endif 
@@ -12,6 +12,7 @@
 #include "atmega128.h"
 #include "at4433.h"
 #include "systemclock.h"
+#include "simulationcontext.h"
 #include "ui/ui.h"
 #include "hardware.h"
 #include "pin.h"
@@ -61,6 +62,7 @@ namespace std {
 %include "atmega128.h"
 %include "at4433.h"
 %include "systemclock.h"
+%include "simulationcontext.h"
 %include "ui/ui.h"
 %include "hardware.h"
 %include "pin.h"
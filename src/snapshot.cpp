@@ -0,0 +1,63 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph		
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include "snapshot.h"
+#include "avrerror.h"
+
+void Snapshot::Block(void *data, size_t size) {
+    if(os != NULL) {
+        os->write((const char *)data, size);
+        if(!*os)
+            avr_error("can't write snapshot");
+    } else {
+        is->read((char *)data, size);
+        if(!*is)
+            avr_error("snapshot is truncated");
+    }
+}
+
+void Snapshot::String(std::string &s) {
+    unsigned int size = s.size();
+    Value(size);
+    std::vector<char> buf(s.begin(), s.end());
+    buf.resize(size + 1);
+    Block(&buf[0], size);
+    s.assign(&buf[0], size);
+}
+
+void Snapshot::Check(const std::string &tag) {
+    std::string s = tag;
+    String(s);
+    if(s != tag)
+        avr_error("snapshot doesn't match: expected '%s', found '%s'", tag.c_str(), s.c_str());
+}
+
+void Snapshot::Check(const std::string &tag, unsigned long value) {
+    unsigned long v = value;
+    Check(tag);
+    Value(v);
+    if(v != value)
+        avr_error("snapshot doesn't match: %s is %lu, but %lu in snapshot", tag.c_str(), value, v);
+}
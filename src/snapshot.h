@@ -0,0 +1,75 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph		
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef SNAPSHOT
+#define SNAPSHOT
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+//! Binary archive to save and restore the state of a simulation
+/*! The same SerializeState method of a simulation object is used for both
+    directions: on saving, Value and Block write the given variable to the
+    stream, on restoring they overwrite the variable with the value read from
+    stream. So the order of values is always the same. A snapshot can only be
+    restored to a simulation, which is set up the same way (same device types,
+    same simulavr binary), the content isn't portable. */
+class Snapshot {
+
+    protected:
+        std::ostream *os; //!< stream to save state, NULL on restore
+        std::istream *is; //!< stream to restore state, NULL on save
+
+    public:
+        //! Creates a archive, which saves state to given stream
+        Snapshot(std::ostream &out): os(&out), is(NULL) {}
+        //! Creates a archive, which restores state from given stream
+        Snapshot(std::istream &in): os(NULL), is(&in) {}
+
+        //! True, if state is restored from stream
+        bool IsRestoring(void) const { return is != NULL; }
+
+        //! Saves or restores a memory block
+        void Block(void *data, size_t size);
+        //! Saves or restores a variable of a basic type (or a struct without pointers)
+        template<typename T> void Value(T &v) { Block(&v, sizeof(T)); }
+        //! Saves or restores a vector of basic type elements
+        template<typename T> void Vector(std::vector<T> &v) {
+            unsigned int size = v.size();
+            Value(size);
+            v.resize(size);
+            if(size > 0)
+                Block(&v[0], size * sizeof(T));
+        }
+        //! Saves or restores a string
+        void String(std::string &s);
+        //! Saves a tag or checks it on restore, aborts, if snapshot doesn't match
+        void Check(const std::string &tag);
+        //! Saves a value or checks it on restore, aborts, if snapshot doesn't match
+        void Check(const std::string &tag, unsigned long value);
+};
+
+#endif
@@ -27,6 +27,8 @@
 #include <cstdlib>
 #include "specialmem.h"
 #include "avrerror.h"
+#include "avrdevice.h"
+#include "executionhistory.h"
 
 using namespace std;
 
@@ -34,15 +36,35 @@ RWWriteToFile::RWWriteToFile(TraceValueRegister *registry,
                              const string &tracename,
                              const string &filename):
     RWMemoryMember(registry, tracename),
-    os(filename=="-" ? cout : ofs)
+    core(dynamic_cast<AvrDevice *>(registry)),
+    os(NULL)
 {
-    if(filename != "-")
+    if(filename != "")
+        Open(filename);
+}
+
+void RWWriteToFile::Open(const string &filename) {
+    if(filename == "-")
+        os = &cout;
+    else {
         ofs.open(filename.c_str());
+        os = &ofs;
+    }
+    *os << pending;
+    os->flush();
+    pending.clear();
 }
 
 void RWWriteToFile::set(unsigned char val) {
-    os << val;
-    os.flush();
+    // byte was written already in live execution
+    if(core != NULL && core->history != NULL && core->history->IsReplaying())
+        return;
+    if(os == NULL) {
+        pending += val;
+        return;
+    }
+    *os << val;
+    os->flush();
 }
 
 unsigned char RWWriteToFile::get() const {
@@ -54,10 +76,20 @@ RWReadFromFile::RWReadFromFile(TraceValueRegister *registry,
                                const string &tracename,
                                const string &filename):
     RWMemoryMember(registry, tracename),
-    is((filename=="-") ? cin : ifs)
+    core(dynamic_cast<AvrDevice *>(registry)),
+    is(NULL)
 {
-    if(filename != "-")
+    if(filename != "")
+        Open(filename);
+}
+
+void RWReadFromFile::Open(const string &filename) {
+    if(filename == "-")
+        is = &cin;
+    else {
         ifs.open(filename.c_str());
+        is = &ifs;
+    }
 }
 
 void RWReadFromFile::set(unsigned char val) {
@@ -65,8 +97,14 @@ void RWReadFromFile::set(unsigned char val) {
 }
 
 unsigned char RWReadFromFile::get() const { 
-    char val;
-    is.get(val);
+    ExecutionHistory *history = (core != NULL) ? core->history : NULL;
+    if(history != NULL && history->IsReplaying())
+        return history->ReplayRead();
+    char val = 0;
+    if(is != NULL)
+        is->get(val);
+    if(history != NULL)
+        history->RecordRead(val);
     return val; 
 } 
 
@@ -32,6 +32,8 @@
 #include <fstream>
 #include "rwmem.h"
 
+class AvrDevice;
+
 //! FIFO write memory
 /*! Memory register which will redirect all write
   accesses to the given (FIFO) file. The output
@@ -39,16 +41,22 @@
 class RWWriteToFile: public RWMemoryMember {
  public:
     /*! The output filename can be '-' which will
-      make this object use cout then. */
+      make this object use cout then. A empty filename
+      creates the register without file, see Open. */
     RWWriteToFile(TraceValueRegister *registry,
                   const std::string &tracename,
                   const std::string &filename);
+    //! Connects a register without file to filename
+    /*! Bytes written before are kept and written to the file first. */
+    void Open(const std::string &filename);
  protected:
     unsigned char get() const;
     void set(unsigned char);
 
-    std::ostream &os;
+    AvrDevice *core; //!< device of registry or NULL, output isn't repeated in replay of it's history
+    std::ostream *os; //!< cout, ofs or NULL without file
     std::ofstream ofs;
+    std::string pending; //!< bytes written without file
 };
 
 //! FIFO read memory
@@ -58,15 +66,20 @@ class RWWriteToFile: public RWMemoryMember {
 class RWReadFromFile: public RWMemoryMember {
  public:
     /*! The input filename can be '-' which will
-      make this object use cin then. */
+      make this object use cin then. A empty filename
+      creates the register without file, it reads 0
+      like on end of file, see Open. */
     RWReadFromFile(TraceValueRegister *registry,
                    const std::string &tracename,
                    const std::string &filename);
+    //! Connects a register without file to filename
+    void Open(const std::string &filename);
  protected:
     unsigned char get() const;
     void set(unsigned char);
 
-    std::istream &is;
+    AvrDevice *core; //!< device of registry or NULL, read bytes are recorded in it's history
+    std::istream *is; //!< cin, ifs or NULL without file
     mutable std::ifstream ifs;
 };
 
@@ -23,6 +23,10 @@
  *  $Id$
  */
 
+#ifndef _MSC_VER
+#   include "config.h"
+#endif
+
 #include "systemclocktypes.h"
 #include "systemclock.h"
 #include "simulationmember.h"
@@ -30,10 +34,39 @@
 #include "application.h"
 #include "avrdevice.h"
 #include "avrerror.h"
+#include "traceval.h"
+#include "net.h"
+#include "simulationcontext.h"
+#include "snapshot.h"
 
 #include "signal.h"
 #include <assert.h>
 
+#ifdef HAVE_LIBPTHREAD
+#   include <pthread.h>
+
+//! Time table of the partition, which is stepped by the current thread, see SystemClock::RunParallel
+static __thread SystemClock *partitionClock = NULL;
+
+//! Synchronisation of worker threads in SystemClock::RunParallel
+struct ParallelRun {
+    pthread_mutex_t mutex;
+    pthread_cond_t startCond;       //!< signals a new time window to workers
+    pthread_cond_t doneCond;        //!< signals end of all workers to main thread
+    unsigned long window;           //!< count of started time windows
+    unsigned int running;           //!< count of workers, which haven't finished current window
+    bool stop;                      //!< workers have to exit
+    SystemClockOffset windowEnd;    //!< end of current time window
+};
+
+//! One worker thread in SystemClock::RunParallel with it's partitions
+struct ParallelWorkerData {
+    ParallelRun *run;
+    std::vector<SystemClock*> partitions;
+    pthread_t thread;
+};
+#endif
+
 using namespace std;
 
 template<typename Key, typename Value>
@@ -109,11 +142,17 @@ void MinHeap<Key, Value>::RemoveAtPositionAndInsertInternal(Key k, Value v, unsi
 }
 
 SystemClock::SystemClock() { 
-    static int no = 0;
     currentTime = 0; 
-    no++;
-    if(no > 1)
-        avr_error("Crazy problem: Second instance of SystemClock created!");
+    runEndTime = numeric_limits<SystemClockOffset>::max();
+    inTimeWindow = false;
+    stopRequest = false;
+}
+
+SystemClock::SystemClock(bool partition) {
+    currentTime = 0;
+    runEndTime = numeric_limits<SystemClockOffset>::max();
+    inTimeWindow = false;
+    stopRequest = false;
 }
 
 void SystemClock::SetTraceModeForAllMembers(int trace_on) {
@@ -139,8 +178,8 @@ int SystemClock::Step(bool &untilCoreStepFinished) {
     int res = 0; // returns the state from a core step. Needed by gdb-server to
                  // watch for breakpoints
 
-    static vector<SimulationMember*>::iterator ami;
-    static vector<SimulationMember*>::iterator amiEnd;
+    vector<SimulationMember*>::iterator ami;
+    vector<SimulationMember*>::iterator amiEnd;
 
     if(syncMembers.begin() != syncMembers.end()) {
         // take simulation member and current simulation time from time table
@@ -186,6 +225,38 @@ void SystemClock::Rescedule(SimulationMember *sm, SystemClockOffset newTime) {
     syncMembers.Insert(newTime+currentTime+1, sm);
 }
 
+void SystemClock::SerializeMember(Snapshot &snap, SimulationMember *member, bool keepMembership) {
+    bool scheduled = false;
+    SystemClockOffset time = 0;
+    for(unsigned i = 0; i < syncMembers.size(); i++) {
+        if(syncMembers[i].second == member) {
+            scheduled = true;
+            time = syncMembers[i].first;
+        }
+    }
+    bool wasScheduled = scheduled;
+    snap.Value(scheduled);
+    snap.Value(time);
+    if(!snap.IsRestoring())
+        return;
+    if(keepMembership) {
+        if(!wasScheduled)
+            return;
+        if(!scheduled)
+            time = currentTime;
+        scheduled = true;
+    }
+
+    MinHeap<SystemClockOffset, SimulationMember *> table;
+    for(unsigned i = 0; i < syncMembers.size(); i++) {
+        if(syncMembers[i].second != member)
+            table.Insert(syncMembers[i].first, syncMembers[i].second);
+    }
+    if(scheduled)
+        table.Insert(time, member);
+    syncMembers = table;
+}
+
 volatile int breakMessage = false;
 
 void OnBreak(int s) {
@@ -195,23 +266,25 @@ void OnBreak(int s) {
 }
 
 void SystemClock::stop() {
-    breakMessage = true;
+    stopRequest = true;
 }
 
 void SystemClock::ResetClock(void) {
     asyncMembers.clear();
     syncMembers.clear();
     currentTime = 0;
+    stopRequest = false;
 }
 
 void SystemClock::Endless() {
     breakMessage = false;        // if we run a second loop, clear break before entering loop
+    stopRequest = false;
     int steps = 0;
     
     signal(SIGINT, OnBreak);
     signal(SIGTERM, OnBreak);
 
-    while(breakMessage == false) {
+    while((breakMessage == false) && (stopRequest == false)) {
         steps++;
         bool untilCoreStepFinished = false;
         Step(untilCoreStepFinished);
@@ -228,12 +301,14 @@ void SystemClock::Run(SystemClockOffset maxRunTime) {
     signal(SIGINT, OnBreak);
     signal(SIGTERM, OnBreak);
 
-    while((breakMessage== false) &&
-          (SystemClock::Instance().GetCurrentTime() < maxRunTime)) {
+    runEndTime = maxRunTime;
+    while((breakMessage == false) && (stopRequest == false) &&
+          (currentTime < maxRunTime)) {
         steps++;
         bool untilCoreStepFinished =false;
         Step(untilCoreStepFinished);
     }
+    runEndTime = numeric_limits<SystemClockOffset>::max();
 
     cout << endl << "Ran too long.  Terminated after " << maxRunTime;
     cout << " simulated nanoseconds." << endl;
@@ -248,18 +323,229 @@ int SystemClock::RunTimeRange(SystemClockOffset timeRange) {
     signal(SIGINT, OnBreak);
     signal(SIGTERM, OnBreak);
     
-    timeRange += SystemClock::Instance().GetCurrentTime();
-    while((breakMessage == false) && (SystemClock::Instance().GetCurrentTime() < timeRange)) {
+    timeRange += currentTime;
+    runEndTime = timeRange;
+    while((breakMessage == false) && (stopRequest == false) && (currentTime < timeRange)) {
         untilCoreStepFinished = false;
         res = Step(untilCoreStepFinished);
         if(res != 0)
             break;
     }
+    runEndTime = numeric_limits<SystemClockOffset>::max();
     
     return res;
 }
 
+bool SystemClock::QueueNetCalculation(Net *net) {
+    if(!inTimeWindow)
+        return false;
+    if(pendingNets.empty() || pendingNets.back() != net)
+        pendingNets.push_back(net);
+    return true;
+}
+
+void SystemClock::StepTimeWindow(SystemClockOffset windowEnd) {
+    runEndTime = windowEnd;
+    inTimeWindow = true;
+    while(!stopRequest && !syncMembers.IsEmpty() && syncMembers.GetMinimumKey() < windowEnd) {
+        bool untilCoreStepFinished = false;
+        Step(untilCoreStepFinished);
+    }
+    inTimeWindow = false;
+    runEndTime = numeric_limits<SystemClockOffset>::max();
+}
+
+void SystemClock::StepPartitions(vector<SystemClock*> &partitions, SystemClockOffset windowEnd) {
+    for(unsigned int i = 0; i < partitions.size(); i++) {
+#ifdef HAVE_LIBPTHREAD
+        partitionClock = partitions[i];
+#endif
+        partitions[i]->StepTimeWindow(windowEnd);
+    }
+#ifdef HAVE_LIBPTHREAD
+    partitionClock = NULL;
+#endif
+}
+
+void *SystemClock::ParallelWorker(void *worker) {
+#ifdef HAVE_LIBPTHREAD
+    ParallelWorkerData *w = (ParallelWorkerData *)worker;
+    ParallelRun *run = w->run;
+    unsigned long window = 0;
+
+    pthread_mutex_lock(&run->mutex);
+    for(;;) {
+        while(run->window == window && !run->stop)
+            pthread_cond_wait(&run->startCond, &run->mutex);
+        if(run->stop)
+            break;
+        window = run->window;
+        SystemClockOffset windowEnd = run->windowEnd;
+        pthread_mutex_unlock(&run->mutex);
+
+        StepPartitions(w->partitions, windowEnd);
+
+        pthread_mutex_lock(&run->mutex);
+        if(--run->running == 0)
+            pthread_cond_signal(&run->doneCond);
+    }
+    pthread_mutex_unlock(&run->mutex);
+#endif
+    return NULL;
+}
+
+void SystemClock::RunParallel(SystemClockOffset timeRange, SystemClockOffset quantum, unsigned int threads) {
+    bool traced = DumpManager::Instance()->IsActive();
+    for(unsigned int i = 0; i < syncMembers.size(); i++) {
+        AvrDevice *core = dynamic_cast<AvrDevice*>(syncMembers[i].second);
+        if(core != NULL && (core->trace_on || core->binaryTrace != NULL))
+            traced = true;
+    }
+#ifdef HAVE_LIBPTHREAD
+    if(quantum <= 0)
+        avr_error("time window for parallel simulation must be greater than 0");
+    if(traced) {
+        avr_warning("tracing isn't possible with parallel simulation, run sequential");
+        RunTimeRange(timeRange);
+        return;
+    }
+
+    signal(SIGINT, OnBreak);
+    signal(SIGTERM, OnBreak);
+
+    // split time table into partitions, one for each device with the members
+    // owned by the device (like a async timer clock), one for the rest
+    vector<SystemClock*> partitions;
+    map<Pin*, SystemClock*> pinOwner;
+    map<AvrDevice*, SystemClock*> devicePartition;
+    SystemClock *rest = new SystemClock(true);
+    partitions.push_back(rest);
+    for(unsigned int i = 0; i < syncMembers.size(); i++) {
+        AvrDevice *core = syncMembers[i].second->GetOwnerDevice();
+        if(core == NULL || devicePartition.find(core) != devicePartition.end())
+            continue;
+        SystemClock *part = new SystemClock(true);
+        partitions.push_back(part);
+        devicePartition[core] = part;
+        const map<string, Pin*> &pins = core->GetAllPins();
+        for(map<string, Pin*>::const_iterator pi = pins.begin(); pi != pins.end(); pi++)
+            pinOwner[pi->second] = part;
+    }
+    for(unsigned int i = 0; i < syncMembers.size(); i++) {
+        AvrDevice *core = syncMembers[i].second->GetOwnerDevice();
+        SystemClock *part = (core == NULL) ? rest : devicePartition[core];
+        part->syncMembers.Insert(syncMembers[i].first, syncMembers[i].second);
+    }
+    syncMembers.clear();
+    for(unsigned int i = 0; i < partitions.size(); i++)
+        partitions[i]->currentTime = currentTime;
+
+    // find nets, which connect pins of different partitions
+    vector<Net*> sharedNets;
+    for(map<Pin*, SystemClock*>::iterator pi = pinOwner.begin(); pi != pinOwner.end(); pi++) {
+        Net *net = pi->first->GetNet();
+        if(net == NULL || net->shared)
+            continue;
+        for(Net::iterator ni = net->begin(); ni != net->end(); ni++) {
+            map<Pin*, SystemClock*>::iterator owner = pinOwner.find(*ni);
+            if((owner == pinOwner.end() ? rest : owner->second) != pi->second) {
+                net->shared = true;
+                sharedNets.push_back(net);
+                break;
+            }
+        }
+    }
+
+    // distribute partitions on threads, first worker is the calling thread
+    if(threads == 0 || threads > partitions.size())
+        threads = partitions.size();
+    ParallelRun run;
+    pthread_mutex_init(&run.mutex, NULL);
+    pthread_cond_init(&run.startCond, NULL);
+    pthread_cond_init(&run.doneCond, NULL);
+    run.window = 0;
+    run.running = 0;
+    run.stop = false;
+    vector<ParallelWorkerData> workers(threads);
+    for(unsigned int i = 0; i < partitions.size(); i++)
+        workers[i % threads].partitions.push_back(partitions[i]);
+    for(unsigned int i = 0; i < threads; i++) {
+        workers[i].run = &run;
+        if(i > 0 && pthread_create(&workers[i].thread, NULL, ParallelWorker, &workers[i]) != 0)
+            avr_error("can't create thread for parallel simulation");
+    }
+
+    SystemClockOffset endTime = currentTime + timeRange;
+    while((breakMessage == false) && (stopRequest == false) && (currentTime < endTime)) {
+        SystemClockOffset windowEnd = currentTime + quantum;
+        if(windowEnd > endTime)
+            windowEnd = endTime;
+
+        pthread_mutex_lock(&run.mutex);
+        run.windowEnd = windowEnd;
+        run.running = threads - 1;
+        run.window++;
+        pthread_cond_broadcast(&run.startCond);
+        pthread_mutex_unlock(&run.mutex);
+
+        StepPartitions(workers[0].partitions, windowEnd);
+
+        pthread_mutex_lock(&run.mutex);
+        while(run.running > 0)
+            pthread_cond_wait(&run.doneCond, &run.mutex);
+        pthread_mutex_unlock(&run.mutex);
+
+        // all threads wait now, deliver pin changes between partitions. Simulation
+        // members added on pin changes are added to the partition for the rest.
+        currentTime = windowEnd;
+        for(unsigned int i = 0; i < partitions.size(); i++)
+            partitions[i]->currentTime = windowEnd;
+        partitionClock = rest;
+        for(unsigned int i = 0; i < partitions.size(); i++) {
+            if(partitions[i]->stopRequest)
+                stopRequest = true;
+            vector<Net*> &nets = partitions[i]->pendingNets;
+            for(unsigned int j = 0; j < nets.size(); j++)
+                nets[j]->CalcNet();
+            nets.clear();
+        }
+        partitionClock = NULL;
+
+        for(unsigned int i = 0; i < asyncMembers.size(); i++) {
+            bool untilCoreStepFinished = false;
+            asyncMembers[i]->Step(untilCoreStepFinished, 0);
+        }
+    }
+
+    pthread_mutex_lock(&run.mutex);
+    run.stop = true;
+    pthread_cond_broadcast(&run.startCond);
+    pthread_mutex_unlock(&run.mutex);
+    for(unsigned int i = 1; i < threads; i++)
+        pthread_join(workers[i].thread, NULL);
+    pthread_cond_destroy(&run.doneCond);
+    pthread_cond_destroy(&run.startCond);
+    pthread_mutex_destroy(&run.mutex);
+
+    // join partitions back to one time table
+    for(unsigned int i = 0; i < sharedNets.size(); i++)
+        sharedNets[i]->shared = false;
+    for(unsigned int i = 0; i < partitions.size(); i++) {
+        MinHeap<SystemClockOffset, SimulationMember *> &members = partitions[i]->syncMembers;
+        for(unsigned int j = 0; j < members.size(); j++)
+            syncMembers.Insert(members[j].first, members[j].second);
+        delete partitions[i];
+    }
+#else
+    avr_warning("simulavr is built without thread support, run sequential");
+    RunTimeRange(timeRange);
+#endif
+}
+
 SystemClock& SystemClock::Instance() {
-    static SystemClock obj;
-    return obj;
+#ifdef HAVE_LIBPTHREAD
+    if(partitionClock != NULL)
+        return *partitionClock;
+#endif
+    return SimulationContext::Current()->GetSystemClock();
 }
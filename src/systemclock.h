@@ -28,10 +28,13 @@
 
 #include <map>
 #include <vector>
+#include <limits>
 
 #include "systemclocktypes.h"
 
 class SimulationMember;
+class Net;
+class Snapshot;
 
 /** A heap data structure optimized for obtaining Value of the smallest Key.
     Example MinHeap<SystemClockOffset, SimulationMember*>. */
@@ -82,13 +85,26 @@ protected:
 class SystemClock
 {
     private:
-        SystemClock(); //!< Do not this constructor from application code!
+        friend class SimulationContext;
+        SystemClock(); //!< Do not this constructor from application code, see SimulationContext!
         SystemClock(const SystemClock &); //!< Do not this constructor from application code!
+        SystemClock(bool partition); //!< Creates a time table for one partition of RunParallel
+
+        //! Thread function for RunParallel, steps the partitions of one worker
+        static void *ParallelWorker(void *worker);
+        //! Steps all members of this partition, which are scheduled before windowEnd
+        void StepTimeWindow(SystemClockOffset windowEnd);
+        //! Steps all given partitions till windowEnd, one after the other
+        static void StepPartitions(std::vector<SystemClock*> &partitions, SystemClockOffset windowEnd);
 
     protected:
         SystemClockOffset currentTime;  //!< time in [ns] since start of simulation
         MinHeap<SystemClockOffset, SimulationMember *> syncMembers;  //!< earliest first
         std::vector<SimulationMember*> asyncMembers; //!< List of asynchron working simulation members, will be called every step!
+        SystemClockOffset runEndTime; //!< end of time range of Run or RunTimeRange, simulation members must not step over it
+        bool inTimeWindow; //!< true, while a partition steps it's members in a time window of RunParallel
+        bool stopRequest; //!< set by stop method, ends Run, RunTimeRange, Endless or RunParallel
+        std::vector<Net*> pendingNets; //!< shared nets changed by this partition in current time window
         
     public:
         //! Returns the current simulation time
@@ -99,6 +115,20 @@ class SystemClock
         //! Increments the current simulation time with a offset
         /*! Attention! Use this method with care, if you don't want crazy results */
         void IncrTime(SystemClockOffset of) { currentTime += of; }
+        //! Returns the time, where the next other simulation member has to be called
+        /*! Used by a simulation member to do more than one step inside it's own
+            Step method without disturbing the time order of other simulation
+            members. (the calling member isn't in time table while it's Step is
+            running) If async members exist, this is the current time, because
+            they have to be called on every step. Inside Run or RunTimeRange it
+            is never behind end of the time range. */
+        SystemClockOffset GetNextEventTime() const {
+            if(!asyncMembers.empty())
+                return currentTime;
+            if(syncMembers.IsEmpty() || syncMembers.GetMinimumKey() > runEndTime)
+                return runEndTime;
+            return syncMembers.GetMinimumKey();
+        }
         //! Add a simulation member (normally a device)
         void Add(SimulationMember *dev);
         //! Add a async simulation member, this will be called every simulation step.
@@ -111,8 +141,27 @@ class SystemClock
         void Run(SystemClockOffset maxRunTime);
         //! Like Run method, but stops on breakpoint or after given time offset
         int RunTimeRange(SystemClockOffset timeRange);
-        //! Returns the central SystemClock instance for the application
-        /*! There will be only one instance on a application! */
+        //! Like RunTimeRange, but runs every device on it's own thread
+        /*! Every AvrDevice gets it's own time table (partition), which holds
+            the device and all members owned by it (see
+            SimulationMember::GetOwnerDevice), all other simulation members
+            share one partition. Partitions are distributed
+            on threads (count of partitions, if threads is 0) and run
+            independently for a time window of quantum [ns], then all
+            threads synchronise. Nets, which connect pins of different
+            partitions, are calculated at the end of a time window, so a pin
+            change reaches other devices with a latency of up to one quantum.
+            Async simulation members are called once per time window. Breakpoints
+            are not handled and tracing isn't possible, with active tracing it
+            falls back to RunTimeRange. */
+        void RunParallel(SystemClockOffset timeRange, SystemClockOffset quantum, unsigned int threads = 0);
+        //! Queues a net, which connects pins of different partitions, for calculation at end of time window
+        /*! Returns false, if the net has to be calculated immediately, e.g. if
+            not called within a time window of RunParallel */
+        bool QueueNetCalculation(Net *net);
+        //! Returns the SystemClock instance of the current SimulationContext
+        /*! Inside of RunParallel it returns the time table of the partition,
+            which is stepped by the calling thread. */
         static SystemClock& Instance();
         //! Moves the given simulation member to a new place in time table
         /*! The next time, simulation member will be called, is calculated as a
@@ -120,9 +169,16 @@ class SystemClock
             
             \todo This method is possibly obsolete! */
         void Rescedule(SimulationMember *sm, SystemClockOffset newTime);
+        //! Saves or restores the place of a simulation member in time table
+        /*! On restore the member is removed from time table and inserted
+            again with the saved time, if it was scheduled, see Snapshot. If
+            keepMembership is true, only the time of a member, which is in
+            time table already, is changed, but it isn't added or removed. */
+        void SerializeMember(Snapshot &snap, SimulationMember *member, bool keepMembership = false);
         //! Switches trace mode for all current found simulation members
         void SetTraceModeForAllMembers(int trace_on);
         //! Gives the possibillity to stop Run od Endless method by programm
+        /*! Only the simulation of this SystemClock is stopped, see SimulationContext */
         void stop();
         //! Resets the simulation time and clears table for simulation members and async simulation members
         void ResetClock(void);
@@ -22,6 +22,10 @@
  *
  *  $Id$
  */
+#ifndef _MSC_VER
+#   include "config.h"
+#endif
+
 #include <algorithm>
 #include <fstream>
 #include <sstream>
@@ -31,6 +35,11 @@
 #include "avrdevice.h"
 #include "avrerror.h"
 #include "systemclock.h"
+#include "simulationcontext.h"
+
+#ifdef HAVE_LIBPTHREAD
+#   include <pthread.h>
+#endif
 
 using namespace std;
 
@@ -45,7 +54,9 @@ TraceValue::TraceValue(size_t bits,
     v(0xaffeaffe),
     f(0),
     _written(false),
-    _enabled(false) {}
+    _enabled(false),
+    _dumpIndex(-1),
+    _dirty(NULL) {}
 
 size_t TraceValue::bits() const { return b; }
 
@@ -65,10 +76,12 @@ bool TraceValue::enabled() const { return _enabled; }
 
 void TraceValue::enable() { _enabled=true; }
 
+int TraceValue::dumpIndex() const { return _dumpIndex; }
+
 void TraceValue::change(unsigned val) {
     // this is mostly the same as write, but dosn't set WRITE nor _written flag!
     if ((v != val) || !_written) {
-        f |= CHANGE;
+        setFlags(CHANGE);
         v = val;
     }
 }
@@ -76,22 +89,22 @@ void TraceValue::change(unsigned val) {
 void TraceValue::change(unsigned val, unsigned mask) {
     // this is mostly the same as write, but dosn't set WRITE nor _written flag!
     if (((v & mask) != (val & mask)) || !_written) {
-        f |= CHANGE;
+        setFlags(CHANGE);
         v = (v & ~mask) | (val & mask);
     }
 }
 
 void TraceValue::write(unsigned val) {
     if ((v != val) || !_written) {
-        f |= CHANGE;
+        setFlags(CHANGE);
         v = val;
     }
-    f |= WRITE;
+    setFlags(WRITE);
     _written = true;
 }
 
 void TraceValue::read() {
-    f |= READ;
+    setFlags(READ);
 }
 
 bool TraceValue::written() const { return _written;  }
@@ -107,6 +120,8 @@ void TraceValue::set_written(unsigned val) {
 
 TraceValue::Atype TraceValue::flags() const { return (Atype)f; }
 
+void TraceValue::clear_flags() { f = 0; }
+
 void TraceValue::cycle() {
     if (shadow) {
         unsigned nv;
@@ -124,7 +139,7 @@ void TraceValue::cycle() {
             break;
         }
         if (v!=nv) {
-            f|=CHANGE;
+            setFlags(CHANGE);
             _written=true; // FIXME: This detection can fail!
             v=nv;
         }
@@ -379,19 +394,119 @@ bool WarnUnknown::enabled(const TraceValue *t) const {
     return true;
 }
 
-void DumpVCD::valout(const TraceValue *v) {
-    osbuffer << 'b';
+//! Second buffer and writer thread of a DumpVCD
+struct DumpVCDWriter {
+    string buffer;              //!< buffer to write, empty if writer is idle
+#ifdef HAVE_LIBPTHREAD
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;        //!< signals a new buffer, stop or a written buffer
+    bool stop;                  //!< writer thread has to exit
+#endif
+};
+
+//! Size of buffer, which is given to writer thread
+static const size_t vcdBufferSize = 64 * 1024;
+
+//! Appends a time marker to buffer
+static void AppendTimeMarker(string &buf, SystemClockOffset clock) {
+    char num[24];
+    int pos = sizeof(num);
+    unsigned long long c = clock;
+    num[--pos] = '\n';
+    do {
+        num[--pos] = '0' + (c % 10);
+        c /= 10;
+    } while(c != 0);
+    num[--pos] = '#';
+    buf.append(num + pos, sizeof(num) - pos);
+}
+
+void DumpVCD::valout(string &buf, const TraceValue *v) {
+    buf += 'b';
     for (int i = v->bits()-1; i >= 0; i--)
-        osbuffer << v->VcdBit(i);
+        buf += v->VcdBit(i);
+}
 
+void DumpVCD::flushbuffer(bool force) {
+    // drop time marker, if nothing is changed in last cycle
+    if(!changesWritten)
+        buffer.resize(cycleStart);
+    changesWritten = false;
+    if(force || buffer.size() >= vcdBufferSize)
+        writebuffer();
+    cycleStart = buffer.size();
 }
 
-void DumpVCD::flushbuffer(void) {
-    if(changesWritten) {
-        *os << osbuffer.str();
-        changesWritten = false;
+void DumpVCD::writebuffer(void) {
+    if(buffer.empty())
+        return;
+    if(writer == NULL) {
+        os->write(buffer.data(), buffer.size());
+        buffer.clear();
+        return;
+    }
+#ifdef HAVE_LIBPTHREAD
+    pthread_mutex_lock(&writer->mutex);
+    while(!writer->buffer.empty())
+        pthread_cond_wait(&writer->cond, &writer->mutex);
+    writer->buffer.swap(buffer);
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->mutex);
+#endif
+}
+
+void DumpVCD::keepcycle(void) {
+    string &slot = ring[ringHead];
+    // oldest cycle leaves ring, it's part of state at begin of ring now
+    if(!slot.empty())
+        applystate(slot);
+    slot.clear();
+    if(changesWritten)
+        slot.swap(buffer);
+    buffer.clear();
+    ringTime[ringHead] = cycleTime;
+    ringHead = (ringHead + 1) % ring.size();
+    if(ringFill < ring.size())
+        ringFill++;
+    changesWritten = false;
+    cycleStart = 0;
+}
+
+void DumpVCD::applystate(const string &changes) {
+    size_t pos = 0;
+    while(pos < changes.size()) {
+        size_t end = changes.find('\n', pos);
+        // only value lines "b<bits> <id>", time markers and strobes are skipped
+        if(changes[pos] == 'b') {
+            size_t sp = changes.find(' ', pos);
+            unsigned n = atoi(changes.c_str() + sp + 1) / (1 + rs + ws);
+            ringState[n].assign(changes, pos, sp - pos);
+        }
+        pos = end + 1;
+    }
+}
+
+void *DumpVCD::WriterThread(void *dumper) {
+#ifdef HAVE_LIBPTHREAD
+    DumpVCD *d = (DumpVCD *)dumper;
+    DumpVCDWriter *w = d->writer;
+    pthread_mutex_lock(&w->mutex);
+    while(true) {
+        while(w->buffer.empty() && !w->stop)
+            pthread_cond_wait(&w->cond, &w->mutex);
+        if(w->buffer.empty())
+            break;
+        // simulation doesn't touch buffer, till it's empty again
+        pthread_mutex_unlock(&w->mutex);
+        d->os->write(w->buffer.data(), w->buffer.size());
+        pthread_mutex_lock(&w->mutex);
+        w->buffer.clear();
+        pthread_cond_broadcast(&w->cond);
     }
-    osbuffer.str("");
+    pthread_mutex_unlock(&w->mutex);
+#endif
+    return NULL;
 }
 
 DumpVCD::DumpVCD(ostream *_os,
@@ -402,7 +517,14 @@ DumpVCD::DumpVCD(ostream *_os,
     rs(rstrobes),
     ws(wstrobes),
     changesWritten(false),
-    os(_os)
+    os(_os),
+    cycleStart(0),
+    writer(NULL),
+    cycleTime(0),
+    window(0),
+    windowOpen(false),
+    ringHead(0),
+    ringFill(0)
 {}
 
 DumpVCD::DumpVCD(const std::string &_name,
@@ -413,7 +535,14 @@ DumpVCD::DumpVCD(const std::string &_name,
     rs(rstrobes),
     ws(wstrobes),
     changesWritten(false),
-    os(new ofstream(_name.c_str()))
+    os(new ofstream(_name.c_str())),
+    cycleStart(0),
+    writer(NULL),
+    cycleTime(0),
+    window(0),
+    windowOpen(false),
+    ringHead(0),
+    ringFill(0)
 {}
 
 void DumpVCD::setActiveSignals(const TraceSet &act) {
@@ -421,9 +550,17 @@ void DumpVCD::setActiveSignals(const TraceSet &act) {
     unsigned n=0;
     for (TraceSet::const_iterator i=act.begin();
          i!=act.end(); i++) {
-        if (id2num.find(*i)!=id2num.end())
+        size_t idx = (*i)->dumpIndex();
+        if (id2num.size() <= idx)
+            id2num.resize(idx + 1, -1);
+        if (id2num[idx] >= 0)
             avr_error("Trace value would be twice in VCD list.");
-        id2num[*i]=n++;
+        id2num[idx]=n;
+        // preformat identifier codes
+        idValue.push_back(" " + int2str(n*(1+rs+ws)) + "\n");
+        idRead.push_back(int2str(n*(1+rs+ws)+1) + "\n");
+        idWrite.push_back(int2str(n*(1+rs+ws)+1+rs) + "\n");
+        n++;
     }
 }
 
@@ -457,53 +594,148 @@ void DumpVCD::start() {
     }
     *os << "$enddefinitions $end\n";
 
-    // mark initial state
-    changesWritten = true;
-    osbuffer << "#0\n$dumpvars\n";
-    n=0;
-    for (iter i=tv.begin();
-         i!=tv.end(); i++) {
-        valout(*i);
-        osbuffer << ' ' << n*(1+rs+ws) << '\n';
-        // reset RS, WS
-        if (rs) {
-            osbuffer << "0" << n*(1+rs+ws)+1 << "\n";
-        }
-        if (ws) {
+    buffer.reserve(vcdBufferSize + 1024);
+    cycleTime = SystemClock::Instance().GetCurrentTime();
+    if (window > 0) {
+        // initial state is written on trigger
+        ringState.resize(tv.size());
+        for (n = 0; n < tv.size(); n++)
+            valout(ringState[n], tv[n]);
+        os->flush();
+    } else {
+        // mark initial state
+        buffer += "#0\n$dumpvars\n";
+        for (n = 0; n < tv.size(); n++) {
+            valout(buffer, tv[n]);
+            buffer += idValue[n];
+            // reset RS, WS
             if (rs)
-                osbuffer << "0" << n*(1+rs+ws)+2 << "\n";
-            else
-                osbuffer << "0" << n*(1+rs+ws)+1 << "\n";
+                buffer += "0" + idRead[n];
+            if (ws)
+                buffer += "0" + idWrite[n];
         }
-        n++;
+        buffer += "$end\n";
+        changesWritten = true;
+        flushbuffer(true);
+    }
+
+#ifdef HAVE_LIBPTHREAD
+    writer = new DumpVCDWriter;
+    writer->buffer.reserve(vcdBufferSize + 1024);
+    writer->stop = false;
+    pthread_mutex_init(&writer->mutex, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+    if(pthread_create(&writer->thread, NULL, WriterThread, this) != 0) {
+        // write without thread
+        pthread_cond_destroy(&writer->cond);
+        pthread_mutex_destroy(&writer->mutex);
+        delete writer;
+        writer = NULL;
     }
-    osbuffer << "$end\n";
-    flushbuffer();
+#endif
 }
 
 void DumpVCD::cycle() {
-    // flush the buffer
-    flushbuffer();
+    // flush the buffer or keep last cycle in ring
+    if (window > 0 && !windowOpen)
+        keepcycle();
+    else
+        flushbuffer(false);
     
     // write new time marker to buffer
-    SystemClockOffset clock=SystemClock::Instance().GetCurrentTime();
-    osbuffer << "#" << clock << '\n';
+    cycleTime = SystemClock::Instance().GetCurrentTime();
+    AppendTimeMarker(buffer, cycleTime);
 
     // reset RS, WS states
-    for (size_t i=0; i<marked.size(); i++)
-        osbuffer << "0" << marked[i] << "\n";
+    for (size_t i=0; i<marked.size(); i++) {
+        buffer += '0';
+        buffer += *marked[i];
+    }
     if(marked.size())
         changesWritten = true;
     marked.clear();
 }
 
+void DumpVCD::setWindow(unsigned long cycles) {
+    window = cycles;
+    ring.resize(cycles);
+    ringTime.resize(cycles);
+}
+
+void DumpVCD::trigger() {
+    if (window == 0 || windowOpen)
+        return;
+    
+    // state at begin of ring, time of first kept cycle
+    size_t oldest = (ringFill < ring.size()) ? 0 : ringHead;
+    string out, marker;
+    AppendTimeMarker(marker, (ringFill > 0) ? ringTime[oldest] : cycleTime);
+    out += marker + "$dumpvars\n";
+    for (size_t n = 0; n < tv.size(); n++) {
+        out += ringState[n] + idValue[n];
+        if (rs)
+            out += "0" + idRead[n];
+        if (ws)
+            out += "0" + idWrite[n];
+    }
+    out += "$end\n";
+    
+    // kept cycles and current cycle follow, the first one has the same time marker
+    for (size_t i = 0; i < ringFill; i++) {
+        string &slot = ring[(oldest + i) % ring.size()];
+        if (i == 0 && slot.compare(0, marker.size(), marker) == 0)
+            out.append(slot, marker.size(), string::npos);
+        else
+            out += slot;
+        slot.clear();
+    }
+    if (ringFill == 0 && buffer.compare(0, marker.size(), marker) == 0)
+        buffer.erase(0, marker.size());
+    ringHead = ringFill = 0;
+    
+    buffer.insert(0, out);
+    cycleStart += out.size();
+    windowOpen = true;
+}
+
+void DumpVCD::rearm() {
+    if (window == 0 || !windowOpen)
+        return;
+    flushbuffer(true);
+    // values are up to date after dumping a cycle
+    for (size_t n = 0; n < tv.size(); n++) {
+        ringState[n].clear();
+        valout(ringState[n], tv[n]);
+    }
+    windowOpen = false;
+}
+
 void DumpVCD::stop() {
-    // flush the buffer
-    flushbuffer();
+    // flush the buffer, cycles without trigger are dropped
+    if (window > 0 && !windowOpen) {
+        buffer.clear();
+        cycleStart = 0;
+        changesWritten = false;
+    } else
+        flushbuffer(false);
     
     // write a last time marker to report end of dump
-    SystemClockOffset clock=SystemClock::Instance().GetCurrentTime();
-    *os << "#" << clock << '\n';
+    AppendTimeMarker(buffer, SystemClock::Instance().GetCurrentTime());
+    writebuffer();
+
+#ifdef HAVE_LIBPTHREAD
+    if(writer != NULL) {
+        pthread_mutex_lock(&writer->mutex);
+        writer->stop = true;
+        pthread_cond_broadcast(&writer->cond);
+        pthread_mutex_unlock(&writer->mutex);
+        pthread_join(writer->thread, NULL);
+        pthread_cond_destroy(&writer->cond);
+        pthread_mutex_destroy(&writer->mutex);
+        delete writer;
+        writer = NULL;
+    }
+#endif
     
     os->flush(); // flush stream
 }
@@ -511,51 +743,92 @@ void DumpVCD::stop() {
 void DumpVCD::markRead(const TraceValue *t) {
     if (rs) {
         // mark read cycle
-        osbuffer << "1" << id2num[t]*(1+rs+ws)+1 << "\n";
+        const string *id = &idRead[id2num[t->dumpIndex()]];
+        buffer += '1';
+        buffer += *id;
         changesWritten = true;
         // mark to disable @ next cycle
-        marked.push_back(id2num[t]*(1+rs+ws)+1);
+        marked.push_back(id);
     }
 }
 
 void DumpVCD::markWrite(const TraceValue *t) {
     if (ws) {
-        osbuffer << "1" << id2num[t]*(1+rs+ws)+1+rs << "\n";
+        const string *id = &idWrite[id2num[t->dumpIndex()]];
+        buffer += '1';
+        buffer += *id;
         changesWritten = true;
-        marked.push_back(id2num[t]*(1+rs+ws)+1+rs);
+        marked.push_back(id);
     }
 }
 
 void DumpVCD::markChange(const TraceValue *t) {
-    valout(t);
-    osbuffer << " " << id2num[t]*(1+rs+ws) << "\n";
+    valout(buffer, t);
+    buffer += idValue[id2num[t->dumpIndex()]];
     changesWritten = true;
 }
 
 bool DumpVCD::enabled(const TraceValue *t) const {
-    return id2num.find(t)!=id2num.end();
+    size_t idx = t->dumpIndex();
+    return idx < id2num.size() && id2num[idx] >= 0;
 }
 
-DumpVCD::~DumpVCD() { delete os; }
+DumpVCD::~DumpVCD() {
+    if(writer != NULL)
+        stop();
+    delete os;
+}
 
 DumpManager* DumpManager::Instance(void) {
-    static DumpManager *f;
-    if(f == NULL)
-        f = new DumpManager();
-    return f;
+    return SimulationContext::Current()->GetDumpManager();
 }
 
 DumpManager::DumpManager() {
     singleDeviceApp = false;
+    deviceCount = 0;
+    pollInterval = 1;
+    pollCount = 0;
+    windowPre = 0;
+    windowPost = 0;
+    postCount = 0;
+}
+
+void DumpManager::SetPollInterval(unsigned int cycles) {
+    pollInterval = (cycles > 0) ? cycles : 1;
+}
+
+void DumpManager::SetTraceWindow(unsigned long preCycles, unsigned long postCycles) {
+    windowPre = preCycles;
+    windowPost = postCycles;
+    if(windowPre == 0)
+        return;
+    for(size_t i = 0; i < dumps.size(); i++)
+        dumps[i]->setWindow(windowPre);
+    sysConHandler.SetTraceWindow(windowPre);
+}
+
+void DumpManager::Trigger(const char *reason) {
+    if(windowPre == 0)
+        return;
+    if(postCount == 0) {
+        ostringstream title;
+        title << "Trace window triggered by " << reason
+              << " at " << SystemClock::Instance().GetCurrentTime() << "ns";
+        avr_message("%s", title.str().c_str());
+        for(size_t i = 0; i < dumps.size(); i++)
+            dumps[i]->trigger();
+        sysConHandler.TraceTrigger(title.str());
+    }
+    // current cycle isn't counted
+    postCount = windowPost + 1;
 }
 
 void DumpManager::appendDeviceName(std::string &s) {
-    static int devidx = 0;
-    devidx++;
-    if(singleDeviceApp && devidx > 1)
+    deviceCount++;
+    if(singleDeviceApp && deviceCount > 1)
         avr_error("Can't create device name twice, because it's a single device application");
     if(!singleDeviceApp)
-        s += "Dev" + int2str(devidx);
+        s += "Dev" + int2str(deviceCount);
 }
 
 void DumpManager::registerAvrDevice(AvrDevice* dev) {
@@ -600,8 +873,17 @@ void DumpManager::addDumper(Dumper *dump, const TraceSet &vals) {
     // enable values and insert into active list, if not there
     for(TraceSet::const_iterator i = vals.begin(); i != vals.end(); i++) {
         (*i)->enable();
-        if(find(active.begin(), active.end(), *i) == active.end())
-            active.push_back(*i);
+        TraceValue *t = *i;
+        if(t->_dumpIndex < 0) {
+            t->_dumpIndex = active.size();
+            active.push_back(t);
+            t->_dirty = &dirty;
+            // accesses before activation are dumped in next cycle
+            if(t->f != 0)
+                dirty.push_back(t);
+            if(t->polled())
+                polledValues.push_back(t);
+        }
     }
     
     // check, if dumper exists in dumps list
@@ -611,6 +893,10 @@ void DumpManager::addDumper(Dumper *dump, const TraceSet &vals) {
     dump->setActiveSignals(vals);
     // and insert dumper in dumps list
     dumps.push_back(dump);
+
+    // traced RAM cells have to be accessed by RWMemoryMember now
+    for(size_t i = 0; i < devices.size(); i++)
+        devices[i]->UpdateDirectAccess();
 }
 
 const TraceSet& DumpManager::all() {
@@ -646,13 +932,28 @@ void DumpManager::cycle() {
     for (size_t i=0; i<dumps.size(); i++)
         dumps[i]->cycle();
 
-    // And then, update the TraceValues and dump them
-    for (TraceSet::iterator i=active.begin();
-         i!=active.end(); i++) {
-        (*i)->cycle();
+    // update values with shadow pointer, changed values go to dirty list
+    if (!polledValues.empty() && ++pollCount >= pollInterval) {
+        pollCount = 0;
+        for (size_t i=0; i<polledValues.size(); i++)
+            polledValues[i]->cycle();
+    }
+
+    // And then, dump the values accessed in this cycle
+    for (size_t i=0; i<dirty.size(); i++) {
+        TraceValue *t = dirty[i];
         for (size_t j=0; j<dumps.size(); j++)
-            if (dumps[j]->enabled(*i))
-                (*i)->dump(*dumps[j]);
+            if (dumps[j]->enabled(t))
+                t->dump(*dumps[j]);
+        t->clear_flags();
+    }
+    dirty.clear();
+
+    // end of post trigger window, keep output in memory again
+    if (postCount > 0 && --postCount == 0) {
+        for (size_t i=0; i<dumps.size(); i++)
+            dumps[i]->rearm();
+        sysConHandler.TraceRearm();
     }
 }
 
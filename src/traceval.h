@@ -31,6 +31,8 @@
 #include <map>
 #include <vector>
 
+#include "systemclocktypes.h"
+
 /* TODO, notes:
 
    ===========================================================   
@@ -141,6 +143,11 @@ class TraceValue {
         //! Enable tracing
         void enable();
         
+        //! Gives the index of this value in the active list of DumpManager (or -1)
+        /*! Dumpers use this index to find their data for a value without a
+          map lookup. */
+        int dumpIndex() const;
+        
         
         //! Log a change on this value
         void change(unsigned val);
@@ -180,11 +187,17 @@ class TraceValue {
         
         /*! Give back VCD coding of a bit */
         virtual char VcdBit(int bitNo) const;
+        
+        //! True, if changes are detected by cycle() only
+        /*! This is true for values with a shadow pointer. Derived classes,
+          which overwrite cycle() to poll a value, have to return true too. */
+        virtual bool polled() const { return shadow != 0; }
 
     protected:
         //! Clear all access flags
         void clear_flags();
         friend class TraceKeeper;
+        friend class DumpManager;
         
     private:
         std::string _name;
@@ -209,6 +222,19 @@ class TraceValue {
         /*! Note that it must additionally be enabled in the particular
           Dumper. */
         bool _enabled;
+        
+        //! Index in DumpManager active list, set by DumpManager::addDumper
+        int _dumpIndex;
+        
+        //! Dirty list of DumpManager, NULL if value isn't active
+        std::vector<TraceValue*> *_dirty;
+        
+        //! Sets access flags and puts value on dirty list on first access in cycle
+        void setFlags(int flags) {
+            if(f == 0 && _dirty != NULL)
+                _dirty->push_back(this);
+            f |= flags;
+        }
 };
 
 class TraceValueOutput: public TraceValue {
@@ -243,6 +269,14 @@ class Dumper {
         //! Called for each cycle before dumping the values
         virtual void cycle() {}
         
+        //! Called before start(), if windowed tracing is enabled, see DumpManager::SetTraceWindow
+        /*! Output of the last cycles has to be kept in memory only. */
+        virtual void setWindow(unsigned long cycles) {}
+        //! A trigger has fired: write kept output and continue writing
+        virtual void trigger() {}
+        //! Post trigger window has ended: keep output in memory again
+        virtual void rearm() {}
+        
         /*! Called when a traced value has been read (as long as it supports read
           logging!) */
         virtual void markRead(const TraceValue *t) {}
@@ -262,9 +296,8 @@ class Dumper {
         virtual ~Dumper() {}
     
         //! Returns true iff tracing a particular value is enabled
-        /*! FIXME: For a lot of values to trace,
-          checking enabled() each time by doing find on a map()
-          could be slow. Here is potential for more optimization! */
+        /*! This is called for every active value in every cycle, so it should
+          be fast. Use TraceValue::dumpIndex() instead of a map lookup. */
         virtual bool enabled(const TraceValue *t) const=0;
 };
 
@@ -281,7 +314,18 @@ class WarnUnknown : public Dumper {
         AvrDevice *core;
 };
 
-/*! Produces value change dump files. */
+struct DumpVCDWriter;
+
+/*! Produces value change dump files.
+
+  Changes are formatted to a buffer with preformatted identifier codes. If
+  the buffer is full, it's given to a writer thread (if pthread is available),
+  which writes it to output, while simulation fills the second buffer.
+
+  With a trace window (see setWindow) the changes of every cycle are kept in
+  a ring of the last cycles. Changes of cycles, which leave the ring, are
+  collected to the state of all signals at begin of ring. On trigger this
+  state is written as $dumpvars section, followed by the kept cycles. */
 class DumpVCD : public Dumper {
     
     public:
@@ -303,6 +347,13 @@ class DumpVCD : public Dumper {
     
         //! Writes next clock cycle and resets all RS and WS states
         void cycle();
+        
+        //! Keeps changes of last cycles in memory only
+        void setWindow(unsigned long cycles);
+        //! Writes state at begin of ring and the kept cycles
+        void trigger();
+        //! Writes all buffered changes and keeps next cycles in memory again
+        void rearm();
     
         /*! Iff rstrobes is true, this will mark reads on a special
           R-strobe signal line. */
@@ -320,22 +371,54 @@ class DumpVCD : public Dumper {
         
     private:
         TraceSet tv;
-        std::map<const TraceValue*, size_t> id2num;
+        //! number of signal in VCD file, indexed by TraceValue::dumpIndex(), -1 if not traced
+        std::vector<int> id2num;
+        //! preformatted identifier codes for value, read and write strobe, indexed by signal number
+        std::vector<std::string> idValue, idRead, idWrite;
         const std::string tscale;
         const bool rs, ws;
         bool changesWritten;
         
-        // list of signals marked last cycle
-        std::vector<int> marked;
+        // list of strobe signals marked last cycle
+        std::vector<const std::string*> marked;
         std::ostream *os;
     
-        // buffer for change data
-        std::stringstream osbuffer;
-        
-        void valout(const TraceValue *v);
-        
-        //! writes content of osbuffer to os and empty osbuffer afterwards
-        void flushbuffer(void);
+        //! buffer for change data
+        std::string buffer;
+        //! start of current cycle in buffer, dropped, if nothing changed in cycle
+        size_t cycleStart;
+        //! second buffer and writer thread, created by start()
+        DumpVCDWriter *writer;
+        //! time of current cycle in buffer
+        SystemClockOffset cycleTime;
+        
+        //! count of cycles in ring, 0 if there is no trace window
+        unsigned long window;
+        //! trigger has fired, changes are written till rearm()
+        bool windowOpen;
+        //! changes of last cycles (empty, if nothing changed) and time of it
+        std::vector<std::string> ring;
+        std::vector<SystemClockOffset> ringTime;
+        //! next cycle to overwrite and count of used cycles in ring
+        size_t ringHead, ringFill;
+        //! value of every signal (without identifier) at begin of ring
+        std::vector<std::string> ringState;
+        
+        void valout(std::string &buf, const TraceValue *v);
+        
+        //! moves current cycle from buffer to ring
+        void keepcycle(void);
+        
+        //! applies value changes of a cycle to ringState
+        void applystate(const std::string &changes);
+        
+        //! writes cycle to buffer, if something has changed, and gives a full buffer to writer
+        void flushbuffer(bool force);
+        
+        //! gives buffer to writer and gets the empty second buffer
+        void writebuffer(void);
+        
+        static void *WriterThread(void *dumper);
 };
 
 /*! Manages all active Dumper instances for a given AvrDevice.
@@ -344,7 +427,7 @@ class DumpVCD : public Dumper {
 class DumpManager {
     
     public:
-        //! Singleton class access.
+        //! Returns the DumpManager of the current SimulationContext
         static DumpManager* Instance(void);
         
         //! Tell DumpManager, that we have only one device
@@ -369,8 +452,36 @@ class DumpManager {
         void stopApplication(void);
         
         /*! Process one AVR clock cycle. Must be done after the AVR did all
-          processing so that changed values etc. can be collected. */
+          processing so that changed values etc. can be collected.
+          
+          Only values, which are accessed in this cycle (dirty list), are
+          dumped. Values with a shadow pointer are polled every pollInterval
+          cycles. So a cycle without any traced access is cheap. */
         void cycle();
+        
+        //! Sets interval in cycles for polling values with shadow pointer
+        /*! Default is 1, e.g. every cycle. A greater interval makes tracing
+          faster, but changes of polled values are dumped later and a change
+          back and forth between two polls isn't dumped. */
+        void SetPollInterval(unsigned int cycles);
+
+        //! Enables windowed tracing, must be called before start()
+        /*! Output of all dumpers and the text trace is kept in memory for the
+          last preCycles cycles only. If a trigger fires (see Trigger), the
+          kept output is written and output continues for postCycles cycles,
+          then it's kept in memory again till next trigger. So simulation runs
+          without writing trace files till a event of interest. */
+        void SetTraceWindow(unsigned long preCycles, unsigned long postCycles);
+        
+        //! Fires a trigger for windowed tracing, does nothing without trace window
+        /*! A trigger inside of a post trigger window extends the window. */
+        void Trigger(const char *reason);
+        
+        //! Returns true, if windowed tracing is enabled
+        bool IsWindowed(void) const { return windowPre > 0; }
+
+        //! Returns true, if there is at least one dumper, which wants to see every cycle
+        bool IsActive(void) const { return !dumps.empty(); }
     
         //! Destroys the DumpManager instance and shut down all dumpers
         ~DumpManager() { stopApplication(); }
@@ -397,6 +508,7 @@ class DumpManager {
     private:
         friend class TraceValueRegister;
         friend class AvrDevice;
+        friend class SimulationContext;
         
         //! Private instance constructor
         DumpManager();
@@ -415,9 +527,22 @@ class DumpManager {
         
         //! Flag, if we use only one device, e.g. assign no device name
         bool singleDeviceApp;
+
+        //! Count of device names created by appendDeviceName
+        int deviceCount;
         
         //! Set of active tracing values
         TraceSet active;
+        //! Active values, which are accessed in current cycle
+        TraceSet dirty;
+        //! Active values with shadow pointer, which have to be polled
+        TraceSet polledValues;
+        //! Interval and counter for polling polledValues
+        unsigned int pollInterval, pollCount;
+        //! Size of trace window before and after a trigger, see SetTraceWindow
+        unsigned long windowPre, windowPost;
+        //! Remaining cycles in post trigger window, 0 if no trigger has fired
+        unsigned long postCount;
         //! Set of all traceable values (placeholder instance for all() method)
         TraceSet _all;
         
@@ -0,0 +1,106 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph		
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+using namespace std;
+
+#include "pinstimulus.h"
+#include "avrdevice.h"
+#include "avrerror.h"
+#include "systemclock.h"
+#include "pin.h"
+#include "net.h"
+
+PinStimulus::PinStimulus(AvrDevice *dev, const string &filename): nextEvent(0) {
+    ifstream in(filename.c_str());
+    if(!in)
+        avr_error("can't open stimulus file '%s'", filename.c_str());
+
+    SystemClockOffset start = SystemClock::Instance().GetCurrentTime();
+    string line;
+    int lineNo = 0;
+    while(getline(in, line)) {
+        lineNo++;
+        istringstream is(line);
+        SystemClockOffset offset;
+        string name, state;
+        if(!(is >> name) || name[0] == '#')
+            continue;
+        is.clear();
+        is.str(line);
+        if(!(is >> offset >> name >> state) || offset < 0 ||
+           state.size() != 1 || string("HLhltS").find(state[0]) == string::npos)
+            avr_error("%s:%d: expected '<time> <pin> <H|L|h|l|t|S>'", filename.c_str(), lineNo);
+        Event ev;
+        ev.time = start + offset;
+        ev.pin = GetStimulusPin(dev, name);
+        ev.state = state[0];
+        events.push_back(ev);
+    }
+    stable_sort(events.begin(), events.end(), EventBefore);
+
+    if(!events.empty())
+        SystemClock::Instance().Add(this);
+}
+
+PinStimulus::~PinStimulus() {
+    // a net disconnects all pins on destruction
+    for(unsigned int i = 0; i < nets.size(); i++)
+        delete nets[i];
+    for(map<string, Pin*>::iterator i = pins.begin(); i != pins.end(); i++)
+        delete i->second;
+}
+
+Pin *PinStimulus::GetStimulusPin(AvrDevice *dev, const string &name) {
+    map<string, Pin*>::iterator i = pins.find(name);
+    if(i != pins.end())
+        return i->second;
+
+    Pin *devPin = dev->GetPin(name.c_str());
+    Pin *pin = new Pin(Pin::TRISTATE);
+    Net *net = devPin->GetNet();
+    if(net == NULL) {
+        net = new Net;
+        nets.push_back(net);
+        net->Add(devPin);
+    }
+    net->Add(pin);
+    pins[name] = pin;
+    return pin;
+}
+
+int PinStimulus::Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns) {
+    SystemClockOffset now = SystemClock::Instance().GetCurrentTime();
+    while(nextEvent < events.size() && events[nextEvent].time <= now) {
+        *events[nextEvent].pin = events[nextEvent].state;
+        nextEvent++;
+    }
+    // no more events: remove stimulus from time table
+    if(timeToNextStepIn_ns != 0)
+        *timeToNextStepIn_ns = (nextEvent < events.size()) ? events[nextEvent].time - now : -1;
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ ****************************************************************************
+ *
+ * simulavr - A simulator for the Atmel AVR family of microcontrollers.
+ * Copyright (C) 2001, 2002, 2003   Klaus Rudolph
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ ****************************************************************************
+ *
+ *  $Id$
+ */
+
+#ifndef PINSTIMULUS
+#define PINSTIMULUS
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "systemclocktypes.h"
+#include "simulationmember.h"
+
+class AvrDevice;
+class Pin;
+class Net;
+
+//! Drives device pins by a waveform script
+/*! The script is a text file with one event per line:
+
+  <time> <pin> <state>
+
+  time is the offset in [ns] from creation of the stimulus (so from start of
+  simulation or, in fork mode of simulavr, from the fork point), pin is the
+  device pin name (like "B0") and state is a pin state character like used
+  by the user interface: H, L (driven high/low), h, l (pull up/down), t
+  (tristate), S (shorted). Empty lines and lines starting with # are
+  ignored. Events don't need to be sorted. Every used device pin gets an own
+  stimulus pin, which is connected to it, till the first event for the pin
+  it's tristate. */
+class PinStimulus: public SimulationMember {
+
+    protected:
+        //! one pin change from script
+        struct Event {
+            SystemClockOffset time; //!< absolute simulation time
+            Pin *pin;               //!< stimulus pin to change
+            char state;             //!< new pin state
+        };
+
+        std::vector<Event> events;           //!< events, sorted by time
+        unsigned int nextEvent;              //!< index of next event to process
+        std::map<std::string, Pin*> pins;    //!< stimulus pins by device pin name
+        std::vector<Net*> nets;              //!< nets, created to connect stimulus pins
+
+        //! Order of events by time, used for stable sort
+        static bool EventBefore(const Event &a, const Event &b) { return a.time < b.time; }
+        //! Returns stimulus pin for device pin, creates and connects it on first call
+        Pin *GetStimulusPin(AvrDevice *dev, const std::string &name);
+
+    public:
+        /*! Reads the script and adds the stimulus to time table
+          @param dev device, which pins are driven
+          @param filename name of script file */
+        PinStimulus(AvrDevice *dev, const std::string &filename);
+        ~PinStimulus();
+
+        //! Applies all events till current time
+        virtual int Step(bool &trueHwStep, SystemClockOffset *timeToNextStepIn_ns = 0);
+};
+
+#endif // PINSTIMULUS